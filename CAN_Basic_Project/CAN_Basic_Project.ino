@@ -1,40 +1,73 @@
 #include <SPI.h>
 #include <mcp_can.h>
+#include "CanRx.h"
+#include "CanGateway.h"
+
+// 0: print each frame as text (115200 baud)
+// 1: CAN <-> serial gateway for a laptop (1000000 baud, see CanGateway.h)
+#define GATEWAY_MODE    1
+#define GATEWAY_FORMAT  CAN_GW_SLCAN
+
 const int spiCSPin = 10;
+const int canIntPin = 2;  // MCP2515 INT pin
 MCP_CAN CAN(spiCSPin);
+CanRx canRx(spiCSPin, canIntPin);
+#if GATEWAY_MODE
+CanGateway gateway(CAN, canRx, Serial);
+#endif
+unsigned long lastFrameTime = 0;
+
+// Called from loop() for every received frame
+void onCanFrame(const CanFrame &frame) {
+#if GATEWAY_MODE
+    gateway.forward(frame);
+#else
+    Serial.print("Received Message ID: ");
+    Serial.println(frame.id, HEX);
+    Serial.print("Data Length: ");
+    Serial.println(frame.len);
+    Serial.print("Data: ");
+    for (int i = 0; i < frame.len; i++) {
+        Serial.print(frame.data[i]);
+        Serial.print("\t");
+    }
+    Serial.println();
+    lastFrameTime = millis();
+#endif
+}
+
 void setup() {
+#if GATEWAY_MODE
+    // no text on the port: the host tools only expect gateway output
+    Serial.begin(1000000);
+    while (CAN_OK != CAN.begin(MCP_ANY, CAN_500KBPS, MCP_8MHZ))
+        delay(100);
+#else
     Serial.begin(115200);
     while (CAN_OK != CAN.begin(MCP_ANY, CAN_500KBPS, MCP_8MHZ)) {
         Serial.println("CAN BUS init Failed");
         delay(100);
     }
     Serial.println("CAN BUS Shield Init OK!");
+#endif
     // Set to normal mode for receiving messages
     CAN.setMode(MCP_NORMAL);
+    canRx.onReceive(onCanFrame);
+    canRx.begin();
+#if GATEWAY_MODE
+    gateway.begin(GATEWAY_FORMAT);
+#endif
 }
 
 void loop() {
-    unsigned char len = 0;
-    unsigned char buf[8];
-
-    // Check if data is available
-    if (CAN_MSGAVAIL == CAN.checkReceive()) {
-        unsigned long canId;
-        CAN.readMsgBuf(&canId, &len, buf);  // Read the message
-        Serial.print("Received Message ID: ");
-        Serial.println(canId, HEX);
-        Serial.print("Data Length: ");
-        Serial.println(len);
-        Serial.print("Data: ");
-        for (int i = 0; i < len; i++) {
-            Serial.print(buf[i]);
-            Serial.print("\t");
-        }
-        Serial.println();
-    } else {
+    canRx.process();
+#if GATEWAY_MODE
+    gateway.poll();
+#else
+    // Report a silent bus once per second instead of on every poll
+    if (millis() - lastFrameTime >= 1000) {
         Serial.println("No message received");
+        lastFrameTime = millis();
     }
-
-    delay(100);  // Adjust delay as necessary
+#endif
 }
-
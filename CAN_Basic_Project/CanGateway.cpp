@@ -0,0 +1,371 @@
+// CanGateway.cpp
+// CAN <-> serial gateway, see CanGateway.h
+
+#include "CanGateway.h"
+
+#define SLCAN_OK            "\r"
+#define SLCAN_ERROR         "\a"
+#define SLCAN_VERSION       "V1013\r"
+#define SLCAN_SERIAL        "N0001\r"
+#define SLCAN_STAMP_WRAP    60000       // SLCAN timestamps: ms, 0..59999
+
+// SLCAN F status bits
+#define SLCAN_F_RX_FULL     0x01
+#define SLCAN_F_TX_FULL     0x02
+#define SLCAN_F_EWARN       0x04
+#define SLCAN_F_OVERRUN     0x08
+#define SLCAN_F_EPASSIVE    0x20
+#define SLCAN_F_BUSERR      0x80
+
+// binary packet flags
+#define GW_BIN_EXT          0x80
+#define GW_BIN_RTR          0x40
+#define GW_BIN_LEN          0x0F
+
+#define MCP_CAN_RTR_FLAG    0x40000000UL    // mcp_can: remote frame request in the ID
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+static bool parseHex(const char *s, byte n, unsigned long *value)
+{
+    unsigned long v = 0;
+    char c;
+
+    while (n--) {
+        c = *s++;
+        if ((c >= '0') && (c <= '9'))
+            c -= '0';
+        else if ((c >= 'A') && (c <= 'F'))
+            c -= 'A' - 10;
+        else if ((c >= 'a') && (c <= 'f'))
+            c -= 'a' - 10;
+        else
+            return false;
+        v = (v << 4) | c;
+    }
+    *value = v;
+    return true;
+}
+
+// COBS: dst gets len + 1 bytes, no 0x00 among them (len < 254)
+static byte cobsEncode(const byte *src, byte len, byte *dst)
+{
+    byte code = 1, codePos = 0, n = 1, i;
+
+    for (i = 0; i < len; i++) {
+        if (src[i] == 0) {
+            dst[codePos] = code;
+            codePos = n++;
+            code = 1;
+        } else {
+            dst[n++] = src[i];
+            code++;
+        }
+    }
+    dst[codePos] = code;
+    return n;
+}
+
+// returns the decoded length, -1 if malformed
+static int cobsDecode(const byte *src, byte len, byte *dst)
+{
+    byte i = 0, n = 0, code, j;
+
+    while (i < len) {
+        code = src[i++];
+        if ((code == 0) || ((i + code - 1) > len))
+            return -1;
+        for (j = 1; j < code; j++)
+            dst[n++] = src[i++];
+        if ((code < 0xFF) && (i < len))
+            dst[n++] = 0;
+    }
+    return n;
+}
+
+CanGateway::CanGateway(MCP_CAN &can, CanRx &canRx, HardwareSerial &port)
+    : can(can), canRx(canRx), port(port), format(CAN_GW_SLCAN), open(false),
+      listenOnly(false), timestamps(false), txHead(0), txTail(0), lineLen(0),
+      lineOverflow(false), lastDrops(0)
+{
+    memset(&counters, 0, sizeof(counters));
+    memset(&lastRx, 0, sizeof(lastRx));
+}
+
+void CanGateway::begin(byte format)
+{
+    this->format = format;
+    open = (format == CAN_GW_BINARY);
+    lastRx = canRx.stats();
+}
+
+void CanGateway::forward(const CanFrame &frame)
+{
+    byte buf[CAN_GW_LINE_SIZE];
+    byte raw[1 + 4 + 4 + 8];
+    byte n = 0, m = 0, i;
+    unsigned int ms;
+
+    if (!open)
+        return;
+    if (format == CAN_GW_SLCAN) {
+        buf[n++] = frame.rtr ? (frame.ext ? 'R' : 'r') : (frame.ext ? 'T' : 't');
+        for (i = frame.ext ? 8 : 3; i > 0; i--)
+            buf[n++] = hexDigits[(frame.id >> (4 * (i - 1))) & 0x0F];
+        buf[n++] = hexDigits[frame.len];
+        if (!frame.rtr) {
+            for (i = 0; i < frame.len; i++) {
+                buf[n++] = hexDigits[frame.data[i] >> 4];
+                buf[n++] = hexDigits[frame.data[i] & 0x0F];
+            }
+        }
+        if (timestamps) {
+            ms = (frame.stamp / 1000) % SLCAN_STAMP_WRAP;
+            for (i = 4; i > 0; i--)
+                buf[n++] = hexDigits[(ms >> (4 * (i - 1))) & 0x0F];
+        }
+        buf[n++] = '\r';
+    } else {
+        raw[m++] = (frame.ext ? GW_BIN_EXT : 0) | (frame.rtr ? GW_BIN_RTR : 0) | frame.len;
+        for (i = 0; i < 4; i++)
+            raw[m++] = frame.stamp >> (8 * i);
+        for (i = 0; i < (frame.ext ? 4 : 2); i++)
+            raw[m++] = frame.id >> (8 * i);
+        if (!frame.rtr) {
+            memcpy(raw + m, frame.data, frame.len);
+            m += frame.len;
+        }
+        n = cobsEncode(raw, m, buf);
+        buf[n++] = 0;
+    }
+    if (put(buf, n))
+        counters.framesOut++;
+    else
+        counters.serialDrops++;
+}
+
+void CanGateway::poll()
+{
+    int c;
+
+    flush();
+    while ((c = port.read()) >= 0)
+        receive(c);
+    flush();
+}
+
+bool CanGateway::put(const byte *data, byte len)
+{
+    byte i;
+
+    if ((unsigned int)(CAN_GW_TX_SIZE - (txHead - txTail)) < len)
+        return false;
+    for (i = 0; i < len; i++)
+        txRing[(txHead + i) & (CAN_GW_TX_SIZE - 1)] = data[i];
+    txHead += len;
+    return true;
+}
+
+// writes what fits in the serial buffer, contiguous chunks
+void CanGateway::flush()
+{
+    int room = port.availableForWrite();
+    unsigned int idx, n;
+
+    while ((room > 0) && (txHead != txTail)) {
+        idx = txTail & (CAN_GW_TX_SIZE - 1);
+        n = txHead - txTail;
+        if (n > CAN_GW_TX_SIZE - idx)
+            n = CAN_GW_TX_SIZE - idx;
+        if (n > (unsigned int)room)
+            n = room;
+        port.write(&txRing[idx], n);
+        txTail += n;
+        room -= n;
+    }
+}
+
+void CanGateway::receive(byte c)
+{
+    byte end = (format == CAN_GW_SLCAN) ? '\r' : 0;
+
+    if (c == end) {
+        if (lineOverflow)
+            counters.badInput++;
+        else if (lineLen && (format == CAN_GW_SLCAN))
+            slcanCommand();
+        else if (lineLen)
+            binaryPacket();
+        lineLen = 0;
+        lineOverflow = false;
+        return;
+    }
+    if ((format == CAN_GW_SLCAN) && (c == '\n'))
+        return;
+    if (lineLen < CAN_GW_LINE_SIZE - 1)
+        line[lineLen++] = c;
+    else
+        lineOverflow = true;
+}
+
+void CanGateway::slcanCommand()
+{
+    unsigned long id, v;
+    byte data[8];
+    byte ext, rtr, idDigits, len, i;
+    char reply[5];
+
+    line[lineLen] = 0;
+    switch (line[0]) {
+    case 'O':
+    case 'L':
+        if (open) {
+            slcanReply(SLCAN_ERROR);
+            break;
+        }
+        listenOnly = (line[0] == 'L');
+        can.setMode(listenOnly ? MCP_LISTENONLY : MCP_NORMAL);
+        open = true;
+        lastRx = canRx.stats();
+        lastDrops = counters.serialDrops;
+        slcanReply(SLCAN_OK);
+        break;
+    case 'C':
+        if (listenOnly)
+            can.setMode(MCP_NORMAL);
+        open = false;
+        listenOnly = false;
+        slcanReply(SLCAN_OK);
+        break;
+    case 'S':
+        // the bit rate is set by the sketch: only 500 kbps is acknowledged
+        slcanReply(((line[1] == '6') && (lineLen == 2) && !open) ? SLCAN_OK : SLCAN_ERROR);
+        break;
+    case 'V':
+        slcanReply(SLCAN_VERSION);
+        break;
+    case 'N':
+        slcanReply(SLCAN_SERIAL);
+        break;
+    case 'F':
+        v = slcanFlags();
+        reply[0] = 'F';
+        reply[1] = hexDigits[v >> 4];
+        reply[2] = hexDigits[v & 0x0F];
+        reply[3] = '\r';
+        reply[4] = 0;
+        slcanReply(reply);
+        break;
+    case 'Z':
+        if (((line[1] == '0') || (line[1] == '1')) && (lineLen == 2)) {
+            timestamps = (line[1] == '1');
+            slcanReply(SLCAN_OK);
+        } else {
+            slcanReply(SLCAN_ERROR);
+        }
+        break;
+    case 't':
+    case 'T':
+    case 'r':
+    case 'R':
+        ext = (line[0] == 'T') || (line[0] == 'R');
+        rtr = (line[0] == 'r') || (line[0] == 'R');
+        idDigits = ext ? 8 : 3;
+        if ((!open) || listenOnly || (lineLen < 2 + idDigits)
+                || !parseHex(line + 1, idDigits, &id) || !parseHex(line + 1 + idDigits, 1, &v)
+                || (v > 8) || (id > (ext ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK))) {
+            counters.badInput++;
+            slcanReply(SLCAN_ERROR);
+            break;
+        }
+        len = v;
+        if (lineLen != 2 + idDigits + (rtr ? 0 : 2 * len)) {
+            counters.badInput++;
+            slcanReply(SLCAN_ERROR);
+            break;
+        }
+        for (i = 0; (i < len) && !rtr; i++) {
+            parseHex(line + 2 + idDigits + 2 * i, 2, &v);
+            data[i] = v;
+        }
+        transmit(id, ext, rtr, len, data);
+        slcanReply(ext ? "Z\r" : "z\r");
+        break;
+    default:
+        counters.badInput++;
+        slcanReply(SLCAN_ERROR);
+        break;
+    }
+}
+
+// host packet: flags, ID (2 or 4 bytes), data (no stamp)
+void CanGateway::binaryPacket()
+{
+    byte raw[CAN_GW_LINE_SIZE];
+    unsigned long id = 0;
+    byte ext, rtr, len, idLen, i;
+    int n = cobsDecode((const byte *)line, lineLen, raw);
+
+    if (n < 1) {
+        counters.badInput++;
+        return;
+    }
+    ext = (raw[0] & GW_BIN_EXT) ? 1 : 0;
+    rtr = (raw[0] & GW_BIN_RTR) ? 1 : 0;
+    len = raw[0] & GW_BIN_LEN;
+    idLen = ext ? 4 : 2;
+    if ((len > 8) || (n != 1 + idLen + (rtr ? 0 : len))) {
+        counters.badInput++;
+        return;
+    }
+    for (i = 0; i < idLen; i++)
+        id |= (unsigned long)raw[1 + i] << (8 * i);
+    if (id > (ext ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK)) {
+        counters.badInput++;
+        return;
+    }
+    transmit(id, ext, rtr, len, raw + 1 + idLen);
+}
+
+void CanGateway::transmit(unsigned long id, byte ext, byte rtr, byte len, const byte *data)
+{
+    byte buf[8];
+
+    memcpy(buf, data, rtr ? 0 : len);
+    if (rtr)
+        id |= MCP_CAN_RTR_FLAG;
+    if (can.sendMsgBuf(id, ext, len, buf) == CAN_OK)
+        counters.framesIn++;
+    else
+        counters.canTxErrors++;
+}
+
+// a reply lost in a full ring is not a frame: not counted in serialDrops
+void CanGateway::slcanReply(const char *reply)
+{
+    put((const byte *)reply, strlen(reply));
+}
+
+// SLCAN F: error states now, losses since last F (or O/L)
+byte CanGateway::slcanFlags()
+{
+    CanRxStats rx = canRx.stats();
+    byte eflg = canRx.eflg();
+    byte flags = 0;
+
+    if (rx.fifoDrops != lastRx.fifoDrops)
+        flags |= SLCAN_F_RX_FULL;
+    if (counters.serialDrops != lastDrops)
+        flags |= SLCAN_F_TX_FULL;
+    if (eflg & CAN_EFLG_EWARN)
+        flags |= SLCAN_F_EWARN;
+    if (rx.hwOverflows != lastRx.hwOverflows)
+        flags |= SLCAN_F_OVERRUN;
+    if (eflg & (CAN_EFLG_RXEP | CAN_EFLG_TXEP))
+        flags |= SLCAN_F_EPASSIVE;
+    if (eflg & CAN_EFLG_TXBO)
+        flags |= SLCAN_F_BUSERR;
+    lastRx = rx;
+    lastDrops = counters.serialDrops;
+    return flags;
+}
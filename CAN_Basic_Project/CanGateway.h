@@ -0,0 +1,106 @@
+// CanGateway.h
+// CAN <-> serial gateway: frames received by CanRx are queued, already
+// encoded, in a transmit ring drained to the serial port without blocking;
+// frames sent by the host are transmitted on the bus.
+//
+// Formats:
+// CAN_GW_SLCAN   Lawicel/SLCAN ASCII, usable with the existing host tools
+//                (Linux: slcand -s6 /dev/ttyACM0 can0, then candump/canplayer;
+//                python-can "slcan" interface). Commands: O (open), L (listen
+//                only), C (close), S6 (500 kbps only), V, N, F, Z0/Z1 and
+//                t/T/r/R to transmit. Frames: tIIIL<data>[ssss]\r
+// CAN_GW_BINARY  COBS framed packets, 0x00 terminated:
+//                flags (bit7 extended, bit6 remote, bits3..0 length),
+//                stamp (device -> host only: micros(), 4 bytes little endian),
+//                ID (2 bytes standard, 4 bytes extended, little endian),
+//                data. 17 bytes on the line for a standard 8 byte frame
+//                (SLCAN 22, 26 with timestamp). Forwarding starts at begin().
+//
+// Serial link budget: at 1000000 baud (8N1, 100000 bytes/s) against a fully
+// loaded 500 kbps bus (about 4000 standard 8 byte frames/s):
+//   binary       17 bytes/frame    68000 bytes/s   fits
+//   SLCAN        22 bytes/frame    88000 bytes/s   fits, 12 % margin
+//   SLCAN Z1     26 bytes/frame   104000 bytes/s   does not fit above about
+//                                                  3800 frames/s (96 % bus load)
+// The transmit ring only absorbs bursts: a frame which does not fit in it is
+// dropped and counted in serialDrops, reported by SLCAN F as "TX full" (bit 1).
+// For a busy bus use the binary format (tools/cangw_bin decodes it) or Z0.
+//
+// Usage:
+//     CanGateway gateway(CAN, canRx, Serial);
+//     void onCanFrame(const CanFrame &frame) { gateway.forward(frame); }
+//
+//     setup():  Serial.begin(1000000); ... canRx.begin(); gateway.begin(CAN_GW_SLCAN);
+//     loop():   canRx.process(); gateway.poll();
+
+#ifndef CAN_GATEWAY_H
+#define CAN_GATEWAY_H
+
+#include <Arduino.h>
+#include <mcp_can.h>
+#include "CanRx.h"
+
+#define CAN_GW_SLCAN        0
+#define CAN_GW_BINARY       1
+
+// serial transmit ring (power of 2, up to 32768)
+#define CAN_GW_TX_SIZE      256
+// longest host command / packet
+#define CAN_GW_LINE_SIZE    32
+
+struct CanGwStats {
+    unsigned long framesOut;    // frames sent to the host
+    unsigned long framesIn;     // frames from the host transmitted on the bus
+    unsigned long serialDrops;  // frames lost: transmit ring full (serial too slow,
+                                // see the link budget above)
+    unsigned long badInput;     // malformed or refused host commands/packets
+    unsigned long canTxErrors;  // host frames the MCP2515 failed to send
+};
+
+class CanGateway {
+public:
+    CanGateway(MCP_CAN &can, CanRx &canRx, HardwareSerial &port);
+
+    void begin(byte format);
+
+    // main loop side (CanRx handler): queues a frame for the host
+    void forward(const CanFrame &frame);
+
+    // main loop side: sends queued bytes the serial port takes without
+    // blocking, executes host commands/packets
+    void poll();
+
+    const CanGwStats &stats() const { return counters; }
+
+private:
+    bool put(const byte *data, byte len);
+    void flush();
+    void receive(byte c);
+    void slcanCommand();
+    void binaryPacket();
+    void transmit(unsigned long id, byte ext, byte rtr, byte len, const byte *data);
+    void slcanReply(const char *reply);
+    byte slcanFlags();
+
+    MCP_CAN &can;
+    CanRx &canRx;
+    HardwareSerial &port;
+    byte format;
+    bool open;                  // forwarding frames (SLCAN: after O or L)
+    bool listenOnly;
+    bool timestamps;            // SLCAN Z1
+
+    byte txRing[CAN_GW_TX_SIZE];
+    unsigned int txHead;
+    unsigned int txTail;
+
+    char line[CAN_GW_LINE_SIZE];
+    byte lineLen;
+    bool lineOverflow;
+
+    CanGwStats counters;
+    CanRxStats lastRx;          // for SLCAN F: what changed since the last F
+    unsigned long lastDrops;
+};
+
+#endif
@@ -0,0 +1,516 @@
+// CanRx.cpp
+// Interrupt driven MCP2515 receiver, see CanRx.h
+//
+// The registers are accessed directly over SPI (same settings as the mcp_can
+// library), SPI.usingInterrupt() keeps the library's own transactions from
+// being interrupted by the service routine.
+
+#include "CanRx.h"
+#include <SPI.h>
+
+// MCP2515 SPI instructions
+#define MCP_INSTR_WRITE         0x02
+#define MCP_INSTR_READ          0x03
+#define MCP_INSTR_BITMOD        0x05
+#define MCP_INSTR_READ_RX0      0x90    // read RXB0 from SIDH, clears RX0IF
+#define MCP_INSTR_READ_RX1      0x94    // read RXB1 from SIDH, clears RX1IF
+
+// MCP2515 registers
+#define MCP_REG_CANSTAT         0x0E
+#define MCP_REG_CANCTRL         0x0F
+#define MCP_REG_RXM0SIDH        0x20    // RXM1 0x24
+#define MCP_REG_CANINTE         0x2B
+#define MCP_REG_CANINTF         0x2C    // followed by EFLG
+#define MCP_REG_EFLG            0x2D
+#define MCP_REG_RXB0CTRL        0x60
+#define MCP_REG_RXB0SIDH        0x61    // RXB0 0x61..0x6D, RXB1 0x71..0x7D
+#define MCP_REG_RXB1CTRL        0x70
+
+#define MCP_OPMODE_MASK         0xE0    // CANCTRL REQOP, CANSTAT OPMOD
+#define MCP_OPMODE_CONFIG       0x80
+#define MCP_RXBCTRL_RXM         0x60    // 00: filters on, 11: any frame
+
+// CANINTE / CANINTF bits
+#define MCP_RX0IF               0x01
+#define MCP_RX1IF               0x02
+#define MCP_ERRIF               0x20
+
+#define MCP_RXB0CTRL_BUKT       0x04    // RXB0 full: roll over into RXB1
+#define MCP_SIDL_SRR            0x10    // standard remote frame
+#define MCP_SIDL_IDE            0x08    // extended identifier
+#define MCP_DLC_RTR             0x40    // extended remote frame
+
+#define MCP_RXB_REGS            13      // SIDH, SIDL, EID8, EID0, DLC, D0..D7
+#define MCP_RXB1_OFFSET         16      // RXB1SIDH - RXB0SIDH
+
+// service rounds per interrupt while INT stays low
+#define CAN_RX_MAX_ROUNDS       4
+// ms waiting for an operation mode change
+#define CAN_RX_MODE_TIMEOUT     10
+
+// Filter cover: IDs in the 29 bit layout of the MCP2515 registers,
+// standard IDs in the top 11 bits (SID), EID bits below.
+// A filter applies to standard or extended frames only (EXIDE) and its
+// buffer mask is shared: 2 filters on RXB0, 4 on RXB1. For standard frames
+// the EID mask bits are matched against the first two data bytes, so the
+// mask of a buffer serving standard filters keeps them clear.
+#define CAN_SID_BITS            0x1FFC0000UL
+#define CAN_SID_SHIFT           18
+#define CAN_RXB0_FILTERS        2
+#define CAN_RXB1_FILTERS        4
+#define CAN_FILTERS             (CAN_RXB0_FILTERS + CAN_RXB1_FILTERS)
+
+struct CanCube {
+    unsigned long value;
+    unsigned long mask;
+    byte ext;
+};
+
+static const SPISettings canRxSpi(10000000, MSBFIRST, SPI_MODE0);
+
+CanRx *CanRx::instance = NULL;
+
+// dispatch table order: full mask subscriptions first, by ext then id
+static unsigned long subKey(byte ext, unsigned long id)
+{
+    return ((unsigned long)ext << 31) | id;
+}
+
+static bool subExact(const CanSub &sub)
+{
+    return sub.mask == (sub.ext ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK);
+}
+
+static byte bitCount(unsigned long v)
+{
+    byte n = 0;
+
+    for (; v; v &= v - 1)
+        n++;
+    return n;
+}
+
+// IDs accepted by a filter under its buffer mask
+static unsigned long cubeCost(const CanCube &c, unsigned long bufMask)
+{
+    unsigned long m = c.mask & bufMask;
+
+    if (c.ext)
+        return 1UL << (29 - bitCount(m));
+    return 1UL << (11 - bitCount(m & CAN_SID_BITS));
+}
+
+// buffer mask shared by the filters selected by sel
+static unsigned long groupMask(const CanCube *cubes, byte n, byte sel)
+{
+    unsigned long m = CAN_EXT_ID_MASK;
+    byte i;
+
+    for (i = 0; i < n; i++) {
+        if (sel & (1 << i)) {
+            m &= cubes[i].mask;
+            if (!cubes[i].ext)
+                m &= CAN_SID_BITS;
+        }
+    }
+    return m;
+}
+
+// best split of n <= CAN_FILTERS cubes between RXB0 and RXB1:
+// returns the IDs accepted, sel0 gets the cubes given to RXB0
+static unsigned long bestSplit(const CanCube *cubes, byte n, byte *sel0)
+{
+    unsigned long best = 0xFFFFFFFFUL;
+    unsigned long cost, m0, m1;
+    byte all = (1 << n) - 1;
+    byte sel, cnt, i;
+
+    for (sel = 1; sel <= all; sel++) {
+        cnt = bitCount(sel);
+        if ((cnt > CAN_RXB0_FILTERS) || ((n - cnt) > CAN_RXB1_FILTERS))
+            continue;
+        m0 = groupMask(cubes, n, sel);
+        m1 = groupMask(cubes, n, all & ~sel);
+        cost = 0;
+        for (i = 0; i < n; i++)
+            cost += cubeCost(cubes[i], (sel & (1 << i)) ? m0 : m1);
+        if (cost < best) {
+            best = cost;
+            *sel0 = sel;
+        }
+    }
+    return best;
+}
+
+static void encodeId(unsigned long v, byte ext, byte *regs)
+{
+    regs[0] = v >> 21;                                      // SIDH
+    regs[1] = ((v >> 13) & 0xE0) | ((v >> 16) & 0x03) | (ext ? MCP_SIDL_IDE : 0);
+    regs[2] = v >> 8;                                       // EID8
+    regs[3] = v;                                            // EID0
+}
+
+CanRx::CanRx(byte csPin, byte intPin)
+    : csPin(csPin), intPin(intPin), handler(NULL), subCnt(0), exactCnt(0),
+      head(0), tail(0), lastEflg(0)
+{
+    memset(&counters, 0, sizeof(counters));
+}
+
+bool CanRx::subscribe(unsigned long id, unsigned long mask, byte ext, CanRxHandler handler)
+{
+    CanSub *sub;
+
+    if ((subCnt >= CAN_RX_MAX_SUBS) || (handler == NULL))
+        return false;
+    sub = &subs[subCnt++];
+    sub->mask = mask & (ext ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK);
+    sub->id = id & sub->mask;
+    sub->ext = ext ? 1 : 0;
+    sub->handler = handler;
+    return true;
+}
+
+bool CanRx::begin()
+{
+    CanSub sub;
+    bool ok = true;
+    byte i, j, prevMode;
+
+    instance = this;
+    pinMode(intPin, INPUT_PULLUP);
+
+    // dispatch table: full mask subscriptions first, sorted for binary search
+    exactCnt = 0;
+    for (i = 0; i < subCnt; i++) {
+        if (subExact(subs[i])) {
+            sub = subs[i];
+            for (j = i; j > exactCnt; j--)
+                subs[j] = subs[j - 1];
+            for (j = exactCnt; (j > 0) && (subKey(subs[j - 1].ext, subs[j - 1].id) > subKey(sub.ext, sub.id)); j--)
+                subs[j] = subs[j - 1];
+            subs[j] = sub;
+            exactCnt++;
+        }
+    }
+
+    SPI.beginTransaction(canRxSpi);
+    if (subCnt) {
+        prevMode = readReg(MCP_REG_CANSTAT) & MCP_OPMODE_MASK;
+        ok = setOpMode(MCP_OPMODE_CONFIG);
+        if (ok) {
+            setFilters();
+            ok = setOpMode(prevMode);
+        }
+    }
+    bitModify(MCP_REG_RXB0CTRL, MCP_RXB0CTRL_BUKT, MCP_RXB0CTRL_BUKT);
+    bitModify(MCP_REG_CANINTE, MCP_RX0IF | MCP_RX1IF | MCP_ERRIF, MCP_RX0IF | MCP_RX1IF | MCP_ERRIF);
+    SPI.endTransaction();
+
+    SPI.usingInterrupt(digitalPinToInterrupt(intPin));
+    attachInterrupt(digitalPinToInterrupt(intPin), isr, FALLING);
+    return ok;
+}
+
+// Greedy cover: merge the two same-type filters accepting the fewest IDs
+// once merged until they fit, then keep merging while it may pay off
+// with the looser buffer masks of fewer filters. Configuration mode only.
+void CanRx::setFilters()
+{
+    static const byte filtAddr[2][CAN_RXB1_FILTERS] = {
+        { 0x00, 0x04 },                 // RXF0, RXF1 (RXB0)
+        { 0x08, 0x10, 0x14, 0x18 }      // RXF2..RXF5 (RXB1)
+    };
+    CanCube cubes[CAN_RX_MAX_SUBS];
+    CanCube best[CAN_FILTERS];
+    CanCube merged;
+    unsigned long bestCost = 0xFFFFFFFFUL;
+    unsigned long cost, minCost, masks;
+    byte n, types, i, j, k, b, mi, mj, sel = 0, bestN = 0, bestSel = 0;
+    byte idx[2][CAN_RXB1_FILTERS], cnt[2];
+    bool copy;
+    byte regs[4];
+
+    types = 0;
+    for (n = 0; n < subCnt; n++) {
+        cubes[n].ext = subs[n].ext;
+        cubes[n].value = subs[n].ext ? subs[n].id : subs[n].id << CAN_SID_SHIFT;
+        cubes[n].mask = subs[n].ext ? subs[n].mask : subs[n].mask << CAN_SID_SHIFT;
+        types |= 1 << subs[n].ext;
+    }
+    types = bitCount(types);
+
+    for (;;) {
+        if (n <= CAN_FILTERS) {
+            cost = bestSplit(cubes, n, &sel);
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestN = n;
+                bestSel = sel;
+                memcpy(best, cubes, n * sizeof(CanCube));
+            }
+        }
+        if (n <= types)
+            break;
+        mi = 0;
+        mj = 0;
+        minCost = 0xFFFFFFFFUL;
+        for (i = 0; i < n; i++) {
+            for (j = i + 1; j < n; j++) {
+                if (cubes[i].ext != cubes[j].ext)
+                    continue;
+                merged.ext = cubes[i].ext;
+                merged.mask = cubes[i].mask & cubes[j].mask & ~(cubes[i].value ^ cubes[j].value);
+                cost = cubeCost(merged, CAN_EXT_ID_MASK);
+                if (cost < minCost) {
+                    minCost = cost;
+                    mi = i;
+                    mj = j;
+                }
+            }
+        }
+        cubes[mi].mask &= cubes[mj].mask & ~(cubes[mi].value ^ cubes[mj].value);
+        cubes[mi].value &= cubes[mi].mask;
+        cubes[mj] = cubes[--n];
+    }
+
+    // RXB0 gets the bestSel cubes, RXB1 the others; spare filters repeat
+    // the first cube of their buffer, RXB1 copies RXB0 if it has none
+    cnt[0] = 0;
+    cnt[1] = 0;
+    for (i = 0; i < bestN; i++) {
+        j = ((bestSel >> i) & 1) ? 0 : 1;
+        idx[j][cnt[j]++] = i;
+    }
+    copy = (cnt[1] == 0);
+    if (copy) {
+        memcpy(idx[1], idx[0], cnt[0]);
+        cnt[1] = cnt[0];
+    }
+    for (b = 0; b < 2; b++) {
+        masks = groupMask(best, bestN, ((b == 0) || copy) ? bestSel : ((1 << bestN) - 1) & ~bestSel);
+        encodeId(masks, 0, regs);
+        writeRegs(MCP_REG_RXM0SIDH + 4 * b, regs, 4);
+        for (k = 0; k < ((b == 0) ? CAN_RXB0_FILTERS : CAN_RXB1_FILTERS); k++) {
+            i = idx[b][(k < cnt[b]) ? k : 0];
+            encodeId(best[i].value & masks, best[i].ext, regs);
+            writeRegs(filtAddr[b][k], regs, 4);
+        }
+    }
+    bitModify(MCP_REG_RXB0CTRL, MCP_RXBCTRL_RXM, 0);
+    bitModify(MCP_REG_RXB1CTRL, MCP_RXBCTRL_RXM, 0);
+}
+
+bool CanRx::setOpMode(byte mode)
+{
+    unsigned long start = millis();
+
+    bitModify(MCP_REG_CANCTRL, MCP_OPMODE_MASK, mode);
+    while ((readReg(MCP_REG_CANSTAT) & MCP_OPMODE_MASK) != mode) {
+        if (millis() - start > CAN_RX_MODE_TIMEOUT)
+            return false;
+    }
+    return true;
+}
+
+void CanRx::isr()
+{
+    byte n;
+
+    // frames arriving while serving keep INT low: no new edge
+    for (n = 0; (n < CAN_RX_MAX_ROUNDS) && (digitalRead(instance->intPin) == LOW); n++)
+        instance->service();
+}
+
+void CanRx::service()
+{
+    byte regs[MCP_RXB1_OFFSET + MCP_RXB_REGS];
+    byte intf, eflg, rise, i;
+
+    SPI.beginTransaction(canRxSpi);
+    digitalWrite(csPin, LOW);
+    SPI.transfer(MCP_INSTR_READ);
+    SPI.transfer(MCP_REG_CANINTF);
+    intf = SPI.transfer(0);
+    eflg = SPI.transfer(0);
+    digitalWrite(csPin, HIGH);
+
+    if ((intf & (MCP_RX0IF | MCP_RX1IF)) == (MCP_RX0IF | MCP_RX1IF)) {
+        // both buffers full: one sequential read RXB0SIDH..RXB1D7,
+        // then release both (nothing can be loaded while they are full)
+        digitalWrite(csPin, LOW);
+        SPI.transfer(MCP_INSTR_READ);
+        SPI.transfer(MCP_REG_RXB0SIDH);
+        for (i = 0; i < sizeof(regs); i++)
+            regs[i] = SPI.transfer(0);
+        digitalWrite(csPin, HIGH);
+        bitModify(MCP_REG_CANINTF, MCP_RX0IF | MCP_RX1IF, 0);
+        push(regs);
+        push(regs + MCP_RXB1_OFFSET);
+        counters.bursts++;
+    } else if (intf & (MCP_RX0IF | MCP_RX1IF)) {
+        digitalWrite(csPin, LOW);
+        SPI.transfer((intf & MCP_RX0IF) ? MCP_INSTR_READ_RX0 : MCP_INSTR_READ_RX1);
+        for (i = 0; i < MCP_RXB_REGS; i++)
+            regs[i] = SPI.transfer(0);
+        digitalWrite(csPin, HIGH);
+        push(regs);
+    }
+
+    if (intf & MCP_ERRIF) {
+        if (eflg & (CAN_EFLG_RX0OVR | CAN_EFLG_RX1OVR)) {
+            counters.hwOverflows += ((eflg & CAN_EFLG_RX0OVR) ? 1 : 0) + ((eflg & CAN_EFLG_RX1OVR) ? 1 : 0);
+            bitModify(MCP_REG_EFLG, CAN_EFLG_RX0OVR | CAN_EFLG_RX1OVR, 0);
+        }
+        rise = eflg & ~lastEflg;
+        if (rise & CAN_EFLG_EWARN)
+            counters.errWarnings++;
+        if (rise & (CAN_EFLG_RXEP | CAN_EFLG_TXEP))
+            counters.errPassive++;
+        if (rise & CAN_EFLG_TXBO)
+            counters.busOff++;
+        lastEflg = eflg & ~(CAN_EFLG_RX0OVR | CAN_EFLG_RX1OVR);
+        bitModify(MCP_REG_CANINTF, MCP_ERRIF, 0);
+    }
+    SPI.endTransaction();
+}
+
+void CanRx::push(const byte *regs)
+{
+    byte next = (head + 1) & (CAN_RX_FIFO_SIZE - 1);
+    CanFrame *f;
+
+    if (next == tail) {
+        counters.fifoDrops++;
+        return;
+    }
+    f = &fifo[head];
+    if (regs[1] & MCP_SIDL_IDE) {
+        f->id = ((unsigned long)regs[0] << 21) | ((unsigned long)(regs[1] & 0xE0) << 13)
+              | ((unsigned long)(regs[1] & 0x03) << 16) | ((unsigned long)regs[2] << 8) | regs[3];
+        f->ext = 1;
+        f->rtr = (regs[4] & MCP_DLC_RTR) ? 1 : 0;
+    } else {
+        f->id = ((unsigned long)regs[0] << 3) | (regs[1] >> 5);
+        f->ext = 0;
+        f->rtr = (regs[1] & MCP_SIDL_SRR) ? 1 : 0;
+    }
+    f->len = regs[4] & 0x0F;
+    if (f->len > 8)
+        f->len = 8;
+    memcpy(f->data, regs + 5, f->len);
+    f->stamp = micros();
+    head = next;
+    counters.frames++;
+}
+
+byte CanRx::readReg(byte addr)
+{
+    byte v;
+
+    digitalWrite(csPin, LOW);
+    SPI.transfer(MCP_INSTR_READ);
+    SPI.transfer(addr);
+    v = SPI.transfer(0);
+    digitalWrite(csPin, HIGH);
+    return v;
+}
+
+void CanRx::writeRegs(byte addr, const byte *data, byte len)
+{
+    digitalWrite(csPin, LOW);
+    SPI.transfer(MCP_INSTR_WRITE);
+    SPI.transfer(addr);
+    while (len--)
+        SPI.transfer(*data++);
+    digitalWrite(csPin, HIGH);
+}
+
+void CanRx::bitModify(byte addr, byte mask, byte value)
+{
+    digitalWrite(csPin, LOW);
+    SPI.transfer(MCP_INSTR_BITMOD);
+    SPI.transfer(addr);
+    SPI.transfer(mask);
+    SPI.transfer(value);
+    digitalWrite(csPin, HIGH);
+}
+
+bool CanRx::read(CanFrame &frame)
+{
+    byte t = tail;
+
+    if (t == head)
+        return false;
+    frame = fifo[t];
+    tail = (t + 1) & (CAN_RX_FIFO_SIZE - 1);
+    return true;
+}
+
+byte CanRx::available() const
+{
+    return (head - tail) & (CAN_RX_FIFO_SIZE - 1);
+}
+
+void CanRx::onReceive(CanRxHandler handler)
+{
+    this->handler = handler;
+}
+
+void CanRx::process()
+{
+    CanFrame frame;
+
+    // INT low with no interrupt pending: an edge was missed (service
+    // rounds exhausted, or frames waiting since before begin())
+    if (digitalRead(intPin) == LOW) {
+        noInterrupts();
+        service();
+        interrupts();
+    }
+    if ((handler != NULL) || subCnt) {
+        while (read(frame))
+            dispatch(frame);
+    }
+}
+
+void CanRx::dispatch(const CanFrame &frame)
+{
+    unsigned long key = subKey(frame.ext, frame.id);
+    bool matched = false;
+    byte lo = 0, hi = exactCnt, mid, i;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (subKey(subs[mid].ext, subs[mid].id) < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    for (; (lo < exactCnt) && (subKey(subs[lo].ext, subs[lo].id) == key); lo++) {
+        subs[lo].handler(frame);
+        matched = true;
+    }
+    for (i = exactCnt; i < subCnt; i++) {
+        if ((subs[i].ext == frame.ext) && (((frame.id ^ subs[i].id) & subs[i].mask) == 0)) {
+            subs[i].handler(frame);
+            matched = true;
+        }
+    }
+    if (!matched) {
+        if (subCnt)
+            counters.unmatched++;
+        if (handler != NULL)
+            handler(frame);
+    }
+}
+
+CanRxStats CanRx::stats() const
+{
+    CanRxStats copy;
+
+    noInterrupts();
+    copy = counters;
+    interrupts();
+    return copy;
+}
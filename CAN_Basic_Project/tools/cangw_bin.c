@@ -0,0 +1,330 @@
+// cangw_bin.c
+// Host side of the CAN_GW_BINARY gateway format (see ../CanGateway.h):
+//
+//   cangw_bin dump <port|file>     decodes device packets, prints them in
+//                                  the candump -L log format (can0)
+//   cangw_bin replay <port> [-n]   sends the frames of a candump -L log read
+//                                  from stdin, spaced as in the log (-n: as
+//                                  fast as the port takes them)
+//
+// A serial port is set to raw 1000000 baud. The stamps printed by dump are
+// the device micros(), which wraps after about 71 minutes.
+//
+// Build: make (plain C99 + POSIX, Linux for the 1000000 baud setting)
+
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// packet flags, as in CanGateway.cpp
+#define GW_BIN_EXT          0x80
+#define GW_BIN_RTR          0x40
+#define GW_BIN_LEN          0x0F
+
+#define CAN_STD_ID_MASK     0x7FFUL
+#define CAN_EXT_ID_MASK     0x1FFFFFFFUL
+
+// longest packet: flags, stamp, extended ID, 8 data bytes, COBS overhead
+#define PACKET_MAX          32
+
+typedef struct {
+    unsigned long id;
+    int ext;
+    int rtr;
+    int len;
+    uint8_t data[8];
+    uint32_t stamp;
+} frame_t;
+
+// COBS: dst gets len + 1 bytes, no 0x00 among them (len < 254)
+static int cobsEncode(const uint8_t *src, int len, uint8_t *dst)
+{
+    int code = 1, codePos = 0, n = 1, i;
+
+    for (i = 0; i < len; i++) {
+        if (src[i] == 0) {
+            dst[codePos] = code;
+            codePos = n++;
+            code = 1;
+        } else {
+            dst[n++] = src[i];
+            code++;
+        }
+    }
+    dst[codePos] = code;
+    return n;
+}
+
+// returns the decoded length, -1 if malformed
+static int cobsDecode(const uint8_t *src, int len, uint8_t *dst)
+{
+    int i = 0, n = 0, code, j;
+
+    while (i < len) {
+        code = src[i++];
+        if ((code == 0) || ((i + code - 1) > len))
+            return -1;
+        for (j = 1; j < code; j++)
+            dst[n++] = src[i++];
+        if ((code < 0xFF) && (i < len))
+            dst[n++] = 0;
+    }
+    return n;
+}
+
+// device packet: flags, stamp (4), ID (2 or 4), data; 0 if malformed
+static int parseDevicePacket(const uint8_t *raw, int n, frame_t *frame)
+{
+    int idLen, i;
+
+    if (n < 1)
+        return 0;
+    frame->ext = (raw[0] & GW_BIN_EXT) != 0;
+    frame->rtr = (raw[0] & GW_BIN_RTR) != 0;
+    frame->len = raw[0] & GW_BIN_LEN;
+    idLen = frame->ext ? 4 : 2;
+    if ((frame->len > 8) || (n != 1 + 4 + idLen + (frame->rtr ? 0 : frame->len)))
+        return 0;
+    frame->stamp = 0;
+    for (i = 0; i < 4; i++)
+        frame->stamp |= (uint32_t)raw[1 + i] << (8 * i);
+    frame->id = 0;
+    for (i = 0; i < idLen; i++)
+        frame->id |= (unsigned long)raw[5 + i] << (8 * i);
+    if (frame->id > (frame->ext ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK))
+        return 0;
+    if (!frame->rtr)
+        memcpy(frame->data, raw + 5 + idLen, frame->len);
+    return 1;
+}
+
+// host packet: flags, ID (2 or 4), data, COBS encoded and 0x00 terminated
+static int encodeHostPacket(const frame_t *frame, uint8_t *out)
+{
+    uint8_t raw[1 + 4 + 8];
+    int m = 0, n, i;
+
+    raw[m++] = (frame->ext ? GW_BIN_EXT : 0) | (frame->rtr ? GW_BIN_RTR : 0) | frame->len;
+    for (i = 0; i < (frame->ext ? 4 : 2); i++)
+        raw[m++] = frame->id >> (8 * i);
+    if (!frame->rtr) {
+        memcpy(raw + m, frame->data, frame->len);
+        m += frame->len;
+    }
+    n = cobsEncode(raw, m, out);
+    out[n++] = 0;
+    return n;
+}
+
+static void printFrame(const frame_t *frame)
+{
+    int i;
+
+    printf("(%lu.%06lu) can0 ", (unsigned long)(frame->stamp / 1000000U),
+           (unsigned long)(frame->stamp % 1000000U));
+    printf(frame->ext ? "%08lX#" : "%03lX#", frame->id);
+    if (frame->rtr) {
+        printf("R");
+        if (frame->len)
+            printf("%d", frame->len);
+    } else {
+        for (i = 0; i < frame->len; i++)
+            printf("%02X", frame->data[i]);
+    }
+    printf("\n");
+}
+
+static int hexValue(char c)
+{
+    if ((c >= '0') && (c <= '9'))
+        return c - '0';
+    if ((c >= 'A') && (c <= 'F'))
+        return c - 'A' + 10;
+    if ((c >= 'a') && (c <= 'f'))
+        return c - 'a' + 10;
+    return -1;
+}
+
+// candump -L line: "(sec.usec) iface ID#data", "ID#R[len]"; the timestamp
+// and the interface are optional. Returns 1 if a frame was parsed.
+static int parseLogLine(const char *line, frame_t *frame, double *t, int *hasTime)
+{
+    const char *p = line, *hash, *id;
+    char *end;
+    int idDigits, i, hi, lo;
+
+    *hasTime = 0;
+    while (*p == ' ')
+        p++;
+    if (*p == '(') {
+        *t = strtod(p + 1, &end);
+        if (*end != ')')
+            return 0;
+        *hasTime = 1;
+        p = end + 1;
+    }
+    hash = strchr(p, '#');
+    if (hash == NULL)
+        return 0;
+    // the ID is the token before '#'
+    for (id = hash; (id > p) && (id[-1] != ' '); id--)
+        ;
+    p = id;
+    idDigits = hash - p;
+    if ((idDigits != 3) && (idDigits != 8))
+        return 0;
+    frame->id = strtoul(p, &end, 16);
+    if (end != hash)
+        return 0;
+    frame->ext = (idDigits == 8);
+    if (frame->id > (frame->ext ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK))
+        return 0;
+    p = hash + 1;
+    frame->rtr = (*p == 'R');
+    frame->len = 0;
+    if (frame->rtr) {
+        if ((p[1] >= '0') && (p[1] <= '8'))
+            frame->len = p[1] - '0';
+        return 1;
+    }
+    for (i = 0; i < 8; i++) {
+        hi = hexValue(p[0]);
+        lo = (hi < 0) ? -1 : hexValue(p[1]);
+        if (lo < 0)
+            break;
+        frame->data[i] = (hi << 4) | lo;
+        p += 2;
+        frame->len++;
+    }
+    return (*p == '\0') || (*p == '\n') || (*p == '\r') || (*p == ' ');
+}
+
+static int openPort(const char *path, int flags)
+{
+    struct termios tio;
+    int fd = open(path, flags | O_NOCTTY, 0644);
+
+    if (fd < 0) {
+        fprintf(stderr, "cangw_bin: %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (isatty(fd)) {
+#ifdef B1000000
+        tcgetattr(fd, &tio);
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, B1000000);
+        cfsetospeed(&tio, B1000000);
+        tcsetattr(fd, TCSANOW, &tio);
+#else
+        fprintf(stderr, "cangw_bin: 1000000 baud not supported on this host\n");
+        close(fd);
+        return -1;
+#endif
+    }
+    return fd;
+}
+
+static int dump(const char *path)
+{
+    uint8_t buf[256], packet[PACKET_MAX], raw[PACKET_MAX];
+    unsigned long frames = 0, bad = 0;
+    int fd = openPort(path, O_RDONLY);
+    int len = 0, overflow = 0, n, i;
+    frame_t frame;
+    ssize_t got;
+
+    if (fd < 0)
+        return 1;
+    while ((got = read(fd, buf, sizeof(buf))) > 0) {
+        for (i = 0; i < got; i++) {
+            if (buf[i] != 0) {
+                if (len < PACKET_MAX)
+                    packet[len++] = buf[i];
+                else
+                    overflow = 1;
+                continue;
+            }
+            // the first packet after opening the port may be cut
+            if (len || overflow) {
+                n = overflow ? -1 : cobsDecode(packet, len, raw);
+                if ((n > 0) && parseDevicePacket(raw, n, &frame)) {
+                    printFrame(&frame);
+                    frames++;
+                } else {
+                    bad++;
+                }
+            }
+            len = 0;
+            overflow = 0;
+        }
+        fflush(stdout);
+    }
+    close(fd);
+    fprintf(stderr, "cangw_bin: %lu frames, %lu malformed packets\n", frames, bad);
+    return 0;
+}
+
+static int replay(const char *path, int paced)
+{
+    char line[256];
+    uint8_t out[PACKET_MAX];
+    unsigned long frames = 0, bad = 0;
+    int fd = openPort(path, O_WRONLY | O_CREAT | O_TRUNC);
+    double t = 0, t0 = 0, start = 0, delay;
+    struct timespec now, wait;
+    int hasTime, first = 1, n;
+    frame_t frame;
+
+    if (fd < 0)
+        return 1;
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        if (!parseLogLine(line, &frame, &t, &hasTime)) {
+            bad++;
+            continue;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (first) {
+            t0 = t;
+            start = now.tv_sec + now.tv_nsec * 1e-9;
+            first = 0;
+        } else if (paced && hasTime) {
+            // wait for the time of the frame relative to the first one
+            delay = (t - t0) - ((now.tv_sec + now.tv_nsec * 1e-9) - start);
+            if (delay > 0) {
+                wait.tv_sec = (time_t)delay;
+                wait.tv_nsec = (long)((delay - wait.tv_sec) * 1e9);
+                nanosleep(&wait, NULL);
+            }
+        }
+        n = encodeHostPacket(&frame, out);
+        if (write(fd, out, n) != n) {
+            fprintf(stderr, "cangw_bin: %s: %s\n", path, strerror(errno));
+            close(fd);
+            return 1;
+        }
+        frames++;
+    }
+    close(fd);
+    fprintf(stderr, "cangw_bin: %lu frames sent, %lu lines skipped\n", frames, bad);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if ((argc == 3) && (strcmp(argv[1], "dump") == 0))
+        return dump(argv[2]);
+    if (((argc == 3) || ((argc == 4) && (strcmp(argv[3], "-n") == 0)))
+            && (strcmp(argv[1], "replay") == 0))
+        return replay(argv[2], argc == 3);
+    fprintf(stderr, "usage: cangw_bin dump <port|file>\n"
+                    "       cangw_bin replay <port> [-n] < candump.log\n");
+    return 2;
+}
@@ -1,11 +1,42 @@
 #include <SPI.h>
 #include "mcp_can.h"
+#include "CanRx.h"
 
 const int spiCSPin = 10;  // SPI Chip Select pin for MCP2515
+const int canIntPin = 3;  // MCP2515 INT pin (D2 drives the LED)
 const int ledPin = 2;     // Pin connected to LED
+const unsigned long ledCanId = 0x100;  // ID of the LED command frames
 boolean ledON = false;    // LED state
 
 MCP_CAN CAN(spiCSPin);
+CanRx canRx(spiCSPin, canIntPin);  // frames read on INT, handled in loop()
+
+// Called from loop() for every LED command frame
+void onLedFrame(const CanFrame &frame) {
+    // Print CAN message details
+    Serial.println("-----------------------------");
+    Serial.print("Data from ID: 0x");
+    Serial.println(frame.id, HEX);
+
+    // Print received data
+    Serial.print("Data: ");
+    for (int i = 0; i < frame.len; i++) {
+        Serial.print(frame.data[i], HEX);  // Print data as hex
+        Serial.print("\t");
+    }
+    Serial.println();
+
+    // Control LED based on received data
+    if (frame.len > 0) {  // Check if there is at least one byte of data
+        if (frame.data[0] == 1) {  // Assuming the first byte is used to toggle LED
+            digitalWrite(ledPin, HIGH);  // Turn LED on
+            ledON = true;
+        } else if (frame.data[0] == 0) {
+            digitalWrite(ledPin, LOW);  // Turn LED off
+            ledON = false;
+        }
+    }
+}
 
 void setup() {
     Serial.begin(115200);  // Initialize serial communication at 115200 baud
@@ -18,40 +49,16 @@ void setup() {
         Serial.println("CAN BUS Init Failed");
         while (1);  // Stay here if initialization failed
     }
+    CAN.setMode(MCP_NORMAL);  // begin() leaves the controller in loopback mode
+
+    // Only LED frames pass the MCP2515 filters
+    canRx.subscribe(ledCanId, 0, onLedFrame);
+    if (!canRx.begin()) {
+        Serial.println("CAN filter setup Failed");
+    }
 }
 
 void loop() {
-    unsigned char len = 0;
-    unsigned char buf[8];
-    unsigned long canId;
-
-    // Check if a new CAN message is available
-    if (CAN.checkReceive() == CAN_MSGAVAIL) {
-        // Read message from the buffer
-        CAN.readMsgBuf(&canId, &len, buf);
-
-        // Print CAN message details
-        Serial.println("-----------------------------");
-        Serial.print("Data from ID: 0x");
-        Serial.println(canId, HEX);
-        
-        // Print received data
-        Serial.print("Data: ");
-        for (int i = 0; i < len; i++) {
-            Serial.print(buf[i], HEX);  // Print data as hex
-            Serial.print("\t");
-        }
-        Serial.println();
-
-        // Control LED based on received data
-        if (len > 0) {  // Check if there is at least one byte of data
-            if (buf[0] == 1) {  // Assuming the first byte is used to toggle LED
-                digitalWrite(ledPin, HIGH);  // Turn LED on
-                ledON = true;
-            } else if (buf[0] == 0) {
-                digitalWrite(ledPin, LOW);  // Turn LED off
-                ledON = false;
-            }
-        }
-    }
+    // Handle the frames buffered since last call
+    canRx.process();
 }
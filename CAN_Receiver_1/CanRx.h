@@ -0,0 +1,141 @@
+// CanRx.h
+// Interrupt driven MCP2515 receiver.
+//
+// The MCP2515 INT pin (active low) triggers a service routine which reads
+// CANINTF and EFLG, drains the RX buffers (both of them in one SPI burst when
+// both are full) and pushes timestamped frames into a software FIFO.
+// The main loop takes frames from the FIFO, or lets process() hand them to
+// the handler set with onReceive(), at its own pace: the RX buffers are
+// emptied within microseconds of a frame arriving, whatever loop() is doing.
+//
+// Usage:
+//     MCP_CAN CAN(spiCSPin);
+//     CanRx canRx(spiCSPin, canIntPin);
+//
+//     setup():  CAN.begin(...); CAN.setMode(MCP_NORMAL);
+//               canRx.onReceive(handler);
+//               canRx.begin();
+//     loop():   canRx.process();
+//
+// Subscriptions (before begin()):
+//     canRx.subscribe(0x100, 0, onLed);                   one standard ID
+//     canRx.subscribe(0x18FF0000, 0x1FFF0000, 1, onPgn);  extended ID/mask pair
+// begin() then programs the MCP2515 masks and filters with the tightest
+// cover of the subscribed IDs it finds (2 masks, 6 filters), so most
+// unwanted frames never raise INT. The cover may let a few more IDs in:
+// process() passes each frame to every matching subscription and only
+// unmatched ones to the onReceive() handler. Without subscriptions every
+// frame is received and given to onReceive().
+//
+// INT must be wired to a pin with an external interrupt (D2 or D3 on an Uno).
+// Only this class reads received frames: don't call CAN.checkReceive() or
+// CAN.readMsgBuf() once begin() has been called.
+
+#ifndef CAN_RX_H
+#define CAN_RX_H
+
+#include <Arduino.h>
+
+// frames buffered between two process() calls (power of 2, up to 128)
+#define CAN_RX_FIFO_SIZE    16
+// subscriptions
+#define CAN_RX_MAX_SUBS     12
+
+#define CAN_STD_ID_MASK     0x7FFUL
+#define CAN_EXT_ID_MASK     0x1FFFFFFFUL
+
+// eflg() bits (MCP2515 EFLG)
+#define CAN_EFLG_EWARN      0x01
+#define CAN_EFLG_RXEP       0x08
+#define CAN_EFLG_TXEP       0x10
+#define CAN_EFLG_TXBO       0x20
+#define CAN_EFLG_RX0OVR     0x40
+#define CAN_EFLG_RX1OVR     0x80
+
+struct CanFrame {
+    unsigned long id;       // 11 or 29 bit identifier
+    unsigned long stamp;    // micros() when the frame was taken from the MCP2515
+    byte ext;               // 1: extended (29 bit) identifier
+    byte rtr;               // 1: remote frame (no data)
+    byte len;
+    byte data[8];
+};
+
+struct CanRxStats {
+    unsigned long frames;       // frames pushed into the FIFO
+    unsigned long fifoDrops;    // frames lost: FIFO full (loop too slow)
+    unsigned long hwOverflows;  // frames lost: RX buffers full (EFLG RX0OVR/RX1OVR)
+    unsigned long errWarnings;  // error counters reached 96 (EFLG EWARN)
+    unsigned long errPassive;   // entered error passive (EFLG RXEP/TXEP)
+    unsigned long busOff;       // entered bus off (EFLG TXBO)
+    unsigned long bursts;       // both RX buffers read in one burst
+    unsigned long unmatched;    // frames let in by the filters, no subscription matching
+};
+
+typedef void (*CanRxHandler)(const CanFrame &frame);
+
+struct CanSub {
+    unsigned long id;
+    unsigned long mask;         // 1 bits must match id
+    byte ext;
+    CanRxHandler handler;
+};
+
+class CanRx {
+public:
+    CanRx(byte csPin, byte intPin);
+
+    // call before begin(): handler gets the frames whose ID matches id
+    // on the 1 bits of mask. False if the table is full
+    bool subscribe(unsigned long id, unsigned long mask, byte ext, CanRxHandler handler);
+    bool subscribe(unsigned long id, byte ext, CanRxHandler handler)
+        { return subscribe(id, ext ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK, ext, handler); }
+
+    // call after MCP_CAN::begin(): programs the filters if there are
+    // subscriptions, enables the MCP2515 RX and error interrupts,
+    // RXB0 to RXB1 rollover and the INT pin interrupt.
+    // False if the MCP2515 didn't enter configuration mode
+    bool begin();
+
+    // main loop side: takes the oldest frame, false if the FIFO is empty
+    bool read(CanFrame &frame);
+    byte available() const;
+
+    // main loop side: passes every buffered frame to the handler
+    void onReceive(CanRxHandler handler);
+    void process();
+
+    // copy of the counters (taken with interrupts disabled)
+    CanRxStats stats() const;
+    byte eflg() const { return lastEflg; }
+
+private:
+    static void isr();
+    void service();
+    void push(const byte *regs);
+    void dispatch(const CanFrame &frame);
+    void setFilters();
+    bool setOpMode(byte mode);
+    byte readReg(byte addr);
+    void writeRegs(byte addr, const byte *data, byte len);
+    void bitModify(byte addr, byte mask, byte value);
+
+    static CanRx *instance;
+
+    byte csPin;
+    byte intPin;
+    CanRxHandler handler;
+
+    CanSub subs[CAN_RX_MAX_SUBS];   // after begin(): full mask ones first, sorted
+    byte subCnt;
+    byte exactCnt;                  // subscriptions with full mask
+
+    CanFrame fifo[CAN_RX_FIFO_SIZE];
+    volatile byte head;         // written by the interrupt only
+    volatile byte tail;         // written by the main loop only
+
+    CanRxStats counters;        // written by the interrupt, read with interrupts disabled
+    volatile byte lastEflg;
+};
+
+#endif
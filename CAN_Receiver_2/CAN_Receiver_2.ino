@@ -1,46 +1,125 @@
 #include <mcp_can.h>
 #include <SPI.h>
+#include "CanRx.h"
+#include "bms_can.h"
 
 // Set the SPI chip select pin for the MCP2515 CAN controller
 const int SPI_CS_PIN = 10;
+const int CAN_INT_PIN = 2; // MCP2515 INT pin
 MCP_CAN CAN(SPI_CS_PIN); // Set CS pin for CAN
+CanRx canRx(SPI_CS_PIN, CAN_INT_PIN); // frames read on INT, handled in loop()
+
+// Frames sent by CAN_Sending_2
+const unsigned long STD_ID = 0x12;
+const unsigned long EXT_ID = 0xABCDEF;
+
+// Called from loop() for every subscribed frame
+void onCanFrame(const CanFrame &frame) {
+  // Print the received message
+  Serial.print("Received ");
+  if (frame.rtr) {
+    Serial.print("RTR ");
+  }
+  Serial.print("packet with id 0x");
+  Serial.print(frame.id, HEX);
+  Serial.print(" and length ");
+  Serial.println(frame.len);
+
+  // Only print packet data if it's not an RTR packet
+  if (!frame.rtr) {
+    for (int i = 0; i < frame.len; i++) {
+      Serial.print(frame.data[i], HEX);
+      Serial.print(" ");
+    }
+    Serial.println();
+  }
+}
+
+// Pack state published by the BMS monitor (bms_can.h, same as Sources/)
+bms_can_pack_status_t bmsStatus;
+bms_can_cell_stats_t bmsCellStats;
+unsigned int bmsFrames = 0;     // frames since last report
+unsigned int bmsLowMv = 0;      // lowest cell since last report
+int bmsLowCell = -1;
+unsigned long lastBmsReport = 0;
+
+// Called from loop() for every frame of the BMS message set
+void onBmsFrame(const CanFrame &frame) {
+  if (frame.ext || frame.rtr || frame.len != BMS_CAN_DLC) {
+    return;
+  }
+  bmsFrames++;
+  if (frame.id == BMS_CAN_ID_PACK_STATUS) {
+    bmsCanDecodePackStatus(frame.data, &bmsStatus);
+  } else if (frame.id == BMS_CAN_ID_CELL_STATS) {
+    bmsCanDecodeCellStats(frame.data, &bmsCellStats);
+  } else if (frame.id == BMS_CAN_ID_CELLS) {
+    bms_can_cells_t cells;
+    bmsCanDecodeCells(frame.data, &cells);
+    for (unsigned int i = 0; i < BMS_CAN_CELLS_PER_FRAME; i++) {
+      if (cells.cellMv[i] != BMS_CAN_CELL_NA && (bmsLowCell < 0 || cells.cellMv[i] < bmsLowMv)) {
+        bmsLowMv = cells.cellMv[i];
+        bmsLowCell = cells.mux * BMS_CAN_CELLS_PER_FRAME + i;
+      }
+    }
+  }
+}
+
+// One line per second while the BMS is sending
+void reportBms() {
+  if (millis() - lastBmsReport < 1000) {
+    return;
+  }
+  lastBmsReport = millis();
+  if (bmsFrames == 0) {
+    return;
+  }
+  Serial.print("BMS ");
+  Serial.print(bmsStatus.voltage / 10.0, 1);
+  Serial.print(" V ");
+  Serial.print(bmsStatus.current / 100.0, 2);
+  Serial.print(" A SoC ");
+  Serial.print(bmsStatus.soc / 2.0, 1);
+  Serial.print(" % Tmax ");
+  Serial.print((int)bmsStatus.tempMax);
+  Serial.print(" C cells ");
+  Serial.print(bmsCellStats.minMv);
+  Serial.print("..");
+  Serial.print(bmsCellStats.maxMv);
+  Serial.print(" mV lowest #");
+  Serial.print(bmsLowCell + 1);
+  Serial.print(" faults 0x");
+  Serial.print(bmsStatus.faults, HEX);
+  Serial.print(" frames/s ");
+  Serial.println(bmsFrames);
+  bmsFrames = 0;
+  bmsLowCell = -1;
+}
 
 void setup() {
-  Serial.begin(9600);
+  Serial.begin(115200); // short prints: the BMS sends 850 frames/s
   while (!Serial);
 
   Serial.println("CAN Receiver");
 
   // Start the CAN bus at 500 kbps
-  if (CAN.begin(MCP_ANY, CAN_500KBPS, SPI_CS_PIN) != MCP2515_OK) {
+  if (CAN.begin(MCP_ANY, CAN_500KBPS, MCP_8MHZ) != CAN_OK) {
     Serial.println("Starting CAN failed!");
     while (1);
   }
+  CAN.setMode(MCP_NORMAL); // begin() leaves the controller in loopback mode
+
+  // The MCP2515 filters let only these IDs through
+  canRx.subscribe(STD_ID, 0, onCanFrame);
+  canRx.subscribe(EXT_ID, 1, onCanFrame);
+  canRx.subscribe(BMS_CAN_ID_BASE, BMS_CAN_ID_MASK, 0, onBmsFrame);
+  if (!canRx.begin()) {
+    Serial.println("CAN filter setup failed!");
+  }
 }
 
 void loop() {
-  // Check if a message has been received
-  if (CAN_MSGAVAIL == CAN.checkReceive()) {
-    // Create buffers to hold CAN message data
-    unsigned long canId;
-    unsigned char len = 0;
-    unsigned char buf[8];
-
-    // Read message from the CAN bus
-    CAN.readMsgBuf(&canId, &len, buf);
-
-    // Print the received message
-    Serial.print("Received ");
-    Serial.print("packet with id 0x");
-    Serial.print(canId, HEX);
-    Serial.print(" and length ");
-    Serial.println(len);
-
-    // Only print packet data if it's not an RTR packet
-    for (int i = 0; i < len; i++) {
-      Serial.print(buf[i], HEX);
-      Serial.print(" ");
-    }
-    Serial.println();
-  }
+  // Handle the frames buffered since last call
+  canRx.process();
+  reportBms();
 }
@@ -1,12 +1,19 @@
 #include <mcp_can.h>
 #include <SPI.h>
+#include "CanTx.h"
 
 const int SPI_CS_PIN = 10; // Pin connected to the CS pin of the MCP2515
+const int CAN_INT_PIN = 2; // Pin connected to the INT pin of the MCP2515
 
 MCP_CAN CAN0(SPI_CS_PIN); // Set CS pin for CAN
+CanTx canTx(SPI_CS_PIN, CAN_INT_PIN);
+
+int8_t statusMsg, helloMsg, worldMsg;
+unsigned long lastReport = 0;
+byte reportNext = 3; // next message to report, 3: none
 
 void setup() {
-  Serial.begin(9600);
+  Serial.begin(115200);
   while (!Serial);
 
   Serial.println("CAN Sender");
@@ -18,20 +25,67 @@ void setup() {
     Serial.println("Error initializing CAN bus.");
     while (1);
   }
-}
+  // begin() leaves the MCP2515 in loopback mode
+  CAN0.setMode(MCP_NORMAL);
 
-void loop() {
-  // Sending a standard CAN message
+  // Status frame every 10 ms, highest priority. 0x010 is not used by the
+  // other nodes (0x100 is the LED command of CAN_Receiver_1)
+  byte status[8] = {0};
+  statusMsg = canTx.add(0x010, 0, sizeof(status), status, 10, 0, 3);
+
+  // Standard and extended messages, 1 s apart
   byte data[] = {'h', 'e', 'l', 'l', 'o'};
-  CAN0.sendMsgBuf(0x12, 0, sizeof(data), data);
-  Serial.println("Standard CAN message sent.");
+  helloMsg = canTx.add(0x12, 0, sizeof(data), data, 2000, 0, 1);
+  byte extendedData[] = {'w', 'o', 'r', 'l', 'd'};
+  worldMsg = canTx.add(0xabcdef, 1, sizeof(extendedData), extendedData, 2000, 1000, 1);
 
-  delay(1000);
+  canTx.begin();
+}
 
-  // Sending an extended CAN message
-  byte extendedData[] = {'w', 'o', 'r', 'l', 'd'};
-  CAN0.sendMsgBuf(0xabcdef, 1, sizeof(extendedData), extendedData);
-  Serial.println("Extended CAN message sent.");
+// One line per message, only when it fits in the serial buffer
+void report() {
+  const int8_t msgs[] = {statusMsg, helloMsg, worldMsg};
+  const char *names[] = {"status", "hello", "world"};
 
-  delay(1000);
+  if (reportNext >= 3 || Serial.availableForWrite() < 60)
+    return;
+  CanTxStats s = canTx.stats(msgs[reportNext]);
+  Serial.print(names[reportNext]);
+  Serial.print(": sent ");
+  Serial.print(s.sent);
+  Serial.print(", missed ");
+  Serial.print(s.missed);
+  if (s.aborted) {
+    Serial.print(", aborted ");
+    Serial.print(s.aborted);
+    Serial.print(" (");
+    Serial.print(s.errors);
+    Serial.print(" bus errors)");
+  }
+  if (s.sent) {
+    Serial.print(", latency ");
+    Serial.print(s.minLatency);
+    Serial.print("..");
+    Serial.print(s.maxLatency);
+    Serial.print(" us, jitter ");
+    Serial.print(s.maxLatency - s.minLatency);
+    Serial.print(" us");
+  }
+  Serial.println();
+  reportNext++;
+}
+
+void loop() {
+  // Status payload: uptime in ms
+  unsigned long now = millis();
+  byte status[8] = {(byte)(now >> 24), (byte)(now >> 16), (byte)(now >> 8), (byte)now};
+  canTx.setData(statusMsg, status);
+  canTx.poll();
+
+  // Statistics every 5 s
+  if (now - lastReport >= 5000) {
+    lastReport = now;
+    reportNext = 0;
+  }
+  report();
 }
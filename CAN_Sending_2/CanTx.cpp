@@ -0,0 +1,328 @@
+// CanTx.cpp
+// Periodic MCP2515 transmit scheduler, see CanTx.h
+//
+// The registers are accessed directly over SPI (same settings as the mcp_can
+// library), SPI.usingInterrupt() keeps the library's own transactions from
+// being interrupted by the service routine. Message states move
+// IDLE -> PENDING (poll) -> LOADED (poll or interrupt) -> IDLE (interrupt),
+// or LOADED -> PENDING (poll) when the stale frame is aborted.
+
+#include "CanTx.h"
+#include <SPI.h>
+
+// MCP2515 SPI instructions
+#define MCP_INSTR_WRITE         0x02
+#define MCP_INSTR_READ          0x03
+#define MCP_INSTR_BITMOD        0x05
+#define MCP_INSTR_RTS           0x80    // | 1 << buffer
+
+// MCP2515 registers
+#define MCP_REG_CANINTE         0x2B
+#define MCP_REG_CANINTF         0x2C
+#define MCP_REG_TXB0CTRL        0x30    // TXB1CTRL 0x40, TXB2CTRL 0x50
+
+// CANINTE / CANINTF bits
+#define MCP_TX0IF               0x04    // TX1IF 0x08, TX2IF 0x10
+#define MCP_TXIF_ALL            0x1C
+#define MCP_MERRF               0x80    // message error
+
+// TXBnCTRL bits
+#define MCP_TXB_TXERR           0x10    // bus error while transmitting
+#define MCP_TXB_TXREQ           0x08    // transmission pending
+
+#define MCP_SIDL_EXIDE          0x08    // extended identifier
+#define MCP_TXB_REGS            14      // CTRL, SIDH, SIDL, EID8, EID0, DLC, D0..D7
+#define MCP_TXB_OFFSET          0x10    // TXB1CTRL - TXB0CTRL
+
+#define CAN_TX_BUFFERS          3
+// service rounds per interrupt while INT stays low
+#define CAN_TX_MAX_ROUNDS       4
+
+enum {
+    MSG_IDLE,
+    MSG_PENDING,    // released, waiting for a TX buffer
+    MSG_LOADED      // in a TX buffer
+};
+
+static const SPISettings canTxSpi(10000000, MSBFIRST, SPI_MODE0);
+
+CanTx *CanTx::instance = NULL;
+
+CanTx::CanTx(byte csPin, byte intPin)
+    : csPin(csPin), intPin(intPin), started(false), msgCnt(0)
+{
+    byte i;
+
+    for (i = 0; i < CAN_TX_BUFFERS; i++)
+        bufMsg[i] = -1;
+}
+
+int8_t CanTx::add(unsigned long id, byte ext, byte len, const byte *data,
+                  unsigned int period, unsigned int offset, byte priority)
+{
+    Msg *m;
+
+    if ((msgCnt >= CAN_TX_MAX_MSGS) || (len > 8) || (period == 0) || (priority > 3)
+            || (id > (ext ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK)))
+        return -1;
+    m = &msgs[msgCnt];
+    m->id = id;
+    m->ext = ext ? 1 : 0;
+    m->len = len;
+    m->priority = priority;
+    m->state = MSG_IDLE;
+    m->period = period * 1000UL;
+    // relative until begin()
+    m->nextDue = offset * 1000UL + (started ? micros() : 0);
+    memcpy(m->data, data, len);
+    memset(&m->counters, 0, sizeof(m->counters));
+    m->counters.minLatency = 0xFFFFFFFFUL;
+    return msgCnt++;
+}
+
+void CanTx::setData(int8_t msg, const byte *data)
+{
+    if ((msg < 0) || (msg >= msgCnt))
+        return;
+    noInterrupts();
+    memcpy(msgs[msg].data, data, msgs[msg].len);
+    interrupts();
+}
+
+void CanTx::begin()
+{
+    unsigned long now;
+    byte i;
+
+    instance = this;
+    pinMode(intPin, INPUT_PULLUP);
+
+    SPI.beginTransaction(canTxSpi);
+    bitModify(MCP_REG_CANINTE, 0xFF, MCP_TXIF_ALL);
+    bitModify(MCP_REG_CANINTF, MCP_TXIF_ALL, 0);
+    SPI.endTransaction();
+
+    now = micros();
+    for (i = 0; i < msgCnt; i++)
+        msgs[i].nextDue += now;
+    started = true;
+
+    SPI.usingInterrupt(digitalPinToInterrupt(intPin));
+    attachInterrupt(digitalPinToInterrupt(intPin), isr, FALLING);
+}
+
+void CanTx::poll()
+{
+    unsigned long now = micros();
+    Msg *m;
+    byte i;
+
+    if (!started)
+        return;
+    for (i = 0; i < msgCnt; i++) {
+        m = &msgs[i];
+        noInterrupts();
+        // catch up after a long loop(): one release, the rest missed
+        while ((long)(now - m->nextDue) >= 0) {
+            if ((m->state == MSG_IDLE) || ((m->state == MSG_LOADED) && abort(i))) {
+                m->state = MSG_PENDING;
+                m->release = m->nextDue;
+            } else {
+                m->counters.missed++;
+            }
+            m->nextDue += m->period;
+        }
+        interrupts();
+    }
+
+    noInterrupts();
+    // INT low with no interrupt pending: an edge was missed
+    if (digitalRead(intPin) == LOW)
+        service();
+    if (nextPending() >= 0) {
+        SPI.beginTransaction(canTxSpi);
+        for (i = 0; i < CAN_TX_BUFFERS; i++) {
+            if (bufMsg[i] < 0)
+                fill(i);
+        }
+        SPI.endTransaction();
+    }
+    interrupts();
+}
+
+CanTxStats CanTx::stats(int8_t msg) const
+{
+    CanTxStats s;
+
+    memset(&s, 0, sizeof(s));
+    if ((msg < 0) || (msg >= msgCnt))
+        return s;
+    noInterrupts();
+    s = msgs[msg].counters;
+    interrupts();
+    return s;
+}
+
+void CanTx::resetStats(int8_t msg)
+{
+    if ((msg < 0) || (msg >= msgCnt))
+        return;
+    noInterrupts();
+    memset(&msgs[msg].counters, 0, sizeof(msgs[msg].counters));
+    msgs[msg].counters.minLatency = 0xFFFFFFFFUL;
+    interrupts();
+}
+
+void CanTx::isr()
+{
+    byte n;
+
+    // a buffer completing while serving keeps INT low: no new edge
+    for (n = 0; (n < CAN_TX_MAX_ROUNDS) && (digitalRead(instance->intPin) == LOW); n++)
+        instance->service();
+}
+
+void CanTx::service()
+{
+    unsigned long now, latency;
+    CanTxStats *c;
+    byte intf, i;
+
+    SPI.beginTransaction(canTxSpi);
+    intf = readReg(MCP_REG_CANINTF);
+    now = micros();
+
+    for (i = 0; i < CAN_TX_BUFFERS; i++) {
+        if (!(intf & (MCP_TX0IF << i)))
+            continue;
+        bitModify(MCP_REG_CANINTF, MCP_TX0IF << i, 0);
+        if (bufMsg[i] >= 0) {
+            c = &msgs[bufMsg[i]].counters;
+            latency = now - msgs[bufMsg[i]].release;
+            if (latency < c->minLatency)
+                c->minLatency = latency;
+            if (latency > c->maxLatency)
+                c->maxLatency = latency;
+            c->sent++;
+            msgs[bufMsg[i]].state = MSG_IDLE;
+            bufMsg[i] = -1;
+        }
+        fill(i);
+    }
+    SPI.endTransaction();
+}
+
+// loads the most urgent pending message into a free buffer.
+// Interrupts disabled, inside an SPI transaction
+void CanTx::fill(byte buf)
+{
+    int8_t msg = nextPending();
+
+    if (msg >= 0)
+        load(buf, msg);
+}
+
+// highest priority, then oldest release
+int8_t CanTx::nextPending()
+{
+    int8_t best = -1;
+    byte i;
+
+    for (i = 0; i < msgCnt; i++) {
+        if (msgs[i].state != MSG_PENDING)
+            continue;
+        if ((best < 0) || (msgs[i].priority > msgs[best].priority)
+                || ((msgs[i].priority == msgs[best].priority)
+                    && ((long)(msgs[i].release - msgs[best].release) < 0)))
+            best = i;
+    }
+    return best;
+}
+
+void CanTx::load(byte buf, int8_t msg)
+{
+    Msg *m = &msgs[msg];
+    byte regs[MCP_TXB_REGS];
+    byte i;
+
+    regs[0] = m->priority;                                  // TXP
+    if (m->ext) {
+        regs[1] = m->id >> 21;                              // SIDH
+        regs[2] = ((m->id >> 13) & 0xE0) | MCP_SIDL_EXIDE | ((m->id >> 16) & 0x03);
+        regs[3] = m->id >> 8;                               // EID8
+        regs[4] = m->id;                                    // EID0
+    } else {
+        regs[1] = m->id >> 3;
+        regs[2] = (m->id & 0x07) << 5;
+        regs[3] = 0;
+        regs[4] = 0;
+    }
+    regs[5] = m->len;                                       // DLC
+    memcpy(regs + 6, m->data, m->len);
+
+    digitalWrite(csPin, LOW);
+    SPI.transfer(MCP_INSTR_WRITE);
+    SPI.transfer(MCP_REG_TXB0CTRL + buf * MCP_TXB_OFFSET);
+    for (i = 0; i < 6 + m->len; i++)
+        SPI.transfer(regs[i]);
+    digitalWrite(csPin, HIGH);
+
+    digitalWrite(csPin, LOW);
+    SPI.transfer(MCP_INSTR_RTS | (1 << buf));
+    digitalWrite(csPin, HIGH);
+
+    m->state = MSG_LOADED;
+    bufMsg[buf] = msg;
+}
+
+// frees the TX buffer of a message whose frame was not sent before its next
+// instance became due. Interrupts disabled. False if the frame is on the wire
+// or completed meanwhile: the TX interrupt takes care of it
+bool CanTx::abort(int8_t msg)
+{
+    CanTxStats *c = &msgs[msg].counters;
+    byte buf, ctrl, intf;
+
+    for (buf = 0; (buf < CAN_TX_BUFFERS) && (bufMsg[buf] != msg); buf++)
+        ;
+    if (buf >= CAN_TX_BUFFERS)
+        return false;
+
+    SPI.beginTransaction(canTxSpi);
+    bitModify(MCP_REG_TXB0CTRL + buf * MCP_TXB_OFFSET, MCP_TXB_TXREQ, 0);
+    ctrl = readReg(MCP_REG_TXB0CTRL + buf * MCP_TXB_OFFSET);
+    intf = readReg(MCP_REG_CANINTF);
+    if (intf & MCP_MERRF)
+        bitModify(MCP_REG_CANINTF, MCP_MERRF, 0);
+    SPI.endTransaction();
+
+    if ((ctrl & MCP_TXB_TXREQ) || (intf & (MCP_TX0IF << buf)))
+        return false;
+    if (ctrl & MCP_TXB_TXERR)
+        c->errors++;
+    c->aborted++;
+    bufMsg[buf] = -1;
+    return true;
+}
+
+byte CanTx::readReg(byte addr)
+{
+    byte value;
+
+    digitalWrite(csPin, LOW);
+    SPI.transfer(MCP_INSTR_READ);
+    SPI.transfer(addr);
+    value = SPI.transfer(0);
+    digitalWrite(csPin, HIGH);
+    return value;
+}
+
+void CanTx::bitModify(byte addr, byte mask, byte value)
+{
+    digitalWrite(csPin, LOW);
+    SPI.transfer(MCP_INSTR_BITMOD);
+    SPI.transfer(addr);
+    SPI.transfer(mask);
+    SPI.transfer(value);
+    digitalWrite(csPin, HIGH);
+}
@@ -0,0 +1,123 @@
+// CanTx.h
+// Periodic MCP2515 transmit scheduler.
+//
+// Messages are registered with a period and an offset. poll(), called from
+// the main loop, releases the messages that are due; a released message is
+// loaded at once into a free TX buffer, otherwise it waits until the
+// TX-complete interrupt of one of the three buffers loads the most urgent
+// waiting message (highest priority, then oldest release) into it.
+// Nothing waits for a frame to go out: loop() keeps doing sensor work and
+// only has to call poll() more often than the shortest period.
+//
+// Priorities 0..3 (3 highest) are also written to TXBnCTRL.TXP, so among
+// loaded buffers the MCP2515 starts the most important one first; bus
+// arbitration is still decided by the IDs.
+//
+// Each message keeps its latency statistics: time from the scheduled
+// release to the TX-complete interrupt (min, max: jitter is max - min), and
+// missed deadlines, instances not sent because the previous one was still
+// waiting for a TX buffer when the next became due.
+//
+// A frame that never completes (no ACK with a single node on the bus, error
+// passive, bus off) would keep its TX buffer forever, the MCP2515 retries it
+// on its own. When the next instance of a message is due while the previous
+// one is still in a buffer, poll() aborts that buffer (clears TXREQ) and
+// releases the new instance; aborts and the aborted frames which saw a bus
+// error (TXERR) are counted. A frame already on the wire can't be aborted,
+// its instance is counted as missed. MERRF is not enabled as an interrupt:
+// without an ACK it would fire on every retransmission.
+//
+// Usage:
+//     MCP_CAN CAN(spiCSPin);
+//     CanTx canTx(spiCSPin, canIntPin);
+//
+//     setup():  CAN.begin(...); CAN.setMode(MCP_NORMAL);
+//               status = canTx.add(0x010, 0, 8, data, 10, 0, 3);    every 10 ms
+//               canTx.begin();
+//     loop():   canTx.setData(status, data); canTx.poll();
+//
+// INT must be wired to a pin with an external interrupt (D2 or D3 on an Uno).
+// begin() takes over CANINTE (TX interrupts only) and the three TX buffers:
+// don't call CAN.sendMsgBuf() afterwards, and don't use CanRx on the same
+// INT pin.
+
+#ifndef CAN_TX_H
+#define CAN_TX_H
+
+#include <Arduino.h>
+
+// registered messages
+#define CAN_TX_MAX_MSGS     8
+
+#define CAN_STD_ID_MASK     0x7FFUL
+#define CAN_EXT_ID_MASK     0x1FFFFFFFUL
+
+struct CanTxStats {
+    unsigned long sent;         // instances transmitted (TX-complete)
+    unsigned long missed;       // instances skipped: previous one not sent yet
+    unsigned long aborted;      // stale frames aborted in their TX buffer
+    unsigned long errors;       // aborted frames with a bus error (TXERR)
+    unsigned long minLatency;   // us from scheduled release to TX-complete
+    unsigned long maxLatency;
+};
+
+class CanTx {
+public:
+    CanTx(byte csPin, byte intPin);
+
+    // registers a message sent every period ms, first offset ms after
+    // begin() (or after add() once started). Returns its handle, -1 if
+    // the table is full or the parameters are invalid
+    int8_t add(unsigned long id, byte ext, byte len, const byte *data,
+               unsigned int period, unsigned int offset, byte priority);
+
+    // payload of the next instances (len bytes as registered)
+    void setData(int8_t msg, const byte *data);
+
+    // call after MCP_CAN::begin(): enables the TX interrupts and the INT
+    // pin interrupt, starts the schedule
+    void begin();
+
+    // main loop side: releases due messages, aborts stale TX buffers, fills
+    // free TX buffers
+    void poll();
+
+    // copy of the counters (taken with interrupts disabled)
+    CanTxStats stats(int8_t msg) const;
+    void resetStats(int8_t msg);
+
+private:
+    struct Msg {
+        unsigned long id;
+        unsigned long period;       // us
+        unsigned long nextDue;      // micros() of the next release
+        unsigned long release;      // scheduled release of the instance in flight
+        byte ext;
+        byte len;
+        byte priority;
+        byte state;
+        byte data[8];
+        CanTxStats counters;
+    };
+
+    static void isr();
+    void service();
+    void fill(byte buf);
+    int8_t nextPending();
+    void load(byte buf, int8_t msg);
+    bool abort(int8_t msg);
+    byte readReg(byte addr);
+    void bitModify(byte addr, byte mask, byte value);
+
+    static CanTx *instance;
+
+    byte csPin;
+    byte intPin;
+    bool started;
+
+    Msg msgs[CAN_TX_MAX_MSGS];      // state written with interrupts disabled
+    byte msgCnt;
+    int8_t bufMsg[3];               // message in each TX buffer, -1: free
+};
+
+#endif
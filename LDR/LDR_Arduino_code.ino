@@ -1,17 +1,28 @@
 #include <Adafruit_NeoPixel.h>
+#include "NeoCompositor.h"
+#include "RcInput.h"
 
 //User-defined MACROS
 #define NEO_LED_PIN           2
 #define NUM_PIXELS            2
 #define LDRPIN                A0
 #define PWM_PIN               3
+#define PRINT_PERIOD          500   //ms between value prints
 
 int LDRValue = 0;
 double pulse_var;
+unsigned long last_print = 0;
 
 //LED objects
 Adafruit_NeoPixel white=  Adafruit_NeoPixel(NUM_PIXELS,  NEO_LED_PIN, NEO_GRB + NEO_KHZ800);
 
+//Strip colour, show() only when it changed
+NeoCompositor leds(50);
+int8_t whiteStrip;
+
+//RC receiver channel on PWM_PIN, decoded by the pin interrupt
+RcInput rc;
+
 
 //Private function prototypes
 void white_led_strip_on(void);
@@ -22,19 +33,24 @@ int readLDRvalue(void);
 void setup() {
   // put your setup code here, to run once:
   Serial.begin(9600);
-  pinMode(PWM_PIN, INPUT);
-  white.begin();
+  rc.addPwm(PWM_PIN);
+  rc.begin();
+  whiteStrip = leds.add(white);
+  leds.begin();
 }
 
 void loop() {
   // put your main code here, to run repeatedly:
   LDRValue= readLDRvalue();
-  Serial.println("LDR Values: ");
-  Serial.println(LDRValue);
-  Serial.println("PWM values: ");
-  Serial.println(pulse_var);
   control_led();
-delay(500);
+  leds.update();
+  if(millis() - last_print >= PRINT_PERIOD && Serial.availableForWrite() >= 48){
+    last_print = millis();
+    Serial.println("LDR Values: ");
+    Serial.println(LDRValue);
+    Serial.println("PWM values: ");
+    Serial.println(pulse_var);
+  }
 }
 
 int readLDRvalue(void){
@@ -42,17 +58,14 @@ int readLDRvalue(void){
 }
 
 void white_led_strip_on(void){
-  white.setPixelColor(0, white.Color(255,255,255)); 
-  white.setPixelColor(1, white.Color(255,255,255));
-  white.show();
+  leds.set(whiteStrip, white.Color(255,255,255));
 }
 void white_led_strip_off(void){
-  white.setPixelColor(0, white.Color(0, 0, 0));   
-  white.setPixelColor(1, white.Color(0, 0, 0));
-  white.show();
+  leds.set(whiteStrip, white.Color(0, 0, 0));
 }
 void control_led(void){
-  pulse_var= pulseIn(PWM_PIN, HIGH);
+  //Latest pulse width, 0 if the receiver signal is lost
+  pulse_var= rc.width(0);
 
   if(pulse_var<=1000.00){
     if(LDRValue<50){
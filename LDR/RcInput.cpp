@@ -0,0 +1,147 @@
+// RcInput.cpp
+// RC receiver input decoded in the background, see RcInput.h
+
+#include "RcInput.h"
+
+RcInput *RcInput::instance = NULL;
+
+RcInput::RcInput()
+    : channelCnt(0), ppm(false), ppmPin(0), ppmNext(RC_MAX_CHANNELS),
+      ppmLast(0), glitchCnt(0)
+{
+    memset(chans, 0, sizeof(chans));
+}
+
+bool RcInput::addPwm(byte pin)
+{
+    if (ppm || (channelCnt >= RC_MAX_PWM) || (digitalPinToInterrupt(pin) < 0))
+        return false;
+    chans[channelCnt++].pin = pin;
+    return true;
+}
+
+bool RcInput::setPpm(byte pin, byte count)
+{
+    if ((channelCnt > 0) || (count == 0) || (count > RC_MAX_CHANNELS)
+            || (digitalPinToInterrupt(pin) < 0))
+        return false;
+    ppm = true;
+    ppmPin = pin;
+    channelCnt = count;
+    return true;
+}
+
+void RcInput::begin()
+{
+    static void (*const pwmIsrs[RC_MAX_PWM])() = {
+        pwmIsr<0>, pwmIsr<1>, pwmIsr<2>, pwmIsr<3>
+    };
+    byte i;
+
+    instance = this;
+    if (ppm) {
+        pinMode(ppmPin, INPUT);
+        attachInterrupt(digitalPinToInterrupt(ppmPin), ppmIsr, RISING);
+        return;
+    }
+    for (i = 0; i < channelCnt; i++) {
+        pinMode(chans[i].pin, INPUT);
+        attachInterrupt(digitalPinToInterrupt(chans[i].pin), pwmIsrs[i], CHANGE);
+    }
+}
+
+unsigned int RcInput::width(byte ch) const
+{
+    return read(ch).width;
+}
+
+RcPulse RcInput::read(byte ch) const
+{
+    RcPulse p;
+
+    memset(&p, 0, sizeof(p));
+    if (ch >= channelCnt)
+        return p;
+    noInterrupts();
+    p.width = chans[ch].width;
+    p.stamp = chans[ch].stamp;
+    p.frames = chans[ch].frames;
+    interrupts();
+    if (!p.frames || (micros() - p.stamp >= RC_FAILSAFE_MS * 1000UL))
+        p.width = 0;
+    return p;
+}
+
+bool RcInput::failsafe(byte ch) const
+{
+    return read(ch).width == 0;
+}
+
+unsigned long RcInput::glitches() const
+{
+    unsigned long n;
+
+    noInterrupts();
+    n = glitchCnt;
+    interrupts();
+    return n;
+}
+
+template <byte N> void RcInput::pwmIsr()
+{
+    unsigned long now = micros();
+
+    instance->edge(N, digitalRead(instance->chans[N].pin) == HIGH, now);
+}
+
+void RcInput::ppmIsr()
+{
+    unsigned long now = micros();
+    unsigned long gap = now - instance->ppmLast;
+
+    instance->ppmLast = now;
+    if (gap >= RC_PPM_SYNC)
+        instance->ppmNext = 0;
+    else if (instance->ppmNext < instance->channelCnt)
+        instance->pulse(instance->ppmNext++, gap, now);
+}
+
+void RcInput::edge(byte ch, bool high, unsigned long now)
+{
+    unsigned long width;
+
+    if (high) {
+        chans[ch].rise = now;
+        chans[ch].high = true;
+    } else if (chans[ch].high) {
+        chans[ch].high = false;
+        // a missed edge can make a pulse of any length
+        width = now - chans[ch].rise;
+        pulse(ch, (width > RC_MAX_PULSE) ? RC_MAX_PULSE + 1 : width, now);
+    }
+}
+
+// interrupt side: glitch filter, then the new width
+void RcInput::pulse(byte ch, unsigned int width, unsigned long now)
+{
+    Channel *c = &chans[ch];
+
+    if ((width < RC_MIN_PULSE) || (width > RC_MAX_PULSE)) {
+        glitchCnt++;
+        return;
+    }
+    // a jump is taken when the next pulse is close to it
+    if (c->frames && (abs((int)width - (int)c->width) > RC_GLITCH_STEP)
+            && (!c->pending || (abs((int)width - (int)c->pending) > RC_GLITCH_STEP))) {
+        // after a failsafe time the old width doesn't count
+        if (now - c->stamp < RC_FAILSAFE_MS * 1000UL) {
+            c->pending = width;
+            glitchCnt++;
+            return;
+        }
+    }
+    c->pending = 0;
+    c->width = width;
+    c->stamp = now;
+    c->frames++;
+}
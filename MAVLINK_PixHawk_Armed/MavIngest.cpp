@@ -0,0 +1,140 @@
+// MavIngest.cpp
+// MAVLink receiver on a hardware UART, see MavIngest.h
+
+#include "MavIngest.h"
+
+MavIngest::MavIngest(HardwareSerial &port, uint8_t chan)
+    : port(port), chan(chan), routeCnt(0), sourceCnt(0), lastReport(0),
+      reportLine(MAV_MAX_ROUTES + 1)
+{
+    memset(&status, 0, sizeof(status));
+    memset(&counters, 0, sizeof(counters));
+    memset(&lastCounters, 0, sizeof(lastCounters));
+    memset(&rates, 0, sizeof(rates));
+}
+
+bool MavIngest::on(uint32_t msgid, MavHandler handler)
+{
+    Route *r;
+
+    if (routeCnt >= MAV_MAX_ROUTES)
+        return false;
+    r = &routes[routeCnt++];
+    r->msgid = msgid;
+    r->handler = handler;
+    r->count = 0;
+    r->lastCount = 0;
+    r->rate = 0;
+    return true;
+}
+
+void MavIngest::begin(unsigned long baud)
+{
+    port.begin(baud);
+    lastReport = millis();
+}
+
+void MavIngest::poll()
+{
+    int c;
+
+    // only what is already buffered: bytes arriving meanwhile wait for the
+    // next call instead of holding up loop()
+    for (c = port.available(); c > 0; c--) {
+        counters.bytes++;
+        if (mavlink_parse_char(chan, port.read(), &msg, &status)) {
+            counters.messages++;
+            track(msg);
+            dispatch(msg);
+        }
+        // the status copy holds the parse errors of this byte only, not a
+        // running total
+        counters.crcErrors += status.packet_rx_drop_count;
+    }
+}
+
+void MavIngest::dispatch(const mavlink_message_t &msg)
+{
+    byte i;
+
+    for (i = 0; i < routeCnt; i++) {
+        if (routes[i].msgid == msg.msgid) {
+            routes[i].count++;
+            routes[i].handler(msg);
+            return;
+        }
+    }
+    counters.unhandled++;
+}
+
+// sequence numbers count up per sender: a gap is the number of lost
+// messages, a repeated number a copy received over a second link
+void MavIngest::track(const mavlink_message_t &msg)
+{
+    Source *s;
+    byte i;
+
+    for (i = 0; i < sourceCnt; i++) {
+        s = &sources[i];
+        if ((s->sysid == msg.sysid) && (s->compid == msg.compid)) {
+            if (msg.seq != s->seq)
+                counters.lost += (uint8_t)(msg.seq - s->seq - 1);
+            s->seq = msg.seq;
+            return;
+        }
+    }
+    if (sourceCnt < MAV_MAX_SOURCES) {
+        s = &sources[sourceCnt++];
+        s->sysid = msg.sysid;
+        s->compid = msg.compid;
+        s->seq = msg.seq;
+    }
+}
+
+void MavIngest::report(Print &out, unsigned long period)
+{
+    unsigned long now = millis();
+    unsigned long dt = now - lastReport;
+    Route *r;
+    byte i;
+
+    if (dt >= period) {
+        lastReport = now;
+        rates.bytes = (counters.bytes - lastCounters.bytes) * 1000 / dt;
+        rates.messages = (counters.messages - lastCounters.messages) * 1000 / dt;
+        rates.unhandled = (counters.unhandled - lastCounters.unhandled) * 1000 / dt;
+        rates.lost = counters.lost - lastCounters.lost;
+        rates.crcErrors = counters.crcErrors - lastCounters.crcErrors;
+        lastCounters = counters;
+        for (i = 0; i < routeCnt; i++) {
+            r = &routes[i];
+            r->rate = (r->count - r->lastCount) * 1000 / dt;
+            r->lastCount = r->count;
+        }
+        reportLine = 0;
+    }
+
+    if ((reportLine > routeCnt) || (out.availableForWrite() < MAV_REPORT_LINE))
+        return;
+    if (reportLine == 0) {
+        out.print("MAV ");
+        out.print(rates.bytes);
+        out.print(" B/s, ");
+        out.print(rates.messages);
+        out.print(" msg/s (");
+        out.print(rates.unhandled);
+        out.print(" unhandled), lost ");
+        out.print(rates.lost);
+        out.print(", crc ");
+        out.println(rates.crcErrors);
+    } else {
+        r = &routes[reportLine - 1];
+        out.print("  id ");
+        out.print(r->msgid);
+        out.print(": ");
+        out.print(r->rate);
+        out.print(" msg/s, total ");
+        out.println(r->count);
+    }
+    reportLine++;
+}
@@ -0,0 +1,102 @@
+// MavIngest.h
+// MAVLink receiver on a hardware UART with a message ID dispatch table.
+//
+// The UART receive interrupt of HardwareSerial stores incoming bytes in its
+// ring buffer (SERIAL_RX_BUFFER_SIZE, 64 bytes on AVR: 11 ms at 57600 baud)
+// without disabling interrupts for whole bytes like SoftwareSerial does.
+// poll() drains the buffer through mavlink_parse_char() and passes every
+// decoded message to the handler registered for its ID, so loop() only has
+// to call poll() every few milliseconds and never block.
+//
+// Lost messages are counted from the sequence numbers of each sender,
+// corrupted ones by the parser (bad CRC); bytes lost to a full UART buffer
+// show up in both.
+//
+// Usage:
+//     MavIngest mav(Serial1);
+//     void onHeartbeat(const mavlink_message_t &msg) { ... }
+//
+//     setup():  mav.on(MAVLINK_MSG_ID_HEARTBEAT, onHeartbeat);
+//               mav.begin(57600);
+//     loop():   mav.poll();
+//               mav.report(Serial, 5000);    message rates every 5 s
+
+#ifndef MAV_INGEST_H
+#define MAV_INGEST_H
+
+#include <Arduino.h>
+#include "mavlink.h"
+
+// handled message IDs
+#define MAV_MAX_ROUTES      8
+// senders (system/component) whose sequence numbers are tracked
+#define MAV_MAX_SOURCES     4
+// free serial buffer needed to print a report line
+#define MAV_REPORT_LINE     48
+
+typedef void (*MavHandler)(const mavlink_message_t &msg);
+
+struct MavStats {
+    unsigned long bytes;        // bytes read from the UART
+    unsigned long messages;     // messages decoded
+    unsigned long unhandled;    // decoded, no handler for the ID
+    unsigned long lost;         // sequence number gaps
+    unsigned long crcErrors;    // dropped by the parser
+};
+
+class MavIngest {
+public:
+    MavIngest(HardwareSerial &port, uint8_t chan = 0);
+
+    // handler gets the messages with this ID. False if the table is full
+    bool on(uint32_t msgid, MavHandler handler);
+
+    void begin(unsigned long baud);
+
+    // main loop side: parses the buffered bytes, dispatches the messages
+    void poll();
+
+    const MavStats &stats() const { return counters; }
+
+    // main loop side: every period ms takes the message rates, then prints
+    // them one line per call, only when the line fits in the serial buffer
+    void report(Print &out, unsigned long period);
+
+private:
+    struct Route {
+        uint32_t msgid;
+        MavHandler handler;
+        unsigned long count;
+        unsigned long lastCount;    // count at the last report
+        unsigned int rate;          // messages/s of the last report
+    };
+
+    struct Source {
+        uint8_t sysid;
+        uint8_t compid;
+        uint8_t seq;
+    };
+
+    void dispatch(const mavlink_message_t &msg);
+    void track(const mavlink_message_t &msg);
+
+    HardwareSerial &port;
+    uint8_t chan;
+
+    Route routes[MAV_MAX_ROUTES];
+    byte routeCnt;
+    Source sources[MAV_MAX_SOURCES];
+    byte sourceCnt;
+
+    mavlink_message_t msg;
+    mavlink_status_t status;
+    MavStats counters;
+
+    // report
+    unsigned long lastReport;
+    MavStats lastCounters;
+    MavStats rates;             // per second over the last period, except errors
+    byte reportLine;            // next line to print, past routeCnt: done
+};
+
+#endif
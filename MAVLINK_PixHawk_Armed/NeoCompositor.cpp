@@ -0,0 +1,88 @@
+// NeoCompositor.cpp
+// One colour per NeoPixel strip, shown only when it changed, see
+// NeoCompositor.h
+
+#include "NeoCompositor.h"
+
+NeoCompositor::NeoCompositor(unsigned int maxFps)
+    : stripCnt(0), framePeriod(1000000UL / (maxFps ? maxFps : 1)), lastFrame(0)
+{
+    memset(&counters, 0, sizeof(counters));
+}
+
+int8_t NeoCompositor::add(Adafruit_NeoPixel &strip)
+{
+    byte i;
+
+    if (stripCnt >= NEO_MAX_STRIPS)
+        return -1;
+    for (i = 0; i < stripCnt; i++) {
+        if (strips[i].pixels->getPin() == strip.getPin())
+            return -1;
+    }
+    strips[stripCnt].pixels = &strip;
+    strips[stripCnt].color = 0;
+    strips[stripCnt].shown = 0;
+    return stripCnt++;
+}
+
+void NeoCompositor::begin()
+{
+    byte i;
+
+    for (i = 0; i < stripCnt; i++) {
+        strips[i].pixels->begin();
+        show(strips[i]);
+    }
+    lastFrame = micros();
+}
+
+void NeoCompositor::set(int8_t strip, uint32_t color)
+{
+    if ((strip < 0) || (strip >= stripCnt))
+        return;
+    strips[strip].color = color;
+}
+
+uint32_t NeoCompositor::get(int8_t strip) const
+{
+    if ((strip < 0) || (strip >= stripCnt))
+        return 0;
+    return strips[strip].color;
+}
+
+bool NeoCompositor::update()
+{
+    unsigned long now = micros();
+    bool sent = false;
+    byte i;
+
+    if (now - lastFrame < framePeriod)
+        return false;
+    for (i = 0; i < stripCnt; i++) {
+        if (strips[i].color != strips[i].shown) {
+            show(strips[i]);
+            sent = true;
+        }
+    }
+    if (sent) {
+        // the frame period starts with the first change after an idle time
+        lastFrame = now;
+        counters.frames++;
+    }
+    return sent;
+}
+
+void NeoCompositor::show(Strip &s)
+{
+    unsigned long start, t;
+
+    s.pixels->fill(s.color);
+    start = micros();
+    s.pixels->show();
+    t = micros() - start;
+    if (t > counters.maxShowUs)
+        counters.maxShowUs = t;
+    s.shown = s.color;
+    counters.shows++;
+}
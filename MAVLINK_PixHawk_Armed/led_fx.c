@@ -0,0 +1,197 @@
+/*!
+ * @file led_fx.c
+ *
+ * Non-blocking LED effect engine, see led_fx.h.
+ */
+
+#include <stddef.h>
+#include "led_fx.h"
+
+/*******************************************************************************
+ * Private functions
+ ******************************************************************************/
+
+/*!
+ * @brief Level of a pulse train: pulses of onMs, offMs apart.
+ */
+static uint8_t ledFxPulse(const led_fx_t* fx, uint32_t t)
+{
+    uint32_t period = (uint32_t)fx->onMs + fx->offMs;
+
+    return ((period > 0U) && ((t % period) < fx->onMs)) ? fx->level : 0U;
+}
+
+/*!
+ * @brief Fade from 0 to the effect level, t = 0..length. Squared ramp, the
+ * perceived brightness rises about linearly.
+ */
+static uint8_t ledFxRamp(const led_fx_t* fx, uint32_t t, uint16_t length)
+{
+    uint32_t r = (t * LED_FX_LEVEL_MAX) / length;
+
+    return (uint8_t)((r * r * fx->level) / (LED_FX_LEVEL_MAX * LED_FX_LEVEL_MAX));
+}
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : ledFxLevel
+ * Description   : This function computes the level of an effect.
+ *
+ *END**************************************************************************/
+uint8_t ledFxLevel(const led_fx_t* fx, uint32_t elapsed, bool* done)
+{
+    uint32_t burst, cycle, t;
+    bool end = false;
+    uint8_t level = 0U;
+
+    switch (fx->type)
+    {
+        case LED_FX_TYPE_SOLID:
+            end = (fx->onMs > 0U) && (elapsed >= fx->onMs);
+            level = end ? 0U : fx->level;
+            break;
+
+        case LED_FX_TYPE_BLINK:
+            burst = (uint32_t)fx->count * ((uint32_t)fx->onMs + fx->offMs);
+            end = (fx->count > 0U) && (elapsed >= burst);
+            level = end ? 0U : ledFxPulse(fx, elapsed);
+            break;
+
+        case LED_FX_TYPE_STROBE:
+            burst = (uint32_t)fx->count * ((uint32_t)fx->onMs + fx->offMs);
+            cycle = burst + fx->pauseMs;
+            if (cycle > 0U)
+            {
+                t = elapsed % cycle;
+                level = (t < burst) ? ledFxPulse(fx, t) : 0U;
+            }
+            break;
+
+        case LED_FX_TYPE_BREATHE:
+            cycle = (uint32_t)fx->onMs + fx->offMs + fx->pauseMs;
+            if (cycle > 0U)
+            {
+                t = elapsed % cycle;
+                if (t < fx->onMs)
+                {
+                    level = ledFxRamp(fx, t, fx->onMs);
+                }
+                else if (t < ((uint32_t)fx->onMs + fx->offMs))
+                {
+                    level = ledFxRamp(fx, (uint32_t)fx->onMs + fx->offMs - t, fx->offMs);
+                }
+            }
+            break;
+
+        default:
+            end = true;
+            break;
+    }
+
+    if (done != NULL)
+    {
+        *done = end;
+    }
+
+    return level;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : ledFxInit
+ * Description   : This function initializes the engine.
+ *
+ *END**************************************************************************/
+void ledFxInit(led_fx_engine_t* engine, led_fx_channel_t* channels,
+    uint8_t channelCnt, led_fx_output_t output)
+{
+    uint8_t ch;
+
+    engine->channels = channels;
+    engine->channelCnt = channelCnt;
+    engine->output = output;
+
+    for (ch = 0U; ch < channelCnt; ch++)
+    {
+        channels[ch].fx = NULL;
+        channels[ch].start = 0U;
+        channels[ch].level = 0U;
+        channels[ch].done = true;
+        output(ch, 0U);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : ledFxStart
+ * Description   : This function starts an effect on a channel.
+ *
+ *END**************************************************************************/
+void ledFxStart(led_fx_engine_t* engine, uint8_t channel, const led_fx_t* fx,
+    uint32_t now)
+{
+    led_fx_channel_t* chan;
+
+    if (channel >= engine->channelCnt)
+    {
+        return;
+    }
+
+    chan = &engine->channels[channel];
+    if ((fx != NULL) && (fx == chan->fx))
+    {
+        return;
+    }
+
+    chan->fx = fx;
+    chan->start = now;
+    chan->done = (fx == NULL);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : ledFxTick
+ * Description   : This function advances the effects of all channels.
+ *
+ *END**************************************************************************/
+void ledFxTick(led_fx_engine_t* engine, uint32_t now)
+{
+    led_fx_channel_t* chan;
+    uint8_t level;
+    uint8_t ch;
+
+    for (ch = 0U; ch < engine->channelCnt; ch++)
+    {
+        chan = &engine->channels[ch];
+        level = 0U;
+        if (chan->fx != NULL)
+        {
+            level = ledFxLevel(chan->fx, now - chan->start, &chan->done);
+            if (chan->done)
+            {
+                chan->fx = NULL;
+            }
+        }
+
+        if (level != chan->level)
+        {
+            chan->level = level;
+            engine->output(ch, level);
+        }
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : ledFxDone
+ * Description   : This function tells whether the effect of a channel ended.
+ *
+ *END**************************************************************************/
+bool ledFxDone(const led_fx_engine_t* engine, uint8_t channel)
+{
+    return (channel >= engine->channelCnt) || engine->channels[channel].done;
+}
@@ -1,8 +1,10 @@
 #include "mavlink.h"
 #include <Arduino.h>
-#include <SoftwareSerial.h>
 #include <Adafruit_NeoPixel.h>
 #include <stdint.h>
+#include "MavIngest.h"
+#include "led_fx.h"
+#include "NeoCompositor.h"
 
 // Private macros
 #define NEO_LED_PIN_RED   2
@@ -12,8 +14,15 @@
 #define NEO_LED_PIN_WHITE 6
 #define NUM_PIXELS 2
 
-#define RX_PIN 10         // Define the pin for receiving data
-#define TX_PIN 11         // Define the pin for transmitting data
+// Pixhawk TELEM on a hardware UART. Boards with a second UART (Mega,
+// Leonardo) keep Serial for the serial monitor; on an Uno the Pixhawk
+// takes D0/D1 and nothing else is printed
+#if defined(HAVE_HWSERIAL1)
+#define MAV_SERIAL Serial1
+#define LOG_SERIAL Serial
+#else
+#define MAV_SERIAL Serial
+#endif
 #define MAVLINK_COMM_0 0  // MAVLink communication channel
 
 #define MAV_VTOL_STATE_MC 3
@@ -26,71 +35,94 @@ Adafruit_NeoPixel blue2 = Adafruit_NeoPixel(NUM_PIXELS, NEO_LED_PIN_BLUE2, NEO_G
 Adafruit_NeoPixel green = Adafruit_NeoPixel(NUM_PIXELS, NEO_LED_PIN_GREEN, NEO_GRB + NEO_KHZ800);
 Adafruit_NeoPixel white = Adafruit_NeoPixel(NUM_PIXELS, NEO_LED_PIN_WHITE, NEO_GRB + NEO_KHZ800);
 
-// Create SoftwareSerial object for Pixhawk communication
-SoftwareSerial SerialPort(RX_PIN, TX_PIN);  // RX, TX
+// Colour of each strip, show() only for the strips that changed, at most
+// 50 frames/s
+NeoCompositor strips(50);
+int8_t redStrip, blue1Strip, blue2Strip, greenStrip, whiteStrip;
 
-// MAVLink message and status
-mavlink_message_t msg;
-mavlink_status_t status;
+// MAVLink input from the Pixhawk
+MavIngest mav(MAV_SERIAL, MAVLINK_COMM_0);
 
 // Add variables for flight mode and armed status
 uint8_t flight_mode = 0;
 bool is_armed;
 
+// LED effects (led_fx.h), one channel per colour. Advanced by loop()
+// without waiting, so the Pixhawk keeps being read between the steps
+enum { LED_RED, LED_BLUE, LED_GREEN, LED_WHITE, LED_CHANNELS };
+led_fx_channel_t ledChannels[LED_CHANNELS];
+led_fx_engine_t leds;
+
+const led_fx_t ledOn = LED_FX_SOLID(LED_FX_LEVEL_MAX, 0);
+// White strobe: two 100 ms flashes 75 ms apart, then 1 s dark
+const led_fx_t whiteStrobe = LED_FX_STROBE(LED_FX_LEVEL_MAX, 2, 100, 75, 1000);
+
 void setup() {
-  Serial.begin(57600);      // For serial monitor communication
-  SerialPort.begin(57600);  // For Pixhawk communication over SoftwareSerial
+#ifdef LOG_SERIAL
+  LOG_SERIAL.begin(57600);  // For serial monitor communication
+#endif
 
   // Initialize NeoPixel libraries
-  red.begin();
-  blue1.begin();
-  blue2.begin();
-  green.begin();
-  white.begin();
+  redStrip = strips.add(red);
+  blue1Strip = strips.add(blue1);
+  blue2Strip = strips.add(blue2);
+  greenStrip = strips.add(green);
+  whiteStrip = strips.add(white);
+  strips.begin();
+
+  mav.on(MAVLINK_MSG_ID_RC_CHANNELS_RAW, onRcChannelsRaw);
+  mav.on(MAVLINK_MSG_ID_HEARTBEAT, onHeartbeat);
+  mav.begin(57600);  // For Pixhawk communication
+
+  ledFxInit(&leds, ledChannels, LED_CHANNELS, ledOutput);
+  ledFxStart(&leds, LED_WHITE, &whiteStrobe, millis());
 }
 
 void loop() {
-  // Check for data available from Pixhawk
-  while (SerialPort.available() > 0) {
-    uint8_t byte = SerialPort.read();
-
-    // Parse incoming MAVLink message
-    if (mavlink_parse_char(MAVLINK_COMM_0, byte, &msg, &status)) {
-      
-      // Check for RC_CHANNELS message (message ID 65)
-      if (msg.msgid == MAVLINK_MSG_ID_RC_CHANNELS_RAW) {
-        mavlink_rc_channels_override_t rc_channels;
-        mavlink_msg_rc_channels_override_decode(&msg, &rc_channels);
-
-        // Get the value of Channel 8 (typically AUX8)
-        uint16_t channel_8_value = rc_channels.chan8_raw;
-
-        // Map the value of Channel 8 to LED behavior
-        controlLEDsBasedOnRC(channel_8_value);
-      }
-
-      // Check for HEARTBEAT message to get flight mode and armed status
-      if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-        mavlink_heartbeat_t heartbeat;
-        mavlink_msg_heartbeat_decode(&msg, &heartbeat);
-
-        // Update flight mode and armed status
-        flight_mode = heartbeat.custom_mode;
-        is_armed = (heartbeat.base_mode & MAV_MODE_FLAG_SAFETY_ARMED) != 0;// Check if armed
-        //is_armed = (heartbeat.system_status == MAV_STATE_ACTIVE); // Check if armed
-      }
-    }
-  }
+  // Parse and dispatch the MAVLink bytes received so far
+  mav.poll();
+
+  // Advance the LED effects (white strobe), send the changed strips
+  ledFxTick(&leds, millis());
+  strips.update();
+
+#ifdef LOG_SERIAL
+  // Message rates and losses every 5 s
+  mav.report(LOG_SERIAL, 5000);
+#endif
+}
+
+// RC_CHANNELS_RAW (message ID 35)
+void onRcChannelsRaw(const mavlink_message_t &msg) {
+  mavlink_rc_channels_raw_t rc_channels;
+  mavlink_msg_rc_channels_raw_decode(&msg, &rc_channels);
+
+  // Get the value of Channel 8 (typically AUX8)
+  uint16_t channel_8_value = rc_channels.chan8_raw;
+
+  // Map the value of Channel 8 to LED behavior
+  controlLEDsBasedOnRC(channel_8_value);
+}
+
+// HEARTBEAT: flight mode and armed status
+void onHeartbeat(const mavlink_message_t &msg) {
+  mavlink_heartbeat_t heartbeat;
+  mavlink_msg_heartbeat_decode(&msg, &heartbeat);
+
+  // Update flight mode and armed status
+  flight_mode = heartbeat.custom_mode;
+  is_armed = (heartbeat.base_mode & MAV_MODE_FLAG_SAFETY_ARMED) != 0;// Check if armed
+  //is_armed = (heartbeat.system_status == MAV_STATE_ACTIVE); // Check if armed
+
   // Handle LEDs based on flight mode and armed status
   handleLEDs(flight_mode, is_armed);
-  // Handle LED blinking for white LED
-  time_handler();
 }
+
 // Control LEDs based on the RC Channel 8 value
 void controlLEDsBasedOnRC(uint16_t channel_8_value) {
   if (channel_8_value < 1000) {
     // RC Channel 8 is in the low range (e.g., 1000 or below)
-    Serial.println("Red Led ON");
+    logln("Red Led ON");
     red_led_on();
     blue_led_off();
     green_led_off();
@@ -98,7 +130,7 @@ void controlLEDsBasedOnRC(uint16_t channel_8_value) {
   } else if (channel_8_value >= 1000 && channel_8_value < 1500) {
     // RC Channel 8 is in the mid-low range
     red_led_off();
-    Serial.println("Blue Led ON");
+    logln("Blue Led ON");
     blue_led_on();
     green_led_off();
     white_led_off();
@@ -106,7 +138,7 @@ void controlLEDsBasedOnRC(uint16_t channel_8_value) {
     // RC Channel 8 is in the mid-high range
     red_led_off();
     blue_led_off();
-    Serial.println("Green Led ON");
+    logln("Green Led ON");
     green_led_on();
     white_led_off();
   } else {
@@ -114,7 +146,7 @@ void controlLEDsBasedOnRC(uint16_t channel_8_value) {
     red_led_off();
     blue_led_off();
     green_led_off();
-    Serial.println("White Led ON");
+    logln("White Led ON");
     white_led_on();
   }
 }
@@ -124,14 +156,14 @@ void handleLEDs(uint8_t flight_mode, bool is_armed) {
   if (flight_mode == MAV_VTOL_STATE_MC) {
     // Multicopter mode
     if (is_armed) {
-      Serial.println("Red Led ON");
+      logln("Red Led ON");
       red_led_on();
       blue_led_on();
       green_led_on();
     } else {
       red_led_off();
       blue_led_off();
-      Serial.println("Green Led ON");
+      logln("Green Led ON");
       green_led_on();
     }
   } else if (flight_mode == MAV_VTOL_STATE_FW) {
@@ -139,69 +171,65 @@ void handleLEDs(uint8_t flight_mode, bool is_armed) {
     if (is_armed) {
       red_led_off();
       blue_led_off();
-      Serial.println("Green Led ON");
+      logln("Green Led ON");
       green_led_on();
     } else {
       red_led_on();
       green_led_off();
-      Serial.println("Blue Led ON");
+      logln("Blue Led ON");
       blue_led_on();
     }
   }
 }
+// Colour of a channel at the brightness of its effect
+void ledOutput(uint8_t channel, uint8_t level){
+  switch (channel) {
+    case LED_RED:
+      strips.set(redStrip, Adafruit_NeoPixel::Color(level, 0, 0));
+      break;
+    case LED_BLUE:
+      strips.set(blue1Strip, Adafruit_NeoPixel::Color(0, 0, level));
+      strips.set(blue2Strip, Adafruit_NeoPixel::Color(0, 0, level));
+      break;
+    case LED_GREEN:
+      strips.set(greenStrip, Adafruit_NeoPixel::Color(0, level, 0));
+      break;
+    case LED_WHITE:
+      strips.set(whiteStrip, Adafruit_NeoPixel::Color(level, level, level));
+      break;
+  }
+}
+// Control functions for LEDs, shown by the next ledFxTick() and frame
 void red_led_on(void){
-  red.setPixelColor(0, red.Color(255,0,0));
-  red.setPixelColor(1, red.Color(255,0,0));
-  red.show();
+  ledFxStart(&leds, LED_RED, &ledOn, millis());
 }
 void red_led_off(void){
-  red.setPixelColor(0, red.Color(0,0,0));
-  red.setPixelColor(1, red.Color(0,0,0));
-  red.show();
+  ledFxStart(&leds, LED_RED, NULL, millis());
 }
 void blue_led_on(void){
-  blue1.setPixelColor(0, blue1.Color(0,0,255));
-  blue1.setPixelColor(1, blue1.Color(0,0,255));
-  blue1.show();
-  blue2.setPixelColor(0, blue2.Color(0,0,255));
-  blue2.setPixelColor(1, blue2.Color(0,0,255));
-  blue2.show();
+  ledFxStart(&leds, LED_BLUE, &ledOn, millis());
 }
 void blue_led_off(void){
-  blue1.setPixelColor(0, blue1.Color(0,0,0));
-  blue1.setPixelColor(1, blue1.Color(0,0,0));
-  blue1.show();
-  blue2.setPixelColor(0, blue2.Color(0,0,0));
-  blue2.setPixelColor(1, blue2.Color(0,0,0));
-  blue2.show();
+  ledFxStart(&leds, LED_BLUE, NULL, millis());
 }
 void green_led_on(void){
-  green.setPixelColor(0, green.Color(0,255,0));
-  green.setPixelColor(1, green.Color(0,255,0));
-  green.show();
+  ledFxStart(&leds, LED_GREEN, &ledOn, millis());
 }
 void green_led_off(void){
-  green.setPixelColor(0, green.Color(0,0,0));
-  green.setPixelColor(1, green.Color(0,0,0));
-  green.show();
+  ledFxStart(&leds, LED_GREEN, NULL, millis());
 }
 void white_led_on(void){
-  white.setPixelColor(0, white.Color(255,255,255)); //Turn on white LED
-  white.setPixelColor(1, white.Color(255,255,255));
-  white.show();
+  ledFxStart(&leds, LED_WHITE, &ledOn, millis());
 }
+// White is off between the strobe flashes
 void white_led_off(void){
-  white.setPixelColor(0, white.Color(0, 0, 0));   // Turn off white LED
-  white.setPixelColor(1, white.Color(0, 0, 0));
-  white.show();
+  ledFxStart(&leds, LED_WHITE, &whiteStrobe, millis());
+}
+// Serial monitor output, when the Pixhawk isn't on Serial
+void logln(const char *text){
+#ifdef LOG_SERIAL
+  LOG_SERIAL.println(text);
+#else
+  (void)text;
+#endif
 }
-void time_handler(void){
-  // Blinking white LED using NeoPixel library
-  for(int i=0; i<2; i++){
-    white_led_on();
-    delay(100);  // Wait for 500 ms
-    white_led_off();
-    delay(75);  // Wait for 500 ms
-  }
-delay(1000);
-}
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include <Adafruit_NeoPixel.h>
+#include "led_fx.h"
+#include "NeoCompositor.h"
 
 /*****Private macros******/
 //The digital pin number used
@@ -16,68 +18,55 @@ Adafruit_NeoPixel blue2= Adafruit_NeoPixel(NUM_PIXELS, NEO_LED_PIN_BLUE2, NEO_GR
 Adafruit_NeoPixel green= Adafruit_NeoPixel(NUM_PIXELS, NEO_LED_PIN_GREEN, NEO_GRB + NEO_KHZ800);
 Adafruit_NeoPixel white= Adafruit_NeoPixel(NUM_PIXELS, NEO_LED_PIN_WHITE, NEO_GRB + NEO_KHZ800);
 
+/****Strip colours, show() only for the strips that changed, at most 50 frames/s****/
+NeoCompositor strips(50);
+int8_t redStrip, blue1Strip, blue2Strip, greenStrip, whiteStrip;
+
+/****LED effects (led_fx.h), advanced by loop() without waiting****/
+led_fx_channel_t whiteChannel;
+led_fx_engine_t leds;
+//White strobe: two 100 ms flashes 75 ms apart, then 1 s dark
+const led_fx_t whiteStrobe = LED_FX_STROBE(LED_FX_LEVEL_MAX, 2, 100, 75, 1000);
+
 /****Private function protypes****/
 void red_led(void);
 void blue_led(void);
 void green_led(void);
-void white_led_on(void);
-void white_led_off(void);
-void time_handler(void);
+void white_led(uint8_t channel, uint8_t level);
 
 void setup() {
   // put your setup code here, to run once:
   //Initializes the library
-  red.begin();
+  redStrip = strips.add(red);
+  blue1Strip = strips.add(blue1);
+  blue2Strip = strips.add(blue2);
+  greenStrip = strips.add(green);
+  whiteStrip = strips.add(white);
+  strips.begin();
   red_led();
-  blue1.begin();
-  blue2.begin();
   blue_led();
-  green.begin();
   green_led();
-  white.begin();
+  ledFxInit(&leds, &whiteChannel, 1, white_led);
+  ledFxStart(&leds, 0, &whiteStrobe, millis());
 }
 
 void loop() {
   // put your main code here, to run repeatedly:
-  time_handler();
+  ledFxTick(&leds, millis());
+  strips.update();
 }
 
 void red_led(void){
-  red.setPixelColor(0, red.Color(255,0,0));
-  red.setPixelColor(1, red.Color(255,0,0));
-  red.show();
+  strips.set(redStrip, red.Color(255,0,0));
 }
 void blue_led(void){
-  blue1.setPixelColor(0, blue1.Color(0,0,255));
-  blue1.setPixelColor(1, blue1.Color(0,0,255));
-  blue1.show();
-  blue2.setPixelColor(0, blue2.Color(0,0,255));
-  blue2.setPixelColor(1, blue2.Color(0,0,255));
-  blue2.show();
+  strips.set(blue1Strip, blue1.Color(0,0,255));
+  strips.set(blue2Strip, blue2.Color(0,0,255));
 }
 void green_led(void){
-  green.setPixelColor(0, green.Color(0,255,0));
-  green.setPixelColor(1, green.Color(0,255,0));
-  green.show();
-}
-void white_led_on(void){
-  white.setPixelColor(0, white.Color(255,255,255)); //Turn on white LED
-  white.setPixelColor(1, white.Color(255,255,255));
-  white.show();
+  strips.set(greenStrip, green.Color(0,255,0));
 }
-void white_led_off(void){
-  white.setPixelColor(0, white.Color(0, 0, 0));   // Turn off white LED
-  white.setPixelColor(1, white.Color(0, 0, 0));
-  white.show();
+void white_led(uint8_t channel, uint8_t level){
+  (void)channel;
+  strips.set(whiteStrip, white.Color(level, level, level));
 }
-void time_handler(void){
-  // Blinking white LED using NeoPixel library
-  for(int i=0; i<2; i++){
-    white_led_on();
-    delay(100);  // Wait for 500 ms
-    white_led_off();
-    delay(75);  // Wait for 500 ms
-  }
-delay(1000);
-}
-
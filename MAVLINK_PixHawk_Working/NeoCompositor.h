@@ -0,0 +1,76 @@
+// NeoCompositor.h
+// One colour per NeoPixel strip, shown only when it changed.
+//
+// show() sends the whole strip with interrupts disabled (30 us per WS2812
+// pixel plus the reset time), which delays the UART and pin interrupts the
+// sketches depend on. The compositor keeps the desired colour of each strip
+// and the colour last sent; update(), called from the main loop, calls
+// show() only for the strips whose colour differs, at most once per frame
+// period. Setting the same colour again, or changing it several times
+// between two frames, costs nothing on the wire.
+//
+// Each strip must have its own pin: add() refuses a second strip object on a
+// pin already registered (both would send their own frame to the same LEDs).
+//
+// Usage:
+//     Adafruit_NeoPixel red(2, 2, NEO_GRB + NEO_KHZ800);
+//     NeoCompositor leds(50);                 at most 50 frames/s
+//
+//     setup():  redStrip = leds.add(red);
+//               leds.begin();                 all strips off
+//     anywhere: leds.set(redStrip, red.Color(255, 0, 0));
+//     loop():   leds.update();
+
+#ifndef NEO_COMPOSITOR_H
+#define NEO_COMPOSITOR_H
+
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+
+// registered strips
+#define NEO_MAX_STRIPS      6
+
+struct NeoStats {
+    unsigned long frames;       // updates which sent at least one strip
+    unsigned long shows;        // show() calls
+    unsigned long maxShowUs;    // longest show(), interrupts mostly disabled
+};
+
+class NeoCompositor {
+public:
+    NeoCompositor(unsigned int maxFps);
+
+    // registers a strip, returns its handle. -1 if the table is full or the
+    // pin is already used by a registered strip
+    int8_t add(Adafruit_NeoPixel &strip);
+
+    // begins all strips and sends them off
+    void begin();
+
+    // desired colour of the whole strip, sent by the next frame if changed
+    void set(int8_t strip, uint32_t color);
+    uint32_t get(int8_t strip) const;
+
+    // main loop side: sends the changed strips once the frame period is
+    // over. Returns true if a strip was sent
+    bool update();
+
+    const NeoStats &stats() const { return counters; }
+
+private:
+    struct Strip {
+        Adafruit_NeoPixel *pixels;
+        uint32_t color;             // desired
+        uint32_t shown;             // last sent
+    };
+
+    void show(Strip &s);
+
+    Strip strips[NEO_MAX_STRIPS];
+    byte stripCnt;
+    unsigned long framePeriod;      // us
+    unsigned long lastFrame;        // micros() of the last frame
+    NeoStats counters;
+};
+
+#endif
@@ -0,0 +1,169 @@
+/*!
+ * @file led_fx.h
+ *
+ * Non-blocking LED effect engine, shared by the S32K144 firmware (battery
+ * gauge LEDs) and the Arduino NeoPixel sketches. The file pair
+ * led_fx.h/led_fx.c is plain C99 without dependencies, copies in the sketch
+ * folders must be kept identical to Sources/.
+ *
+ * An effect is a constant record (solid, blink N times, strobe, breathe,
+ * see led_fx_t), its brightness is a function of the time elapsed since its
+ * start only (ledFxLevel). The engine runs one effect per channel (an LED,
+ * a pin, a NeoPixel strip). ledFxTick, called from the main loop with the
+ * current time in [ms], computes the level of every channel and calls the
+ * output function of the application for the channels whose level changed.
+ * Nothing waits: the main loop keeps serving its other tasks between ticks,
+ * the effect timing is as accurate as the tick period.
+ *
+ * The time is a parameter, so the engine runs on any millisecond clock
+ * (millis(), OSIF_GetMilliseconds(), a simulated clock).
+ *
+ * Example, the white strobe of the MAVLink sketches:
+ *     static const led_fx_t strobe = LED_FX_STROBE(255U, 2U, 100U, 75U, 1000U);
+ *     ledFxStart(&engine, WHITE, &strobe, millis());
+ *     loop(): ledFxTick(&engine, millis());
+ */
+
+#ifndef LED_FX_H_
+#define LED_FX_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Effect types. */
+typedef enum
+{
+    LED_FX_TYPE_SOLID   = 0U,  /*!< On for onMs (0: forever). */
+    LED_FX_TYPE_BLINK   = 1U,  /*!< count pulses of onMs, offMs apart (count 0:
+                                    forever), then off. */
+    LED_FX_TYPE_STROBE  = 2U,  /*!< Bursts of count pulses of onMs, offMs
+                                    apart, pauseMs dark after each burst. */
+    LED_FX_TYPE_BREATHE = 3U   /*!< Fade in for onMs, fade out for offMs,
+                                    pauseMs dark, repeated. */
+} led_fx_type_t;
+
+/*! @brief Effect record. Fields not used by the type are zero. */
+typedef struct
+{
+    led_fx_type_t type;
+    uint8_t level;             /*!< Brightness when on, 0..LED_FX_LEVEL_MAX. */
+    uint8_t count;             /*!< BLINK, STROBE: pulses. */
+    uint16_t onMs;             /*!< On time or fade in time [ms]. */
+    uint16_t offMs;            /*!< Off time or fade out time [ms]. */
+    uint16_t pauseMs;          /*!< Dark time after a burst or a breath [ms]. */
+} led_fx_t;
+
+/*! @brief Full brightness. */
+#define LED_FX_LEVEL_MAX        255U
+
+/* Initializers of the effect records. */
+#define LED_FX_SOLID(level, onMs) \
+    { LED_FX_TYPE_SOLID, (level), 0U, (onMs), 0U, 0U }
+#define LED_FX_BLINK(level, count, onMs, offMs) \
+    { LED_FX_TYPE_BLINK, (level), (count), (onMs), (offMs), 0U }
+#define LED_FX_STROBE(level, count, onMs, offMs, pauseMs) \
+    { LED_FX_TYPE_STROBE, (level), (count), (onMs), (offMs), (pauseMs) }
+#define LED_FX_BREATHE(level, inMs, outMs, pauseMs) \
+    { LED_FX_TYPE_BREATHE, (level), 0U, (inMs), (outMs), (pauseMs) }
+
+/*! @brief Output function of the application, sets the brightness of a
+ * channel (an on/off output is on for level >= LED_FX_LEVEL_ON). */
+typedef void (*led_fx_output_t)(uint8_t channel, uint8_t level);
+
+/*! @brief Threshold of on/off outputs. */
+#define LED_FX_LEVEL_ON         128U
+
+/*! @brief State of a channel. */
+typedef struct
+{
+    const led_fx_t* fx;        /*!< Running effect, NULL if off. */
+    uint32_t start;            /*!< Start time of the effect [ms]. */
+    uint8_t level;             /*!< Level set by the last tick. */
+    bool done;                 /*!< The effect has ended (the channel is off). */
+} led_fx_channel_t;
+
+/*! @brief Engine, the channel array is provided by the application. */
+typedef struct
+{
+    led_fx_channel_t* channels;
+    uint8_t channelCnt;
+    led_fx_output_t output;
+} led_fx_engine_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief This function initializes the engine and switches all channels off
+ * (the output function is called for each channel).
+ *
+ * @param engine Engine to initialize.
+ * @param channels Array of channelCnt channel states.
+ * @param channelCnt Number of channels.
+ * @param output Output function.
+ */
+void ledFxInit(led_fx_engine_t* engine, led_fx_channel_t* channels,
+    uint8_t channelCnt, led_fx_output_t output);
+
+/*!
+ * @brief This function starts an effect on a channel. The output is updated
+ * by the next tick.
+ *
+ * Starting the effect which is already running on the channel keeps its
+ * phase, so the effect of a state can be set each time the state is
+ * evaluated. An effect which has ended starts again.
+ *
+ * @param engine Engine.
+ * @param channel Channel index.
+ * @param fx Effect (kept by reference, must stay valid), NULL to switch the
+ *           channel off.
+ * @param now Current time in [ms].
+ */
+void ledFxStart(led_fx_engine_t* engine, uint8_t channel, const led_fx_t* fx,
+    uint32_t now);
+
+/*!
+ * @brief This function advances the effects of all channels to the current
+ * time and updates the outputs whose level changed.
+ *
+ * @param engine Engine.
+ * @param now Current time in [ms].
+ */
+void ledFxTick(led_fx_engine_t* engine, uint32_t now);
+
+/*!
+ * @brief This function tells whether the effect of a channel has ended (or
+ * the channel is off), as of the last tick.
+ *
+ * @param engine Engine.
+ * @param channel Channel index.
+ *
+ * @return True if the channel is off for good.
+ */
+bool ledFxDone(const led_fx_engine_t* engine, uint8_t channel);
+
+/*!
+ * @brief This function computes the level of an effect.
+ *
+ * @param fx Effect.
+ * @param elapsed Time since the start of the effect in [ms].
+ * @param done Set to true if the effect has ended (may be NULL).
+ *
+ * @return Level 0..LED_FX_LEVEL_MAX.
+ */
+uint8_t ledFxLevel(const led_fx_t* fx, uint32_t elapsed, bool* done);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LED_FX_H_ */
@@ -1,17 +1,34 @@
+#include "RcInput.h"
+
 #define INPUT_PIN   2
+#define PRINT_PERIOD 500  //ms between prints
 
-double read_var;
+//RC receiver channel on INPUT_PIN, decoded by the pin interrupt
+RcInput rc;
+unsigned long last_print = 0;
 
 void setup() {
   // put your setup code here, to run once:
   Serial.begin(9600);
-  pinMode(INPUT_PIN, INPUT); 
+  rc.addPwm(INPUT_PIN);
+  rc.begin();
 }
 
 void loop() {
   // put your main code here, to run repeatedly:
-  read_var= digitalRead(INPUT_PIN);
-  Serial.println("Digital values: ");
-  Serial.println(read_var);
-  delay(500);
+  if (millis() - last_print < PRINT_PERIOD || Serial.availableForWrite() < 60)
+    return;
+  last_print = millis();
+
+  // Latest pulse, width 0 if the signal is lost
+  RcPulse pulse = rc.read(0);
+  Serial.print("PWM width: ");
+  Serial.print(pulse.width);
+  Serial.print(" us, age ");
+  Serial.print((micros() - pulse.stamp) / 1000);
+  Serial.print(" ms, pulses ");
+  Serial.print(pulse.frames);
+  Serial.print(", glitches ");
+  Serial.print(rc.glitches());
+  Serial.println(pulse.width ? "" : " FAILSAFE");
 }
@@ -0,0 +1,105 @@
+/**
+  ******************************************************************************
+  * @file           : i2c_queue.h
+  * @brief          : Non-blocking I2C transaction queue
+  ******************************************************************************
+  * Register reads/writes of any number of devices on one I2C bus are queued
+  * and run one after the other by the HAL interrupt (or DMA, if linked to
+  * the I2C handle) API: each completion starts the next transfer, so the
+  * main loop never waits for the bus.
+  *
+  * A transfer is described by a caller owned i2cq_xfer_t, which must stay
+  * valid until its completion (status no longer I2CQ_PENDING, done callback
+  * called from interrupt).
+  *
+  * Bus errors, arbitration loss or a transfer not completing in
+  * I2CQ_XFER_TIMEOUT ms make i2cq_poll() (main loop) reset the peripheral
+  * and clock SCL out to release a slave holding SDA low.
+  *
+  * CubeMX setup: I2Cx global interrupt enabled, optionally DMA requests.
+  * Forward the HAL callbacks:
+  *
+  *   void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)    { i2cq_cplt_callback(&q, hi2c); }
+  *   void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)    { i2cq_cplt_callback(&q, hi2c); }
+  *   void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c) { i2cq_cplt_callback(&q, hi2c); }
+  *   void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c) { i2cq_cplt_callback(&q, hi2c); }
+  *   void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)        { i2cq_error_callback(&q, hi2c); }
+  ******************************************************************************
+  */
+
+#ifndef __I2C_QUEUE_H
+#define __I2C_QUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f0xx_hal.h"
+
+#define I2CQ_DEPTH            8U      /* queued transfers, power of 2 */
+#define I2CQ_MAX_DEVS         8U      /* devices with statistics */
+#define I2CQ_XFER_TIMEOUT     25U     /* ms: a transfer taking longer is aborted */
+
+#define I2CQ_WRITE            0U
+#define I2CQ_READ             1U
+
+#define I2CQ_NO_REG           0U      /* reg_size: plain transmit/receive, no register address */
+
+#define I2CQ_PENDING          0xFF    /* status: queued or running */
+
+struct i2cq_xfer;
+typedef void (*i2cq_done_t)(struct i2cq_xfer *xfer);
+
+typedef struct i2cq_xfer
+{
+  uint16_t dev;                   /* device address, HAL (8 bit) format */
+  uint16_t reg;                   /* register address */
+  uint16_t reg_size;              /* I2C_MEMADD_SIZE_8BIT/16BIT or I2CQ_NO_REG */
+  uint8_t dir;                    /* I2CQ_READ/I2CQ_WRITE */
+  uint8_t *data;
+  uint16_t len;
+  i2cq_done_t done;               /* called from interrupt on completion (may be NULL) */
+  void *ctx;                      /* free for the caller */
+  volatile uint8_t status;        /* I2CQ_PENDING, then HAL_OK/HAL_ERROR/HAL_TIMEOUT */
+} i2cq_xfer_t;
+
+typedef struct
+{
+  uint16_t dev;
+  uint32_t xfers;                 /* completed transfers */
+  uint32_t bytes;                 /* data bytes transferred */
+  uint32_t errors;                /* failed transfers (NACK, bus error, timeout) */
+  uint32_t max_time;              /* ms, longest transfer (queue wait excluded) */
+} i2cq_dev_stats_t;
+
+typedef struct
+{
+  I2C_HandleTypeDef *hi2c;
+  GPIO_TypeDef *scl_port;
+  uint16_t scl_pin;
+  GPIO_TypeDef *sda_port;
+  uint16_t sda_pin;
+  i2cq_xfer_t *queue[I2CQ_DEPTH];
+  volatile uint8_t head;
+  volatile uint8_t tail;          /* queue[tail] is running while busy */
+  volatile uint8_t busy;
+  volatile uint8_t recover;       /* bus recovery requested */
+  volatile uint32_t start_time;   /* tick when the running transfer started */
+  i2cq_dev_stats_t devs[I2CQ_MAX_DEVS];
+  volatile uint32_t recoveries;
+  volatile uint32_t full;         /* submissions refused: queue full */
+} i2cq_t;
+
+void i2cq_init(i2cq_t *q, I2C_HandleTypeDef *hi2c, GPIO_TypeDef *scl_port, uint16_t scl_pin, GPIO_TypeDef *sda_port, uint16_t sda_pin);
+HAL_StatusTypeDef i2cq_submit(i2cq_t *q, i2cq_xfer_t *xfer);
+HAL_StatusTypeDef i2cq_transfer_sync(i2cq_t *q, i2cq_xfer_t *xfer);
+void i2cq_poll(i2cq_t *q);
+const i2cq_dev_stats_t *i2cq_get_stats(const i2cq_t *q, uint16_t dev);
+void i2cq_cplt_callback(i2cq_t *q, I2C_HandleTypeDef *hi2c);
+void i2cq_error_callback(i2cq_t *q, I2C_HandleTypeDef *hi2c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __I2C_QUEUE_H */
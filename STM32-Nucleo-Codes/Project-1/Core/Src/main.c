@@ -22,6 +22,7 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "i2c_queue.h"
 
 /* USER CODE END Includes */
 
@@ -33,6 +34,9 @@ uint8_t i2cdata[2];
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define DEV_ADDR        0x53      /* polled device, HAL address format */
+#define DEV_REG         0x010F    /* polled register (16 bit address) */
+#define POLL_PERIOD     50U       /* ms */
 
 /* USER CODE END PD */
 
@@ -47,6 +51,9 @@ I2C_HandleTypeDef hi2c1;
 UART_HandleTypeDef huart2;
 
 /* USER CODE BEGIN PV */
+i2cq_t i2c1_queue;
+uint8_t dev_value;                /* last value read from DEV_REG */
+static i2cq_xfer_t dev_read;
 
 /* USER CODE END PV */
 
@@ -56,11 +63,22 @@ static void MX_GPIO_Init(void);
 static void MX_USART2_UART_Init(void);
 static void MX_I2C1_Init(void);
 /* USER CODE BEGIN PFP */
+static void dev_read_done(i2cq_xfer_t *xfer);
 
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+/**
+  * @brief  Completion of the DEV_REG read (interrupt context)
+  */
+static void dev_read_done(i2cq_xfer_t *xfer)
+{
+  if (xfer->status == HAL_OK)
+  {
+    dev_value = xfer->data[0];
+  }
+}
 
 /* USER CODE END 0 */
 
@@ -96,7 +114,7 @@ int main(void)
   MX_USART2_UART_Init();
   MX_I2C1_Init();
   /* USER CODE BEGIN 2 */
-  if(HAL_I2C_IsDeviceReady(&hi2c1,0x53,2, 10)==HAL_OK)
+  if(HAL_I2C_IsDeviceReady(&hi2c1,DEV_ADDR,2, 10)==HAL_OK)
   {
 	  HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
 //	  printf("The device is ready!!\n");
@@ -105,14 +123,18 @@ int main(void)
   {
 //	  printf("The device not ready\n");
   }
-  //Transmit via I2C
-  i2cdata[0] = 0x01;  // High byte of register address
-  i2cdata[1] = 0x0F;  // Low byte of register address
-//  i2cdata[2]=  0x7F;  // Data to be written
-
-  HAL_I2C_Master_Transmit(&hi2c1,0x53,i2cdata,2,10);
-
-
+  i2cq_init(&i2c1_queue, &hi2c1, GPIOB, GPIO_PIN_8, GPIOB, GPIO_PIN_9);
+
+  //Read via I2C: register read queued every POLL_PERIOD, completed by interrupts
+  dev_read.dev = DEV_ADDR;
+  dev_read.reg = DEV_REG;
+  dev_read.reg_size = I2C_MEMADD_SIZE_16BIT;
+  dev_read.dir = I2CQ_READ;
+  dev_read.data = &i2cdata[1];
+  dev_read.len = 1;
+  dev_read.done = dev_read_done;
+  dev_read.status = HAL_OK;
+  uint32_t poll_time = HAL_GetTick();
 
   /* USER CODE END 2 */
 
@@ -121,14 +143,14 @@ int main(void)
   while (1)
   {
     /* USER CODE END WHILE */
-	  //Read via I2C
-	  i2cdata[0] = 0x01;  // High byte of register address
-	  i2cdata[1] = 0x0F;  // Low byte of register address
-	  HAL_I2C_Master_Transmit(&hi2c1,0x53,i2cdata,1,10);
-	  HAL_I2C_Master_Receive(&hi2c1,0x53,&i2cdata[1],1,10);
-	  HAL_Delay(50);
 
     /* USER CODE BEGIN 3 */
+	  i2cq_poll(&i2c1_queue);
+	  if (((HAL_GetTick() - poll_time) >= POLL_PERIOD) && (dev_read.status != I2CQ_PENDING))
+	  {
+		  poll_time = HAL_GetTick();
+		  i2cq_submit(&i2c1_queue, &dev_read);
+	  }
   }
   /* USER CODE END 3 */
 }
@@ -299,7 +321,30 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+  i2cq_cplt_callback(&i2c1_queue, hi2c);
+}
 
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+  i2cq_cplt_callback(&i2c1_queue, hi2c);
+}
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+  i2cq_cplt_callback(&i2c1_queue, hi2c);
+}
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+  i2cq_cplt_callback(&i2c1_queue, hi2c);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+  i2cq_error_callback(&i2c1_queue, hi2c);
+}
 /* USER CODE END 4 */
 
 /**
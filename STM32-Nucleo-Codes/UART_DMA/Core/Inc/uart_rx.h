@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file           : uart_rx.h
+  * @brief          : UART receiver: circular DMA + idle line framing
+  ******************************************************************************
+  * CubeMX setup: USARTx RX DMA request in circular mode, USARTx global
+  * interrupt and the DMA channel interrupt enabled.
+  *
+  * Usage:
+  *   uart_rx_start(&rx, &huart2, rx_ring_buff, sizeof(rx_ring_buff));
+  *
+  *   void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+  *   {
+  *     uart_rx_event_callback(&rx, huart, Size);
+  *   }
+  *   void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+  *   {
+  *     uart_rx_error_callback(&rx, huart);
+  *   }
+  *   USARTx_IRQHandler(), before HAL_UART_IRQHandler():
+  *     uart_rx_irq_handler(&rx);
+  *
+  *   main loop:
+  *   while (uart_rx_get_frame(&rx, &frame))
+  *   {
+  *     ... use frame.data/len (and data2/len2) ...
+  *     uart_rx_release_frame(&rx);
+  *   }
+  *
+  * A frame ends when the line stays idle for one character time, or when
+  * it reaches half of the buffer. Buffer size must be a power of 2 and
+  * should hold what is received during the longest main loop pass.
+  ******************************************************************************
+  */
+
+#ifndef __UART_RX_H
+#define __UART_RX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f0xx_hal.h"
+#include "uart_ring.h"
+
+typedef struct
+{
+  UART_HandleTypeDef *huart;
+  uart_ring_t ring;
+  volatile uint32_t uart_errors;    /* UART errors (overrun, framing, noise) */
+} uart_rx_t;
+
+HAL_StatusTypeDef uart_rx_start(uart_rx_t *rx, UART_HandleTypeDef *huart, uint8_t *buf, uint16_t size);
+void uart_rx_event_callback(uart_rx_t *rx, UART_HandleTypeDef *huart, uint16_t pos);
+void uart_rx_error_callback(uart_rx_t *rx, UART_HandleTypeDef *huart);
+void uart_rx_irq_handler(uart_rx_t *rx);
+void uart_rx_sync(uart_rx_t *rx);
+
+static inline uint8_t uart_rx_get_frame(uart_rx_t *rx, uart_frame_t *frame)
+{
+  uart_rx_sync(rx);
+  return uart_ring_get_frame(&rx->ring, frame);
+}
+
+static inline uint8_t uart_rx_release_frame(uart_rx_t *rx)
+{
+  uart_rx_sync(rx);
+  return uart_ring_release_frame(&rx->ring);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_RX_H */
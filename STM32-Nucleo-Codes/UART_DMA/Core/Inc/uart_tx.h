@@ -0,0 +1,67 @@
+/**
+  ******************************************************************************
+  * @file           : uart_tx.h
+  * @brief          : UART transmitter: queue of DMA buffers
+  ******************************************************************************
+  * UART_TX_BUFS buffers are filled by the application and sent in order:
+  * each DMA transfer completion starts the next queued buffer, so while one
+  * buffer is on the line the next ones are being filled.
+  *
+  * Usage:
+  *   uart_tx_init(&tx, &huart2);
+  *
+  *   void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+  *   {
+  *     uart_tx_cplt_callback(&tx, huart);
+  *   }
+  *   void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+  *   {
+  *     uart_tx_error_callback(&tx, huart);
+  *   }
+  *
+  *   main loop:
+  *   buf = uart_tx_alloc(&tx);       NULL (counted as drop) if all buffers are queued
+  *   ... write up to UART_TX_BUF_SIZE bytes into buf ...
+  *   uart_tx_send(&tx, len);
+  ******************************************************************************
+  */
+
+#ifndef __UART_TX_H
+#define __UART_TX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f0xx_hal.h"
+
+#define UART_TX_BUFS          4U      /* power of 2, at least 2 */
+#define UART_TX_BUF_SIZE      256U
+
+typedef struct
+{
+  UART_HandleTypeDef *huart;
+  uint8_t buf[UART_TX_BUFS][UART_TX_BUF_SIZE];
+  uint16_t len[UART_TX_BUFS];
+  volatile uint8_t head;          /* next buffer to fill (application) */
+  volatile uint8_t tail;          /* buffer on the line (ISR) */
+  volatile uint8_t busy;          /* DMA transfer running */
+
+  /* counters */
+  volatile uint32_t frames;       /* buffers sent */
+  volatile uint32_t bytes;        /* bytes sent */
+  volatile uint32_t drops;        /* allocations failed: all buffers queued */
+  volatile uint32_t errors;       /* DMA transfers failed (buffer dropped) */
+} uart_tx_t;
+
+void uart_tx_init(uart_tx_t *tx, UART_HandleTypeDef *huart);
+uint8_t *uart_tx_alloc(uart_tx_t *tx);
+void uart_tx_send(uart_tx_t *tx, uint16_t len);
+void uart_tx_cplt_callback(uart_tx_t *tx, UART_HandleTypeDef *huart);
+void uart_tx_error_callback(uart_tx_t *tx, UART_HandleTypeDef *huart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_TX_H */
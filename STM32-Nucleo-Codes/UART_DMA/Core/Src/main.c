@@ -22,6 +22,8 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include <string.h>
+#include "uart_rx.h"
+#include "uart_tx.h"
 
 /* USER CODE END Includes */
 
@@ -32,6 +34,13 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define RX_RING_SIZE    256U    /* circular DMA receive buffer, power of 2 */
+
+/* a frame (data + data2) is at most the whole ring, echo_process writes it
+ * into one TX buffer without a length check */
+#if RX_RING_SIZE > UART_TX_BUF_SIZE
+#error "RX_RING_SIZE must not exceed UART_TX_BUF_SIZE"
+#endif
 
 /* USER CODE END PD */
 
@@ -46,10 +55,11 @@ DMA_HandleTypeDef hdma_usart2_rx;
 DMA_HandleTypeDef hdma_usart2_tx;
 
 /* USER CODE BEGIN PV */
-uint8_t tx_buff[8];
-uint8_t rx_buff[8];
-uint8_t tx_empty = 1;
-uint8_t rx_full = 0;
+uint8_t rx_ring_buff[RX_RING_SIZE];
+uart_rx_t uart2_rx;
+uart_tx_t uart2_tx;
+uint32_t rx_rate;         /* bytes/s received, over last second */
+uint32_t tx_rate;         /* bytes/s sent, over last second */
 
 /* USER CODE END PV */
 
@@ -59,11 +69,33 @@ static void MX_GPIO_Init(void);
 static void MX_DMA_Init(void);
 static void MX_USART2_UART_Init(void);
 /* USER CODE BEGIN PFP */
+static uint16_t echo_process(uint8_t *out, const uart_frame_t *frame);
 
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+/**
+  * @brief  Echo processing: every byte incremented (saturating at 255),
+  *         read from the RX ring and written into a TX buffer in one pass.
+  *         out holds UART_TX_BUF_SIZE >= RX_RING_SIZE >= frame length bytes
+  * @retval bytes written
+  */
+static uint16_t echo_process(uint8_t *out, const uart_frame_t *frame)
+{
+  uint16_t n = 0;
+  uint16_t i;
+
+  for (i = 0; i < frame->len; i++)
+  {
+    out[n++] = (frame->data[i] < 255) ? (frame->data[i] + 1) : 255;
+  }
+  for (i = 0; i < frame->len2; i++)
+  {
+    out[n++] = (frame->data2[i] < 255) ? (frame->data2[i] + 1) : 255;
+  }
+  return n;
+}
 
 /* USER CODE END 0 */
 
@@ -99,52 +131,68 @@ int main(void)
   MX_USART2_UART_Init();
 
   /* USER CODE BEGIN 2 */
-  HAL_UART_Receive_DMA(&huart2, rx_buff, sizeof(rx_buff));
+  uart_tx_init(&uart2_tx, &huart2);
+  if (uart_rx_start(&uart2_rx, &huart2, rx_ring_buff, sizeof(rx_ring_buff)) != HAL_OK)
+  {
+    Error_Handler();
+  }
 
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
+  uint32_t rate_time = HAL_GetTick();
+  uint32_t rx_count = 0;
+  uint32_t tx_count = 0;
+
   while (1)
   {
-    if (rx_full)
-    {
-      rx_full = 0;
-      memcpy(tx_buff, rx_buff, sizeof(rx_buff));
+    uart_frame_t frame;
+    uint8_t *out;
+    uint16_t len = 0;
 
-      for (uint8_t i = 0; i < sizeof(tx_buff); i++)
+    /* every frame (bytes up to an idle line) is echoed back incremented:
+     * while a buffer is on the line the next frames fill the other ones */
+    while (uart_rx_get_frame(&uart2_rx, &frame))
+    {
+      out = uart_tx_alloc(&uart2_tx);
+      if (out != NULL)
       {
-        if (tx_buff[i] < 255) tx_buff[i]++;
+        len = echo_process(out, &frame);
       }
-
-      if (tx_empty)
+      if ((uart_rx_release_frame(&uart2_rx) == 0U) && (out != NULL))
       {
-        tx_empty = 0;
-        HAL_UART_Transmit_DMA(&huart2, tx_buff, sizeof(tx_buff));
+        uart_tx_send(&uart2_tx, len);
       }
+    }
 
-      // Re-initiate DMA reception
-      HAL_UART_Receive_DMA(&huart2, rx_buff, sizeof(rx_buff));
+    if ((HAL_GetTick() - rate_time) >= 1000U)
+    {
+      rate_time += 1000U;
+      rx_rate = uart2_rx.ring.wr_count - rx_count;
+      rx_count = uart2_rx.ring.wr_count;
+      tx_rate = uart2_tx.bytes - tx_count;
+      tx_count = uart2_tx.bytes;
     }
   }
   /* USER CODE END WHILE */
 }
 
 /* USER CODE BEGIN 4 */
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
 {
-  if (huart == &huart2)
-  {
-    rx_full = 1;
-  }
+  uart_rx_event_callback(&uart2_rx, huart, Size);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  uart_rx_error_callback(&uart2_rx, huart);
+  uart_tx_error_callback(&uart2_tx, huart);
 }
 
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
-  if (huart == &huart2)
-  {
-    tx_empty = 1;
-  }
+  uart_tx_cplt_callback(&uart2_tx, huart);
 }
 /* USER CODE END 4 */
 
@@ -0,0 +1,177 @@
+/**
+  ******************************************************************************
+  * @file           : uart_ring.c
+  * @brief          : Frame ring over a circular DMA receive buffer
+  ******************************************************************************
+  * Positions are kept as free running stream indexes (bytes received since
+  * init): buffer index is stream index & (size - 1), and a byte is overwritten
+  * once the DMA is more than size bytes ahead of it.
+  ******************************************************************************
+  */
+
+#include <stddef.h>
+#include "uart_ring.h"
+
+/* keeps the compiler from moving descriptor stores after the index store */
+#define RING_BARRIER()    __asm volatile ("" ::: "memory")
+
+/**
+  * @brief  Init the ring over buf (size must be a power of 2)
+  */
+void uart_ring_init(uart_ring_t *ring, uint8_t *buf, uint16_t size)
+{
+  ring->buf = buf;
+  ring->size = size;
+  ring->last_pos = 0;
+  ring->wr_count = 0;
+  ring->frame_start = 0;
+  ring->frame_head = 0;
+  ring->frame_tail = 0;
+  ring->frames_rx = 0;
+  ring->frame_drops = 0;
+  ring->overruns = 0;
+  ring->splits = 0;
+  ring->restarts = 0;
+}
+
+/**
+  * @brief  Closes the open frame, queueing it for the application
+  */
+static void ring_close_frame(uart_ring_t *ring)
+{
+  uint8_t next = (ring->frame_head + 1U) & (UART_RING_FRAMES - 1U);
+
+  if (next == ring->frame_tail)
+  {
+    ring->frame_drops++;
+  }
+  else
+  {
+    ring->frames[ring->frame_head].start = ring->frame_start;
+    ring->frames[ring->frame_head].len = (uint16_t)(ring->wr_count - ring->frame_start);
+    RING_BARRIER();
+    ring->frame_head = next;
+    ring->frames_rx++;
+  }
+  ring->frame_start = ring->wr_count;
+}
+
+/**
+  * @brief  DMA progress (ISR side)
+  * @param  pos: DMA write position in the buffer (0..size)
+  * @param  idle: 1 if the line went idle (end of frame)
+  *
+  * Also called from the application side (with interrupts disabled) with
+  * the current DMA position, so the overrun checks see the bytes received
+  * since the last interrupt.
+  *
+  * A frame reaching half of the buffer without idle line is closed anyway,
+  * so a continuous stream keeps flowing and no frame is longer than the buffer.
+  */
+void uart_ring_event(uart_ring_t *ring, uint16_t pos, uint8_t idle)
+{
+  uint16_t n;
+  uint32_t len;
+
+  n = (pos >= ring->last_pos) ? (pos - ring->last_pos) : (pos + ring->size - ring->last_pos);
+  if ((pos == ring->size) && (ring->last_pos == 0U))
+  {
+    /* transfer complete of a wrap already taken at pos 0 (application side
+       sync before the interrupt): a whole buffer without half transfer
+       event can't happen */
+    n = 0;
+  }
+  ring->last_pos = pos & (ring->size - 1U);
+  ring->wr_count += n;
+
+  len = ring->wr_count - ring->frame_start;
+  if (len == 0U)
+  {
+    return;
+  }
+  if (idle)
+  {
+    ring_close_frame(ring);
+  }
+  else if (len >= (ring->size / 2U))
+  {
+    ring->splits++;
+    ring_close_frame(ring);
+  }
+}
+
+/**
+  * @brief  DMA restarted from the beginning of the buffer (ISR side):
+  *         the open frame is dropped, queued frames stay valid until
+  *         overwritten
+  */
+void uart_ring_restart(uart_ring_t *ring)
+{
+  /* move the stream index to buffer index 0 */
+  ring->wr_count = (ring->wr_count + ring->size - 1U) & ~(uint32_t)(ring->size - 1U);
+  ring->frame_start = ring->wr_count;
+  ring->last_pos = 0;
+  ring->restarts++;
+}
+
+/**
+  * @brief  Oldest received frame (application side), still owned by the ring
+  *         until uart_ring_release_frame()
+  * @retval 1 if *frame is set, 0 if no frames
+  */
+uint8_t uart_ring_get_frame(uart_ring_t *ring, uart_frame_t *frame)
+{
+  uart_frame_desc_t desc;
+  uint16_t idx;
+
+  while (ring->frame_tail != ring->frame_head)
+  {
+    desc = ring->frames[ring->frame_tail];
+    if ((ring->wr_count - desc.start) > ring->size)
+    {
+      /* already overwritten by the DMA */
+      ring->overruns++;
+      ring->frame_tail = (ring->frame_tail + 1U) & (UART_RING_FRAMES - 1U);
+      continue;
+    }
+
+    idx = desc.start & (ring->size - 1U);
+    frame->data = &ring->buf[idx];
+    if ((uint32_t)idx + desc.len > ring->size)
+    {
+      frame->len = ring->size - idx;
+      frame->data2 = ring->buf;
+      frame->len2 = desc.len - frame->len;
+    }
+    else
+    {
+      frame->len = desc.len;
+      frame->data2 = NULL;
+      frame->len2 = 0;
+    }
+    return 1;
+  }
+  return 0;
+}
+
+/**
+  * @brief  Gives back the frame taken by uart_ring_get_frame()
+  * @retval 0 if the frame was intact while in use, 1 if the DMA overwrote it
+  *         (its content must be discarded)
+  */
+uint8_t uart_ring_release_frame(uart_ring_t *ring)
+{
+  uint8_t overwritten = 0;
+
+  if (ring->frame_tail == ring->frame_head)
+  {
+    return 0;
+  }
+  if ((ring->wr_count - ring->frames[ring->frame_tail].start) > ring->size)
+  {
+    ring->overruns++;
+    overwritten = 1;
+  }
+  ring->frame_tail = (ring->frame_tail + 1U) & (UART_RING_FRAMES - 1U);
+  return overwritten;
+}
@@ -0,0 +1,114 @@
+/**
+  ******************************************************************************
+  * @file           : uart_tx.c
+  * @brief          : UART transmitter: queue of DMA buffers
+  ******************************************************************************
+  * head and tail are free running: (head - tail) buffers are queued,
+  * the one at tail is on the line while busy is set.
+  ******************************************************************************
+  */
+
+#include "uart_tx.h"
+
+#define TX_IDX(n)     ((n) & (UART_TX_BUFS - 1U))
+
+/**
+  * @brief  Starts the transfer of the buffer at tail (interrupts disabled
+  *         or called from the TX complete callback)
+  */
+static void tx_kick(uart_tx_t *tx)
+{
+  uint8_t idx;
+
+  while ((!tx->busy) && (tx->head != tx->tail))
+  {
+    idx = TX_IDX(tx->tail);
+    if (HAL_UART_Transmit_DMA(tx->huart, tx->buf[idx], tx->len[idx]) == HAL_OK)
+    {
+      tx->busy = 1;
+    }
+    else
+    {
+      tx->errors++;
+      tx->tail++;
+    }
+  }
+}
+
+void uart_tx_init(uart_tx_t *tx, UART_HandleTypeDef *huart)
+{
+  tx->huart = huart;
+  tx->head = 0;
+  tx->tail = 0;
+  tx->busy = 0;
+  tx->frames = 0;
+  tx->bytes = 0;
+  tx->drops = 0;
+  tx->errors = 0;
+}
+
+/**
+  * @brief  Next free buffer (UART_TX_BUF_SIZE bytes)
+  * @retval NULL if all buffers are queued
+  */
+uint8_t *uart_tx_alloc(uart_tx_t *tx)
+{
+  if ((uint8_t)(tx->head - tx->tail) >= UART_TX_BUFS)
+  {
+    tx->drops++;
+    return NULL;
+  }
+  return tx->buf[TX_IDX(tx->head)];
+}
+
+/**
+  * @brief  Queues the buffer given by uart_tx_alloc(), len bytes
+  */
+void uart_tx_send(uart_tx_t *tx, uint16_t len)
+{
+  uint32_t primask;
+
+  if ((len == 0U) || ((uint8_t)(tx->head - tx->tail) >= UART_TX_BUFS))
+  {
+    return;
+  }
+  tx->len[TX_IDX(tx->head)] = (len > UART_TX_BUF_SIZE) ? UART_TX_BUF_SIZE : len;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  tx->head++;
+  tx_kick(tx);
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  To be called from HAL_UART_TxCpltCallback()
+  */
+void uart_tx_cplt_callback(uart_tx_t *tx, UART_HandleTypeDef *huart)
+{
+  if ((huart != tx->huart) || (!tx->busy))
+  {
+    return;
+  }
+  tx->frames++;
+  tx->bytes += tx->len[TX_IDX(tx->tail)];
+  tx->tail++;
+  tx->busy = 0;
+  tx_kick(tx);
+}
+
+/**
+  * @brief  To be called from HAL_UART_ErrorCallback(): a failed transfer
+  *         is dropped and the next queued buffer started
+  */
+void uart_tx_error_callback(uart_tx_t *tx, UART_HandleTypeDef *huart)
+{
+  if ((huart != tx->huart) || (!tx->busy) || (huart->gState != HAL_UART_STATE_READY))
+  {
+    return;
+  }
+  tx->errors++;
+  tx->tail++;
+  tx->busy = 0;
+  tx_kick(tx);
+}
@@ -0,0 +1,462 @@
+/**
+  ******************************************************************************
+  * @file           : test_uart_ring.c
+  * @brief          : Host test of the frame ring over the DMA receive buffer
+  ******************************************************************************
+  * The DMA and the HAL are simulated: received bytes are written into the
+  * buffer one by one, with the events uart_rx.c passes to the ring:
+  *   - half transfer: pos = size / 2, not idle
+  *   - transfer complete: pos = size, not idle, the DMA wraps to 0
+  *   - idle line: current pos, idle (at pos 0 after a wrap it comes from
+  *     uart_rx_irq_handler(), the HAL doesn't report it)
+  *   - UART error: reception restarted at buffer index 0
+  *   - application side sync: current pos, not idle (uart_rx_get_frame() and
+  *     uart_rx_release_frame() do it)
+  * Stream bytes are their stream index & 0xFF, so any delivered frame can be
+  * checked to be contiguous and in order.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include "uart_ring.h"
+
+#define RING_SIZE       64U
+#define MAX_FRAME       (2U * RING_SIZE)
+
+#define CHECK(cond)     check((cond), #cond, __LINE__)
+
+static uart_ring_t ring;
+static uint8_t ring_buf[RING_SIZE];
+static uint16_t dma_pos;          /* DMA write index in ring_buf */
+static uint32_t stream_count;     /* bytes sent since reset */
+static uint32_t next_expected;    /* stream index of the next delivered byte */
+static int failures;
+static uint32_t rand_state = 2463534242U;
+
+static void check(int ok, const char *expr, int line)
+{
+  if (!ok)
+  {
+    failures++;
+    printf("test_uart_ring.c:%d: check failed: %s\n", line, expr);
+  }
+}
+
+static uint32_t test_rand(void)
+{
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 17;
+  rand_state ^= rand_state << 5;
+  return rand_state;
+}
+
+static void sim_reset(void)
+{
+  memset(ring_buf, 0, sizeof(ring_buf));
+  uart_ring_init(&ring, ring_buf, RING_SIZE);
+  dma_pos = 0;
+  stream_count = 0;
+  next_expected = 0;
+}
+
+/* DMA side: n bytes received, with the half transfer and transfer complete
+   events on the way */
+static void sim_receive(uint32_t n)
+{
+  while (n-- > 0U)
+  {
+    ring_buf[dma_pos++] = (uint8_t)stream_count++;
+    if (dma_pos == RING_SIZE / 2U)
+    {
+      uart_ring_event(&ring, dma_pos, 0);
+    }
+    else if (dma_pos == RING_SIZE)
+    {
+      uart_ring_event(&ring, RING_SIZE, 0);
+      dma_pos = 0;
+    }
+  }
+}
+
+/* the line went idle after the last byte */
+static void sim_idle(void)
+{
+  uart_ring_event(&ring, dma_pos, 1);
+}
+
+/* UART error: the open frame is lost, the DMA restarts at index 0 */
+static void sim_error(void)
+{
+  uart_ring_restart(&ring);
+  stream_count = ring.wr_count;
+  dma_pos = 0;
+}
+
+/* application side: the DMA position read from its counter */
+static void sim_sync(void)
+{
+  uart_ring_event(&ring, dma_pos, 0);
+}
+
+/* application side: copies the oldest frame out of the ring and releases it
+   @retval frame length, -1 if no frame, -2 if overwritten while in use */
+static int take_frame(uint8_t *out, uart_frame_t *frame)
+{
+  uart_frame_t f;
+
+  sim_sync();
+  if (!uart_ring_get_frame(&ring, &f))
+  {
+    return -1;
+  }
+  CHECK(f.len > 0U);
+  CHECK((f.data2 == NULL) == (f.len2 == 0U));
+  CHECK((f.data >= ring_buf) && (f.data + f.len <= ring_buf + RING_SIZE));
+  if (f.data2 != NULL)
+  {
+    /* second segment only when the first one reaches the end of the buffer */
+    CHECK(f.data + f.len == ring_buf + RING_SIZE);
+    CHECK(f.data2 == ring_buf);
+  }
+  memcpy(out, f.data, f.len);
+  if (f.len2 > 0U)
+  {
+    memcpy(out + f.len, f.data2, f.len2);
+  }
+  if (frame != NULL)
+  {
+    *frame = f;
+  }
+  sim_sync();
+  if (uart_ring_release_frame(&ring) != 0U)
+  {
+    return -2;
+  }
+  return f.len + f.len2;
+}
+
+/* frame content: stream bytes starting at first */
+static int frame_is(const uint8_t *data, int len, uint32_t first)
+{
+  int i;
+
+  for (i = 0; i < len; i++)
+  {
+    if (data[i] != (uint8_t)(first + (uint32_t)i))
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void test_frames(void)
+{
+  uint8_t out[MAX_FRAME];
+  uart_frame_t f;
+
+  sim_reset();
+  sim_receive(3);
+  CHECK(take_frame(out, NULL) == -1);       /* no idle line yet */
+  sim_idle();
+  sim_receive(5);
+  sim_idle();
+  sim_idle();                               /* repeated idle: no empty frame */
+
+  CHECK(take_frame(out, &f) == 3);
+  CHECK(frame_is(out, 3, 0));
+  CHECK(f.data == ring_buf);                /* a view, not a copy */
+  CHECK(take_frame(out, NULL) == 5);
+  CHECK(frame_is(out, 5, 3));
+  CHECK(take_frame(out, NULL) == -1);
+  CHECK(ring.frames_rx == 2U);
+  CHECK((ring.overruns | ring.frame_drops | ring.splits) == 0U);
+}
+
+static void test_wrap(void)
+{
+  uint8_t out[MAX_FRAME];
+  uart_frame_t f;
+
+  sim_reset();
+  sim_receive(20);
+  sim_idle();
+  sim_receive(30);
+  sim_idle();
+  CHECK(take_frame(out, NULL) == 20);
+  CHECK(take_frame(out, NULL) == 30);
+  /* 30 bytes from index 50: 14 up to the end, 16 from the start */
+  sim_receive(30);
+  sim_idle();
+  CHECK(take_frame(out, &f) == 30);
+  CHECK((f.len == 14U) && (f.len2 == 16U));
+  CHECK(f.data == ring_buf + 50);
+  CHECK(frame_is(out, 30, 50));
+}
+
+static void test_end_of_buffer(void)
+{
+  uint8_t out[MAX_FRAME];
+
+  sim_reset();
+  sim_receive(20);
+  sim_idle();
+  sim_receive(20);
+  sim_idle();
+  CHECK(take_frame(out, NULL) == 20);
+  CHECK(take_frame(out, NULL) == 20);
+  sim_receive(RING_SIZE - 40U);             /* ends exactly at the buffer end */
+  sim_idle();
+  sim_receive(7);
+  sim_idle();
+
+  CHECK(take_frame(out, NULL) == (int)(RING_SIZE - 40U));
+  CHECK(frame_is(out, RING_SIZE - 40U, 40));
+  CHECK(take_frame(out, NULL) == 7);
+  CHECK(frame_is(out, 7, RING_SIZE));
+}
+
+static void test_split(void)
+{
+  uint8_t out[MAX_FRAME];
+  uint32_t first = 0;
+  int len;
+
+  uint8_t i;
+
+  /* a continuous stream without idle line is cut at half buffer */
+  sim_reset();
+  for (i = 0; i < 10U; i++)
+  {
+    sim_receive(10);
+    while ((len = take_frame(out, NULL)) > 0)
+    {
+      CHECK(len == (int)(RING_SIZE / 2U));
+      CHECK(frame_is(out, len, first));
+      first += (uint32_t)len;
+    }
+    CHECK(len == -1);
+  }
+  CHECK(ring.splits == 3U);
+  sim_idle();
+  CHECK(take_frame(out, NULL) == 4);
+  CHECK(frame_is(out, 4, 96));
+  CHECK(first == 96U);
+}
+
+static void test_overrun(void)
+{
+  uint8_t out[MAX_FRAME];
+  uint8_t i;
+
+  /* frame 0 overwritten before the application gets to it */
+  sim_reset();
+  sim_receive(10);
+  sim_idle();
+  for (i = 0; i < 4U; i++)
+  {
+    sim_receive(20);
+    sim_idle();
+  }
+  CHECK(take_frame(out, NULL) == 20);
+  CHECK(frame_is(out, 20, 30));             /* frames 0 and 1 lost */
+  CHECK(ring.overruns == 2U);
+
+  /* frame overwritten while the application uses it */
+  sim_reset();
+  sim_receive(10);
+  sim_idle();
+  {
+    uart_frame_t f;
+
+    CHECK(uart_ring_get_frame(&ring, &f) == 1U);
+    sim_receive(RING_SIZE - 20U);
+    sim_sync();
+    CHECK(uart_ring_release_frame(&ring) == 0U);
+    CHECK(uart_ring_get_frame(&ring, &f) == 1U);    /* the split frame */
+    sim_receive(21);            /* over its first byte, no event since the wrap */
+    sim_sync();
+    CHECK(uart_ring_release_frame(&ring) == 1U);
+    CHECK(ring.overruns == 1U);
+  }
+}
+
+static void test_sync_before_interrupt(void)
+{
+  uint8_t out[MAX_FRAME];
+
+  /* the application takes pos 0 right after the wrap, before the transfer
+     complete interrupt: the wrap counts once */
+  sim_reset();
+  sim_receive(20);
+  sim_idle();
+  CHECK(take_frame(out, NULL) == 20);
+  uart_ring_event(&ring, RING_SIZE / 2U, 0);
+  uart_ring_event(&ring, 0, 0);
+  CHECK(ring.wr_count == RING_SIZE);
+  uart_ring_event(&ring, RING_SIZE, 0);
+  CHECK(ring.wr_count == RING_SIZE);
+  uart_ring_event(&ring, 5, 1);
+  CHECK(ring.wr_count == RING_SIZE + 5U);
+}
+
+static void test_queue_full(void)
+{
+  uint8_t out[MAX_FRAME];
+  uint32_t first = 0;
+  int n = 0;
+  int len;
+  uint8_t i;
+
+  sim_reset();
+  for (i = 0; i < 20U; i++)
+  {
+    sim_receive(2);
+    sim_idle();
+  }
+  CHECK(ring.frames_rx == UART_RING_FRAMES - 1U);
+  CHECK(ring.frame_drops == 20U - (UART_RING_FRAMES - 1U));
+  while ((len = take_frame(out, NULL)) > 0)
+  {
+    CHECK(len == 2);
+    CHECK(frame_is(out, len, first));
+    first += 2U;
+    n++;
+  }
+  CHECK(n == (int)(UART_RING_FRAMES - 1U));
+}
+
+static void test_restart(void)
+{
+  uint8_t out[MAX_FRAME];
+  uint32_t restart_index;
+
+  sim_reset();
+  sim_receive(12);
+  sim_idle();
+  sim_receive(5);                           /* open frame, lost by the error */
+  sim_error();
+  restart_index = ring.wr_count;
+  CHECK((restart_index & (RING_SIZE - 1U)) == 0U);
+  CHECK(ring.restarts == 1U);
+  CHECK(take_frame(out, NULL) == 12);       /* queued before: still valid */
+  CHECK(frame_is(out, 12, 0));
+  sim_receive(9);
+  sim_idle();
+  CHECK(take_frame(out, NULL) == 9);
+  CHECK(frame_is(out, 9, restart_index));
+  CHECK(take_frame(out, NULL) == -1);
+
+  /* until the restarted DMA writes over it */
+  sim_reset();
+  sim_receive(12);
+  sim_idle();
+  sim_error();
+  sim_receive(9);
+  sim_idle();
+  CHECK(take_frame(out, NULL) == 9);
+  CHECK(ring.overruns == 1U);
+}
+
+/* random frame lengths and reading rates: with a reader that looks at the
+   ring at least every 8 bytes the frames cover the stream exactly, with a
+   slow one every delivered frame is intact and in order, and the counters
+   account for the rest */
+static void test_random(void)
+{
+  uint8_t out[MAX_FRAME];
+  uint32_t delivered, lost_frames, frames, round;
+  uint32_t first;
+  int len;
+  int slow;
+
+  for (slow = 0; slow <= 1; slow++)
+  {
+    sim_reset();
+    delivered = 0;
+    lost_frames = 0;
+    frames = 0;
+    for (round = 0; round < 100000U; round++)
+    {
+      sim_receive(1U + (test_rand() % 8U));
+      if ((test_rand() % 4U) == 0U)
+      {
+        sim_idle();
+      }
+      /* fast: reads everything, slow: now and then a frame */
+      while ((slow ? ((test_rand() % 4U) == 0U) : 1) &&
+             ((len = take_frame(out, NULL)) != -1))
+      {
+        frames++;
+        if (len == -2)
+        {
+          lost_frames++;
+          continue;
+        }
+        CHECK(len <= (int)RING_SIZE);
+        first = stream_count - 1U;
+        /* find its start: the first byte tells the stream index mod 256 */
+        while ((uint8_t)first != out[0])
+        {
+          first--;
+        }
+        CHECK(frame_is(out, len, first));
+        CHECK(first >= next_expected);
+        next_expected = first + (uint32_t)len;
+        delivered += (uint32_t)len;
+        if (slow == 0)
+        {
+          CHECK(delivered == next_expected);
+        }
+        if (slow)
+        {
+          break;
+        }
+      }
+      if (failures > 0)
+      {
+        return;
+      }
+    }
+    sim_idle();
+    while ((len = take_frame(out, NULL)) != -1)
+    {
+      frames++;
+      if (len > 0)
+      {
+        delivered += (uint32_t)len;
+      }
+    }
+    if (slow == 0)
+    {
+      CHECK(delivered == stream_count);
+      CHECK((ring.overruns | ring.frame_drops) == 0U);
+    }
+    else
+    {
+      CHECK(ring.overruns > 0U);
+      CHECK(frames + ring.overruns - lost_frames == ring.frames_rx);
+    }
+    printf("%s reader: %lu bytes, %lu frames, %lu splits, %lu overruns, %lu drops\n",
+           slow ? "slow" : "fast", (unsigned long)stream_count,
+           (unsigned long)ring.frames_rx, (unsigned long)ring.splits,
+           (unsigned long)ring.overruns, (unsigned long)ring.frame_drops);
+  }
+}
+
+int main(void)
+{
+  test_frames();
+  test_wrap();
+  test_end_of_buffer();
+  test_split();
+  test_overrun();
+  test_queue_full();
+  test_restart();
+  test_sync_before_interrupt();
+  test_random();
+
+  printf("test_uart_ring: %s\n", (failures == 0) ? "OK" : "FAILED");
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file           : uart_ring.h
+  * @brief          : Frame ring over a circular DMA receive buffer
+  ******************************************************************************
+  * The DMA writes received bytes into the ring buffer, wrapping around on its
+  * own. The ISR side only reports how far the DMA got (uart_ring_event()) and
+  * whether the line went idle; idle line closes the current frame.
+  * The application takes frames as views into the ring (no copy): a frame
+  * wrapping around the end of the buffer comes as two segments.
+  *
+  * The DMA doesn't know what the application still reads, so data is never
+  * held back: a frame overwritten before it is released is counted as
+  * overrun and dropped.
+  *
+  * No HAL dependency: the ring can be driven by hand (e.g. on a host).
+  ******************************************************************************
+  */
+
+#ifndef __UART_RING_H
+#define __UART_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* number of closed frames waiting for the application (power of 2) */
+#define UART_RING_FRAMES      16U
+
+typedef struct
+{
+  const uint8_t *data;        /* first segment */
+  uint16_t len;
+  const uint8_t *data2;       /* second segment, when the frame wraps (NULL otherwise) */
+  uint16_t len2;
+} uart_frame_t;
+
+typedef struct
+{
+  uint32_t start;             /* stream index of the first byte */
+  uint16_t len;
+} uart_frame_desc_t;
+
+typedef struct
+{
+  uint8_t *buf;
+  uint16_t size;                              /* buffer size, power of 2 */
+  uint16_t last_pos;                          /* DMA position at last event */
+  volatile uint32_t wr_count;                 /* bytes written by DMA since init (stream index) */
+  uint32_t frame_start;                       /* stream index of the open frame */
+  uart_frame_desc_t frames[UART_RING_FRAMES];
+  volatile uint8_t frame_head;                /* written by ISR side */
+  volatile uint8_t frame_tail;                /* written by application side */
+
+  /* counters */
+  volatile uint32_t frames_rx;                /* frames queued */
+  volatile uint32_t frame_drops;              /* frames lost: frame queue full */
+  volatile uint32_t overruns;                 /* frames overwritten by DMA before release */
+  volatile uint32_t splits;                   /* frames cut at half buffer, no idle line yet */
+  volatile uint32_t restarts;                 /* reception restarted (after UART errors) */
+} uart_ring_t;
+
+void uart_ring_init(uart_ring_t *ring, uint8_t *buf, uint16_t size);
+void uart_ring_event(uart_ring_t *ring, uint16_t pos, uint8_t idle);
+void uart_ring_restart(uart_ring_t *ring);
+uint8_t uart_ring_get_frame(uart_ring_t *ring, uart_frame_t *frame);
+uint8_t uart_ring_release_frame(uart_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_RING_H */
@@ -22,6 +22,7 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include <string.h>
+#include "uart_rx.h"
 
 /* USER CODE END Includes */
 
@@ -32,10 +33,12 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define RX_RING_SIZE    256U    /* circular DMA receive buffer, power of 2 */
+#define CMD_SIZE        100U    /* longest command line, with the '\0' */
+
 uint8_t tx_buffer[30]="Hi idiot\n\r";
 uint8_t rx_index;
-uint8_t rx_data[1];
-uint8_t rx_buffer[100]={0};
+uint8_t rx_buffer[CMD_SIZE]={0};
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -45,21 +48,70 @@ uint8_t rx_buffer[100]={0};
 
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart2_rx;
 
 /* USER CODE BEGIN PV */
+uint8_t rx_ring_buff[RX_RING_SIZE];
+uart_rx_t uart2_rx;
+uint32_t cmd_overflows;   /* command lines longer than CMD_SIZE, dropped */
 
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART2_UART_Init(void);
 /* USER CODE BEGIN PFP */
+static void command_byte(uint8_t c);
 
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+/**
+  * @brief  Command line assembly: bytes up to '\r' form a command,
+  *         "LED ON" and "LED OFF" drive the LED, every line is acknowledged.
+  *         A line longer than the buffer is dropped up to its '\r'.
+  * @retval None
+  */
+static void command_byte(uint8_t c)
+{
+  if(c!='\r')
+  {
+    if(rx_index<CMD_SIZE-1)
+    {
+      rx_buffer[rx_index++]=c;
+    }
+    else if(rx_index==CMD_SIZE-1)
+    {
+      cmd_overflows++;
+      rx_index=CMD_SIZE;    /* discard until '\r' */
+    }
+    return;
+  }
+
+  if(rx_index<CMD_SIZE)
+  {
+    rx_buffer[rx_index] = '\0'; // Null-terminate the string
+
+    if(strcmp((char*)rx_buffer, "LED ON") == 0)
+    {
+      HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, GPIO_PIN_SET); // Turn LED ON
+    }
+    else if(strcmp((char*)rx_buffer, "LED OFF") == 0)
+    {
+      HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, GPIO_PIN_RESET); // Turn LED OFF
+    }
+  }
+
+  // Reset index and buffer for the next command
+  rx_index = 0;
+  memset(rx_buffer, 0, sizeof(rx_buffer)); // Clear buffer
+
+  // Acknowledge the command (Optional)
+  HAL_UART_Transmit(&huart2, (uint8_t*)"\n\rCommand received\r\n", 22, 100);
+}
 
 /* USER CODE END 0 */
 
@@ -92,9 +144,13 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART2_UART_Init();
   /* USER CODE BEGIN 2 */
-  HAL_UART_Receive_IT(&huart2,rx_data,1);
+  if (uart_rx_start(&uart2_rx, &huart2, rx_ring_buff, sizeof(rx_ring_buff)) != HAL_OK)
+  {
+    Error_Handler();
+  }
 
   /* USER CODE END 2 */
 
@@ -107,6 +163,29 @@ int main(void)
 //	  HAL_Delay(1000);
 
     /* USER CODE BEGIN 3 */
+    uart_frame_t frame;
+    uint16_t i;
+
+    /* frames (bytes up to an idle line) are echoed back in one transfer
+     * each and fed to the command parser; the DMA keeps receiving into the
+     * ring meanwhile */
+    while (uart_rx_get_frame(&uart2_rx, &frame))
+    {
+      HAL_UART_Transmit(&huart2, frame.data, frame.len, 100);
+      if (frame.len2 > 0)
+      {
+        HAL_UART_Transmit(&huart2, frame.data2, frame.len2, 100);
+      }
+      for (i = 0; i < frame.len; i++)
+      {
+        command_byte(frame.data[i]);
+      }
+      for (i = 0; i < frame.len2; i++)
+      {
+        command_byte(frame.data2[i]);
+      }
+      uart_rx_release_frame(&uart2_rx);
+    }
   }
   /* USER CODE END 3 */
 }
@@ -184,6 +263,22 @@ static void MX_USART2_UART_Init(void)
 
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Channel4_5_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel4_5_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel4_5_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -221,50 +316,14 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
 {
-  /* Prevent unused argument(s) compilation warning */
-  UNUSED(huart);
-
-  /* NOTE : This function should not be modified, when the callback is needed,
-            the HAL_UART_RxCpltCallback can be implemented in the user file.
-   */
-//  HAL_UART_Transmit(&huart2, rx_data, 10, 10);
-  if(huart->Instance==USART2)
-  {
-	  if(rx_index>=100-1)// Check for buffer overflow
-	  {
-//		  HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, GPIO_PIN_RESET);
-		  rx_index=0;
-	  }
-	  if(rx_data[0]!='\r')// Check if the received character is not Carriage Return
-	  {
-		  rx_buffer[rx_index++]=rx_data[0];
-	  }
-	  else
-	  {
-          rx_buffer[rx_index] = '\0'; // Null-terminate the string
-
-          if(strcmp((char*)rx_buffer, "LED ON") == 0)
-          {
-              HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, GPIO_PIN_SET); // Turn LED ON
-          }
-          else if(strcmp((char*)rx_buffer, "LED OFF") == 0)
-          {
-              HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, GPIO_PIN_RESET); // Turn LED OFF
-          }
-
-          // Reset index and buffer for the next command
-          rx_index = 0;
-          memset(rx_buffer, 0, sizeof(rx_buffer)); // Clear buffer
-
-          // Acknowledge the command (Optional)
-          HAL_UART_Transmit(&huart2, (uint8_t*)"\n\rCommand received\r\n", 22, 100);
-
-	  }
-	  HAL_UART_Receive_IT(&huart2, rx_data,1);
-	  HAL_UART_Transmit(&huart2, rx_data, sizeof(rx_data),100);
-  }
+  uart_rx_event_callback(&uart2_rx, huart, Size);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  uart_rx_error_callback(&uart2_rx, huart);
 }
 
 /* USER CODE END 4 */
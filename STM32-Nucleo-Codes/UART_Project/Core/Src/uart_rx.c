@@ -0,0 +1,97 @@
+/**
+  ******************************************************************************
+  * @file           : uart_rx.c
+  * @brief          : UART receiver: circular DMA + idle line framing
+  ******************************************************************************
+  * HAL side of the receiver: HAL_UARTEx_ReceiveToIdle_DMA() in circular mode
+  * reports the DMA position on half transfer, transfer complete and idle line;
+  * each report is passed to the frame ring.
+  ******************************************************************************
+  */
+
+#include "uart_rx.h"
+
+/**
+  * @brief  Starts reception into buf (size: power of 2)
+  * @retval HAL_ERROR if the RX DMA is not circular or size is not a power of 2
+  */
+HAL_StatusTypeDef uart_rx_start(uart_rx_t *rx, UART_HandleTypeDef *huart, uint8_t *buf, uint16_t size)
+{
+  if ((huart->hdmarx == NULL) || (huart->hdmarx->Init.Mode != DMA_CIRCULAR) ||
+      (size == 0U) || ((size & (size - 1U)) != 0U))
+  {
+    return HAL_ERROR;
+  }
+  rx->huart = huart;
+  rx->uart_errors = 0;
+  uart_ring_init(&rx->ring, buf, size);
+  return HAL_UARTEx_ReceiveToIdle_DMA(huart, buf, size);
+}
+
+/**
+  * @brief  To be called from HAL_UARTEx_RxEventCallback()
+  * @param  pos: DMA position in the buffer, as given by the HAL
+  */
+void uart_rx_event_callback(uart_rx_t *rx, UART_HandleTypeDef *huart, uint16_t pos)
+{
+  if (huart != rx->huart)
+  {
+    return;
+  }
+  uart_ring_event(&rx->ring, pos, (HAL_UARTEx_GetRxEventType(huart) == HAL_UART_RXEVENT_IDLE));
+}
+
+/**
+  * @brief  To be called from HAL_UART_ErrorCallback(): the HAL stops
+  *         DMA reception on errors, restart it from the buffer start
+  */
+void uart_rx_error_callback(uart_rx_t *rx, UART_HandleTypeDef *huart)
+{
+  if (huart != rx->huart)
+  {
+    return;
+  }
+  rx->uart_errors++;
+  if (huart->RxState == HAL_UART_STATE_READY)
+  {
+    uart_ring_restart(&rx->ring);
+    HAL_UARTEx_ReceiveToIdle_DMA(huart, rx->ring.buf, rx->ring.size);
+  }
+}
+
+/**
+  * @brief  To be called from USARTx_IRQHandler() before HAL_UART_IRQHandler():
+  *         the HAL doesn't report an idle line when the DMA counter is back
+  *         at the buffer size, so a frame ending exactly at the end of the
+  *         buffer would stay open and merge with the next one
+  */
+void uart_rx_irq_handler(uart_rx_t *rx)
+{
+  UART_HandleTypeDef *huart = rx->huart;
+
+  /* last_pos 0: the transfer complete event of this wrap was handled */
+  if ((huart != NULL) && __HAL_UART_GET_FLAG(huart, UART_FLAG_IDLE) &&
+      (READ_BIT(huart->Instance->CR1, USART_CR1_IDLEIE) != 0U) &&
+      (__HAL_DMA_GET_COUNTER(huart->hdmarx) == rx->ring.size) &&
+      (rx->ring.last_pos == 0U))
+  {
+    uart_ring_event(&rx->ring, 0, 1);
+  }
+}
+
+/**
+  * @brief  Passes the current DMA position to the ring (application side).
+  *         The interrupts report it only every half buffer or idle line: a
+  *         frame overwritten since then would look intact
+  */
+void uart_rx_sync(uart_rx_t *rx)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if (rx->huart->RxState == HAL_UART_STATE_BUSY_RX)
+  {
+    uart_ring_event(&rx->ring, rx->ring.size - (uint16_t)__HAL_DMA_GET_COUNTER(rx->huart->hdmarx), 0);
+  }
+  __set_PRIMASK(primask);
+}
@@ -114,6 +114,7 @@ typedef int8_t VL53L1X_ERROR;
 #define RESULT__AMBIENT_COUNT_RATE_MCPS_SD					0x0090
 #define VL53L1_RESULT__FINAL_CROSSTALK_CORRECTED_RANGE_MM_SD0				0x0096
 #define VL53L1_RESULT__PEAK_SIGNAL_COUNT_RATE_CROSSTALK_CORRECTED_MCPS_SD0 	0x0098
+#define VL53L1X_RESULT_BLOCK_SIZE							17		/* bytes from VL53L1_RESULT__RANGE_STATUS to the signal rate */
 #define VL53L1_RESULT__OSC_CALIBRATE_VAL					0x00DE
 #define VL53L1_FIRMWARE__SYSTEM_STATUS                      0x00E5
 #define VL53L1_IDENTIFICATION__MODEL_ID                     0x010F
@@ -155,7 +156,7 @@ VL53L1X_ERROR VL53L1X_GetSWVersion(VL53L1X_Version_t *pVersion);
 VL53L1X_ERROR VL53L1X_SetI2CAddress(uint16_t, uint8_t new_address);
 
 /**
- * @brief This function loads the 135 bytes default values to initialize the sensor.
+ * @brief This function loads the 91 bytes default values (0x2D..0x87) in a single write to initialize the sensor.
  * @param dev Device address
  * @return 0:success, != 0:failed
  */
@@ -220,6 +221,15 @@ VL53L1X_ERROR VL53L1X_SetDistanceMode(uint16_t dev, uint16_t DistanceMode);
  */
 VL53L1X_ERROR VL53L1X_GetDistanceMode(uint16_t dev, uint16_t *pDistanceMode);
 
+/**
+ * @brief This function programs the distance mode (1=short, 2=long) and the timing budget in ms
+ * together, without reading back the current configuration.\n
+ * Register values come from a precomputed table and are written in 4 I2C transactions.
+ * Returns 1 (nothing written) if the pair is not supported, e.g. 15 ms in long mode.
+ */
+VL53L1X_ERROR VL53L1X_SetDistanceModeAndTimingBudget(uint16_t dev, uint16_t DistanceMode,
+					 uint16_t TimingBudgetInMs);
+
 /**
  * @brief This function programs the Intermeasurement period in ms\n
  * Intermeasurement period must be >/= timing budget. This condition is not checked by the API,
@@ -285,6 +295,21 @@ VL53L1X_ERROR VL53L1X_GetRangeStatus(uint16_t dev, uint8_t *rangeStatus);
  */
 VL53L1X_ERROR VL53L1X_GetResult(uint16_t dev, VL53L1X_Result_t *pResult);
 
+/**
+ * @brief This function decodes a result block of VL53L1X_RESULT_BLOCK_SIZE bytes
+ * read from VL53L1_RESULT__RANGE_STATUS (e.g. by DMA), as done by VL53L1X_GetResult()
+ */
+void VL53L1X_DecodeResult(const uint8_t *pBlock, VL53L1X_Result_t *pResult);
+
+/**
+ * @brief This function returns measurements and the range status in a single read access,
+ * then clears the interrupt to arm the next data ready event.\n
+ * Fast path for the ranging loop: two I2C transactions per sample instead of one per value.\n
+ * SigPerSPAD and Ambient are the signal and ambient rates in kcps (as GetSignalRate() and GetAmbientRate()).\n
+ * On I2C error Status is set to 255.
+ */
+VL53L1X_ERROR VL53L1X_GetResultAndClearInterrupt(uint16_t dev, VL53L1X_Result_t *pResult);
+
 /**
  * @brief This function programs the offset correction in mm
  * @param OffsetValue:the offset correction value to program in mm
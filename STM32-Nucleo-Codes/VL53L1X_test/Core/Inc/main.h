@@ -32,10 +32,15 @@ extern "C" {
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "i2c_queue.h"
 #include "vl53l1_platform.h"
 #include "VL53L1X_api.h"
 #include "vl53l1_types.h"
 #include "z_vl53l1_test.h"
+#include "z_vl53l1_stats.h"
+#include "z_vl53l1_gesture.h"
+#include "z_vl53l1_acq.h"
+#include "z_vl53l1_array.h"
 /* USER CODE END Includes */
 
 /* Exported types ------------------------------------------------------------*/
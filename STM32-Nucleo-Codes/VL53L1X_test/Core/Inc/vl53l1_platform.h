@@ -14,9 +14,9 @@
  *
  * to enable the device followed by
  *
- * VL53L1__InitGesture();
+ * VL53L1__InitGesture(&gesture);
  *
- * if using library handling gestures and/or gesture menus.
+ * if using library handling gestures and/or gesture menus (see z_vl53l1_gesture.h).
  *
  * Finally add:
  *
@@ -45,11 +45,20 @@
  * using polling mode via I2C, comment it
  * if XSHUT pin is connected to uC (named TOF_XSHUT)
  * uncomment the corresponding define
+ * if GPIO pin is connected to an EXTI line and a DMA
+ * channel serves I2C RX, uncomment VL53L1__USING_DMA
+ * for interrupt driven readings (see z_vl53l1_acq.h)
  ***************************************************/
 #define VL53L1__PORT			hi2c1	// that's the I2C port connected to VI53L1X
 #define VL53L1__ADDR			0x52	// the I2C chip address
 //#define VL53L1__USING_XSHUT				// uncomment this line if XSHUT pin of VL35L1X is connected
 //#define VL53L1__USING_GPIO			// uncomment this line if GPIO pin of VL35L1X is connected
+//#define VL53L1__USING_DMA			// uncomment this line to read results by DMA on GPIO interrupt (needs VL53L1__USING_GPIO)
+//#define VL53L1__USING_ARRAY			// uncomment this line to handle more sensors on VL53L1__PORT (needs VL53L1__USING_DMA, see z_vl53l1_array.h)
+#define VL53L1__SCL_PORT		TOF_SCL_GPIO_Port	// VL53L1__PORT pins, clocked by hand to release a stuck bus (VL53L1__USING_DMA, see i2c_queue.h)
+#define VL53L1__SCL_PIN			TOF_SCL_Pin
+#define VL53L1__SDA_PORT		TOF_SDA_GPIO_Port
+#define VL53L1__SDA_PIN			TOF_SDA_Pin
 
 
 
@@ -116,6 +125,7 @@
 #define VL53L1__MASKREV_VALUE		0x10
 
 #define I2C_COMM_TIMEOUT			20   	// ms timeout for the I2C communication
+#define VL53L1__WRCOMBINE_SIZE		16		// bytes of consecutive register writes sent as one transfer
 
 // error code returned by I/O interface functions
 #define VL53L1__IO_ERROR			( - 13)
@@ -136,9 +146,15 @@ typedef VL53L1_Dev_t *VL53L1_DEV;
 uint8_t		VL53L1__Xshut(uint8_t level);
 #endif
 uint8_t  	VL53L1__Init();
+uint8_t  	VL53L1__InitDev(uint16_t dev);
 uint8_t 	VL53L1__GetDistance(uint16_t *Distance);
 uint8_t 	VL53L1__SetTimingBudget(uint16_t levelTB,uint16_t levelIM);
 uint8_t 	VL53L1__SetDistanceMode(uint16_t level);
+void		VL53L1__WrCombineBegin();
+int8_t		VL53L1__WrCombineEnd();
+#ifdef	VL53L1__USING_DMA
+i2cq_t		*VL53L1__GetI2cQueue();
+#endif
 
 
 
@@ -0,0 +1,83 @@
+/*
+ * z_vl53l1_acq.h
+ *
+ *	Event driven VL53L1X acquisition (data ready interrupt + I2C DMA)
+ *
+ * How to use it:
+ * in vl53l1_platform.h enable VL53L1__USING_GPIO and VL53L1__USING_DMA,
+ * then configure in CubeMX:
+ * - TOF_GPIO pin as GPIO_EXTI, edge matching the interrupt polarity
+ *   (rising for the default active high), and enable its EXTI NVIC line
+ * - I2C DMA request for RX (I2C1_RX) and the I2C event/error NVIC line
+ *   (the interrupt clear is sent in interrupt mode, no TX DMA needed)
+ * - forward the EXTI callback and the I2C callbacks (to the transaction
+ *   queue, see i2c_queue.h) in main.c:
+ *
+ *   void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin){
+ *   	VL53L1__AcqEXTI_Callback(GPIO_Pin);
+ *   }
+ *   void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c){
+ *   	i2cq_cplt_callback(VL53L1__GetI2cQueue(), hi2c);
+ *   }
+ *   ... same for HAL_I2C_MemTxCpltCallback(), HAL_I2C_ErrorCallback()
+ *   calling i2cq_error_callback()
+ *
+ * After VL53L1X_StartRanging() call VL53L1__AcqStart().
+ * Each data ready edge starts a DMA read of the result block, its completion
+ * clears the sensor interrupt and pushes a timestamped sample into a ring
+ * buffer. Main loop reads samples with VL53L1__AcqGetSample() and may call
+ * VL53L1__AcqSleep() to wait for the next interrupt with the core stopped.
+ * Call VL53L1__AcqStop() before any blocking access to the sensor (e.g.
+ * changing timing budget or distance mode) and VL53L1__AcqStart() after it.
+ *
+ * More sensors on the same I2C bus (each one with its own EXTI line, i.e.
+ * different pin numbers) are served in turn, see z_vl53l1_array.h.
+ *
+ */
+
+#ifndef _Z_VL53L1_ACQ_H_
+#define _Z_VL53L1_ACQ_H_
+
+#ifdef VL53L1__USING_DMA
+
+#ifndef VL53L1__USING_GPIO
+#error "VL53L1__USING_DMA requires VL53L1__USING_GPIO (data ready interrupt)"
+#endif
+
+// number of samples buffered between main loop reads (power of 2)
+#define VL53L1__ACQ_RING_SIZE		8
+// maximum number of sensors served (bit masks are 8 bits)
+#define VL53L1__ACQ_MAX_SENSORS		8
+
+
+typedef struct {
+	uint16_t 			Addr;		// I2C address
+	GPIO_TypeDef		*IntPort;	// data ready (GPIO1) pin
+	uint16_t 			IntPin;
+} VL53L1__AcqSensor_t;
+
+typedef struct {
+	uint32_t 			Timestamp;	// HAL_GetTick() at data ready interrupt
+	uint8_t 			Sensor;		// index of the sensor (0 if single sensor)
+	VL53L1X_Result_t	Result;		// decoded result block
+} VL53L1__Sample_t;
+
+typedef struct {
+	uint32_t	Samples;		// samples pushed into the ring buffer
+	uint32_t	Overruns;		// samples lost because the ring buffer was full
+	uint32_t	I2cErrors;		// failed DMA reads or interrupt clears
+	uint32_t	MissedEdges;	// data ready found by level check instead of EXTI edge
+} VL53L1__AcqStats_t;
+
+
+void 		VL53L1__AcqSetSensors(const VL53L1__AcqSensor_t *pSensors, uint8_t cnt);
+void 		VL53L1__AcqStart();
+void 		VL53L1__AcqStop();
+uint8_t 	VL53L1__AcqGetSample(VL53L1__Sample_t *pSample);
+void 		VL53L1__AcqSleep();
+const VL53L1__AcqStats_t *VL53L1__AcqGetStats();
+void 		VL53L1__AcqEXTI_Callback(uint16_t GPIO_Pin);
+
+#endif /* VL53L1__USING_DMA */
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * z_vl53l1_array.h
+ *
+ *	Array of VL53L1X sensors sharing one I2C bus
+ *
+ * How to use it:
+ * in vl53l1_platform.h enable VL53L1__USING_GPIO, VL53L1__USING_DMA and
+ * VL53L1__USING_ARRAY, configure DMA and EXTI in CubeMX as described in
+ * z_vl53l1_acq.h (one EXTI line per sensor: GPIO1 pins must have different
+ * pin numbers), set below parameters, then in main.c:
+ *
+ * VL53L1__ArrayInit();		instead of VL53L1__Init()
+ * VL53L1__ArrayStart();	instead of VL53L1X_StartRanging()
+ *
+ * and in main loop read scan frames with VL53L1__ArrayGetFrame().
+ *
+ * ArrayInit() holds all sensors in reset (XSHUT low), then releases them one
+ * by one: each sensor boots at the default address VL53L1__ADDR, it gets its
+ * own address and it is initialized with the project settings of
+ * vl53l1_platform.h. A sensor failing is kept in reset and left out.
+ *
+ * ArrayStart() starts ranging staggered by VL53L1__INTERMEASUREMENT / (number
+ * of sensors), so data ready events are spread over the intermeasurement
+ * period and reads don't pile up on the bus. Emissions don't overlap if
+ * VL53L1__TIMING_BUDGET <= VL53L1__INTERMEASUREMENT / (number of sensors)
+ * (e.g. 4 sensors, 20 ms timing budget, 80 ms or more intermeasurement).
+ * Sensor clocks drift apart slowly: call ArrayStart() again to re-align.
+ *
+ */
+
+#ifndef _Z_VL53L1_ARRAY_H_
+#define _Z_VL53L1_ARRAY_H_
+
+#ifdef VL53L1__USING_ARRAY
+
+#ifndef VL53L1__USING_DMA
+#error "VL53L1__USING_ARRAY requires VL53L1__USING_DMA"
+#endif
+
+
+/*||||||||||| USER/PROJECT PARAMETERS |||||||||||*/
+
+/*****************     STEP 1      *****************
+ ************* sensors and addresses ***************
+ * number of sensors, I2C address of the first one
+ * (8 bit format as VL53L1__ADDR, next sensors get
+ * +2 each, none of them may be VL53L1__ADDR)
+ ***************************************************/
+#define VL53L1__ARRAY_CNT			4		// up to VL53L1__ACQ_MAX_SENSORS
+#define VL53L1__ARRAY_FIRST_ADDR	0x54
+
+
+/*****************     STEP 2      *****************
+ ****************** sensor pins ********************
+ * {port, pin} of XSHUT and of GPIO1 (data ready)
+ * of every sensor, labels as set in CubeMX
+ ***************************************************/
+#define VL53L1__ARRAY_XSHUT_PINS	{ {TOF0_XSHUT_GPIO_Port, TOF0_XSHUT_Pin}, {TOF1_XSHUT_GPIO_Port, TOF1_XSHUT_Pin}, \
+									  {TOF2_XSHUT_GPIO_Port, TOF2_XSHUT_Pin}, {TOF3_XSHUT_GPIO_Port, TOF3_XSHUT_Pin} }
+#define VL53L1__ARRAY_INT_PINS		{ {TOF0_GPIO_GPIO_Port, TOF0_GPIO_Pin}, {TOF1_GPIO_GPIO_Port, TOF1_GPIO_Pin}, \
+									  {TOF2_GPIO_GPIO_Port, TOF2_GPIO_Pin}, {TOF3_GPIO_GPIO_Port, TOF3_GPIO_Pin} }
+
+
+/*****************     STEP 3      *****************
+ ******************** timings **********************/
+#define VL53L1__ARRAY_BOOT_TIMEOUT	100		// ms waiting for a sensor to boot after XSHUT release
+#define VL53L1__ARRAY_FRAME_TIMEOUT	(VL53L1__INTERMEASUREMENT + VL53L1__TB_IM_DELTA)	// ms: a frame is closed even if some sensor didn't answer
+
+/*|||||||| END OF USER/PROJECT PARAMETERS ||||||||*/
+
+
+
+typedef struct {
+	GPIO_TypeDef	*Port;
+	uint16_t 		Pin;
+} VL53L1__Pin_t;
+
+typedef struct {
+	uint32_t 			Timestamp;						// data ready time of the first sample of the frame
+	uint32_t 			Seq;							// frame counter
+	uint8_t 			ValidMask;						// bit n set: Sample[n] belongs to this frame
+	VL53L1__Sample_t	Sample[VL53L1__ARRAY_CNT];		// Sample[n].Sensor is n
+} VL53L1__Frame_t;
+
+
+uint8_t 	VL53L1__ArrayInit();
+uint8_t 	VL53L1__ArrayStart();
+uint8_t 	VL53L1__ArrayGetActive();
+uint8_t 	VL53L1__ArrayGetFrame(VL53L1__Frame_t *pFrame);
+
+#endif /* VL53L1__USING_ARRAY */
+
+#endif
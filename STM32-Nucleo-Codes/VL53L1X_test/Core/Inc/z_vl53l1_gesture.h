@@ -0,0 +1,117 @@
+/*
+ * z_vl53l1_gesture.h
+ *
+ *	Gesture recognition on VL53L1X distance readings
+ *
+ * How to use it:
+ * set below parameters, then in main.c, after VL53L1__Init():
+ *
+ * VL53L1__Gesture_t gesture;
+ * VL53L1__InitGesture(&gesture);
+ *
+ * and in main loop:
+ *
+ * VL53L1__GestureEvent_t event;
+ * while (VL53L1__GestureGetEvent(&gesture, &event)) {
+ * 		... handle event.Type ...
+ * }
+ *
+ * VL53L1__GestureGetEvent() never waits for the sensor: it takes the samples
+ * already available (the z_vl53l1_acq ring buffer if VL53L1__USING_DMA,
+ * otherwise a data ready check and, if ready, a single result read) and runs
+ * them through the state machine, so an event is reported within one sample
+ * period from the hand movement.
+ * Timings are taken from sample timestamps only: VL53L1__GestureFeed() can
+ * be called directly with recorded (timestamp, distance) traces, e.g. to
+ * replay them on a host.
+ *
+ * Gestures (hand "present" means a valid reading in
+ * GESTURE_MIN_DIST..GESTURE_MAX_DIST):
+ * - click:			hand present shorter than GESTURE_LONG_TIME, then
+ * 					absent longer than GESTURE_DCLICK_GAP
+ * - double click:	two clicks within GESTURE_DCLICK_GAP
+ * - long press:	hand present longer than GESTURE_LONG_TIME, then while
+ * 					hand stays, moving it changes Value between Lower
+ * 					and Upper limits (set by VL53L1__GestureSetValue())
+ * - swipe:			hand present shorter than GESTURE_LONG_TIME, moving
+ * 					toward (NEAR) or away from (FAR) the sensor by at
+ * 					least GESTURE_SWIPE_DELTA
+ *
+ * A hand is released when it is absent for GESTURE_RELEASE_TIME (at least
+ * two consecutive absent samples): shorter dropouts during a press (a
+ * failed reading, a finger gap) are ignored. Release times, and so the
+ * double click gap, are counted from the first absent sample.
+ *
+ */
+
+#ifndef _Z_VL53L1_GESTURE_H_
+#define _Z_VL53L1_GESTURE_H_
+
+
+/*||||||||||| USER/PROJECT PARAMETERS |||||||||||*/
+
+/*****************     STEP 1      *****************
+ ***************** gesture zone ********************
+ * readings (mm) between these limits are a hand
+ * in front of the sensor
+ ***************************************************/
+#define GESTURE_MIN_DIST		30
+#define GESTURE_MAX_DIST		400
+
+
+/*****************     STEP 2      *****************
+ ****************** gesture timings ****************/
+#define GESTURE_LONG_TIME		800		// ms: a press longer than this is a long press
+#define GESTURE_DCLICK_GAP		400		// ms: max release time between the two clicks of a double click
+#define GESTURE_RELEASE_TIME	60		// ms: absent time ending a press, shorter dropouts are ignored
+
+
+/*****************     STEP 3      *****************
+ ************ long press and swipe *****************/
+#define GESTURE_SWIPE_DELTA		80		// mm: minimum distance change for a swipe
+#define GESTURE_LONG_SPAN		(GESTURE_MAX_DIST-GESTURE_MIN_DIST)	// mm of hand movement covering the whole Lower..Upper range
+
+/*|||||||| END OF USER/PROJECT PARAMETERS ||||||||*/
+
+
+
+typedef enum {
+	VL53L1__GESTURE_NONE=0,
+	VL53L1__GESTURE_CLICK,
+	VL53L1__GESTURE_DOUBLECLICK,
+	VL53L1__GESTURE_LONG_START,
+	VL53L1__GESTURE_LONG_VALUE,		// Value changed during long press
+	VL53L1__GESTURE_LONG_END,
+	VL53L1__GESTURE_SWIPE_NEAR,		// hand moved toward the sensor
+	VL53L1__GESTURE_SWIPE_FAR		// hand moved away from the sensor
+} VL53L1__GestureType_t;
+
+typedef struct {
+	VL53L1__GestureType_t	Type;
+	uint32_t 				Timestamp;	// timestamp of the sample completing the gesture
+	int16_t 				Value;		// long press value (LONG_xxx events)
+} VL53L1__GestureEvent_t;
+
+typedef struct {
+	uint8_t 	State;			// state machine state
+	uint32_t	StateTime;		// timestamp of the last state change
+	uint32_t	AbsentTime;		// timestamp of the first sample of the current absence
+	uint8_t 	Absent;			// last sample had no hand
+	uint16_t	FirstDist;		// first distance of current press
+	uint16_t	LastDist;		// last distance of current press
+	uint16_t	MinDist;		// distance range of current press
+	uint16_t	MaxDist;
+	int16_t 	Value;			// long press value
+	int16_t 	Lower;			// long press value limits
+	int16_t 	Upper;
+	int16_t 	LongRefValue;	// Value and distance when long press started
+	uint16_t	LongRefDist;
+} VL53L1__Gesture_t;
+
+
+void 		VL53L1__InitGesture(VL53L1__Gesture_t *pGesture);
+void 		VL53L1__GestureSetValue(VL53L1__Gesture_t *pGesture, int16_t Value, int16_t Lower, int16_t Upper);
+uint8_t 	VL53L1__GestureFeed(VL53L1__Gesture_t *pGesture, uint32_t Timestamp, uint16_t Distance, uint8_t RangeStatus, VL53L1__GestureEvent_t *pEvent);
+uint8_t 	VL53L1__GestureGetEvent(VL53L1__Gesture_t *pGesture, VL53L1__GestureEvent_t *pEvent);
+
+#endif
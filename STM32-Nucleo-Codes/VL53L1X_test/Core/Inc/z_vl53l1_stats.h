@@ -0,0 +1,56 @@
+/*
+ * z_vl53l1_stats.h
+ *
+ *	Windowed statistics of distance readings, integer only
+ *	(Cortex-M0 has no FPU)
+ *
+ * - mean and standard deviation over the last VL53L1__STATS_WIN samples,
+ *   updated in constant time per sample by running sums
+ * - median over the last VL53L1__STATS_MED_WIN samples, kept in a small
+ *   sorted array beside their ring
+ * - outlier rejection: a sample farther than
+ *   max(VL53L1__STATS_OUTLIER_MIN, VL53L1__STATS_OUTLIER_K * std dev)
+ *   from the median is not added to mean/std dev window
+ *   (it still enters the median window, so a real step is followed
+ *   after VL53L1__STATS_MED_WIN/2 samples)
+ *
+ * Mean and standard deviation are returned in Q4 fixed point (1/16 mm).
+ *
+ * Readings are clamped to VL53L1__STATS_MAX_DIST, so all sums and the
+ * variance fit in 32 bits: no 64 bit multiply/divide (library calls on
+ * Cortex-M0), the only divisions are three 32 bit ones per std dev.
+ *
+ */
+
+#ifndef _Z_VL53L1_STATS_H_
+#define _Z_VL53L1_STATS_H_
+
+
+#define VL53L1__STATS_WIN			100		// samples for mean and standard deviation (up to 256)
+#define VL53L1__STATS_MED_WIN		9		// samples for median (odd, up to 15)
+#define VL53L1__STATS_OUTLIER_K		3		// outlier threshold in standard deviations
+#define VL53L1__STATS_OUTLIER_MIN	50		// (mm) minimum outlier threshold, 0 disables rejection
+#define VL53L1__STATS_MAX_DIST		4095	// (mm) readings are clamped to it (VL53L1X ranges up to 4 m)
+
+
+typedef struct {
+	uint16_t	Ring[VL53L1__STATS_WIN];			// accepted samples
+	uint16_t	Pos;								// next position in Ring
+	uint16_t	Cnt;								// samples in Ring
+	uint32_t	Sum;								// sum of samples in Ring
+	uint32_t	SumSq;								// sum of squared samples in Ring
+	uint16_t	MedRing[VL53L1__STATS_MED_WIN];		// all samples, arrival order
+	uint16_t	Sorted[VL53L1__STATS_MED_WIN];		// the same samples, sorted
+	uint8_t 	MedPos;
+	uint8_t 	MedCnt;
+	uint32_t	Rejected;							// outliers counter
+} VL53L1__Stats_t;
+
+
+void 		VL53L1__StatsReset(VL53L1__Stats_t *pStats);
+uint8_t 	VL53L1__StatsAdd(VL53L1__Stats_t *pStats, uint16_t Distance);
+uint32_t	VL53L1__StatsMeanQ4(const VL53L1__Stats_t *pStats);
+uint32_t	VL53L1__StatsStdDevQ4(const VL53L1__Stats_t *pStats);
+uint16_t	VL53L1__StatsMedian(const VL53L1__Stats_t *pStats);
+
+#endif
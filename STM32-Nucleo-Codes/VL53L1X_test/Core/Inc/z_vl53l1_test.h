@@ -31,15 +31,24 @@
 #define TESTGESTURE_LCLICK_UPPER	1000
 #define TESTGESTURE_LCLICK_LOWER	0
 
-//number of sample for average and std deviation calculation
-#define TESTGESTURE_DIM_ARR 		100
+//number of sample for average and std deviation calculation: see VL53L1__STATS_WIN in z_vl53l1_stats.h
 // time (ms) a click keeps active (to ,correctly show it in CubeMonitor)
 #define TESTGESTURE_CLICK_DURATION	1000
+// number of items of the test menu
+#define TESTMENU_ITEMS				3
 
 
 
 
+// startup/reconfiguration time in ms, shown on CubeMonitor
+extern uint32_t	InitTime;
+extern uint32_t	ReconfigTime;
+
+
 void VL53L1__testRanging();
+#ifdef	VL53L1__USING_ARRAY
+void VL53L1__testArray();
+#endif
 void VL53L1__testGesture();
 void VL53L1__testMenu();
 void VL53L1X__GestureMenu_Items(uint8_t menuItem, uint8_t firstCall, uint8_t shortClick, uint8_t doubleClick, uint8_t longClick,int16_t *longClickVal,int16_t *longClickLowerValue,int16_t *longClickUpperValue);
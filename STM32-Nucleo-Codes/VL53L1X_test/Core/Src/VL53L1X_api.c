@@ -62,6 +62,7 @@
  * @brief Functions implementation
  */
 
+#include "main.h"
 #include "VL53L1X_api.h"
 #include <string.h>
 
@@ -203,6 +204,80 @@ static const uint8_t status_rtn[24] = { 255, 255, 255, 5, 2, 4, 1, 7, 3, 0,
 	255, 255, 11, 12
 };
 
+/* distance mode registers, index = distance mode - 1 (0:short, 1:long) */
+typedef struct {
+	uint8_t PhaseCalTimeout;	/* PHASECAL_CONFIG__TIMEOUT_MACROP */
+	uint8_t VcselPeriodA;		/* RANGE_CONFIG__VCSEL_PERIOD_A */
+	uint8_t VcselPeriodB;		/* RANGE_CONFIG__VCSEL_PERIOD_B */
+	uint8_t ValidPhaseHigh;		/* RANGE_CONFIG__VALID_PHASE_HIGH */
+	uint8_t SdConfig[4];		/* SD_CONFIG__WOI_SD0 and SD_CONFIG__INITIAL_PHASE_SD0 (MSB first) */
+} VL53L1X_DistanceModeCfg_t;
+
+static const VL53L1X_DistanceModeCfg_t DistanceModeCfg[2] = {
+	{ 0x14, 0x07, 0x05, 0x38, { 0x07, 0x05, 0x06, 0x06 } },	/* short */
+	{ 0x0A, 0x0F, 0x0D, 0xB8, { 0x0F, 0x0D, 0x0E, 0x0E } }	/* long */
+};
+
+/* timing budget registers per distance mode */
+typedef struct {
+	uint16_t TimingBudgetInMs;
+	uint16_t MacropA;			/* RANGE_CONFIG__TIMEOUT_MACROP_A_HI */
+	uint16_t MacropB;			/* RANGE_CONFIG__TIMEOUT_MACROP_B_HI */
+} VL53L1X_TimingBudgetCfg_t;
+
+#define TIMING_BUDGET_CFG_CNT	7
+
+static const VL53L1X_TimingBudgetCfg_t TimingBudgetCfg[2][TIMING_BUDGET_CFG_CNT] = {
+	{	/* short */
+		{ 15, 0x001D, 0x0027 },	/* only available in short distance mode */
+		{ 20, 0x0051, 0x006E },
+		{ 33, 0x00D6, 0x006E },
+		{ 50, 0x01AE, 0x01E8 },
+		{ 100, 0x02E1, 0x0388 },
+		{ 200, 0x03E1, 0x0496 },
+		{ 500, 0x0591, 0x05C1 }
+	},
+	{	/* long */
+		{ 20, 0x001E, 0x0022 },
+		{ 33, 0x0060, 0x006E },
+		{ 50, 0x00AD, 0x00C6 },
+		{ 100, 0x01CC, 0x01EA },
+		{ 200, 0x02D9, 0x02F8 },
+		{ 500, 0x048F, 0x04A4 },
+		{ 0, 0, 0 }				/* unused */
+	}
+};
+
+/*
+ * Writes timing budget and VCSEL periods of the given distance mode as one block
+ * RANGE_CONFIG__TIMEOUT_MACROP_A_HI (0x5E) .. RANGE_CONFIG__VCSEL_PERIOD_B (0x63).
+ * Returns 1 if the distance mode / timing budget pair is not supported.
+ */
+static VL53L1X_ERROR VL53L1X_WriteTimingBlock(uint16_t dev, uint16_t DM, uint16_t TimingBudgetInMs)
+{
+	const VL53L1X_TimingBudgetCfg_t *pTB;
+	uint8_t Block[6];
+	uint8_t i;
+
+	if ((DM != 1) && (DM != 2))
+		return 1;
+	for (i = 0; i < TIMING_BUDGET_CFG_CNT; i++) {
+		pTB = &TimingBudgetCfg[DM - 1][i];
+		if ((pTB->TimingBudgetInMs != 0) && (pTB->TimingBudgetInMs == TimingBudgetInMs))
+			break;
+	}
+	if (i == TIMING_BUDGET_CFG_CNT)
+		return 1;
+
+	Block[0] = pTB->MacropA >> 8;
+	Block[1] = pTB->MacropA & 0xFF;
+	Block[2] = DistanceModeCfg[DM - 1].VcselPeriodA;
+	Block[3] = pTB->MacropB >> 8;
+	Block[4] = pTB->MacropB & 0xFF;
+	Block[5] = DistanceModeCfg[DM - 1].VcselPeriodB;
+	return VL53L1_WriteMulti(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI, Block, sizeof(Block));
+}
+
 VL53L1X_ERROR VL53L1X_GetSWVersion(VL53L1X_Version_t *pVersion)
 {
 	VL53L1X_ERROR Status = 0;
@@ -225,11 +300,11 @@ VL53L1X_ERROR VL53L1X_SetI2CAddress(uint16_t dev, uint8_t new_address)
 VL53L1X_ERROR VL53L1X_SensorInit(uint16_t dev)
 {
 	VL53L1X_ERROR status = 0;
-	uint8_t Addr = 0x00, tmp;
+	uint8_t tmp;
 
-	for (Addr = 0x2D; Addr <= 0x87; Addr++){
-		status |= VL53L1_WrByte(dev, Addr, VL51L1X_DEFAULT_CONFIGURATION[Addr - 0x2D]);
-	}
+	/* 0x2D..0x87 in a single transaction (the platform layer does not modify the buffer) */
+	status |= VL53L1_WriteMulti(dev, 0x2D, (uint8_t *)VL51L1X_DEFAULT_CONFIGURATION,
+			sizeof(VL51L1X_DEFAULT_CONFIGURATION));
 	status |= VL53L1X_StartRanging(dev);
 	tmp  = 0;
 	while(tmp==0){
@@ -290,15 +365,16 @@ VL53L1X_ERROR VL53L1X_StopRanging(uint16_t dev)
 
 VL53L1X_ERROR VL53L1X_CheckForDataReady(uint16_t dev, uint8_t *isDataReady)
 {
-	uint8_t Temp;
+	uint8_t Temp[2];
 	uint8_t IntPol;
 	VL53L1X_ERROR status = 0;
 
-	status |= VL53L1X_GetInterruptPolarity(dev, &IntPol);
-	status |= VL53L1_RdByte(dev, GPIO__TIO_HV_STATUS, &Temp);
+	/* GPIO_HV_MUX__CTRL (polarity) and GPIO__TIO_HV_STATUS are adjacent, read both at once */
+	status |= VL53L1_ReadMulti(dev, GPIO_HV_MUX__CTRL, Temp, 2);
+	IntPol = !((Temp[0] & 0x10) >> 4);
 	/* Read in the register to check if a new value is available */
 	if (status == 0){
-		if ((Temp & 1) == IntPol)
+		if ((Temp[1] & 1) == IntPol)
 			*isDataReady = 1;
 		else
 			*isDataReady = 0;
@@ -308,103 +384,14 @@ VL53L1X_ERROR VL53L1X_CheckForDataReady(uint16_t dev, uint8_t *isDataReady)
 
 VL53L1X_ERROR VL53L1X_SetTimingBudgetInMs(uint16_t dev, uint16_t TimingBudgetInMs)
 {
-	uint16_t DM;
+	uint16_t DM = 0;
 	VL53L1X_ERROR  status=0;
 
 	status |= VL53L1X_GetDistanceMode(dev, &DM);
-	if (DM == 0)
+	if ((status != 0) || (DM == 0))
 		return 1;
-	else if (DM == 1) {	/* Short DistanceMode */
-		switch (TimingBudgetInMs) {
-		case 15: /* only available in short distance mode */
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI,
-					0x01D);
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_B_HI,
-					0x0027);
-			break;
-		case 20:
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI,
-					0x0051);
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_B_HI,
-					0x006E);
-			break;
-		case 33:
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI,
-					0x00D6);
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_B_HI,
-					0x006E);
-			break;
-		case 50:
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI,
-					0x1AE);
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_B_HI,
-					0x01E8);
-			break;
-		case 100:
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI,
-					0x02E1);
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_B_HI,
-					0x0388);
-			break;
-		case 200:
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI,
-					0x03E1);
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_B_HI,
-					0x0496);
-			break;
-		case 500:
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI,
-					0x0591);
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_B_HI,
-					0x05C1);
-			break;
-		default:
-			status = 1;
-			break;
-		}
-	} else {
-		switch (TimingBudgetInMs) {
-		case 20:
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI,
-					0x001E);
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_B_HI,
-					0x0022);
-			break;
-		case 33:
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI,
-					0x0060);
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_B_HI,
-					0x006E);
-			break;
-		case 50:
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI,
-					0x00AD);
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_B_HI,
-					0x00C6);
-			break;
-		case 100:
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI,
-					0x01CC);
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_B_HI,
-					0x01EA);
-			break;
-		case 200:
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI,
-					0x02D9);
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_B_HI,
-					0x02F8);
-			break;
-		case 500:
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_A_HI,
-					0x048F);
-			VL53L1_WrWord(dev, RANGE_CONFIG__TIMEOUT_MACROP_B_HI,
-					0x04A4);
-			break;
-		default:
-			status = 1;
-			break;
-		}
-	}
+	/* 15 ms is only available in short distance mode */
+	status |= VL53L1X_WriteTimingBlock(dev, DM, TimingBudgetInMs);
 	return status;
 }
 
@@ -457,30 +444,24 @@ VL53L1X_ERROR VL53L1X_SetDistanceMode(uint16_t dev, uint16_t DM)
 	status |= VL53L1X_GetTimingBudgetInMs(dev, &TB);
 	if (status != 0)
 		return 1;
-	switch (DM) {
-	case 1:
-		status = VL53L1_WrByte(dev, PHASECAL_CONFIG__TIMEOUT_MACROP, 0x14);
-		status = VL53L1_WrByte(dev, RANGE_CONFIG__VCSEL_PERIOD_A, 0x07);
-		status = VL53L1_WrByte(dev, RANGE_CONFIG__VCSEL_PERIOD_B, 0x05);
-		status = VL53L1_WrByte(dev, RANGE_CONFIG__VALID_PHASE_HIGH, 0x38);
-		status = VL53L1_WrWord(dev, SD_CONFIG__WOI_SD0, 0x0705);
-		status = VL53L1_WrWord(dev, SD_CONFIG__INITIAL_PHASE_SD0, 0x0606);
-		break;
-	case 2:
-		status = VL53L1_WrByte(dev, PHASECAL_CONFIG__TIMEOUT_MACROP, 0x0A);
-		status = VL53L1_WrByte(dev, RANGE_CONFIG__VCSEL_PERIOD_A, 0x0F);
-		status = VL53L1_WrByte(dev, RANGE_CONFIG__VCSEL_PERIOD_B, 0x0D);
-		status = VL53L1_WrByte(dev, RANGE_CONFIG__VALID_PHASE_HIGH, 0xB8);
-		status = VL53L1_WrWord(dev, SD_CONFIG__WOI_SD0, 0x0F0D);
-		status = VL53L1_WrWord(dev, SD_CONFIG__INITIAL_PHASE_SD0, 0x0E0E);
-		break;
-	default:
-		status = 1;
-		break;
-	}
+	return VL53L1X_SetDistanceModeAndTimingBudget(dev, DM, TB);
+}
 
-	if (status == 0)
-		status |= VL53L1X_SetTimingBudgetInMs(dev, TB);
+VL53L1X_ERROR VL53L1X_SetDistanceModeAndTimingBudget(uint16_t dev, uint16_t DM, uint16_t TimingBudgetInMs)
+{
+	const VL53L1X_DistanceModeCfg_t *pDM;
+	VL53L1X_ERROR status = 0;
+
+	if ((DM != 1) && (DM != 2))
+		return 1;
+	pDM = &DistanceModeCfg[DM - 1];
+	/* timing budget and both VCSEL periods in one block; checks the DM/TB pair before anything is written */
+	status = VL53L1X_WriteTimingBlock(dev, DM, TimingBudgetInMs);
+	if (status != 0)
+		return status;
+	status |= VL53L1_WrByte(dev, PHASECAL_CONFIG__TIMEOUT_MACROP, pDM->PhaseCalTimeout);
+	status |= VL53L1_WrByte(dev, RANGE_CONFIG__VALID_PHASE_HIGH, pDM->ValidPhaseHigh);
+	status |= VL53L1_WriteMulti(dev, SD_CONFIG__WOI_SD0, (uint8_t *)pDM->SdConfig, sizeof(pDM->SdConfig));
 	return status;
 }
 
@@ -623,21 +604,45 @@ VL53L1X_ERROR VL53L1X_GetRangeStatus(uint16_t dev, uint8_t *rangeStatus)
 	return status;
 }
 
-VL53L1X_ERROR VL53L1X_GetResult(uint16_t dev, VL53L1X_Result_t *pResult)
+void VL53L1X_DecodeResult(const uint8_t *Temp, VL53L1X_Result_t *pResult)
 {
-	VL53L1X_ERROR status = 0;
-	uint8_t Temp[17];
-	uint8_t RgSt = 255;
+	uint8_t RgSt;
 
-	status |= VL53L1_ReadMulti(dev, VL53L1_RESULT__RANGE_STATUS, Temp, 17);
 	RgSt = Temp[0] & 0x1F;
 	if (RgSt < 24)
 		RgSt = status_rtn[RgSt];
+	else
+		RgSt = 255;
 	pResult->Status = RgSt;
 	pResult->Ambient = (Temp[7] << 8 | Temp[8]) * 8;
 	pResult->NumSPADs = Temp[3];
 	pResult->SigPerSPAD = (Temp[15] << 8 | Temp[16]) * 8;
 	pResult->Distance = Temp[13] << 8 | Temp[14];
+}
+
+VL53L1X_ERROR VL53L1X_GetResult(uint16_t dev, VL53L1X_Result_t *pResult)
+{
+	VL53L1X_ERROR status = 0;
+	uint8_t Temp[VL53L1X_RESULT_BLOCK_SIZE];
+
+	status |= VL53L1_ReadMulti(dev, VL53L1_RESULT__RANGE_STATUS, Temp, VL53L1X_RESULT_BLOCK_SIZE);
+	VL53L1X_DecodeResult(Temp, pResult);
+
+	return status;
+}
+
+VL53L1X_ERROR VL53L1X_GetResultAndClearInterrupt(uint16_t dev, VL53L1X_Result_t *pResult)
+{
+	VL53L1X_ERROR status = 0;
+	uint8_t Temp[VL53L1X_RESULT_BLOCK_SIZE];
+
+	status |= VL53L1_ReadMulti(dev, VL53L1_RESULT__RANGE_STATUS, Temp, VL53L1X_RESULT_BLOCK_SIZE);
+	/* re-arm the interrupt even if the read failed, otherwise ranging stalls */
+	status |= VL53L1_WrByte(dev, SYSTEM__INTERRUPT_CLEAR, 0x01);
+	if (status == 0)
+		VL53L1X_DecodeResult(Temp, pResult);
+	else
+		pResult->Status = 255;
 
 	return status;
 }
@@ -648,10 +653,12 @@ VL53L1X_ERROR VL53L1X_SetOffset(uint16_t dev, int16_t OffsetValue)
 	int16_t Temp;
 
 	Temp = (OffsetValue*4);
+	VL53L1__WrCombineBegin();
 	status |= VL53L1_WrWord(dev, ALGO__PART_TO_PART_RANGE_OFFSET_MM,
 			(uint16_t)Temp);
 	status |= VL53L1_WrWord(dev, MM_CONFIG__INNER_OFFSET_MM, 0x0);
 	status |= VL53L1_WrWord(dev, MM_CONFIG__OUTER_OFFSET_MM, 0x0);
+	status |= VL53L1__WrCombineEnd();
 	return status;
 }
 
@@ -678,6 +685,7 @@ VL53L1X_ERROR VL53L1X_SetXtalk(uint16_t dev, uint16_t XtalkValue)
 /* XTalkValue in count per second to avoid float type */
 	VL53L1X_ERROR status = 0;
 
+	VL53L1__WrCombineBegin();
 	status |= VL53L1_WrWord(dev,
 			ALGO__CROSSTALK_COMPENSATION_X_PLANE_GRADIENT_KCPS,
 			0x0000);
@@ -685,6 +693,7 @@ VL53L1X_ERROR VL53L1X_SetXtalk(uint16_t dev, uint16_t XtalkValue)
 			0x0000);
 	status |= VL53L1_WrWord(dev, ALGO__CROSSTALK_COMPENSATION_PLANE_OFFSET_KCPS,
 			(XtalkValue<<9)/1000); /* * << 9 (7.9 format) and /1000 to convert cps to kpcs */
+	status |= VL53L1__WrCombineEnd();
 	return status;
 }
 
@@ -713,8 +722,10 @@ VL53L1X_ERROR VL53L1X_SetDistanceThreshold(uint16_t dev, uint16_t ThreshLow,
 		status = VL53L1_WrByte(dev, SYSTEM__INTERRUPT_CONFIG_GPIO,
 			       ((Temp | (Window & 0x07)) | 0x40));
 	}
+	VL53L1__WrCombineBegin();
 	status |= VL53L1_WrWord(dev, SYSTEM__THRESH_HIGH, ThreshHigh);
 	status |= VL53L1_WrWord(dev, SYSTEM__THRESH_LOW, ThreshLow);
+	status |= VL53L1__WrCombineEnd();
 	return status;
 }
 
@@ -776,9 +787,11 @@ VL53L1X_ERROR VL53L1X_SetROI(uint16_t dev, uint16_t X, uint16_t Y)
 	if (X > 10 || Y > 10){
 		OpticalCenter = 199;
 	}
+	VL53L1__WrCombineBegin();
 	status |= VL53L1_WrByte(dev, ROI_CONFIG__USER_ROI_CENTRE_SPAD, OpticalCenter);
 	status |= VL53L1_WrByte(dev, ROI_CONFIG__USER_ROI_REQUESTED_GLOBAL_XY_SIZE,
 		       (Y - 1) << 4 | (X - 1));
+	status |= VL53L1__WrCombineEnd();
 	return status;
 }
 
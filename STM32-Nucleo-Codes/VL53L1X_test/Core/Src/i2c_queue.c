@@ -0,0 +1,352 @@
+/**
+  ******************************************************************************
+  * @file           : i2c_queue.c
+  * @brief          : Non-blocking I2C transaction queue
+  ******************************************************************************
+  * head and tail are free running: (head - tail) transfers are queued,
+  * queue[tail] is the one on the bus.
+  * busy: 0 bus free, 1 transfer running, 2 transfer refused by the HAL
+  * (peripheral still busy): retried by i2cq_poll().
+  ******************************************************************************
+  */
+
+#include "i2c_queue.h"
+
+#define Q_IDX(n)              ((n) & (I2CQ_DEPTH - 1U))
+
+#define Q_FREE                0U
+#define Q_RUNNING             1U
+#define Q_WAITING             2U
+
+/* errors leaving the bus in an unknown state */
+#define Q_BUS_ERRORS          (HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_ARLO | HAL_I2C_ERROR_TIMEOUT | HAL_I2C_ERROR_DMA)
+
+/* half SCL period of the clock-out (about 5 us at 48 MHz) */
+#define Q_HALF_BIT_LOOPS      40U
+
+static uint32_t q_lock(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  return primask;
+}
+
+static void q_unlock(uint32_t primask)
+{
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Statistics slot of dev, allocated on first use
+  * @retval NULL if the table is full
+  */
+static i2cq_dev_stats_t *q_stats(i2cq_t *q, uint16_t dev)
+{
+  uint8_t i;
+
+  for (i = 0; i < I2CQ_MAX_DEVS; i++)
+  {
+    if (q->devs[i].dev == dev)
+    {
+      return &q->devs[i];
+    }
+    if (q->devs[i].dev == 0U)
+    {
+      q->devs[i].dev = dev;
+      return &q->devs[i];
+    }
+  }
+  return NULL;
+}
+
+static HAL_StatusTypeDef q_start(i2cq_t *q, i2cq_xfer_t *x)
+{
+  I2C_HandleTypeDef *h = q->hi2c;
+
+  if (x->reg_size == I2CQ_NO_REG)
+  {
+    if (x->dir == I2CQ_READ)
+    {
+      return (h->hdmarx != NULL) ? HAL_I2C_Master_Receive_DMA(h, x->dev, x->data, x->len)
+                                 : HAL_I2C_Master_Receive_IT(h, x->dev, x->data, x->len);
+    }
+    return (h->hdmatx != NULL) ? HAL_I2C_Master_Transmit_DMA(h, x->dev, x->data, x->len)
+                               : HAL_I2C_Master_Transmit_IT(h, x->dev, x->data, x->len);
+  }
+  if (x->dir == I2CQ_READ)
+  {
+    return (h->hdmarx != NULL) ? HAL_I2C_Mem_Read_DMA(h, x->dev, x->reg, x->reg_size, x->data, x->len)
+                               : HAL_I2C_Mem_Read_IT(h, x->dev, x->reg, x->reg_size, x->data, x->len);
+  }
+  return (h->hdmatx != NULL) ? HAL_I2C_Mem_Write_DMA(h, x->dev, x->reg, x->reg_size, x->data, x->len)
+                             : HAL_I2C_Mem_Write_IT(h, x->dev, x->reg, x->reg_size, x->data, x->len);
+}
+
+/**
+  * @brief  Completes queue[tail] and frees the bus (interrupts masked)
+  */
+static void q_finish(i2cq_t *q, HAL_StatusTypeDef status)
+{
+  i2cq_xfer_t *x = q->queue[Q_IDX(q->tail)];
+  i2cq_dev_stats_t *st = q_stats(q, x->dev);
+  uint32_t time = HAL_GetTick() - q->start_time;
+
+  if (st != NULL)
+  {
+    if (status == HAL_OK)
+    {
+      st->xfers++;
+      st->bytes += x->len;
+    }
+    else
+    {
+      st->errors++;
+    }
+    if (time > st->max_time)
+    {
+      st->max_time = time;
+    }
+  }
+  q->tail++;
+  q->busy = Q_FREE;
+  x->status = status;
+  if (x->done != NULL)
+  {
+    x->done(x);
+  }
+}
+
+/**
+  * @brief  Starts queued transfers while the bus is free (interrupts masked)
+  */
+static void q_kick(i2cq_t *q)
+{
+  HAL_StatusTypeDef status;
+
+  while ((q->busy != Q_RUNNING) && (!q->recover) && (q->head != q->tail))
+  {
+    if (q->busy == Q_FREE)
+    {
+      q->start_time = HAL_GetTick();
+    }
+    status = q_start(q, q->queue[Q_IDX(q->tail)]);
+    if (status == HAL_OK)
+    {
+      q->busy = Q_RUNNING;
+    }
+    else if (status == HAL_BUSY)
+    {
+      q->busy = Q_WAITING;          /* retried by i2cq_poll() */
+      return;
+    }
+    else
+    {
+      q_finish(q, status);
+    }
+  }
+}
+
+/**
+  * @brief  Resets the peripheral, clocking SCL until the slaves release SDA
+  *         then sending a STOP condition (main loop only)
+  */
+static void q_bus_recover(i2cq_t *q)
+{
+  GPIO_InitTypeDef gpio = {0};
+  volatile uint32_t d;
+  uint8_t i;
+
+  HAL_I2C_DeInit(q->hi2c);
+
+  HAL_GPIO_WritePin(q->scl_port, q->scl_pin, GPIO_PIN_SET);
+  HAL_GPIO_WritePin(q->sda_port, q->sda_pin, GPIO_PIN_SET);
+  gpio.Mode = GPIO_MODE_OUTPUT_OD;
+  gpio.Pull = GPIO_NOPULL;
+  gpio.Speed = GPIO_SPEED_FREQ_LOW;
+  gpio.Pin = q->scl_pin;
+  HAL_GPIO_Init(q->scl_port, &gpio);
+  gpio.Pin = q->sda_pin;
+  HAL_GPIO_Init(q->sda_port, &gpio);
+
+  for (i = 0; (i < 9U) && (HAL_GPIO_ReadPin(q->sda_port, q->sda_pin) == GPIO_PIN_RESET); i++)
+  {
+    HAL_GPIO_WritePin(q->scl_port, q->scl_pin, GPIO_PIN_RESET);
+    for (d = 0; d < Q_HALF_BIT_LOOPS; d++) {}
+    HAL_GPIO_WritePin(q->scl_port, q->scl_pin, GPIO_PIN_SET);
+    for (d = 0; d < Q_HALF_BIT_LOOPS; d++) {}
+  }
+
+  /* STOP: SDA rising while SCL high */
+  HAL_GPIO_WritePin(q->scl_port, q->scl_pin, GPIO_PIN_RESET);
+  for (d = 0; d < Q_HALF_BIT_LOOPS; d++) {}
+  HAL_GPIO_WritePin(q->sda_port, q->sda_pin, GPIO_PIN_RESET);
+  for (d = 0; d < Q_HALF_BIT_LOOPS; d++) {}
+  HAL_GPIO_WritePin(q->scl_port, q->scl_pin, GPIO_PIN_SET);
+  for (d = 0; d < Q_HALF_BIT_LOOPS; d++) {}
+  HAL_GPIO_WritePin(q->sda_port, q->sda_pin, GPIO_PIN_SET);
+  for (d = 0; d < Q_HALF_BIT_LOOPS; d++) {}
+
+  HAL_I2C_Init(q->hi2c);            /* MSP init gives the pins back to the peripheral */
+}
+
+/**
+  * @brief  Init the queue on hi2c (already initialized), SCL/SDA are the
+  *         I2C pins, used to recover a stuck bus
+  */
+void i2cq_init(i2cq_t *q, I2C_HandleTypeDef *hi2c, GPIO_TypeDef *scl_port, uint16_t scl_pin, GPIO_TypeDef *sda_port, uint16_t sda_pin)
+{
+  uint8_t i;
+
+  q->hi2c = hi2c;
+  q->scl_port = scl_port;
+  q->scl_pin = scl_pin;
+  q->sda_port = sda_port;
+  q->sda_pin = sda_pin;
+  q->head = 0;
+  q->tail = 0;
+  q->busy = Q_FREE;
+  q->recover = 0;
+  q->recoveries = 0;
+  q->full = 0;
+  for (i = 0; i < I2CQ_MAX_DEVS; i++)
+  {
+    q->devs[i].dev = 0;
+    q->devs[i].xfers = 0;
+    q->devs[i].bytes = 0;
+    q->devs[i].errors = 0;
+    q->devs[i].max_time = 0;
+  }
+}
+
+/**
+  * @brief  Queues a transfer (any context)
+  * @retval HAL_OK if queued, HAL_BUSY if the queue is full
+  */
+HAL_StatusTypeDef i2cq_submit(i2cq_t *q, i2cq_xfer_t *xfer)
+{
+  uint32_t primask = q_lock();
+
+  if ((uint8_t)(q->head - q->tail) >= I2CQ_DEPTH)
+  {
+    q->full++;
+    q_unlock(primask);
+    return HAL_BUSY;
+  }
+  xfer->status = I2CQ_PENDING;
+  q->queue[Q_IDX(q->head)] = xfer;
+  q->head++;
+  q_kick(q);
+  q_unlock(primask);
+  return HAL_OK;
+}
+
+/**
+  * @brief  Queues a transfer and waits for its completion (main loop only),
+  *         other queued transfers keep running meanwhile
+  * @retval transfer status, HAL_BUSY if the queue is full
+  */
+HAL_StatusTypeDef i2cq_transfer_sync(i2cq_t *q, i2cq_xfer_t *xfer)
+{
+  if (i2cq_submit(q, xfer) != HAL_OK)
+  {
+    return HAL_BUSY;
+  }
+  while (xfer->status == I2CQ_PENDING)
+  {
+    i2cq_poll(q);
+  }
+  return (HAL_StatusTypeDef)xfer->status;
+}
+
+/**
+  * @brief  Main loop service: aborts a transfer over I2CQ_XFER_TIMEOUT,
+  *         recovers the bus after errors, retries refused transfers
+  */
+void i2cq_poll(i2cq_t *q)
+{
+  uint32_t primask = q_lock();
+
+  if ((q->busy != Q_FREE) && ((HAL_GetTick() - q->start_time) > I2CQ_XFER_TIMEOUT))
+  {
+    q_finish(q, HAL_TIMEOUT);
+    q->recover = 1;
+  }
+  q_unlock(primask);
+
+  if (q->recover)
+  {
+    q_bus_recover(q);
+    q->recoveries++;
+    q->recover = 0;
+  }
+
+  primask = q_lock();
+  q_kick(q);
+  q_unlock(primask);
+}
+
+/**
+  * @brief  Statistics of dev
+  * @retval NULL if dev never used the queue
+  */
+const i2cq_dev_stats_t *i2cq_get_stats(const i2cq_t *q, uint16_t dev)
+{
+  uint8_t i;
+
+  for (i = 0; i < I2CQ_MAX_DEVS; i++)
+  {
+    if (q->devs[i].dev == dev)
+    {
+      return &q->devs[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+  * @brief  To be called from the HAL transfer complete callbacks
+  */
+void i2cq_cplt_callback(i2cq_t *q, I2C_HandleTypeDef *hi2c)
+{
+  uint32_t primask;
+
+  if (hi2c != q->hi2c)
+  {
+    return;
+  }
+  primask = q_lock();
+  if (q->busy == Q_RUNNING)
+  {
+    q_finish(q, HAL_OK);
+    q_kick(q);
+  }
+  q_unlock(primask);
+}
+
+/**
+  * @brief  To be called from HAL_I2C_ErrorCallback(): a NACK lets the
+  *         queue go on, bus errors leave recovery to i2cq_poll()
+  */
+void i2cq_error_callback(i2cq_t *q, I2C_HandleTypeDef *hi2c)
+{
+  uint32_t primask;
+
+  if (hi2c != q->hi2c)
+  {
+    return;
+  }
+  primask = q_lock();
+  if (q->busy == Q_RUNNING)
+  {
+    q_finish(q, HAL_ERROR);
+    if (HAL_I2C_GetError(hi2c) & Q_BUS_ERRORS)
+    {
+      q->recover = 1;
+    }
+    else
+    {
+      q_kick(q);
+    }
+  }
+  q_unlock(primask);
+}
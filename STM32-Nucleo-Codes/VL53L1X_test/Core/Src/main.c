@@ -94,18 +94,40 @@ int main(void)
   MX_USART2_UART_Init();
   MX_I2C1_Init();
   /* USER CODE BEGIN 2 */
+  InitTime=HAL_GetTick();
+#ifdef	VL53L1__USING_ARRAY
+  VL53L1__ArrayInit();
+  if(!VL53L1__ArrayGetActive())
+	  while(1){};
+#else
   if(VL53L1__Init())
 	  while(1){};
+#endif
+  InitTime=HAL_GetTick()-InitTime;
 
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
+#if defined(VL53L1__USING_ARRAY)
+  VL53L1__ArrayStart();
+#else
   VL53L1X_StartRanging(VL53L1__ADDR);
+#ifdef	VL53L1__USING_DMA
+  VL53L1__AcqStart();
+#endif
+#endif
   while (1)
   {
     /* USER CODE END WHILE */
+#ifdef	VL53L1__USING_ARRAY
+	  VL53L1__testArray();
+#else
 	  VL53L1__testRanging();
+#endif
+#ifdef	VL53L1__USING_DMA
+	  VL53L1__AcqSleep();		// nothing to do until next data ready
+#endif
 
     /* USER CODE BEGIN 3 */
   }
@@ -278,6 +300,23 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+#ifdef	VL53L1__USING_DMA
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin){
+	VL53L1__AcqEXTI_Callback(GPIO_Pin);
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c){
+	i2cq_cplt_callback(VL53L1__GetI2cQueue(), hi2c);
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c){
+	i2cq_cplt_callback(VL53L1__GetI2cQueue(), hi2c);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c){
+	i2cq_error_callback(VL53L1__GetI2cQueue(), hi2c);
+}
+#endif
 
 /* USER CODE END 4 */
 
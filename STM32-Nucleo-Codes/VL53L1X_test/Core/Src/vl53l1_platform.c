@@ -45,22 +45,171 @@
 
 #include "main.h"
 
-//#include <string.h>
+#include <string.h>
 //#include <time.h>
 //#include <math.h>
 
 extern I2C_HandleTypeDef VL53L1__PORT;
 
 
-int8_t VL53L1_RdByte(uint16_t dev, uint16_t index, uint8_t *data) {
-	if (HAL_I2C_Mem_Read(&VL53L1__PORT, dev, index, I2C_MEMADD_SIZE_16BIT, data, 1, I2C_COMM_TIMEOUT))
+#ifdef	VL53L1__USING_DMA
+i2cq_t	VL53L1__I2cQueue;				// I2C transaction queue shared with acquisition (stats for CubeMonitor)
+static uint8_t	queueReady=0;
+
+
+
+
+/*****************************************
+ * @brief	I2C transaction queue on VL53L1__PORT,
+ * 			initialized on first use
+ *****************************************/
+i2cq_t *VL53L1__GetI2cQueue(){
+	if (!queueReady) {
+		i2cq_init(&VL53L1__I2cQueue, &VL53L1__PORT, VL53L1__SCL_PORT, VL53L1__SCL_PIN, VL53L1__SDA_PORT, VL53L1__SDA_PIN);
+		queueReady=1;
+	}
+	return &VL53L1__I2cQueue;
+}
+#endif
+
+
+
+
+/*****************************************
+ * @brief	register access used by the STM API:
+ * 			queued behind the transfers of the
+ * 			acquisition if VL53L1__USING_DMA,
+ * 			HAL blocking calls otherwise
+ * @return	0 or VL53L1__IO_ERROR
+ *****************************************/
+static int8_t PlatformXfer(uint16_t dev, uint16_t index, uint8_t dir, uint8_t *pdata, uint16_t count){
+#ifdef	VL53L1__USING_DMA
+	i2cq_xfer_t xfer = { dev, index, I2C_MEMADD_SIZE_16BIT, dir, pdata, count, NULL, NULL, 0 };
+
+	if (i2cq_transfer_sync(VL53L1__GetI2cQueue(), &xfer) != HAL_OK)
 		return VL53L1__IO_ERROR;
+#else
+	HAL_StatusTypeDef status;
+
+	if (dir==I2CQ_READ)
+		status=HAL_I2C_Mem_Read(&VL53L1__PORT, dev, index, I2C_MEMADD_SIZE_16BIT, pdata, count, I2C_COMM_TIMEOUT);
 	else
+		status=HAL_I2C_Mem_Write(&VL53L1__PORT, dev, index, I2C_MEMADD_SIZE_16BIT, pdata, count, I2C_COMM_TIMEOUT);
+	if (status)
+		return VL53L1__IO_ERROR;
+#endif
+	return 0;
+}
+
+
+
+
+/*****************************************
+ * write combining: between VL53L1__WrCombineBegin() and
+ * VL53L1__WrCombineEnd() writes to consecutive registers
+ * of the same device are collected and sent as one I2C
+ * transfer (the device auto-increments the index).
+ * Any other access sends the collected writes first, so
+ * the device sees the same register values in the same
+ * order, only in fewer transfers.
+ *****************************************/
+static uint8_t	wrDepth=0;							// nested Begin() calls
+static uint16_t	wrDev;
+static uint16_t	wrIndex;							// register of wrBuf[0]
+static uint16_t	wrLen=0;
+static uint8_t	wrBuf[VL53L1__WRCOMBINE_SIZE];
+
+
+
+
+/*****************************************
+ * @brief	sends the collected writes
+ * @return	0 or VL53L1__IO_ERROR
+ *****************************************/
+static int8_t WrFlush(){
+	uint16_t len=wrLen;
+
+	if (!len)
 		return 0;
+	wrLen=0;
+	return PlatformXfer(wrDev, wrIndex, I2CQ_WRITE, wrBuf, len);
+}
+
+
+
+
+/*****************************************
+ * @brief	write of "count" registers from "index":
+ * 			appended to the collected ones if contiguous,
+ * 			sent right away if not combining or too long
+ * @return	0 or VL53L1__IO_ERROR (collected writes
+ * 			failing when sent are reported here)
+ *****************************************/
+static int8_t PlatformWrite(uint16_t dev, uint16_t index, uint8_t *pdata, uint16_t count){
+	int8_t status=0;
+
+	if (!wrDepth)
+		return PlatformXfer(dev, index, I2CQ_WRITE, pdata, count);
+	if ((wrLen) && ((dev!=wrDev) || (index!=(uint16_t)(wrIndex+wrLen)) || ((wrLen+count)>VL53L1__WRCOMBINE_SIZE)))
+		status=WrFlush();
+	if (count>VL53L1__WRCOMBINE_SIZE)
+		return (status | PlatformXfer(dev, index, I2CQ_WRITE, pdata, count));
+	if (!wrLen) {
+		wrDev=dev;
+		wrIndex=index;
+	}
+	memcpy(&wrBuf[wrLen], pdata, count);
+	wrLen+=count;
+	return status;
+}
+
+
+
+
+/*****************************************
+ * @brief	read of "count" registers from "index",
+ * 			after sending the collected writes
+ * @return	0 or VL53L1__IO_ERROR
+ *****************************************/
+static int8_t PlatformRead(uint16_t dev, uint16_t index, uint8_t *pdata, uint16_t count){
+	int8_t status=WrFlush();
+
+	return (status | PlatformXfer(dev, index, I2CQ_READ, pdata, count));
+}
+
+
+
+
+/*****************************************
+ * @brief	starts collecting register writes
+ * 			(calls may be nested)
+ *****************************************/
+void VL53L1__WrCombineBegin(){
+	wrDepth++;
+}
+
+
+
+
+/*****************************************
+ * @brief	sends the collected register writes
+ * @return	0 or VL53L1__IO_ERROR
+ *****************************************/
+int8_t VL53L1__WrCombineEnd(){
+	if (wrDepth)
+		wrDepth--;
+	return WrFlush();
+}
+
+
+
+
+int8_t VL53L1_RdByte(uint16_t dev, uint16_t index, uint8_t *data) {
+	return PlatformRead(dev, index, data, 1);
 }
 
 int8_t VL53L1_RdWord(uint16_t dev, uint16_t index, uint16_t *data) {
-	if (HAL_I2C_Mem_Read(&VL53L1__PORT, dev, index, I2C_MEMADD_SIZE_16BIT, (uint8_t *)data, 2, I2C_COMM_TIMEOUT))
+	if (PlatformRead(dev, index, (uint8_t *)data, 2))
 		return VL53L1__IO_ERROR;
 	else {
 		*data=__REVSH(*data);
@@ -69,7 +218,7 @@ int8_t VL53L1_RdWord(uint16_t dev, uint16_t index, uint16_t *data) {
 }
 
 int8_t VL53L1_RdDWord(uint16_t dev, uint16_t index, uint32_t *data) {
-	if (HAL_I2C_Mem_Read(&VL53L1__PORT, dev, index, I2C_MEMADD_SIZE_16BIT, (uint8_t *)data, 4, I2C_COMM_TIMEOUT))
+	if (PlatformRead(dev, index, (uint8_t *)data, 4))
 		return VL53L1__IO_ERROR;
 	else {
 		*data=__REV(*data);
@@ -78,40 +227,25 @@ int8_t VL53L1_RdDWord(uint16_t dev, uint16_t index, uint32_t *data) {
 }
 
 int8_t VL53L1_ReadMulti(uint16_t dev, uint16_t index, uint8_t *pdata, uint32_t count){
-	if (HAL_I2C_Mem_Read(&VL53L1__PORT, dev, index, I2C_MEMADD_SIZE_16BIT, pdata, count, I2C_COMM_TIMEOUT))
-		return VL53L1__IO_ERROR;
-	else
-		return 0;
+	return PlatformRead(dev, index, pdata, count);
 }
 
 int8_t VL53L1_WrByte(uint16_t dev, uint16_t index, uint8_t data) {
-	if (HAL_I2C_Mem_Write(&VL53L1__PORT, dev, index, I2C_MEMADD_SIZE_16BIT, &data, 1, I2C_COMM_TIMEOUT))
-		return VL53L1__IO_ERROR;
-	else
-		return 0;
+	return PlatformWrite(dev, index, &data, 1);
 }
 
 int8_t VL53L1_WrWord(uint16_t dev, uint16_t index, uint16_t data) {
 	data=__REVSH(data);
-	if (HAL_I2C_Mem_Write(&VL53L1__PORT, dev, index, I2C_MEMADD_SIZE_16BIT, (uint8_t *)&data, 2, I2C_COMM_TIMEOUT))
-		return VL53L1__IO_ERROR;
-	else
-		return 0;
+	return PlatformWrite(dev, index, (uint8_t *)&data, 2);
 }
 
 int8_t VL53L1_WrDWord(uint16_t dev, uint16_t index, uint32_t data) {
 	data=__REV(data);
-	if (HAL_I2C_Mem_Write(&VL53L1__PORT, dev, index, I2C_MEMADD_SIZE_16BIT, (uint8_t *)&data, 4, I2C_COMM_TIMEOUT))
-		return VL53L1__IO_ERROR;
-	else
-		return 0;
+	return PlatformWrite(dev, index, (uint8_t *)&data, 4);
 }
 
 int8_t VL53L1_WriteMulti( uint16_t dev, uint16_t index, uint8_t *pdata, uint32_t count) {
-	if (HAL_I2C_Mem_Write(&VL53L1__PORT, dev, index, I2C_MEMADD_SIZE_16BIT, pdata, count, I2C_COMM_TIMEOUT))
-		return VL53L1__IO_ERROR;
-	else
-		return 0;
+	return PlatformWrite(dev, index, pdata, count);
 }
 
 /*
@@ -152,37 +286,49 @@ uint8_t VL53L1__Xshut(uint8_t level){
  * @return:	0	if no errors detected in setting up VL53L1X
  ************************************************************/
 uint8_t VL53L1__Init(){
-	uint8_t refRegs[4] = {0,0,0,0};
-	uint8_t status =0;
-
 	// Enable VL53L1 sensor waiting for a complete boot sequence
 #ifdef	VL53L1__USING_XSHUT
+	uint8_t status =0;
 	status |= VL53L1__Xshut(1);
 	if (status)
 		return (status);
 #endif
 	HAL_Delay(4);
 
+	return (VL53L1__InitDev(VL53L1__ADDR));
+};
+
+
+
+
+/************************************************************
+ * @brief:		initializes the (booted) sensor answering at
+ * 				address "dev" with project settings
+ * @return:	0	if no errors detected in setting up VL53L1X
+ ************************************************************/
+uint8_t VL53L1__InitDev(uint16_t dev){
+	uint8_t refRegs[4] = {0,0,0,0};
+	uint8_t status =0;
+
 	//check if VL53L1X is alive and kicking. Remove MASKREV if VL53L1
-	VL53L1_ReadMulti(VL53L1__ADDR, VL53L1__MODELID_INDEX, refRegs, 4);
+	VL53L1_ReadMulti(dev, VL53L1__MODELID_INDEX, refRegs, 4);
 	if ((refRegs[0]!=VL53L1__MODELID_VALUE) || (refRegs[1]!=VL53L1__MODULETYPE_VALUE) || (refRegs[2]!=VL53L1__MASKREV_VALUE))
 		return (1);
 
 
 	// VL53L1X sensor is available
 	/* initializing: default setting  */
-	status |= VL53L1X_SensorInit(VL53L1__ADDR);
+	status |= VL53L1X_SensorInit(dev);
 	/* initializing: device calibration settings*/
-	status |= VL53L1X_SetOffset(VL53L1__ADDR, VL53L1__CALIB_OFFSET);
-	status |= VL53L1X_SetXtalk(VL53L1__ADDR, VL53L1__CALIB_XTALK);
+	status |= VL53L1X_SetOffset(dev, VL53L1__CALIB_OFFSET);
+	status |= VL53L1X_SetXtalk(dev, VL53L1__CALIB_XTALK);
 	/* initializing: project settings */
-	status |= VL53L1X_SetDistanceMode(VL53L1__ADDR, VL53L1__DISTANCE_MODE);
-	status |= VL53L1X_SetTimingBudgetInMs(VL53L1__ADDR, VL53L1__TIMING_BUDGET);
-	status |= VL53L1X_SetInterMeasurementInMs(VL53L1__ADDR, VL53L1__INTERMEASUREMENT);
-	status |= VL53L1X_SetDistanceThreshold(VL53L1__ADDR,VL53L1__LOWER_THRESHOLD, VL53L1__UPPER_THRESHOLD, VL53L1__WINDOW_MODE, 0);
+	status |= VL53L1X_SetDistanceModeAndTimingBudget(dev, VL53L1__DISTANCE_MODE, VL53L1__TIMING_BUDGET);
+	status |= VL53L1X_SetInterMeasurementInMs(dev, VL53L1__INTERMEASUREMENT);
+	status |= VL53L1X_SetDistanceThreshold(dev,VL53L1__LOWER_THRESHOLD, VL53L1__UPPER_THRESHOLD, VL53L1__WINDOW_MODE, 0);
 
 	return (status);
-};
+}
 
 
 
@@ -198,12 +344,19 @@ uint8_t VL53L1__Init(){
  * 					value	the read Distance, if not 0
  *****************************************/
 uint8_t VL53L1__GetDistance(uint16_t *Distance){
-	uint8_t RangingStatus;
+	VL53L1X_Result_t Result;
 	uint8_t status =0;
 	uint32_t testingTime=HAL_GetTick();
 	static uint16_t PrevDistance=0;
 
-#ifdef	VL53L1__USING_GPIO
+#if defined(VL53L1__USING_DMA)
+	// sample read by DMA on data ready interrupt: sleep waiting for it
+	VL53L1__Sample_t Sample;
+	uint8_t sampleReady;
+	while ((!(sampleReady=VL53L1__AcqGetSample(&Sample))) && ((HAL_GetTick()-testingTime)<=VL53L1__INTERMEASUREMENT))
+		VL53L1__AcqSleep();
+	if (sampleReady) {
+#elif defined(VL53L1__USING_GPIO)
 	// VL53L1X data available test if TOF_GPIO pin is available
 	while ((!HAL_GPIO_ReadPin(TOF_GPIO_GPIO_Port, TOF_GPIO_Pin)) && ((HAL_GetTick()-testingTime)<=VL53L1__INTERMEASUREMENT)) {};
 	if (HAL_GPIO_ReadPin(TOF_GPIO_GPIO_Port, TOF_GPIO_Pin)) {
@@ -214,10 +367,14 @@ uint8_t VL53L1__GetDistance(uint16_t *Distance){
 		status |= VL53L1X_CheckForDataReady(VL53L1__ADDR, &dataReady);
 	if (dataReady && (!status)) {
 #endif
-		status |= VL53L1X_GetRangeStatus(VL53L1__ADDR, &RangingStatus);
-		status |= VL53L1X_GetDistance(VL53L1__ADDR, Distance);
-		status |= VL53L1X_ClearInterrupt(VL53L1__ADDR);
-		if ((status==0) && (RangingStatus<=VL53L1__RANGE_STATUS_THRESH)) {
+#ifdef	VL53L1__USING_DMA
+		Result=Sample.Result;		// already read and interrupt cleared
+#else
+		// one burst read of the result block, then restart readings (clears interrupt)
+		status |= VL53L1X_GetResultAndClearInterrupt(VL53L1__ADDR, &Result);
+#endif
+		if ((status==0) && (Result.Status<=VL53L1__RANGE_STATUS_THRESH)) {
+			*Distance=Result.Distance;
 			PrevDistance=*Distance;
 		} else {
 			*Distance=PrevDistance;
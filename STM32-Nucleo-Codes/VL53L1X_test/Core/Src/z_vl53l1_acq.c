@@ -0,0 +1,349 @@
+/*
+ * z_vl53l1_acq.c
+ *
+ *	Event driven VL53L1X acquisition (data ready interrupt + I2C DMA)
+ *	see z_vl53l1_acq.h for configuration
+ *
+ *	data ready EXTI -> DMA read of result block -> ring buffer push
+ *	                -> interrupt clear (I2C interrupt mode) -> idle
+ *
+ *	Sensors sharing the I2C bus are served one transfer at a time:
+ *	data ready and clear requests are queued as bit masks,
+ *	clears first (they re-arm a sensor), lowest sensor index first.
+ *	Transfers go through the I2C transaction queue (i2c_queue.h) so
+ *	they interleave with the platform register accesses of the API.
+ *
+ */
+
+#include "main.h"
+
+#ifdef VL53L1__USING_DMA
+
+#if (VL53L1__ACQ_RING_SIZE & (VL53L1__ACQ_RING_SIZE - 1)) || (VL53L1__ACQ_RING_SIZE > 128)
+#error "VL53L1__ACQ_RING_SIZE must be a power of 2, not greater than 128"
+#endif
+
+// bus state
+#define ACQ_IDLE			0
+#define ACQ_READING			1		// DMA read of a result block running
+#define ACQ_CLEARING		2		// interrupt clear running
+
+// a stop waits for the acquisition transfers to leave the queue: every
+// transfer queued ahead of them may run up to the queue timeout
+#define ACQ_STOP_TIMEOUT	(I2CQ_DEPTH*(I2CQ_XFER_TIMEOUT+1U))
+
+#ifndef VL53L1__USING_ARRAY
+// single sensor configured in vl53l1_platform.h
+static const VL53L1__AcqSensor_t defaultSensor = { VL53L1__ADDR, TOF_GPIO_GPIO_Port, TOF_GPIO_Pin };
+static const VL53L1__AcqSensor_t *acqSensors=&defaultSensor;
+static uint8_t				acqSensorCnt=1;
+#else
+static const VL53L1__AcqSensor_t *acqSensors=NULL;
+static uint8_t				acqSensorCnt=0;
+#endif
+
+static volatile uint8_t		acqEnabled=0;
+static volatile uint8_t		busState=ACQ_IDLE;
+static volatile uint8_t		busSensor;								// sensor served by the running transfer
+static volatile uint8_t		readPending=0;							// bit n: sensor n has data ready to be read
+static volatile uint8_t		clearPending=0;							// bit n: sensor n interrupt to be cleared
+static volatile uint32_t	acqTime[VL53L1__ACQ_MAX_SENSORS];		// data ready timestamp
+static volatile uint32_t	clearTime[VL53L1__ACQ_MAX_SENSORS];		// tick of the last completed interrupt clear
+static uint8_t				rxBlock[VL53L1X_RESULT_BLOCK_SIZE];
+static uint8_t				clearCmd=0x01;
+
+static void AcqReadDone(i2cq_xfer_t *xfer);
+static void AcqClearDone(i2cq_xfer_t *xfer);
+static i2cq_xfer_t			readXfer  = { 0, VL53L1_RESULT__RANGE_STATUS, I2C_MEMADD_SIZE_16BIT, I2CQ_READ, rxBlock, VL53L1X_RESULT_BLOCK_SIZE, AcqReadDone, NULL, 0 };
+static i2cq_xfer_t			clearXfer = { 0, SYSTEM__INTERRUPT_CLEAR, I2C_MEMADD_SIZE_16BIT, I2CQ_WRITE, &clearCmd, 1, AcqClearDone, NULL, 0 };
+
+static VL53L1__Sample_t		ring[VL53L1__ACQ_RING_SIZE];
+static volatile uint8_t		ringHead=0;			// written by interrupts only
+static volatile uint8_t		ringTail=0;			// written by main loop only
+static VL53L1__AcqStats_t	acqStats;
+
+
+
+
+/*****************************************
+ * @brief	critical section usable in any context
+ *****************************************/
+static uint32_t AcqLock(){
+	uint32_t primask=__get_PRIMASK();
+	__disable_irq();
+	return primask;
+}
+
+static void AcqUnlock(uint32_t primask){
+	__set_PRIMASK(primask);
+}
+
+
+
+// an acquisition transfer still in the queue can't be submitted again
+static uint8_t AcqXferQueued(){
+	return (readXfer.status==I2CQ_PENDING) || (clearXfer.status==I2CQ_PENDING);
+}
+
+
+
+
+/*****************************************
+ * @brief	submits next requested transfer if bus is idle
+ * 			(any context, it masks interrupts itself)
+ * 			a request failing on submission (queue full)
+ * 			is re-armed: main loop retries.
+ * 			Nothing is submitted while a transfer abandoned by
+ * 			VL53L1__AcqStop() is still queued
+ *****************************************/
+static void AcqNext(){
+	uint32_t primask=AcqLock();
+	uint8_t n;
+
+	if ((busState==ACQ_IDLE) && (!AcqXferQueued())) {
+		if (clearPending) {
+			for (n=0; !(clearPending & (1U<<n)); n++) {};
+			clearPending &= ~(1U<<n);		// before submitting: a failing transfer may complete right away
+			busSensor=n;
+			busState=ACQ_CLEARING;
+			clearXfer.dev=acqSensors[n].Addr;
+			if (i2cq_submit(VL53L1__GetI2cQueue(), &clearXfer) != HAL_OK) {
+				clearPending |= (1U<<n);
+				busState=ACQ_IDLE;
+			}
+		} else if (readPending && acqEnabled) {
+			for (n=0; !(readPending & (1U<<n)); n++) {};
+			readPending &= ~(1U<<n);
+			busSensor=n;
+			busState=ACQ_READING;
+			readXfer.dev=acqSensors[n].Addr;
+			if (i2cq_submit(VL53L1__GetI2cQueue(), &readXfer) != HAL_OK) {
+				readPending |= (1U<<n);
+				busState=ACQ_IDLE;
+			}
+		}
+	}
+	AcqUnlock(primask);
+}
+
+
+
+
+/*****************************************
+ * @brief	main loop side: restarts what interrupts could not start
+ * 			and catches a data ready asserted without an edge
+ * 			(e.g. already high when acquisition started)
+ *****************************************/
+static void AcqKick(){
+	uint8_t n;
+	uint8_t mask;
+
+	__disable_irq();
+	if (acqEnabled) {
+		for (n=0; n<acqSensorCnt; n++) {
+			mask=(1U<<n);
+			if ((!((readPending | clearPending) & mask))
+					&& (!((busState!=ACQ_IDLE) && (busSensor==n)))
+					&& HAL_GPIO_ReadPin(acqSensors[n].IntPort, acqSensors[n].IntPin)
+					&& ((HAL_GetTick()-clearTime[n])>1)) {
+				acqStats.MissedEdges++;
+				acqTime[n]=HAL_GetTick();
+				readPending |= mask;
+			}
+		}
+	}
+	__enable_irq();
+	i2cq_poll(VL53L1__GetI2cQueue());		// transfer timeouts and bus recovery
+	AcqNext();
+}
+
+
+
+
+/*****************************************
+ * @brief 			sets the sensors served by acquisition
+ * 					(VL53L1__USING_ARRAY), the table must stay valid.
+ * 					Call it with acquisition stopped
+ * @param	pSensors	sensors table, index is the sample Sensor field
+ * @param	cnt		number of sensors (up to VL53L1__ACQ_MAX_SENSORS)
+ *****************************************/
+void VL53L1__AcqSetSensors(const VL53L1__AcqSensor_t *pSensors, uint8_t cnt){
+	if (cnt>VL53L1__ACQ_MAX_SENSORS)
+		cnt=VL53L1__ACQ_MAX_SENSORS;
+	acqSensors=pSensors;
+	acqSensorCnt=cnt;
+}
+
+
+
+
+/*****************************************
+ * @brief	enables acquisition, discarding buffered samples
+ * 			call it after VL53L1X_StartRanging()
+ *****************************************/
+void VL53L1__AcqStart(){
+	uint8_t n;
+
+	ringTail=ringHead;
+	readPending=0;
+	clearPending=0;
+	busState=ACQ_IDLE;
+	for (n=0; n<acqSensorCnt; n++)
+		clearTime[n]=HAL_GetTick()-2;
+	acqEnabled=1;
+	AcqKick();
+}
+
+
+
+
+/*****************************************
+ * @brief	disables acquisition waiting for the running
+ * 			transfer to end and leave the I2C queue (the queue
+ * 			aborts a stuck transfer). Call it before any blocking
+ * 			access to the sensors
+ *****************************************/
+void VL53L1__AcqStop(){
+	uint32_t stopTime=HAL_GetTick();
+
+	acqEnabled=0;
+	readPending=0;
+	while (((busState!=ACQ_IDLE) || AcqXferQueued()) && ((HAL_GetTick()-stopTime)<=ACQ_STOP_TIMEOUT))
+		i2cq_poll(VL53L1__GetI2cQueue());
+	busState=ACQ_IDLE;			// a late completion is ignored, AcqNext() doesn't resubmit it
+	clearPending=0;
+}
+
+
+
+
+/*****************************************
+ * @brief 			gets the oldest buffered sample
+ * @param	pSample	sample read
+ * @return			1 if a sample was read, 0 if buffer is empty
+ *****************************************/
+uint8_t VL53L1__AcqGetSample(VL53L1__Sample_t *pSample){
+	AcqKick();
+	if (ringTail==ringHead)
+		return 0;
+	*pSample=ring[ringTail];
+	ringTail=(ringTail+1) & (VL53L1__ACQ_RING_SIZE-1);
+	return 1;
+}
+
+
+
+
+/*****************************************
+ * @brief	stops the core until next interrupt (data ready,
+ * 			I2C, SysTick, ...) if no sample is waiting
+ *****************************************/
+void VL53L1__AcqSleep(){
+	__disable_irq();
+	if (ringTail==ringHead)
+		__WFI();			// a pending interrupt wakes the core also with PRIMASK set
+	__enable_irq();
+}
+
+
+
+
+const VL53L1__AcqStats_t *VL53L1__AcqGetStats(){
+	return &acqStats;
+}
+
+
+
+
+/*****************************************
+ * @brief	to be called by HAL_GPIO_EXTI_Callback()
+ *****************************************/
+void VL53L1__AcqEXTI_Callback(uint16_t GPIO_Pin){
+	uint8_t n;
+
+	if (!acqEnabled)
+		return;
+	for (n=0; n<acqSensorCnt; n++) {
+		if (acqSensors[n].IntPin==GPIO_Pin) {
+			uint32_t primask;
+			acqTime[n]=HAL_GetTick();
+			primask=AcqLock();
+			readPending |= (1U<<n);
+			AcqUnlock(primask);
+			AcqNext();
+			return;
+		}
+	}
+}
+
+
+
+
+/*****************************************
+ * @brief	transfer failed: frame lost or clear not sent.
+ * 			Re-arms the sensor, retried by main loop
+ * 			(not from here, a persistent bus error would
+ * 			loop in interrupts)
+ *****************************************/
+static void AcqXferFailed(){
+	uint32_t primask=AcqLock();
+
+	acqStats.I2cErrors++;
+	clearPending |= (1U<<busSensor);
+	busState=ACQ_IDLE;
+	AcqUnlock(primask);
+}
+
+
+
+
+/*****************************************
+ * @brief	result block read completed (I2C interrupt)
+ *****************************************/
+static void AcqReadDone(i2cq_xfer_t *xfer){
+	uint32_t primask;
+	uint8_t next;
+	uint8_t n=busSensor;
+
+	if (busState!=ACQ_READING)
+		return;
+	if (xfer->status!=HAL_OK) {
+		AcqXferFailed();
+		return;
+	}
+	next=(ringHead+1) & (VL53L1__ACQ_RING_SIZE-1);
+	if (next==ringTail) {
+		acqStats.Overruns++;				// main loop too slow: drop the newest sample
+	} else {
+		ring[ringHead].Timestamp=acqTime[n];
+		ring[ringHead].Sensor=n;
+		VL53L1X_DecodeResult(rxBlock, &ring[ringHead].Result);
+		ringHead=next;
+		acqStats.Samples++;
+	}
+	primask=AcqLock();
+	clearPending |= (1U<<n);
+	busState=ACQ_IDLE;
+	AcqUnlock(primask);
+	AcqNext();
+}
+
+
+
+
+/*****************************************
+ * @brief	interrupt clear completed (I2C interrupt)
+ *****************************************/
+static void AcqClearDone(i2cq_xfer_t *xfer){
+	if (busState!=ACQ_CLEARING)
+		return;
+	if (xfer->status!=HAL_OK) {
+		AcqXferFailed();
+		return;
+	}
+	clearTime[busSensor]=HAL_GetTick();
+	busState=ACQ_IDLE;
+	AcqNext();
+}
+
+#endif /* VL53L1__USING_DMA */
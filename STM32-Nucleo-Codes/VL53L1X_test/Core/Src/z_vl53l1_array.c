@@ -0,0 +1,188 @@
+/*
+ * z_vl53l1_array.c
+ *
+ *	Array of VL53L1X sensors sharing one I2C bus
+ *	see z_vl53l1_array.h for configuration
+ *
+ *	bring-up:	XSHUT sequencing and address assignment
+ *	ranging:	staggered start, samples read by z_vl53l1_acq
+ *	output:		one scan frame per intermeasurement period
+ *
+ */
+
+#include "main.h"
+
+#ifdef VL53L1__USING_ARRAY
+
+#if (VL53L1__ARRAY_CNT > VL53L1__ACQ_MAX_SENSORS)
+#error "VL53L1__ARRAY_CNT can't be greater than VL53L1__ACQ_MAX_SENSORS"
+#endif
+
+#define ARRAY_ADDR(n)	(VL53L1__ARRAY_FIRST_ADDR + 2*(n))
+
+static const VL53L1__Pin_t	xshutPins[VL53L1__ARRAY_CNT] = VL53L1__ARRAY_XSHUT_PINS;
+static const VL53L1__Pin_t	intPins[VL53L1__ARRAY_CNT] = VL53L1__ARRAY_INT_PINS;
+
+static VL53L1__AcqSensor_t	acqTable[VL53L1__ARRAY_CNT];	// working sensors, as served by acquisition
+static uint8_t				acqToArray[VL53L1__ARRAY_CNT];	// acquisition index -> array index
+static uint8_t				activeCnt=0;
+static uint8_t				activeMask=0;					// bit n: sensor n working
+
+static VL53L1__Frame_t		curFrame;						// frame being filled
+static uint32_t				frameSeq=0;
+
+
+
+
+/************************************************************
+ * @brief:		brings sensors up one by one assigning
+ * 				their addresses (call it before the main loop
+ * 				instead of VL53L1__Init())
+ * @return:	0	if all sensors are working, else bit n set
+ * 				for every sensor failing (left in reset)
+ ************************************************************/
+uint8_t VL53L1__ArrayInit(){
+	uint8_t n;
+	uint8_t booted;
+	uint8_t status;
+	uint32_t bootTime;
+
+	activeCnt=0;
+	activeMask=0;
+	// all sensors in reset: none of them answers at default address
+	for (n=0; n<VL53L1__ARRAY_CNT; n++)
+		HAL_GPIO_WritePin(xshutPins[n].Port, xshutPins[n].Pin, GPIO_PIN_RESET);
+	HAL_Delay(2);
+
+	for (n=0; n<VL53L1__ARRAY_CNT; n++) {
+		// release sensor n and wait for its boot at default address
+		HAL_GPIO_WritePin(xshutPins[n].Port, xshutPins[n].Pin, GPIO_PIN_SET);
+		bootTime=HAL_GetTick();
+		booted=0;
+		while ((!(booted & 0x01)) && ((HAL_GetTick()-bootTime)<=VL53L1__ARRAY_BOOT_TIMEOUT)) {
+			HAL_Delay(2);
+			if (VL53L1X_BootState(VL53L1__ADDR, &booted))
+				booted=0;							// no answer while booting
+		}
+
+		status=1;
+		if (booted & 0x01) {
+			status=VL53L1X_SetI2CAddress(VL53L1__ADDR, ARRAY_ADDR(n));
+			if (!status)
+				status=VL53L1__InitDev(ARRAY_ADDR(n));
+		}
+		if (status) {
+			// keep it in reset, else it would answer at default address
+			HAL_GPIO_WritePin(xshutPins[n].Port, xshutPins[n].Pin, GPIO_PIN_RESET);
+			continue;
+		}
+
+		acqTable[activeCnt].Addr=ARRAY_ADDR(n);
+		acqTable[activeCnt].IntPort=intPins[n].Port;
+		acqTable[activeCnt].IntPin=intPins[n].Pin;
+		acqToArray[activeCnt]=n;
+		activeCnt++;
+		activeMask |= (1U<<n);
+	}
+
+	VL53L1__AcqSetSensors(acqTable, activeCnt);
+	return (((1U<<VL53L1__ARRAY_CNT)-1) & ~activeMask);
+}
+
+
+
+
+/************************************************************
+ * @brief:		(re)starts ranging on working sensors, staggered
+ * 				by VL53L1__INTERMEASUREMENT/(working sensors),
+ * 				and acquisition. It blocks for about an
+ * 				intermeasurement period
+ * @return:	0	if no I2C errors
+ ************************************************************/
+uint8_t VL53L1__ArrayStart(){
+	uint8_t n;
+	uint8_t status=0;
+
+	VL53L1__AcqStop();
+	for (n=0; n<activeCnt; n++)
+		status |= VL53L1X_StopRanging(acqTable[n].Addr);
+	for (n=0; n<activeCnt; n++) {
+		status |= VL53L1X_StartRanging(acqTable[n].Addr);
+		if ((n+1)<activeCnt)
+			HAL_Delay(VL53L1__INTERMEASUREMENT/activeCnt);
+	}
+	curFrame.ValidMask=0;
+	VL53L1__AcqStart();
+	return status;
+}
+
+
+
+
+/************************************************************
+ * @return:		bit n set if sensor n is working
+ ************************************************************/
+uint8_t VL53L1__ArrayGetActive(){
+	return activeMask;
+}
+
+
+
+
+/************************************************************
+ * @brief:		closes the frame being filled into *pFrame
+ ************************************************************/
+static void ArrayCloseFrame(VL53L1__Frame_t *pFrame){
+	curFrame.Seq=frameSeq++;
+	*pFrame=curFrame;
+	curFrame.ValidMask=0;
+}
+
+
+
+
+/************************************************************
+ * @brief:		collects samples into scan frames.
+ * 				A frame is closed when all working sensors
+ * 				gave a sample, when a sensor gives its second
+ * 				sample or after VL53L1__ARRAY_FRAME_TIMEOUT
+ * @param:	pFrame	closed frame
+ * @return:	1	if a frame was closed, 0 otherwise
+ ************************************************************/
+uint8_t VL53L1__ArrayGetFrame(VL53L1__Frame_t *pFrame){
+	VL53L1__Sample_t Sample;
+	uint8_t n;
+	uint8_t closed=0;
+
+	// frame completed by a sample which closed the previous one
+	if (curFrame.ValidMask && (curFrame.ValidMask==activeMask)) {
+		ArrayCloseFrame(pFrame);
+		return 1;
+	}
+
+	while ((!closed) && VL53L1__AcqGetSample(&Sample)) {
+		n=acqToArray[Sample.Sensor];
+		Sample.Sensor=n;
+		if (curFrame.ValidMask & (1U<<n)) {
+			// sensor n is one period ahead: it opens next frame
+			ArrayCloseFrame(pFrame);
+			closed=1;
+		}
+		if (!curFrame.ValidMask)
+			curFrame.Timestamp=Sample.Timestamp;
+		curFrame.Sample[n]=Sample;
+		curFrame.ValidMask |= (1U<<n);
+		if ((!closed) && (curFrame.ValidMask==activeMask)) {
+			ArrayCloseFrame(pFrame);
+			closed=1;
+		}
+	}
+
+	if ((!closed) && curFrame.ValidMask && ((HAL_GetTick()-curFrame.Timestamp)>VL53L1__ARRAY_FRAME_TIMEOUT)) {
+		ArrayCloseFrame(pFrame);
+		closed=1;
+	}
+	return closed;
+}
+
+#endif /* VL53L1__USING_ARRAY */
@@ -0,0 +1,264 @@
+/*
+ * z_vl53l1_gesture.c
+ *
+ *	Gesture recognition on VL53L1X distance readings
+ *	see z_vl53l1_gesture.h for configuration and use
+ *
+ *	table driven state machine:
+ *	every sample is turned into one input (absent, present, hold,
+ *	gap, swipe), the table gives next state and action to run
+ *
+ */
+
+#include "main.h"
+#include <string.h>
+
+#if (GESTURE_RELEASE_TIME >= GESTURE_DCLICK_GAP)
+#error "GESTURE_RELEASE_TIME must be shorter than GESTURE_DCLICK_GAP"
+#endif
+
+
+// states
+enum {
+	ST_IDLE=0,		// no hand
+	ST_PRESS1,		// hand present, first press
+	ST_WAIT2,		// hand released after a short press: waiting for a second one
+	ST_PRESS2,		// hand present, second press
+	ST_LONG,		// long press: hand movements change Value
+	ST_NUM
+};
+
+// inputs
+enum {
+	IN_ABSENT=0,	// no hand
+	IN_PRESENT,		// hand in gesture zone
+	IN_HOLD,		// hand pressing for GESTURE_LONG_TIME
+	IN_GAP,			// no hand for GESTURE_DCLICK_GAP after a short press
+	IN_SWIPE,		// hand left after moving GESTURE_SWIPE_DELTA
+	IN_DROPOUT,		// no hand during a press, for less than GESTURE_RELEASE_TIME
+	IN_NUM
+};
+
+// actions
+enum {
+	AC_NONE=0,
+	AC_START,		// start tracking a press
+	AC_TRACK,		// track hand distance
+	AC_CLICK,
+	AC_DCLICK,
+	AC_LONG_START,
+	AC_LONG_VALUE,
+	AC_LONG_END,
+	AC_SWIPE
+};
+
+typedef struct {
+	uint8_t Next;
+	uint8_t Action;
+} GestureTrans_t;
+
+
+static const GestureTrans_t GestureTable[ST_NUM][IN_NUM] = {
+	//				IN_ABSENT					IN_PRESENT					IN_HOLD							IN_GAP						IN_SWIPE					IN_DROPOUT
+	[ST_IDLE]  = { {ST_IDLE,  AC_NONE},		{ST_PRESS1, AC_START},		{ST_PRESS1, AC_START},			{ST_IDLE,  AC_NONE},		{ST_IDLE,  AC_NONE},		{ST_IDLE,   AC_NONE} },
+	[ST_PRESS1]= { {ST_WAIT2, AC_NONE},		{ST_PRESS1, AC_TRACK},		{ST_LONG,   AC_LONG_START},		{ST_WAIT2, AC_NONE},		{ST_IDLE,  AC_SWIPE},		{ST_PRESS1, AC_NONE} },
+	[ST_WAIT2] = { {ST_WAIT2, AC_NONE},		{ST_PRESS2, AC_START},		{ST_PRESS2, AC_START},			{ST_IDLE,  AC_CLICK},		{ST_WAIT2, AC_NONE},		{ST_WAIT2,  AC_NONE} },
+	[ST_PRESS2]= { {ST_IDLE,  AC_DCLICK},	{ST_PRESS2, AC_TRACK},		{ST_LONG,   AC_LONG_START},		{ST_IDLE,  AC_DCLICK},		{ST_IDLE,  AC_SWIPE},		{ST_PRESS2, AC_NONE} },
+	[ST_LONG]  = { {ST_IDLE,  AC_LONG_END},	{ST_LONG,   AC_LONG_VALUE},	{ST_LONG,   AC_LONG_VALUE},		{ST_IDLE,  AC_LONG_END},	{ST_IDLE,  AC_LONG_END},	{ST_LONG,   AC_NONE} },
+};
+
+
+
+
+/*****************************************
+ * @brief	sets initial state and default long press
+ * 			value limits
+ *****************************************/
+void VL53L1__InitGesture(VL53L1__Gesture_t *pGesture){
+	memset(pGesture, 0, sizeof(VL53L1__Gesture_t));
+	pGesture->State=ST_IDLE;
+	pGesture->Lower=GESTURE_MIN_DIST;
+	pGesture->Upper=GESTURE_MAX_DIST;
+	pGesture->Value=(GESTURE_MIN_DIST+GESTURE_MAX_DIST)/2;
+}
+
+
+
+
+/*****************************************
+ * @brief	sets long press value and its limits
+ * 			(e.g. entering a menu item)
+ *****************************************/
+void VL53L1__GestureSetValue(VL53L1__Gesture_t *pGesture, int16_t Value, int16_t Lower, int16_t Upper){
+	pGesture->Lower=Lower;
+	pGesture->Upper=Upper;
+	if (Value<Lower)
+		Value=Lower;
+	if (Value>Upper)
+		Value=Upper;
+	pGesture->Value=Value;
+	pGesture->LongRefValue=Value;
+}
+
+
+
+
+/*****************************************
+ * @brief	classifies a sample into a state machine input
+ *****************************************/
+static uint8_t GestureInput(const VL53L1__Gesture_t *pGesture, uint32_t Timestamp){
+	uint32_t elapsed=Timestamp-pGesture->StateTime;
+	uint8_t pressing=((pGesture->State==ST_PRESS1) || (pGesture->State==ST_PRESS2));
+
+	if (!pGesture->Absent) {
+		if (pressing && (elapsed>=GESTURE_LONG_TIME))
+			return IN_HOLD;
+		return IN_PRESENT;
+	}
+	// a press (or a long press) ends only after GESTURE_RELEASE_TIME without hand
+	if ((pressing || (pGesture->State==ST_LONG)) && ((Timestamp-pGesture->AbsentTime)<GESTURE_RELEASE_TIME))
+		return IN_DROPOUT;
+	if (pressing && ((pGesture->MaxDist-pGesture->MinDist)>=GESTURE_SWIPE_DELTA))
+		return IN_SWIPE;
+	if ((pGesture->State==ST_WAIT2) && (elapsed>=GESTURE_DCLICK_GAP))
+		return IN_GAP;
+	return IN_ABSENT;
+}
+
+
+
+
+/*****************************************
+ * @brief		runs one sample through the state machine.
+ * 				No I/O: it can be fed by recorded traces
+ * @param	Timestamp	ms, sample time
+ * @param	Distance	mm
+ * @param	RangeStatus	as returned by the sensor
+ * @param	pEvent		gesture detected
+ * @return	1 if a gesture event was set into *pEvent
+ *****************************************/
+uint8_t VL53L1__GestureFeed(VL53L1__Gesture_t *pGesture, uint32_t Timestamp, uint16_t Distance, uint8_t RangeStatus, VL53L1__GestureEvent_t *pEvent){
+	const GestureTrans_t *pTrans;
+	int32_t value;
+	uint8_t absent;
+
+	absent=!((RangeStatus<=VL53L1__RANGE_STATUS_THRESH) && (Distance>=GESTURE_MIN_DIST) && (Distance<=GESTURE_MAX_DIST));
+	if (absent && !pGesture->Absent)
+		pGesture->AbsentTime=Timestamp;
+	pGesture->Absent=absent;
+
+	pTrans=&GestureTable[pGesture->State][GestureInput(pGesture, Timestamp)];
+	pEvent->Type=VL53L1__GESTURE_NONE;
+	pEvent->Timestamp=Timestamp;
+
+	switch (pTrans->Action) {
+	case AC_START:
+		pGesture->FirstDist=Distance;
+		pGesture->MinDist=Distance;
+		pGesture->MaxDist=Distance;
+		pGesture->LastDist=Distance;
+		break;
+	case AC_TRACK:
+		if (Distance<pGesture->MinDist)
+			pGesture->MinDist=Distance;
+		if (Distance>pGesture->MaxDist)
+			pGesture->MaxDist=Distance;
+		pGesture->LastDist=Distance;
+		break;
+	case AC_CLICK:
+		pEvent->Type=VL53L1__GESTURE_CLICK;
+		break;
+	case AC_DCLICK:
+		pEvent->Type=VL53L1__GESTURE_DOUBLECLICK;
+		break;
+	case AC_LONG_START:
+		pGesture->LongRefDist=Distance;
+		pGesture->LongRefValue=pGesture->Value;
+		pEvent->Type=VL53L1__GESTURE_LONG_START;
+		break;
+	case AC_LONG_VALUE:
+		// Value moves with the hand: GESTURE_LONG_SPAN mm cover Lower..Upper
+		value=pGesture->LongRefValue + ((int32_t)Distance-pGesture->LongRefDist)*(pGesture->Upper-pGesture->Lower)/GESTURE_LONG_SPAN;
+		if (value<pGesture->Lower)
+			value=pGesture->Lower;
+		if (value>pGesture->Upper)
+			value=pGesture->Upper;
+		if (value!=pGesture->Value) {
+			pGesture->Value=value;
+			pEvent->Type=VL53L1__GESTURE_LONG_VALUE;
+		}
+		break;
+	case AC_LONG_END:
+		pEvent->Type=VL53L1__GESTURE_LONG_END;
+		break;
+	case AC_SWIPE:
+		pEvent->Type=(pGesture->LastDist<pGesture->FirstDist) ? VL53L1__GESTURE_SWIPE_NEAR : VL53L1__GESTURE_SWIPE_FAR;
+		break;
+	}
+	pEvent->Value=pGesture->Value;
+
+	if (pTrans->Next!=pGesture->State) {
+		pGesture->State=pTrans->Next;
+		// a release dates from the first absent sample
+		pGesture->StateTime=absent ? pGesture->AbsentTime : Timestamp;
+	}
+	return (pEvent->Type!=VL53L1__GESTURE_NONE);
+}
+
+
+
+
+/*****************************************
+ * @brief	takes next sample, if already available,
+ * 			without waiting for the sensor
+ * @return	1 if a sample was taken
+ *****************************************/
+static uint8_t GestureNextSample(uint32_t *pTimestamp, uint16_t *pDistance, uint8_t *pRangeStatus){
+#ifdef	VL53L1__USING_DMA
+	VL53L1__Sample_t Sample;
+
+	if (!VL53L1__AcqGetSample(&Sample))
+		return 0;
+	*pTimestamp=Sample.Timestamp;
+	*pDistance=Sample.Result.Distance;
+	*pRangeStatus=Sample.Result.Status;
+	return 1;
+#else
+	VL53L1X_Result_t Result;
+	uint8_t dataReady=0;
+
+#ifdef	VL53L1__USING_GPIO
+	dataReady=(HAL_GPIO_ReadPin(TOF_GPIO_GPIO_Port, TOF_GPIO_Pin)==GPIO_PIN_SET);
+#else
+	if (VL53L1X_CheckForDataReady(VL53L1__ADDR, &dataReady))
+		return 0;
+#endif
+	if (!dataReady)
+		return 0;
+	*pTimestamp=HAL_GetTick();
+	VL53L1X_GetResultAndClearInterrupt(VL53L1__ADDR, &Result);	// Status is 255 on I2C error
+	*pDistance=Result.Distance;
+	*pRangeStatus=Result.Status;
+	return 1;
+#endif
+}
+
+
+
+
+/*****************************************
+ * @brief	runs available samples through the
+ * 			state machine, until a gesture is detected.
+ * 			It doesn't wait for new samples
+ * @return	1 if a gesture event was set into *pEvent
+ *****************************************/
+uint8_t VL53L1__GestureGetEvent(VL53L1__Gesture_t *pGesture, VL53L1__GestureEvent_t *pEvent){
+	uint32_t timestamp;
+	uint16_t distance;
+	uint8_t rangeStatus;
+
+	while (GestureNextSample(&timestamp, &distance, &rangeStatus))
+		if (VL53L1__GestureFeed(pGesture, timestamp, distance, rangeStatus, pEvent))
+			return 1;
+	return 0;
+}
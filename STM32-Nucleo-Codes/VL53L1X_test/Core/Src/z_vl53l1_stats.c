@@ -0,0 +1,180 @@
+/*
+ * z_vl53l1_stats.c
+ *
+ *	Windowed statistics of distance readings, integer only
+ *	see z_vl53l1_stats.h
+ *
+ */
+
+#include "main.h"
+#include <string.h>
+
+#if (VL53L1__STATS_WIN > 256) || (VL53L1__STATS_MED_WIN > 15) || !(VL53L1__STATS_MED_WIN & 1)
+#error "check VL53L1__STATS_WIN and VL53L1__STATS_MED_WIN limits"
+#endif
+#if (VL53L1__STATS_WIN * VL53L1__STATS_MAX_DIST * VL53L1__STATS_MAX_DIST) > 0xFFFFFFFF
+#error "sum of squares of VL53L1__STATS_WIN readings up to VL53L1__STATS_MAX_DIST exceeds 32 bits"
+#endif
+
+
+
+
+/*****************************************
+ * @brief	integer square root (bit by bit, up to 16 steps)
+ *****************************************/
+static uint32_t StatsSqrt(uint32_t x){
+	uint32_t bit=(uint32_t)1<<30;
+	uint32_t res=0;
+
+	while (bit>x)
+		bit >>= 2;
+	while (bit) {
+		uint32_t trial=res+bit;
+		uint32_t ge=0U-(uint32_t)(x>=trial);	// all ones if the bit is set, no branch
+		x -= trial & ge;
+		res=(res>>1) | (bit & ge);
+		bit >>= 2;
+	}
+	return res;
+}
+
+
+
+
+/*****************************************
+ * @brief	adds a sample to the median window
+ * 			keeping Sorted in order
+ *****************************************/
+static void StatsMedianAdd(VL53L1__Stats_t *pStats, uint16_t Distance){
+	uint16_t *sorted=pStats->Sorted;
+	uint8_t k;
+
+	if (pStats->MedCnt==VL53L1__STATS_MED_WIN) {
+		// the new sample takes the slot of the oldest one and moves
+		// to its place: only the samples in between are shifted
+		uint16_t old=pStats->MedRing[pStats->MedPos];
+		for (k=0; sorted[k]!=old; k++) {};
+		for (; (k>0) && (sorted[k-1]>Distance); k--)
+			sorted[k]=sorted[k-1];
+		for (; (k<VL53L1__STATS_MED_WIN-1) && (sorted[k+1]<Distance); k++)
+			sorted[k]=sorted[k+1];
+	} else {
+		for (k=pStats->MedCnt; (k>0) && (sorted[k-1]>Distance); k--)
+			sorted[k]=sorted[k-1];
+		pStats->MedCnt++;
+	}
+	sorted[k]=Distance;
+
+	pStats->MedRing[pStats->MedPos]=Distance;
+	if (++pStats->MedPos==VL53L1__STATS_MED_WIN)
+		pStats->MedPos=0;
+}
+
+
+
+
+void VL53L1__StatsReset(VL53L1__Stats_t *pStats){
+	memset(pStats, 0, sizeof(VL53L1__Stats_t));
+}
+
+
+
+
+/*****************************************
+ * @brief 			adds a new distance reading
+ * @param	Distance	mm, clamped to VL53L1__STATS_MAX_DIST
+ * @return			1 if the reading was rejected as outlier
+ * 					(not added to mean/std dev), 0 otherwise
+ *****************************************/
+uint8_t VL53L1__StatsAdd(VL53L1__Stats_t *pStats, uint16_t Distance){
+	uint32_t limit, dev;
+	uint16_t median;
+	uint8_t rejected=0;
+
+	if (Distance>VL53L1__STATS_MAX_DIST)
+		Distance=VL53L1__STATS_MAX_DIST;
+
+	// outlier test against the samples seen so far
+	if ((VL53L1__STATS_OUTLIER_MIN>0) && (pStats->MedCnt==VL53L1__STATS_MED_WIN)) {
+		median=VL53L1__StatsMedian(pStats);
+		dev=(Distance>median) ? (uint32_t)(Distance-median) : (uint32_t)(median-Distance);
+		// the std dev is needed only above the minimum threshold
+		if (dev>VL53L1__STATS_OUTLIER_MIN) {
+			limit=(VL53L1__STATS_OUTLIER_K * VL53L1__StatsStdDevQ4(pStats)) >> 4;
+			if (dev>limit)
+				rejected=1;
+		}
+	}
+	StatsMedianAdd(pStats, Distance);
+
+	if (rejected) {
+		pStats->Rejected++;
+		return 1;
+	}
+
+	// running sums: remove the sample leaving the window, add the new one
+	if (pStats->Cnt==VL53L1__STATS_WIN) {
+		uint16_t old=pStats->Ring[pStats->Pos];
+		pStats->Sum -= old;
+		pStats->SumSq -= (uint32_t)old*old;
+	} else
+		pStats->Cnt++;
+	pStats->Ring[pStats->Pos]=Distance;
+	pStats->Sum += Distance;
+	pStats->SumSq += (uint32_t)Distance*Distance;
+	if (++pStats->Pos==VL53L1__STATS_WIN)
+		pStats->Pos=0;
+	return 0;
+}
+
+
+
+
+/*****************************************
+ * @return	mean of the window, 1/16 mm
+ *****************************************/
+uint32_t VL53L1__StatsMeanQ4(const VL53L1__Stats_t *pStats){
+	if (!pStats->Cnt)
+		return 0;
+	return ((pStats->Sum << 4) + (pStats->Cnt >> 1)) / pStats->Cnt;
+}
+
+
+
+
+/*****************************************
+ * @return	(population) standard deviation of the window, 1/16 mm
+ *****************************************/
+uint32_t VL53L1__StatsStdDevQ4(const VL53L1__Stats_t *pStats){
+	uint32_t n=pStats->Cnt;
+	uint32_t q, r, m, t, u;
+
+	if (n<2)
+		return 0;
+	// Sum = q*n + r, so n*variance = SumSq - Sum^2/n = m - r^2/n
+	// with m = SumSq - q^2*n - 2*q*r, exact and below 2^32 (x <= MAX_DIST)
+	q=pStats->Sum / n;
+	r=pStats->Sum - q*n;
+	m=pStats->SumSq - q*q*n - 2*q*r;
+	// variance = t + (u*n - r^2)/n^2 with m = t*n + u
+	t=m / n;
+	u=m - t*n;
+	if (u*n < r*r) {		// r^2/n borrows from the integer part (t>0 then)
+		t--;
+		u += n;
+	}
+	// variance in 1/256 mm^2, its square root is in 1/16 mm
+	return StatsSqrt((t << 8) + (((u*n - r*r) << 8) / (n*n)));
+}
+
+
+
+
+/*****************************************
+ * @return	median of the last VL53L1__STATS_MED_WIN readings, mm
+ *****************************************/
+uint16_t VL53L1__StatsMedian(const VL53L1__Stats_t *pStats){
+	if (!pStats->MedCnt)
+		return 0;
+	return pStats->Sorted[pStats->MedCnt >> 1];
+}
@@ -12,7 +12,6 @@
  */
 
 #include "main.h"
-#include <math.h>
 
 
 /*
@@ -28,6 +27,7 @@ uint16_t 	SignalRate;							// data read from VL53L1
 uint16_t 	AmbientRate;						// data read from VL53L1
 uint16_t 	SignalPerSpad;						// data read from VL53L1
 uint16_t 	AmbientPerSpad;						// data read from VL53L1
+uint16_t 	SpadNum;							// data read from VL53L1
 uint16_t 	TimingBudget=VL53L1__TIMING_BUDGET;	// TimeBudget requested on (written by) STM32CubeMonitor
 int16_t 	CalibOffset=VL53L1__CALIB_OFFSET;	// CalibrationOffset requested on (written by) STM32CubeMonitor
 uint16_t 	DistanceMode=VL53L1__DISTANCE_MODE;	// DistanceMode requested on (written by) STM32CubeMonitor
@@ -36,6 +36,23 @@ uint32_t 	numerrors=0;						//
 uint32_t 	readCounter=0;						//
 float 		avgDist;
 float		StdDev;
+uint16_t	MedianDist;							// median of last VL53L1__STATS_MED_WIN distances
+uint32_t	Outliers;							// distances left out of avgDist/StdDev as outliers
+uint32_t	InitTime;							// ms spent in VL53L1__Init() (set in main.c)
+uint32_t	ReconfigTime;						// ms spent in the last TimingBudget/DistanceMode change
+
+
+/*
+ **** VL53L1__testArray() ***
+ * the above function feeds the following global variables
+ * for STM32CubeMonitor
+ *
+ */
+#ifdef	VL53L1__USING_ARRAY
+VL53L1__Frame_t	ArrayFrame;						// last scan frame
+uint16_t	ArraySampleRate;					// aggregate samples/s of all sensors, over last second
+uint32_t	ArrayPartialFrames;					// frames closed without a sample of every working sensor
+#endif
 
 
 /*
@@ -46,16 +63,16 @@ float		StdDev;
 uint8_t 	shortClick=0;
 uint8_t 	doubleClick=0;
 uint8_t 	longClick=0;
+uint8_t 	swipe=0;							// 1: toward the sensor, 2: away from the sensor
 int16_t 	longClickVal=(TESTGESTURE_LCLICK_UPPER+TESTGESTURE_LCLICK_LOWER)/2;
 int16_t		lowerlimit_V = TESTGESTURE_LCLICK_LOWER;
 int16_t		upperlimit_V = TESTGESTURE_LCLICK_UPPER;
-//int16_t		lowerlimit_H = GESTURE_MIN_DIST;
-//int16_t		upperlimit_H = GESTURE_MAX_DIST;
-
-uint16_t	currentIM;
-
+int16_t		lowerlimit_H = GESTURE_MIN_DIST;
+int16_t		upperlimit_H = GESTURE_MAX_DIST;
+uint8_t 	GestureState;						// gesture state machine state
 
-uint8_t SStatus;
+static VL53L1__Gesture_t	TestGesture;		// gesture engine shared by testGesture and testMenu
+static uint8_t 				TestGestureInit=0;
 
 
 /*
@@ -65,6 +82,7 @@ uint8_t SStatus;
  *
  */
 
+uint8_t		menuItem=1;						// current menu item (double click moves to next one)
 uint8_t		option1,option2;
 int16_t 	glevel1=150,gll1=100,gul1=200;
 int16_t 	glevel2=500,gll2=0,gul2=1000;
@@ -80,44 +98,61 @@ int16_t 	glevel2=500,gll2=0,gul2=1000;
 void VL53L1__testRanging(){
 	static uint16_t curTB=VL53L1__TIMING_BUDGET;
 	static uint16_t curDM=VL53L1__DISTANCE_MODE;
-	static float DistArray[TESTGESTURE_DIM_ARR];	// storing last DIM_ARR values of "Distance" to compute avg value and std dev.
-	static uint16_t posArr=0;			// position in DistArray to store next "Distance" value
-	static uint16_t	sampleNum=0;
-	float sumArr=0, sumSqArr=0;
+	static VL53L1__Stats_t DistStats;	// last VL53L1__STATS_WIN values of "Distance" to compute avg value and std dev.
 	static uint32_t	ReadingTime=0;
 	uint32_t testingTime=HAL_GetTick();
 	uint8_t status=0;
+	VL53L1X_Result_t Result;
 
 	//before starting rangings update sensor, if user changed ranging parameters through CubeMonitor
 	if (TimingBudget!=curTB) {		// update TimingBudget if changed in repTB (by CubeMonitor)
+		ReconfigTime=HAL_GetTick();
+#ifdef	VL53L1__USING_DMA
+		VL53L1__AcqStop();
+#endif
 		status |= VL53L1X_StopRanging(VL53L1__ADDR);
 		status |= VL53L1X_SetTimingBudgetInMs(VL53L1__ADDR, TimingBudget);
 		status |= VL53L1X_SetInterMeasurementInMs(VL53L1__ADDR, (TimingBudget+VL53L1__TB_IM_DELTA));
 		curTB = TimingBudget;
 		status |= VL53L1X_StartRanging(VL53L1__ADDR);
+#ifdef	VL53L1__USING_DMA
+		VL53L1__AcqStart();
+#endif
+		ReconfigTime=HAL_GetTick()-ReconfigTime;
 		readCounter=0;
 		numerrors=0;
 		ErrorPerc=0;
-		posArr=0;
-		sampleNum=0;
+		VL53L1__StatsReset(&DistStats);
 	}
 
 	if (DistanceMode!=curDM) {		// update Distance Mode if changed by CubeMonitor
+		ReconfigTime=HAL_GetTick();
+#ifdef	VL53L1__USING_DMA
+		VL53L1__AcqStop();
+#endif
 		status |= VL53L1X_StopRanging(VL53L1__ADDR);
 		status |= VL53L1X_SetDistanceMode(VL53L1__ADDR, DistanceMode);
 		curDM = DistanceMode;
 		status |= VL53L1X_StartRanging(VL53L1__ADDR);
+#ifdef	VL53L1__USING_DMA
+		VL53L1__AcqStart();
+#endif
+		ReconfigTime=HAL_GetTick()-ReconfigTime;
 		readCounter=0;
 		numerrors=0;
 		ErrorPerc=0;
-		posArr=0;
-		sampleNum=0;
+		VL53L1__StatsReset(&DistStats);
 	}
 
 // check data availability waiting for the intermeasurement time
 // test can be done in two modes depending if using interrupt or polling mode
 
-#ifdef	VL53L1__USING_GPIO
+#if defined(VL53L1__USING_DMA)
+	// sample already read by DMA on data ready interrupt: don't wait, main loop may sleep
+	VL53L1__Sample_t Sample;
+	(void)testingTime;
+	if (VL53L1__AcqGetSample(&Sample)) {
+#elif defined(VL53L1__USING_GPIO)
 	while ((!HAL_GPIO_ReadPin(TOF_GPIO_GPIO_Port, TOF_GPIO_Pin)) && ((HAL_GetTick()-testingTime)<=VL53L1__INTERMEASUREMENT)) {};
 	if (HAL_GPIO_ReadPin(TOF_GPIO_GPIO_Port, TOF_GPIO_Pin)) {
 #else
@@ -128,30 +163,30 @@ void VL53L1__testRanging(){
 #endif
 		// a new ranging data set is available
 		readCounter++;
+#ifdef	VL53L1__USING_DMA
+		ReadingTime=Sample.Timestamp;
+		Result=Sample.Result;			// already read and interrupt restarted
+#else
 		ReadingTime=HAL_GetTick();
 
-		status |= VL53L1X_GetRangeStatus(VL53L1__ADDR, &RangeStatus);
+		// read all values in a single burst and restart interrupt
+		status |= VL53L1X_GetResultAndClearInterrupt(VL53L1__ADDR, &Result);
+#endif
+		RangeStatus=Result.Status;
 		if (RangeStatus>VL53L1__RANGE_STATUS_THRESH){	//non acceptable range status
 			numerrors++;
-			status |= VL53L1X_ClearInterrupt(VL53L1__ADDR); // reset for a new ranging notification
-		} else {					//here is available a "no error" reading. Proceed getting all values
-			status |= VL53L1X_GetDistance(VL53L1__ADDR, &Distance);
-			status |= VL53L1X_GetSignalRate(VL53L1__ADDR, &SignalRate);
-			status |= VL53L1X_GetAmbientRate(VL53L1__ADDR, &AmbientRate);
-			status |= VL53L1X_ClearInterrupt(VL53L1__ADDR); // Everything read. Restart interrupt
-
-			// Calculate distance average value and standard deviation over last TESTGESTURE_DIM_ARR readings
-			DistArray[posArr]=Distance;		//store Distance into array to compute avg value and std dev.
-			if ((posArr+1) > sampleNum)
-				sampleNum = (posArr+1); 	//that's the number of samples available in DistArray
-			posArr = (posArr+1) % TESTGESTURE_DIM_ARR;
-			for (uint16_t k=0; k<sampleNum; k++){
-				sumArr+=DistArray[k];
-				sumSqArr+=(DistArray[k]*DistArray[k]);
-			}
-			avgDist=sumArr/((float)sampleNum);									// that's average value
-			StdDev=sqrt(sampleNum*sumSqArr - sumArr*sumArr)/((float)sampleNum); // that's the standard deviation
-			// end of "Calculate distance average value and ...
+		} else {					//here is available a "no error" reading. Store all values
+			Distance=Result.Distance;
+			SignalRate=Result.SigPerSPAD;
+			AmbientRate=Result.Ambient;
+			SpadNum=Result.NumSPADs;
+
+			// Update distance average value, standard deviation (over last VL53L1__STATS_WIN readings) and median
+			VL53L1__StatsAdd(&DistStats, Distance);
+			avgDist=VL53L1__StatsMeanQ4(&DistStats)/16.0f;		// that's average value
+			StdDev=VL53L1__StatsStdDevQ4(&DistStats)/16.0f;		// that's the standard deviation
+			MedianDist=VL53L1__StatsMedian(&DistStats);
+			Outliers=DistStats.Rejected;
 		}
 		uint8_t currperc =((numerrors*100)+readCounter-1)/readCounter;
 		ErrorPerc=currperc;
@@ -169,37 +204,84 @@ void VL53L1__testRanging(){
 
 
 
+#ifdef	VL53L1__USING_ARRAY
 /*************************************************************
- * @brief: 	test function performing one  gesture detection,
- * 			saving results on (above) global variables for
+ * @brief: 	collecting scan frames of the sensor array,
+ * 			saving results on global variables for
  * 			STM32CubeMonitor
  ************************************************************/
+void VL53L1__testArray(){
+	static uint32_t rateTime=0;
+	static uint16_t rateCnt=0;
+	VL53L1__Frame_t frame;
+
+	if (VL53L1__ArrayGetFrame(&frame)) {
+		ArrayFrame=frame;
+		if (frame.ValidMask!=VL53L1__ArrayGetActive())
+			ArrayPartialFrames++;
+		for (uint8_t n=0; n<VL53L1__ARRAY_CNT; n++)
+			if (frame.ValidMask & (1U<<n))
+				rateCnt++;
+	}
+	if ((HAL_GetTick()-rateTime)>=1000) {
+		ArraySampleRate=rateCnt;
+		rateCnt=0;
+		rateTime=HAL_GetTick();
+	}
+}
+#endif
+
+
+
+/*************************************************************
+ * @brief: 	gesture detection on available samples (it doesn't
+ * 			wait for the sensor), saving results on global
+ * 			variables for STM32CubeMonitor
+ ************************************************************/
 void VL53L1__testGesture(){
 	static uint32_t clickTime=0;
+	VL53L1__GestureEvent_t Event;
 
-	lowerlimit_V = TESTGESTURE_LCLICK_LOWER;
-	upperlimit_V = TESTGESTURE_LCLICK_UPPER;
-//	int16_t lowerlimit_H = GESTURE_MIN_DIST;
-//	int16_t upperlimit_H = GESTURE_MAX_DIST;
-
-	if (shortClick || doubleClick) {
-		if (clickTime==0)
-			clickTime=HAL_GetTick();
-		if ((HAL_GetTick()-clickTime) > TESTGESTURE_CLICK_DURATION) {
-			clickTime=0;
-			shortClick=0;
-			doubleClick=0;
-		}
+	if (!TestGestureInit) {
+		VL53L1__InitGesture(&TestGesture);
+		VL53L1__GestureSetValue(&TestGesture, longClickVal, TESTGESTURE_LCLICK_LOWER, TESTGESTURE_LCLICK_UPPER);
+		TestGestureInit=1;
 	}
 
-/*	uint16_t locIM;
-	VL53L1X_GetInterMeasurementInMs(VL53L1__ADDR, &locIM);
-	currentIM=locIM;
-*/
-	SStatus=VL53L1__GetDistance(&Distance);
-	if (SStatus<=VL53L1__RANGE_STATUS_THRESH)
-		VL53L1__CheckGesture(Distance, &shortClick, &doubleClick, &longClick, &longClickVal, TESTGESTURE_LCLICK_LOWER, TESTGESTURE_LCLICK_UPPER);
+	while (VL53L1__GestureGetEvent(&TestGesture, &Event)) {
+		switch (Event.Type) {
+		case VL53L1__GESTURE_CLICK:
+			shortClick=1;
+			clickTime=Event.Timestamp;
+			break;
+		case VL53L1__GESTURE_DOUBLECLICK:
+			doubleClick=1;
+			clickTime=Event.Timestamp;
+			break;
+		case VL53L1__GESTURE_SWIPE_NEAR:
+		case VL53L1__GESTURE_SWIPE_FAR:
+			swipe=(Event.Type==VL53L1__GESTURE_SWIPE_NEAR) ? 1 : 2;
+			clickTime=Event.Timestamp;
+			break;
+		case VL53L1__GESTURE_LONG_START:
+			longClick=1;
+			break;
+		case VL53L1__GESTURE_LONG_END:
+			longClick=0;
+			break;
+		default:
+			break;
+		}
+		longClickVal=Event.Value;
+	}
+	GestureState=TestGesture.State;
 
+	// clicks and swipes keep active for TESTGESTURE_CLICK_DURATION (to show them in CubeMonitor)
+	if ((shortClick || doubleClick || swipe) && ((HAL_GetTick()-clickTime) > TESTGESTURE_CLICK_DURATION)) {
+		shortClick=0;
+		doubleClick=0;
+		swipe=0;
+	}
 }
 
 
@@ -207,15 +289,46 @@ void VL53L1__testGesture(){
 
 /*************************************************************
  * @brief: 	test function performing gesture detection,
- * 			and menu handling
+ * 			and menu handling: double click moves to next
+ * 			menu item
  ************************************************************/
 void VL53L1__testMenu(){
-//	static uint32_t clickTime=0;
+	static uint8_t firstCall=1;
+	VL53L1__GestureEvent_t Event;
+	int16_t value, lower, upper;
 
+	if (!TestGestureInit) {
+		VL53L1__InitGesture(&TestGesture);
+		TestGestureInit=1;
+	}
 
-	SStatus=VL53L1__GetDistance(&Distance);
-	if (SStatus<=VL53L1__RANGE_STATUS_THRESH)
-		VL53L1__GestureMenu(SStatus, Distance);
+	do {
+		Event.Type=VL53L1__GESTURE_NONE;
+		if ((!firstCall) && (!VL53L1__GestureGetEvent(&TestGesture, &Event)))
+			break;
+		switch (Event.Type) {
+		case VL53L1__GESTURE_DOUBLECLICK:
+			menuItem=(menuItem % TESTMENU_ITEMS) + 1;
+			firstCall=1;
+			break;
+		case VL53L1__GESTURE_LONG_START:
+			longClick=1;
+			break;
+		case VL53L1__GESTURE_LONG_END:
+			longClick=0;
+			break;
+		default:
+			break;
+		}
+		value=TestGesture.Value;
+		lower=TestGesture.Lower;
+		upper=TestGesture.Upper;
+		VL53L1X__GestureMenu_Items(menuItem, firstCall, (Event.Type==VL53L1__GESTURE_CLICK), (Event.Type==VL53L1__GESTURE_DOUBLECLICK), longClick, &value, &lower, &upper);
+		if (firstCall)
+			VL53L1__GestureSetValue(&TestGesture, value, lower, upper);
+		firstCall=0;
+	} while (1);
+	GestureState=TestGesture.State;
 }
 
 
@@ -0,0 +1,34 @@
+/*
+ * main.h
+ *
+ *	Host build stand-in for Core/Inc/main.h: the modules under test
+ *	only need the integer types, their own headers and the few sensor
+ *	definitions below, not the HAL
+ *
+ */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include "z_vl53l1_stats.h"
+#include "z_vl53l1_gesture.h"
+
+// from vl53l1_platform.h and VL53L1X_api.h
+#define VL53L1__ADDR				0x52
+#define VL53L1__RANGE_STATUS_THRESH	(2)
+
+typedef struct {
+	uint8_t Status;
+	uint16_t Distance;
+	uint16_t Ambient;
+	uint16_t SigPerSPAD;
+	uint16_t NumSPADs;
+} VL53L1X_Result_t;
+
+// sensor access of VL53L1__GestureGetEvent(), the tests feed samples directly
+int8_t		VL53L1X_CheckForDataReady(uint16_t dev, uint8_t *isDataReady);
+int8_t		VL53L1X_GetResultAndClearInterrupt(uint16_t dev, VL53L1X_Result_t *pResult);
+uint32_t	HAL_GetTick(void);
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * main.h
+ *
+ *	Host build stand-in for Core/Inc/main.h used by the register
+ *	level tests: same includes, HAL from stm32f0xx_hal.h of this
+ *	directory, pin labels as set in CubeMX (TOFn_ for the sensor
+ *	array of test_z_vl53l1_array.c)
+ *
+ */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include "stm32f0xx_hal.h"
+
+#include "i2c_queue.h"
+#include "vl53l1_platform.h"
+#include "VL53L1X_api.h"
+#include "z_vl53l1_acq.h"
+#include "z_vl53l1_array.h"
+
+#define TOF_SCL_Pin					GPIO_PIN_8
+#define TOF_SCL_GPIO_Port			GPIOB
+#define TOF_SDA_Pin					GPIO_PIN_9
+#define TOF_SDA_GPIO_Port			GPIOB
+
+#define TOF0_XSHUT_Pin				GPIO_PIN_0
+#define TOF0_XSHUT_GPIO_Port		GPIOB
+#define TOF1_XSHUT_Pin				GPIO_PIN_1
+#define TOF1_XSHUT_GPIO_Port		GPIOB
+#define TOF2_XSHUT_Pin				GPIO_PIN_2
+#define TOF2_XSHUT_GPIO_Port		GPIOB
+#define TOF3_XSHUT_Pin				GPIO_PIN_3
+#define TOF3_XSHUT_GPIO_Port		GPIOB
+#define TOF0_GPIO_Pin				GPIO_PIN_4
+#define TOF0_GPIO_GPIO_Port			GPIOA
+#define TOF1_GPIO_Pin				GPIO_PIN_5
+#define TOF1_GPIO_GPIO_Port			GPIOA
+#define TOF2_GPIO_Pin				GPIO_PIN_6
+#define TOF2_GPIO_GPIO_Port			GPIOA
+#define TOF3_GPIO_Pin				GPIO_PIN_7
+#define TOF3_GPIO_GPIO_Port			GPIOA
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * stm32f0xx_hal.h
+ *
+ *	Host build stand-in for the HAL and CMSIS definitions used by
+ *	vl53l1_platform.c, VL53L1X_api.c, i2c_queue.c and the acquisition
+ *	modules. The functions are implemented by each test: register
+ *	maps of the sensors, and for the acquisition a simulated bus on
+ *	a virtual clock
+ *
+ */
+
+#ifndef __STM32F0xx_HAL_H
+#define __STM32F0xx_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// from stm32f0xx_hal_def.h
+typedef enum {
+	HAL_OK       = 0x00U,
+	HAL_ERROR    = 0x01U,
+	HAL_BUSY     = 0x02U,
+	HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+// from stm32f0xx.h and stm32f0xx_hal_gpio.h (ports are never dereferenced)
+typedef struct {
+	uint32_t dummy;
+} GPIO_TypeDef;
+
+#define GPIOA						((GPIO_TypeDef *)0x48000000UL)
+#define GPIOB						((GPIO_TypeDef *)0x48000400UL)
+#define GPIOC						((GPIO_TypeDef *)0x48000800UL)
+#define GPIOF						((GPIO_TypeDef *)0x48001400UL)
+
+typedef enum {
+	GPIO_PIN_RESET = 0U,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+	uint32_t Pin;
+	uint32_t Mode;
+	uint32_t Pull;
+	uint32_t Speed;
+	uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_PIN_0					((uint16_t)0x0001U)
+#define GPIO_PIN_1					((uint16_t)0x0002U)
+#define GPIO_PIN_2					((uint16_t)0x0004U)
+#define GPIO_PIN_3					((uint16_t)0x0008U)
+#define GPIO_PIN_4					((uint16_t)0x0010U)
+#define GPIO_PIN_5					((uint16_t)0x0020U)
+#define GPIO_PIN_6					((uint16_t)0x0040U)
+#define GPIO_PIN_7					((uint16_t)0x0080U)
+#define GPIO_PIN_8					((uint16_t)0x0100U)
+#define GPIO_PIN_9					((uint16_t)0x0200U)
+#define GPIO_PIN_13					((uint16_t)0x2000U)
+#define GPIO_PIN_14					((uint16_t)0x4000U)
+#define GPIO_PIN_15					((uint16_t)0x8000U)
+
+#define GPIO_MODE_OUTPUT_OD			(0x00000011U)
+#define GPIO_NOPULL					(0x00000000U)
+#define GPIO_SPEED_FREQ_LOW			(0x00000000U)
+
+void			HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+GPIO_PinState	HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void			HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+
+// from stm32f0xx_hal_dma.h and stm32f0xx_hal_i2c.h
+typedef struct {
+	uint32_t dummy;
+} DMA_HandleTypeDef;
+
+typedef struct {
+	DMA_HandleTypeDef	*hdmatx;
+	DMA_HandleTypeDef	*hdmarx;
+	volatile uint32_t	ErrorCode;
+} I2C_HandleTypeDef;
+
+#define I2C_MEMADD_SIZE_8BIT		(0x00000001U)
+#define I2C_MEMADD_SIZE_16BIT		(0x00000002U)
+
+#define HAL_I2C_ERROR_NONE			(0x00000000U)
+#define HAL_I2C_ERROR_BERR			(0x00000001U)
+#define HAL_I2C_ERROR_ARLO			(0x00000002U)
+#define HAL_I2C_ERROR_AF			(0x00000004U)
+#define HAL_I2C_ERROR_OVR			(0x00000008U)
+#define HAL_I2C_ERROR_DMA			(0x00000010U)
+#define HAL_I2C_ERROR_TIMEOUT		(0x00000020U)
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Mem_Read_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Master_Receive_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size);
+uint32_t		HAL_I2C_GetError(I2C_HandleTypeDef *hi2c);
+
+// from stm32f0xx_hal.h
+void		HAL_Delay(uint32_t Delay);
+uint32_t	HAL_GetTick(void);
+
+// from cmsis_gcc.h
+uint32_t	__get_PRIMASK(void);
+void		__set_PRIMASK(uint32_t priMask);
+void		__disable_irq(void);
+void		__enable_irq(void);
+void		__WFI(void);
+
+static inline uint32_t __REV(uint32_t value){
+	return __builtin_bswap32(value);
+}
+
+static inline int16_t __REVSH(int16_t value){
+	return (int16_t)__builtin_bswap16((uint16_t)value);
+}
+
+#endif
@@ -0,0 +1,330 @@
+/*
+ * test_vl53l1_platform.c
+ *
+ *	Host test of the register access and write combining of
+ *	vl53l1_platform.c, on a register map standing in for the sensor
+ *	(stub_hal/main.h, HAL_I2C_Mem_Read/Write below)
+ *
+ * - byte order of the word and double word accesses
+ * - combining rules: contiguous writes of one device collected up to
+ *   VL53L1__WRCOMBINE_SIZE bytes, sent before any read, any other
+ *   device or register, at VL53L1__WrCombineEnd(), I2C errors reported
+ * - register trace: VL53L1__InitDev() and a settings sequence through
+ *   VL53L1X_api.c write and read the same bytes in the same order, and
+ *   leave the same register map, with combining as without it; only
+ *   the number of write transfers differs. VL53L1X_api.c is built with
+ *   its VL53L1__WrCombineBegin/End() calls renamed to the switchable
+ *   testWrCombineBegin/End() (see Makefile)
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+
+#define DEV_B			0x54		// a second sensor on the bus
+#define TRACE_MAX		4096U		// register bytes recorded per run
+
+#define CHECK(cond)		check((cond), #cond, __LINE__)
+
+typedef struct {
+	uint8_t		Dir;				// I2CQ_READ/I2CQ_WRITE
+	uint16_t	Dev;
+	uint16_t	Index;
+	uint8_t		Value;
+} TraceByte_t;
+
+typedef struct {
+	TraceByte_t	Byte[TRACE_MAX];
+	uint32_t	Len;
+	uint32_t	Xfers[2];			// transfers by direction
+	uint8_t		Regs[2][0x10000];	// register maps of VL53L1__ADDR and DEV_B
+} Trace_t;
+
+I2C_HandleTypeDef hi2c1;
+
+static int failures;
+static Trace_t *trace;				// where the bus is recorded
+static Trace_t runs[2];				// register trace without and with combining
+static uint8_t failWrites;			// write transfers to fail
+static uint8_t combining=1;			// testWrCombineBegin/End() call the platform ones
+static uint32_t tick;
+
+
+
+
+static void check(int ok, const char *expr, int line){
+	if (!ok) {
+		failures++;
+		if (failures<20)
+			printf("test_vl53l1_platform.c:%d: check failed: %s\n", line, expr);
+	}
+}
+
+
+
+
+/*****************************************
+ * HAL stand-ins: the sensors are register maps,
+ * auto-incrementing the index within a transfer.
+ * Data is always ready (GPIO__TIO_HV_STATUS follows
+ * the interrupt polarity set in GPIO_HV_MUX__CTRL).
+ *****************************************/
+static uint8_t *devRegs(uint16_t dev){
+	return trace->Regs[(dev==DEV_B) ? 1 : 0];
+}
+
+
+
+static void record(uint8_t dir, uint16_t dev, uint16_t index, uint8_t value){
+	if (trace->Len<TRACE_MAX) {
+		trace->Byte[trace->Len].Dir=dir;
+		trace->Byte[trace->Len].Dev=dev;
+		trace->Byte[trace->Len].Index=index;
+		trace->Byte[trace->Len].Value=value;
+	}
+	trace->Len++;
+}
+
+
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout){
+	uint16_t i;
+
+	(void)Timeout;
+	CHECK(hi2c==&hi2c1);
+	CHECK(MemAddSize==I2C_MEMADD_SIZE_16BIT);
+	CHECK(Size>0);
+	if (failWrites) {
+		failWrites--;
+		return HAL_ERROR;
+	}
+	trace->Xfers[I2CQ_WRITE]++;
+	for (i=0; i<Size; i++) {
+		devRegs(DevAddress)[(uint16_t)(MemAddress+i)]=pData[i];
+		record(I2CQ_WRITE, DevAddress, (uint16_t)(MemAddress+i), pData[i]);
+	}
+	return HAL_OK;
+}
+
+
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout){
+	uint8_t *regs=devRegs(DevAddress);
+	uint16_t i, index;
+
+	(void)Timeout;
+	CHECK(hi2c==&hi2c1);
+	CHECK(MemAddSize==I2C_MEMADD_SIZE_16BIT);
+	trace->Xfers[I2CQ_READ]++;
+	regs[GPIO__TIO_HV_STATUS]=!(regs[GPIO_HV_MUX__CTRL] & 0x10);
+	for (i=0; i<Size; i++) {
+		index=(uint16_t)(MemAddress+i);
+		pData[i]=regs[index];
+		record(I2CQ_READ, DevAddress, index, pData[i]);
+	}
+	return HAL_OK;
+}
+
+
+
+void HAL_Delay(uint32_t Delay){
+	tick+=Delay;
+}
+
+
+
+uint32_t HAL_GetTick(void){
+	return tick++;
+}
+
+
+
+
+/*****************************************
+ * write combining calls of VL53L1X_api.c
+ *****************************************/
+void testWrCombineBegin(){
+	if (combining)
+		VL53L1__WrCombineBegin();
+}
+
+
+
+int8_t testWrCombineEnd(){
+	return combining ? VL53L1__WrCombineEnd() : 0;
+}
+
+
+
+
+static void traceReset(Trace_t *t){
+	memset(t, 0, sizeof(Trace_t));
+	t->Regs[0][VL53L1__MODELID_INDEX]=VL53L1__MODELID_VALUE;
+	t->Regs[0][VL53L1__MODULETYPE_INDEX]=VL53L1__MODULETYPE_VALUE;
+	t->Regs[0][VL53L1__MASKREV_INDEX]=VL53L1__MASKREV_VALUE;
+	trace=t;
+}
+
+
+
+
+static void testByteOrder(void){
+	uint16_t word=0;
+	uint32_t dword=0;
+	uint8_t *regs;
+
+	traceReset(&runs[0]);
+	regs=devRegs(VL53L1__ADDR);
+	CHECK(VL53L1_WrWord(VL53L1__ADDR, 0x0100, 0x1234)==0);
+	CHECK(VL53L1_WrDWord(VL53L1__ADDR, 0x0104, 0x89ABCDEFU)==0);
+	CHECK((regs[0x0100]==0x12) && (regs[0x0101]==0x34));
+	CHECK((regs[0x0104]==0x89) && (regs[0x0105]==0xAB) && (regs[0x0106]==0xCD) && (regs[0x0107]==0xEF));
+	CHECK(VL53L1_RdWord(VL53L1__ADDR, 0x0100, &word)==0);
+	CHECK(VL53L1_RdDWord(VL53L1__ADDR, 0x0104, &dword)==0);
+	CHECK(word==0x1234);
+	CHECK(dword==0x89ABCDEFU);
+
+	// the same through the combining buffer
+	VL53L1__WrCombineBegin();
+	CHECK(VL53L1_WrWord(VL53L1__ADDR, 0x0200, 0xBEEF)==0);
+	CHECK(VL53L1_WrDWord(VL53L1__ADDR, 0x0202, 0x01020304U)==0);
+	CHECK(VL53L1__WrCombineEnd()==0);
+	CHECK((regs[0x0200]==0xBE) && (regs[0x0201]==0xEF));
+	CHECK((regs[0x0202]==0x01) && (regs[0x0205]==0x04));
+	CHECK(trace->Xfers[I2CQ_WRITE]==3);
+}
+
+
+
+
+static void testCombineRules(void){
+	uint8_t data[VL53L1__WRCOMBINE_SIZE+4];
+	uint8_t value=0;
+	uint8_t *regs;
+	uint16_t i;
+
+	traceReset(&runs[0]);
+	regs=devRegs(VL53L1__ADDR);
+
+	// contiguous writes wait for a read, which sees them
+	VL53L1__WrCombineBegin();
+	CHECK(VL53L1_WrByte(VL53L1__ADDR, 0x0010, 0xA1)==0);
+	CHECK(VL53L1_WrWord(VL53L1__ADDR, 0x0011, 0xA2A3)==0);
+	CHECK(VL53L1_WrByte(VL53L1__ADDR, 0x0013, 0xA4)==0);
+	CHECK(trace->Xfers[I2CQ_WRITE]==0);
+	CHECK(regs[0x0010]==0);
+	CHECK(VL53L1_RdByte(VL53L1__ADDR, 0x0012, &value)==0);
+	CHECK(value==0xA3);
+	CHECK(trace->Xfers[I2CQ_WRITE]==1);
+	CHECK((trace->Len==5) && (trace->Byte[3].Index==0x0013) && (trace->Byte[4].Dir==I2CQ_READ));
+
+	// another register, another device
+	CHECK(VL53L1_WrByte(VL53L1__ADDR, 0x0020, 1)==0);
+	CHECK(VL53L1_WrByte(VL53L1__ADDR, 0x0022, 2)==0);
+	CHECK(VL53L1_WrByte(DEV_B, 0x0023, 3)==0);
+	CHECK(VL53L1__WrCombineEnd()==0);
+	CHECK(trace->Xfers[I2CQ_WRITE]==4);
+	CHECK((regs[0x0022]==2) && (regs[0x0023]==0) && (devRegs(DEV_B)[0x0023]==3));
+
+	// full buffer, longer writes sent as they are
+	for (i=0; i<sizeof(data); i++)
+		data[i]=(uint8_t)(0x40+i);
+	VL53L1__WrCombineBegin();
+	for (i=0; i<=VL53L1__WRCOMBINE_SIZE; i++)
+		CHECK(VL53L1_WrByte(VL53L1__ADDR, 0x0040+i, data[i])==0);
+	CHECK(trace->Xfers[I2CQ_WRITE]==5);
+	CHECK(VL53L1_WriteMulti(VL53L1__ADDR, 0x0060, data, sizeof(data))==0);
+	CHECK(trace->Xfers[I2CQ_WRITE]==7);
+	CHECK(VL53L1__WrCombineEnd()==0);
+	CHECK(trace->Xfers[I2CQ_WRITE]==7);
+	CHECK(memcmp(&regs[0x0040], data, VL53L1__WRCOMBINE_SIZE+1)==0);
+	CHECK(memcmp(&regs[0x0060], data, sizeof(data))==0);
+
+	// nested: each End() sends, the outer one ends combining
+	VL53L1__WrCombineBegin();
+	VL53L1__WrCombineBegin();
+	CHECK(VL53L1_WrByte(VL53L1__ADDR, 0x0080, 1)==0);
+	CHECK(VL53L1__WrCombineEnd()==0);
+	CHECK(trace->Xfers[I2CQ_WRITE]==8);
+	CHECK(VL53L1_WrByte(VL53L1__ADDR, 0x0081, 2)==0);
+	CHECK(VL53L1_WrByte(VL53L1__ADDR, 0x0082, 3)==0);
+	CHECK(trace->Xfers[I2CQ_WRITE]==8);
+	CHECK(VL53L1__WrCombineEnd()==0);
+	CHECK(trace->Xfers[I2CQ_WRITE]==9);
+	CHECK(VL53L1_WrByte(VL53L1__ADDR, 0x0083, 4)==0);
+	CHECK(trace->Xfers[I2CQ_WRITE]==10);
+
+	// a failing transfer of collected writes is reported, and dropped
+	VL53L1__WrCombineBegin();
+	CHECK(VL53L1_WrByte(VL53L1__ADDR, 0x0090, 1)==0);
+	failWrites=1;
+	CHECK(VL53L1_RdByte(VL53L1__ADDR, 0x0090, &value)==VL53L1__IO_ERROR);
+	CHECK(VL53L1_WrByte(VL53L1__ADDR, 0x0091, 2)==0);
+	failWrites=1;
+	CHECK(VL53L1__WrCombineEnd()==VL53L1__IO_ERROR);
+	CHECK(VL53L1__WrCombineEnd()==0);
+	CHECK((regs[0x0090]==0) && (regs[0x0091]==0));
+	CHECK(trace->Xfers[I2CQ_WRITE]==10);
+}
+
+
+
+
+/*****************************************
+ * sensor setup as done by the application
+ *****************************************/
+static void sequence(void){
+	VL53L1X_Result_t Result;
+	uint16_t Distance=0;
+
+	CHECK(VL53L1__InitDev(VL53L1__ADDR)==0);
+	CHECK(VL53L1X_SetROI(VL53L1__ADDR, 8, 8)==0);
+	CHECK(VL53L1__SetDistanceMode(1)==0);
+	CHECK(VL53L1__SetTimingBudget(50, 55)==0);
+	CHECK(VL53L1X_SetOffset(VL53L1__ADDR, 12)==0);
+	CHECK(VL53L1X_SetXtalk(VL53L1__ADDR, 300)==0);
+	CHECK(VL53L1X_SetDistanceThreshold(VL53L1__ADDR, 100, 300, 3, 1)==0);
+	CHECK(VL53L1X_StartRanging(VL53L1__ADDR)==0);
+	CHECK(VL53L1X_GetResultAndClearInterrupt(VL53L1__ADDR, &Result)==0);
+	VL53L1__GetDistance(&Distance);
+	CHECK(VL53L1X_StopRanging(VL53L1__ADDR)==0);
+}
+
+
+
+static void testRegisterTrace(void){
+	uint32_t i, diff=0;
+
+	combining=0;
+	traceReset(&runs[0]);
+	sequence();
+	combining=1;
+	traceReset(&runs[1]);
+	sequence();
+
+	CHECK(runs[0].Len<=TRACE_MAX);
+	CHECK(runs[0].Len==runs[1].Len);
+	for (i=0; (i<runs[0].Len) && (i<runs[1].Len) && (i<TRACE_MAX); i++)
+		diff+=(memcmp(&runs[0].Byte[i], &runs[1].Byte[i], sizeof(TraceByte_t))!=0);
+	CHECK(diff==0);
+	CHECK(memcmp(runs[0].Regs, runs[1].Regs, sizeof(runs[0].Regs))==0);
+	CHECK(runs[0].Xfers[I2CQ_READ]==runs[1].Xfers[I2CQ_READ]);
+	CHECK(runs[1].Xfers[I2CQ_WRITE]<runs[0].Xfers[I2CQ_WRITE]);
+
+	printf("register trace  %u bytes, %u reads, %u write transfers (%u without combining)\n",
+			(unsigned)runs[1].Len, (unsigned)runs[1].Xfers[I2CQ_READ],
+			(unsigned)runs[1].Xfers[I2CQ_WRITE], (unsigned)runs[0].Xfers[I2CQ_WRITE]);
+}
+
+
+
+
+int main(void){
+	testByteOrder();
+	testCombineRules();
+	testRegisterTrace();
+
+	printf("test_vl53l1_platform: %s\n", (failures == 0) ? "OK" : "FAILED");
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,634 @@
+/*
+ * test_z_vl53l1_array.c
+ *
+ *	Host test of the sensor array (z_vl53l1_array.c) on a simulated
+ *	I2C bus: the whole DMA acquisition path (z_vl53l1_acq.c,
+ *	i2c_queue.c, vl53l1_platform.c, VL53L1X_api.c) runs unchanged
+ *	against sensor models, on a virtual clock (ns)
+ *
+ * simulation:
+ * - bus: a transfer lasts its bits (9 per byte, start/stop, repeated
+ *   start of reads) at the bus clock, then completes by interrupt
+ *   through the i2c_queue callbacks; no booted sensor at the address
+ *   gives a NACK
+ * - sensors: XSHUT, boot time, I2C address, ranging every
+ *   intermeasurement period as programmed in the registers, data ready
+ *   pin held until the interrupt clear. A measurement ending before
+ *   the previous one was read is lost
+ * - interrupts run when due with PRIMASK clear, __WFI() sleeps to the
+ *   next one, main loop time passes at each HAL_GetTick() call
+ *
+ * checks:
+ * - bring-up: unique addresses, never two sensors answering together,
+ *   a sensor which doesn't boot left out and held in reset
+ * - frames: every sample in the slot of its sensor, all frames complete
+ * - aggregate samples/s, as VL53L1__testArray() reports them, at bus
+ *   clocks and intermeasurement periods: sensors x 1000 / IM while the
+ *   bus keeps up, the bus capacity once saturated, no I2C errors
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+
+#define SIM_SENSORS		VL53L1__ARRAY_CNT
+#define CPU_STEP_NS		1000U			// main loop time per HAL_GetTick() call
+#define BOOT_NS			1200000U		// XSHUT release to firmware booted
+#define RATE_WARMUP_MS	1000U
+#define RATE_MS			4000U			// samples/s measurement window
+#define NO_EVENT		UINT64_MAX
+
+#define CHECK(cond)		check((cond), #cond, __LINE__)
+
+typedef struct {
+	uint8_t		Xshut;
+	uint8_t		Dead;					// never boots
+	uint16_t	Addr;					// 8 bit format as VL53L1__ADDR
+	uint64_t	BootAt;
+	uint8_t		Ranging;
+	uint64_t	NextEnd;				// end of the running measurement
+	uint8_t		IntLevel;				// data ready pin
+	uint32_t	Measures;
+	uint32_t	Lost;					// ended with the previous one not read
+	uint8_t		Regs[0x10000];
+} SimSensor_t;
+
+typedef struct {
+	uint8_t		Busy;
+	uint64_t	DoneAt;
+	uint16_t	Dev;
+	uint16_t	Reg;
+	uint8_t		Dir;
+	uint8_t		*Data;
+	uint16_t	Len;
+	uint8_t		Stuck;					// transfers never end (slave holding SCL)
+	uint64_t	BusyNs;					// time with a transfer on the bus
+	uint32_t	Collisions;				// transfers answered by more sensors
+} SimBus_t;
+
+typedef struct {
+	uint32_t	Samples;
+	uint32_t	Frames;
+	uint32_t	Partial;				// frames without a sample of every working sensor
+} FrameCount_t;
+
+I2C_HandleTypeDef hi2c1;
+
+static DMA_HandleTypeDef hdma_i2c1_rx;
+static const uint16_t xshutPins[SIM_SENSORS]={ TOF0_XSHUT_Pin, TOF1_XSHUT_Pin, TOF2_XSHUT_Pin, TOF3_XSHUT_Pin };
+static const uint16_t intPins[SIM_SENSORS]={ TOF0_GPIO_Pin, TOF1_GPIO_Pin, TOF2_GPIO_Pin, TOF3_GPIO_Pin };
+
+static int failures;
+static uint64_t simNs;
+static uint8_t primask;
+static uint8_t inIrq;
+static uint32_t busKHz;
+static SimBus_t bus;
+static SimSensor_t sensors[SIM_SENSORS];
+
+
+
+
+static void check(int ok, const char *expr, int line){
+	if (!ok) {
+		failures++;
+		if (failures<20)
+			printf("test_z_vl53l1_array.c:%d: check failed: %s\n", line, expr);
+	}
+}
+
+
+
+
+/*****************************************
+ * sensor model
+ *****************************************/
+static void sensorReset(SimSensor_t *s){
+	memset(s->Regs, 0, sizeof(s->Regs));
+	s->Regs[VL53L1__MODELID_INDEX]=VL53L1__MODELID_VALUE;
+	s->Regs[VL53L1__MODULETYPE_INDEX]=VL53L1__MODULETYPE_VALUE;
+	s->Regs[VL53L1__MASKREV_INDEX]=VL53L1__MASKREV_VALUE;
+	s->Regs[VL53L1_RESULT__OSC_CALIBRATE_VAL]=0x03;			// PLL period 1000
+	s->Regs[VL53L1_RESULT__OSC_CALIBRATE_VAL+1]=0xE8;
+	s->Addr=VL53L1__ADDR;
+	s->Ranging=0;
+	s->IntLevel=0;
+}
+
+
+
+// intermeasurement period as written by VL53L1X_SetInterMeasurementInMs()
+static uint64_t sensorPeriodNs(const SimSensor_t *s){
+	const uint8_t *r=&s->Regs[VL53L1_SYSTEM__INTERMEASUREMENT_PERIOD];
+	uint64_t val=((uint32_t)r[0]<<24) | ((uint32_t)r[1]<<16) | ((uint32_t)r[2]<<8) | r[3];
+	uint64_t osc=((s->Regs[VL53L1_RESULT__OSC_CALIBRATE_VAL]<<8) | s->Regs[VL53L1_RESULT__OSC_CALIBRATE_VAL+1]) & 0x3FF;
+	uint64_t ns=(val*1000000000ULL)/(osc*1075U);
+
+	return (ns<1000000U) ? 1000000U : ns;
+}
+
+
+
+static uint8_t sensorAnswers(const SimSensor_t *s, uint16_t dev){
+	return s->Xshut && (!s->Dead) && (simNs>=s->BootAt) && (s->Addr==dev);
+}
+
+
+
+static void sensorAccess(SimSensor_t *s, uint16_t reg, uint8_t dir, uint8_t *data, uint16_t len){
+	uint8_t intPol=!(s->Regs[GPIO_HV_MUX__CTRL] & 0x10);
+	uint16_t i, index;
+
+	s->Regs[GPIO__TIO_HV_STATUS]=s->IntLevel ? intPol : !intPol;
+	s->Regs[VL53L1_FIRMWARE__SYSTEM_STATUS]=1;
+	for (i=0; i<len; i++) {
+		index=(uint16_t)(reg+i);
+		if (dir==I2CQ_READ) {
+			data[i]=s->Regs[index];
+			continue;
+		}
+		s->Regs[index]=data[i];
+		if (index==VL53L1_I2C_SLAVE__DEVICE_ADDRESS)
+			s->Addr=(data[i] & 0x7F)<<1;
+		else if ((index==SYSTEM__INTERRUPT_CLEAR) && (data[i] & 0x01))
+			s->IntLevel=0;
+		else if ((index==SYSTEM__MODE_START) && (data[i]==0x40)) {
+			s->Ranging=1;
+			s->NextEnd=simNs+sensorPeriodNs(s);
+		} else if (index==SYSTEM__MODE_START)
+			s->Ranging=0;
+	}
+}
+
+
+
+// end of a measurement of sensor n: result block, data ready edge
+static void sensorMeasure(uint8_t n){
+	SimSensor_t *s=&sensors[n];
+	uint8_t *block=&s->Regs[VL53L1_RESULT__RANGE_STATUS];
+	uint16_t distance;
+
+	s->Measures++;
+	s->NextEnd+=sensorPeriodNs(s);
+	if (s->IntLevel) {
+		s->Lost++;
+		return;
+	}
+	distance=(uint16_t)(100*(n+1) + (s->Measures & 0x3F));	// sensor n reads (n+1)xx mm
+	block[0]=9;													// range valid
+	block[3]=40;												// SPADs
+	block[13]=(uint8_t)(distance>>8);
+	block[14]=(uint8_t)distance;
+	s->IntLevel=1;
+	VL53L1__AcqEXTI_Callback(intPins[n]);
+}
+
+
+
+
+/*****************************************
+ * bus model
+ *****************************************/
+static uint32_t busBits(uint8_t dir, uint16_t len){
+	return 9U*(3U+len) + ((dir==I2CQ_READ) ? 9U : 0U) + 2U;
+}
+
+
+
+static HAL_StatusTypeDef busStart(I2C_HandleTypeDef *hi2c, uint16_t dev, uint16_t reg, uint16_t regSize, uint8_t dir, uint8_t *data, uint16_t len){
+	uint64_t ns=(uint64_t)busBits(dir, len)*1000000U/busKHz;
+
+	CHECK(hi2c==&hi2c1);
+	CHECK(regSize==I2C_MEMADD_SIZE_16BIT);
+	if (bus.Busy)
+		return HAL_BUSY;
+	bus.Busy=1;
+	bus.DoneAt=bus.Stuck ? NO_EVENT : simNs+ns;
+	bus.BusyNs+=ns;
+	bus.Dev=dev;
+	bus.Reg=reg;
+	bus.Dir=dir;
+	bus.Data=data;
+	bus.Len=len;
+	return HAL_OK;
+}
+
+
+
+static void busDone(void){
+	SimSensor_t *target=NULL;
+	uint8_t n, answers=0;
+
+	bus.Busy=0;
+	for (n=0; n<SIM_SENSORS; n++) {
+		if (sensorAnswers(&sensors[n], bus.Dev)) {
+			target=&sensors[n];
+			answers++;
+		}
+	}
+	if (answers>1)
+		bus.Collisions++;
+	if (target==NULL) {
+		hi2c1.ErrorCode=HAL_I2C_ERROR_AF;
+		i2cq_error_callback(VL53L1__GetI2cQueue(), &hi2c1);
+		return;
+	}
+	sensorAccess(target, bus.Reg, bus.Dir, bus.Data, bus.Len);
+	hi2c1.ErrorCode=HAL_I2C_ERROR_NONE;
+	i2cq_cplt_callback(VL53L1__GetI2cQueue(), &hi2c1);
+}
+
+
+
+
+/*****************************************
+ * virtual clock and interrupts
+ *****************************************/
+static uint64_t simNextEvent(void){
+	uint64_t t=bus.Busy ? bus.DoneAt : NO_EVENT;
+	uint8_t n;
+
+	for (n=0; n<SIM_SENSORS; n++)
+		if (sensors[n].Ranging && (sensors[n].NextEnd<t))
+			t=sensors[n].NextEnd;
+	return t;
+}
+
+
+
+// runs the interrupts due, if not masked
+static void simDispatch(void){
+	uint64_t t;
+	uint8_t n;
+
+	if (primask || inIrq)
+		return;
+	inIrq=1;
+	while ((t=simNextEvent())<=simNs) {
+		if (bus.Busy && (bus.DoneAt==t)) {
+			busDone();
+			continue;
+		}
+		for (n=0; n<SIM_SENSORS; n++) {
+			if (sensors[n].Ranging && (sensors[n].NextEnd==t)) {
+				sensorMeasure(n);
+				break;
+			}
+		}
+	}
+	inIrq=0;
+}
+
+
+
+static void simRun(uint64_t until){
+	uint64_t t;
+
+	while ((!primask) && (!inIrq) && ((t=simNextEvent())<=until)) {
+		if (t>simNs)
+			simNs=t;
+		simDispatch();
+	}
+	if (simNs<until)
+		simNs=until;
+}
+
+
+
+
+/*****************************************
+ * HAL and CMSIS stand-ins
+ *****************************************/
+void HAL_Delay(uint32_t Delay){
+	simRun(simNs+(uint64_t)Delay*1000000U);
+}
+
+uint32_t HAL_GetTick(void){
+	simNs+=CPU_STEP_NS;
+	simDispatch();
+	return (uint32_t)(simNs/1000000U);
+}
+
+uint32_t __get_PRIMASK(void){
+	return primask;
+}
+
+void __set_PRIMASK(uint32_t priMask){
+	primask=priMask & 1U;
+	simDispatch();
+}
+
+void __disable_irq(void){
+	primask=1;
+}
+
+void __enable_irq(void){
+	primask=0;
+	simDispatch();
+}
+
+void __WFI(void){
+	uint64_t t=simNextEvent();
+
+	if (t==NO_EVENT)
+		simNs+=1000000U;
+	else if (t>simNs)
+		simNs=t;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init){
+	(void)GPIOx;
+	(void)GPIO_Init;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin){
+	uint8_t n;
+
+	for (n=0; n<SIM_SENSORS; n++)
+		if ((GPIOx==TOF0_GPIO_GPIO_Port) && (GPIO_Pin==intPins[n]))
+			return sensors[n].IntLevel ? GPIO_PIN_SET : GPIO_PIN_RESET;
+	return GPIO_PIN_SET;				// SDA released
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState){
+	SimSensor_t *s;
+	uint8_t n;
+
+	for (n=0; n<SIM_SENSORS; n++) {
+		if ((GPIOx!=TOF0_XSHUT_GPIO_Port) || (GPIO_Pin!=xshutPins[n]))
+			continue;
+		s=&sensors[n];
+		if (PinState && (!s->Xshut))
+			s->BootAt=simNs+BOOT_NS;
+		else if ((!PinState) && s->Xshut)
+			sensorReset(s);
+		s->Xshut=(PinState!=GPIO_PIN_RESET);
+	}
+}
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c){
+	(void)hi2c;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c){
+	(void)hi2c;
+	bus.Busy=0;							// peripheral reset aborts the transfer
+	return HAL_OK;
+}
+
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef *hi2c){
+	return hi2c->ErrorCode;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size){
+	return busStart(hi2c, DevAddress, MemAddress, MemAddSize, I2CQ_WRITE, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size){
+	return busStart(hi2c, DevAddress, MemAddress, MemAddSize, I2CQ_READ, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size){
+	return busStart(hi2c, DevAddress, MemAddress, MemAddSize, I2CQ_WRITE, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size){
+	return busStart(hi2c, DevAddress, MemAddress, MemAddSize, I2CQ_READ, pData, Size);
+}
+
+// plain transfers are not used by the sensors
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size){
+	(void)hi2c; (void)DevAddress; (void)pData; (void)Size;
+	CHECK(0);
+	return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size){
+	(void)hi2c; (void)DevAddress; (void)pData; (void)Size;
+	CHECK(0);
+	return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size){
+	(void)hi2c; (void)DevAddress; (void)pData; (void)Size;
+	CHECK(0);
+	return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size){
+	(void)hi2c; (void)DevAddress; (void)pData; (void)Size;
+	CHECK(0);
+	return HAL_ERROR;
+}
+
+
+
+
+/*****************************************
+ * test helpers
+ *****************************************/
+// powers the array down, deadMask: sensors which won't boot
+static void simReset(uint32_t kHz, uint8_t deadMask){
+	uint8_t n;
+
+	VL53L1__AcqStop();
+	busKHz=kHz;
+	bus.Stuck=0;
+	bus.BusyNs=0;
+	bus.Collisions=0;
+	for (n=0; n<SIM_SENSORS; n++) {
+		sensorReset(&sensors[n]);
+		sensors[n].Xshut=0;
+		sensors[n].Dead=(deadMask>>n) & 1;
+		sensors[n].Measures=0;
+		sensors[n].Lost=0;
+	}
+}
+
+
+
+// main loop as VL53L1__testArray(), for ms: frames read, sleep in between
+static void mainLoop(uint32_t ms, FrameCount_t *cnt){
+	uint64_t end=simNs+(uint64_t)ms*1000000U;
+	VL53L1__Frame_t frame;
+	uint8_t n;
+
+	memset(cnt, 0, sizeof(FrameCount_t));
+	while (simNs<end) {
+		if (!VL53L1__ArrayGetFrame(&frame)) {
+			VL53L1__AcqSleep();
+			continue;
+		}
+		cnt->Frames++;
+		if (frame.ValidMask!=VL53L1__ArrayGetActive())
+			cnt->Partial++;
+		CHECK((frame.ValidMask & ~VL53L1__ArrayGetActive())==0);
+		for (n=0; n<SIM_SENSORS; n++) {
+			if (!(frame.ValidMask & (1U<<n)))
+				continue;
+			cnt->Samples++;
+			CHECK(frame.Sample[n].Sensor==n);
+			CHECK(frame.Sample[n].Result.Distance/100==n+1);
+			CHECK(frame.Sample[n].Result.Status==0);
+		}
+	}
+}
+
+
+
+static uint32_t lostSamples(void){
+	uint32_t lost=0;
+	uint8_t n;
+
+	for (n=0; n<SIM_SENSORS; n++)
+		lost+=sensors[n].Lost;
+	return lost;
+}
+
+
+
+
+static void testBringUp(void){
+	const uint8_t all=(1U<<SIM_SENSORS)-1;
+	FrameCount_t cnt;
+	uint64_t start;
+	uint8_t n;
+
+	simReset(400, 0);
+	start=simNs;
+	CHECK(VL53L1__ArrayInit()==0);
+	CHECK(VL53L1__ArrayGetActive()==all);
+	for (n=0; n<SIM_SENSORS; n++) {
+		CHECK(sensors[n].Xshut);
+		CHECK(sensors[n].Addr==VL53L1__ARRAY_FIRST_ADDR+2*n);
+	}
+	CHECK(bus.Collisions==0);
+	printf("bring-up        %u sensors in %u ms\n", (unsigned)SIM_SENSORS, (unsigned)((simNs-start)/1000000U));
+
+	// sensor 2 doesn't boot: left out, held in reset, the others framed
+	simReset(400, 0x04);
+	CHECK(VL53L1__ArrayInit()==0x04);
+	CHECK(VL53L1__ArrayGetActive()==(all & ~0x04));
+	CHECK(!sensors[2].Xshut);
+	CHECK(sensors[3].Addr==VL53L1__ARRAY_FIRST_ADDR+6);
+	CHECK(VL53L1__ArrayStart()==0);
+	mainLoop(RATE_WARMUP_MS, &cnt);
+	CHECK(cnt.Frames>=(RATE_WARMUP_MS/VL53L1__INTERMEASUREMENT)-2);
+	CHECK(cnt.Partial==0);
+	CHECK(bus.Collisions==0);
+	printf("dead sensor     left out, %u frames of %u sensors\n", (unsigned)cnt.Frames, (unsigned)(SIM_SENSORS-1));
+}
+
+
+
+
+// stop with an acquisition transfer stuck on the bus, then restart
+static void testStopStuck(void){
+	const VL53L1__AcqStats_t *stats=VL53L1__AcqGetStats();
+	i2cq_t *q=VL53L1__GetI2cQueue();
+	uint32_t errors, recoveries;
+	VL53L1__Frame_t frame;
+	FrameCount_t cnt;
+	uint64_t end;
+
+	simReset(400, 0);
+	CHECK(VL53L1__ArrayInit()==0);
+	CHECK(VL53L1__ArrayStart()==0);
+	mainLoop(RATE_WARMUP_MS, &cnt);
+
+	bus.Stuck=1;
+	end=simNs+(uint64_t)VL53L1__INTERMEASUREMENT*2000000U;
+	while (((!bus.Busy) || (bus.DoneAt!=NO_EVENT)) && (simNs<end)) {
+		if (!VL53L1__ArrayGetFrame(&frame))
+			VL53L1__AcqSleep();
+	}
+	CHECK(bus.Busy && (bus.DoneAt==NO_EVENT));
+	errors=stats->I2cErrors;
+	recoveries=q->recoveries;
+
+	// the stop outlasts the queue timeout: nothing left queued
+	VL53L1__AcqStop();
+	CHECK(q->head==q->tail);
+	CHECK(q->recoveries==recoveries+1);
+	CHECK(!bus.Busy);
+
+	bus.Stuck=0;
+	CHECK(VL53L1__ArrayStart()==0);
+	mainLoop(RATE_WARMUP_MS, &cnt);
+	CHECK(cnt.Frames>=(RATE_WARMUP_MS/VL53L1__INTERMEASUREMENT)-2);
+	CHECK(cnt.Partial==0);
+	CHECK(stats->I2cErrors==errors+1);		// the aborted transfer only
+	CHECK((uint8_t)(q->head-q->tail)<=1);
+	printf("stuck stop      queue drained, %u frames after restart\n", (unsigned)cnt.Frames);
+}
+
+
+
+
+// aggregate samples/s with every sensor at imMs on a kHz bus
+static void testRate(uint32_t kHz, uint16_t imMs){
+	const VL53L1__AcqStats_t *stats=VL53L1__AcqGetStats();
+	uint32_t demand=SIM_SENSORS*1000U/imMs;
+	uint32_t capacity=kHz*1000U/(busBits(I2CQ_READ, VL53L1X_RESULT_BLOCK_SIZE)+busBits(I2CQ_WRITE, 1));
+	uint32_t errors, overruns, lost, rate, load;
+	uint64_t busy;
+	FrameCount_t cnt;
+	uint8_t n;
+
+	simReset(kHz, 0);
+	CHECK(VL53L1__ArrayInit()==0);
+	for (n=0; n<SIM_SENSORS; n++)
+		CHECK(VL53L1X_SetInterMeasurementInMs(VL53L1__ARRAY_FIRST_ADDR+2*n, imMs)==0);
+	CHECK(VL53L1__ArrayStart()==0);
+	mainLoop(RATE_WARMUP_MS, &cnt);
+
+	errors=stats->I2cErrors;
+	overruns=stats->Overruns;
+	lost=lostSamples();
+	busy=bus.BusyNs;
+	mainLoop(RATE_MS, &cnt);
+	rate=cnt.Samples*1000U/RATE_MS;
+	load=(uint32_t)((bus.BusyNs-busy)*100U/((uint64_t)RATE_MS*1000000U));
+	errors=stats->I2cErrors-errors;
+	overruns=stats->Overruns-overruns;
+	lost=lostSamples()-lost;
+
+	CHECK(errors==0);
+	CHECK(overruns==0);
+	CHECK(bus.Collisions==0);
+	if (demand*10U<capacity*8U) {
+		// the bus keeps up: every measurement read
+		CHECK(rate*100U>=demand*99U);
+		CHECK(rate*100U<=demand*101U);
+		CHECK(lost==0);
+		CHECK(cnt.Partial==0);
+	} else {
+		// saturated: the bus capacity, measurements lost at the sensors
+		CHECK(rate*100U>=capacity*90U);
+		CHECK(rate<=capacity);
+		CHECK(lost>0);
+	}
+	printf("%3u kHz IM %3u  %4u samples/s of %4u (bus capacity %4u, load %2u%%), %u lost, %u partial frames\n",
+			(unsigned)kHz, (unsigned)imMs, (unsigned)rate, (unsigned)demand, (unsigned)capacity,
+			(unsigned)load, (unsigned)lost, (unsigned)cnt.Partial);
+}
+
+
+
+
+int main(void){
+	hi2c1.hdmarx=&hdma_i2c1_rx;			// RX by DMA, interrupt clear in interrupt mode (see z_vl53l1_acq.h)
+
+	testBringUp();
+	testStopStuck();
+	testRate(400, VL53L1__INTERMEASUREMENT);
+	testRate(400, 10);
+	testRate(400, 5);
+	testRate(100, VL53L1__INTERMEASUREMENT);
+	testRate(100, 5);
+
+	printf("test_z_vl53l1_array: %s\n", (failures == 0) ? "OK" : "FAILED");
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,356 @@
+/*
+ * test_z_vl53l1_gesture.c
+ *
+ *	Host test of the gesture state machine (z_vl53l1_gesture.c):
+ *	recorded-style traces of (timestamp, distance, range status) samples
+ *	are replayed through VL53L1__GestureFeed() and the events compared
+ *
+ * - each gesture on a clean trace
+ * - the same traces with dropouts during the presses (no echo, failed
+ *   range status, a reading out of the zone) shorter than
+ *   GESTURE_RELEASE_TIME: same events
+ * - releases just above GESTURE_RELEASE_TIME, double click gap counted
+ *   from the first absent sample
+ * - random gesture sequences with random short dropouts: same events as
+ *   without the dropouts
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+
+#define SAMPLE_MS		25			// VL53L1__INTERMEASUREMENT of the default configuration
+#define EVENTS_MAX		1024
+#define RANDOM_RUNS		2000
+
+#define ABSENT			0			// no echo: distance 0
+#define BAD_STATUS		255			// failed reading (status 255 on I2C error)
+
+#define CHECK(cond)		check((cond), #cond, __LINE__)
+
+// a trace segment: ms long, hand moving from Dist to DistEnd (0: same),
+// readings with Status
+typedef struct {
+	uint16_t	Ms;
+	uint16_t	Dist;
+	uint16_t	DistEnd;
+	uint8_t 	Status;
+} TraceSeg_t;
+
+static VL53L1__Gesture_t gesture;
+static VL53L1__GestureEvent_t events[EVENTS_MAX];
+static uint32_t eventCnt;
+static uint32_t clockMs;
+static int failures;
+static uint32_t randState=2463534242U;
+
+
+
+
+// sensor access of VL53L1__GestureGetEvent(): no sample available
+int8_t VL53L1X_CheckForDataReady(uint16_t dev, uint8_t *isDataReady){
+	(void)dev;
+	*isDataReady=0;
+	return 0;
+}
+
+int8_t VL53L1X_GetResultAndClearInterrupt(uint16_t dev, VL53L1X_Result_t *pResult){
+	(void)dev;
+	memset(pResult, 0, sizeof(VL53L1X_Result_t));
+	return 0;
+}
+
+uint32_t HAL_GetTick(void){
+	return clockMs;
+}
+
+
+
+
+static void check(int ok, const char *expr, int line){
+	if (!ok) {
+		failures++;
+		printf("test_z_vl53l1_gesture.c:%d: check failed: %s\n", line, expr);
+	}
+}
+
+
+
+
+static uint32_t testRand(void){
+	randState ^= randState << 13;
+	randState ^= randState >> 17;
+	randState ^= randState << 5;
+	return randState;
+}
+
+
+
+
+static void replayReset(void){
+	VL53L1__InitGesture(&gesture);
+	eventCnt=0;
+	clockMs=1000;
+}
+
+
+
+
+static void replaySample(uint16_t Distance, uint8_t Status){
+	VL53L1__GestureEvent_t event;
+
+	clockMs += SAMPLE_MS;
+	if (VL53L1__GestureFeed(&gesture, clockMs, Distance, Status, &event) && (eventCnt<EVENTS_MAX))
+		events[eventCnt++]=event;
+}
+
+
+
+
+/*****************************************
+ * @brief	replays a trace, one sample every SAMPLE_MS
+ * @param	dropEvery	0: clean trace, otherwise every dropEvery-th
+ * 						sample of a present segment is a dropout of
+ * 						dropLen samples (kind rotating: no echo, bad
+ * 						status, out of the zone)
+ *****************************************/
+static void replay(const TraceSeg_t *pTrace, uint16_t segCnt, uint16_t dropEvery, uint16_t dropLen){
+	uint16_t s, k, n, dist, drop=0, kind=0;
+
+	for (s=0; s<segCnt; s++) {
+		n=pTrace[s].Ms/SAMPLE_MS;
+		for (k=0; k<n; k++) {
+			dist=pTrace[s].Dist;
+			if (pTrace[s].DistEnd)
+				dist=pTrace[s].Dist + ((int32_t)pTrace[s].DistEnd-pTrace[s].Dist)*k/n;
+			if (dropEvery && pTrace[s].Dist && (k>0) && (k+dropLen<n) && ((k % dropEvery)==0))
+				drop=dropLen;
+			if (drop) {
+				drop--;
+				kind=(kind+1) % 3;
+				if (kind==0)
+					replaySample(ABSENT, 0);
+				else if (kind==1)
+					replaySample(dist, BAD_STATUS);
+				else
+					replaySample(GESTURE_MAX_DIST+200, 0);
+			} else
+				replaySample(dist, 0);
+		}
+	}
+}
+
+
+
+
+static uint32_t countEvents(VL53L1__GestureType_t Type){
+	uint32_t i, n=0;
+
+	for (i=0; i<eventCnt; i++)
+		if (events[i].Type==Type)
+			n++;
+	return n;
+}
+
+
+
+
+// drops the LONG_VALUE events, which follow the hand distance
+static void filterLongValue(VL53L1__GestureEvent_t *pEvents, uint32_t *pCnt){
+	uint32_t i, n=0;
+
+	for (i=0; i<*pCnt; i++)
+		if (pEvents[i].Type!=VL53L1__GESTURE_LONG_VALUE)
+			pEvents[n++]=pEvents[i];
+	*pCnt=n;
+}
+
+
+
+
+/*****************************************
+ * @brief	replays a trace clean and with dropouts of 1 and 2 samples
+ * 			(shorter than GESTURE_RELEASE_TIME): the events must be
+ * 			the expected ones each time
+ *****************************************/
+static void expectEvents(const char *name, const TraceSeg_t *pTrace, uint16_t segCnt, const VL53L1__GestureType_t *pExpected, uint32_t expectedCnt){
+	static const uint16_t drops[][2]={ {0,0}, {4,1}, {3,1}, {5,2} };
+	uint32_t d, i;
+	int before=failures;
+
+	for (d=0; d<sizeof(drops)/sizeof(drops[0]); d++) {
+		replayReset();
+		replay(pTrace, segCnt, drops[d][0], drops[d][1]);
+		// events other than LONG_VALUE, in order
+		filterLongValue(events, &eventCnt);
+		CHECK(eventCnt==expectedCnt);
+		for (i=0; (i<eventCnt) && (i<expectedCnt); i++)
+			CHECK(events[i].Type==pExpected[i]);
+		if (failures!=before) {
+			printf("  %s, dropouts of %u samples every %u: %lu events\n", name,
+					drops[d][1], drops[d][0], (unsigned long)eventCnt);
+			return;
+		}
+	}
+	printf("%-14s OK, clean and with dropouts\n", name);
+}
+
+
+
+
+#define TRACE(...)		(const TraceSeg_t[]){ __VA_ARGS__ }, sizeof((const TraceSeg_t[]){ __VA_ARGS__ })/sizeof(TraceSeg_t)
+#define EXPECT(...)		(const VL53L1__GestureType_t[]){ __VA_ARGS__ }, sizeof((const VL53L1__GestureType_t[]){ __VA_ARGS__ })/sizeof(VL53L1__GestureType_t)
+
+static void testGestures(void){
+	expectEvents("click",
+			TRACE({500, ABSENT, 0, 0}, {300, 200, 0, 0}, {1000, ABSENT, 0, 0}),
+			EXPECT(VL53L1__GESTURE_CLICK));
+	expectEvents("double click",
+			TRACE({500, ABSENT, 0, 0}, {250, 200, 0, 0}, {200, ABSENT, 0, 0}, {250, 210, 0, 0}, {1000, ABSENT, 0, 0}),
+			EXPECT(VL53L1__GESTURE_DOUBLECLICK));
+	expectEvents("long press",
+			TRACE({500, ABSENT, 0, 0}, {2500, 200, 0, 0}, {1000, ABSENT, 0, 0}),
+			EXPECT(VL53L1__GESTURE_LONG_START, VL53L1__GESTURE_LONG_END));
+	expectEvents("long + move",
+			TRACE({500, ABSENT, 0, 0}, {1000, 200, 0, 0}, {1000, 200, 350, 0}, {1000, ABSENT, 0, 0}),
+			EXPECT(VL53L1__GESTURE_LONG_START, VL53L1__GESTURE_LONG_END));
+	expectEvents("swipe near",
+			TRACE({500, ABSENT, 0, 0}, {400, 350, 150, 0}, {1000, ABSENT, 0, 0}),
+			EXPECT(VL53L1__GESTURE_SWIPE_NEAR));
+	expectEvents("swipe far",
+			TRACE({500, ABSENT, 0, 0}, {400, 100, 300, 0}, {1000, ABSENT, 0, 0}),
+			EXPECT(VL53L1__GESTURE_SWIPE_FAR));
+}
+
+
+
+
+/*****************************************
+ * @brief	release timing: an absence of GESTURE_RELEASE_TIME ends a
+ * 			press, the double click gap starts at the first absent sample
+ *****************************************/
+static void testRelease(void){
+	uint16_t n;
+
+	// absent samples spanning GESTURE_RELEASE_TIME separate two presses: double click
+	replayReset();
+	replay(TRACE({300, 200, 0, 0}, {GESTURE_RELEASE_TIME+2*SAMPLE_MS, ABSENT, 0, 0}, {300, 200, 0, 0}, {1000, ABSENT, 0, 0}), 0, 0);
+	CHECK(eventCnt==1);
+	CHECK(countEvents(VL53L1__GESTURE_DOUBLECLICK)==1);
+
+	// a shorter gap is a dropout: a single click
+	replayReset();
+	replay(TRACE({300, 200, 0, 0}, {GESTURE_RELEASE_TIME, ABSENT, 0, 0}, {300, 200, 0, 0}, {1000, ABSENT, 0, 0}), 0, 0);
+	CHECK(eventCnt==1);
+	CHECK(countEvents(VL53L1__GESTURE_CLICK)==1);
+
+	// the click is reported GESTURE_DCLICK_GAP after the first absent sample
+	replayReset();
+	replay(TRACE({300, 200, 0, 0}), 0, 0);
+	n=0;
+	while ((eventCnt==0) && (n++<100))
+		replaySample(ABSENT, 0);
+	CHECK(eventCnt==1);
+	CHECK(events[0].Type==VL53L1__GESTURE_CLICK);
+	CHECK(n*SAMPLE_MS>=GESTURE_DCLICK_GAP);
+	CHECK(n*SAMPLE_MS<GESTURE_DCLICK_GAP+2*SAMPLE_MS);
+
+	// a second press GESTURE_DCLICK_GAP - 2 samples after the release: double click
+	replayReset();
+	replay(TRACE({300, 200, 0, 0}, {GESTURE_DCLICK_GAP-2*SAMPLE_MS, ABSENT, 0, 0}, {300, 200, 0, 0}, {1000, ABSENT, 0, 0}), 0, 0);
+	CHECK(eventCnt==1);
+	CHECK(countEvents(VL53L1__GESTURE_DOUBLECLICK)==1);
+
+	// a long press survives a dropout at any point, ends on release
+	replayReset();
+	replay(TRACE({1000, 200, 0, 0}, {GESTURE_RELEASE_TIME, ABSENT, 0, 0}, {500, 200, 0, 0}, {GESTURE_RELEASE_TIME+2*SAMPLE_MS, ABSENT, 0, 0}), 0, 0);
+	CHECK(eventCnt==2);
+	CHECK(countEvents(VL53L1__GESTURE_LONG_START)==1);
+	CHECK(countEvents(VL53L1__GESTURE_LONG_END)==1);
+	printf("release        %s\n", failures ? "FAILED" : "OK");
+}
+
+
+
+
+/*****************************************
+ * @brief	random sequences of gestures, replayed clean and with random
+ * 			dropouts of 1..2 samples: the same events
+ *****************************************/
+static void testRandom(void){
+	TraceSeg_t trace[24];
+	VL53L1__GestureEvent_t clean[EVENTS_MAX];
+	uint32_t cleanCnt, run, i, samples=0, dropouts=0, total=0;
+	uint16_t s, segCnt, k, n, drop;
+	uint8_t dropped;
+
+	for (run=0; run<RANDOM_RUNS; run++) {
+		segCnt=0;
+		while (segCnt<sizeof(trace)/sizeof(trace[0])-2) {
+			// press of 100..1500 ms, possibly moving, then an absence of
+			// 100..1000 ms (well away from GESTURE_DCLICK_GAP)
+			trace[segCnt].Ms=100+(testRand() % 1400);
+			trace[segCnt].Dist=GESTURE_MIN_DIST+20+(testRand() % (GESTURE_MAX_DIST-GESTURE_MIN_DIST-40));
+			trace[segCnt].DistEnd=(testRand() & 1) ? GESTURE_MIN_DIST+20+(testRand() % (GESTURE_MAX_DIST-GESTURE_MIN_DIST-40)) : 0;
+			trace[segCnt].Status=0;
+			segCnt++;
+			trace[segCnt].Ms=(testRand() & 1) ? 100+(testRand() % 200) : 500+(testRand() % 500);
+			trace[segCnt].Dist=ABSENT;
+			trace[segCnt].DistEnd=0;
+			trace[segCnt].Status=0;
+			segCnt++;
+		}
+		replayReset();
+		replay(trace, segCnt, 0, 0);
+		memcpy(clean, events, sizeof(events));
+		cleanCnt=eventCnt;
+		total += cleanCnt;
+
+		// the same trace with random dropouts during the presses
+		replayReset();
+		for (s=0; s<segCnt; s++) {
+			n=trace[s].Ms/SAMPLE_MS;
+			drop=0;
+			dropped=0;
+			for (k=0; k<n; k++) {
+				uint16_t dist=trace[s].DistEnd ? trace[s].Dist + ((int32_t)trace[s].DistEnd-trace[s].Dist)*k/n : trace[s].Dist;
+
+				samples++;
+				if (trace[s].Dist && (k>0) && (k+2<n) && !drop && !dropped && ((testRand() % 8)==0)) {
+					drop=1+(testRand() % ((GESTURE_RELEASE_TIME-1)/SAMPLE_MS));
+					dropouts++;
+				}
+				dropped=(drop>0);
+				if (drop) {
+					drop--;
+					replaySample(ABSENT, 0);
+				} else
+					replaySample(dist, 0);
+			}
+		}
+		// a dropout holds the last distance: only LONG_VALUE events may differ
+		filterLongValue(clean, &cleanCnt);
+		filterLongValue(events, &eventCnt);
+		CHECK(eventCnt==cleanCnt);
+		for (i=0; (i<eventCnt) && (i<cleanCnt); i++)
+			CHECK(events[i].Type==clean[i].Type);
+		if (failures)
+			break;
+	}
+	printf("random         %lu sequences, %lu samples, %lu dropouts, %lu events: %s\n",
+			(unsigned long)run, (unsigned long)samples, (unsigned long)dropouts, (unsigned long)total,
+			failures ? "FAILED" : "OK");
+}
+
+
+
+
+int main(void){
+	testGestures();
+	testRelease();
+	testRandom();
+
+	printf("test_z_vl53l1_gesture: %s\n", (failures == 0) ? "OK" : "FAILED");
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,326 @@
+/*
+ * test_z_vl53l1_stats.c
+ *
+ *	Host test of the windowed distance statistics (z_vl53l1_stats.c)
+ *
+ * - numerical equivalence with a double precision reference on synthetic
+ *   traces (noise, spikes, steps, extremes of the clamped range, full 16 bit
+ *   range clamped to VL53L1__STATS_MAX_DIST): mean within 1/32 mm,
+ *   standard deviation within 1/16 mm (rounded down), median exact,
+ *   outlier decisions equal except within the 1 mm rounding of the limit
+ * - cost per reading compared with the float code it replaced (re-sum of
+ *   the whole window and sqrt every reading). Host time only, with the
+ *   host FPU: on the Cortex-M0 the float version is soft-float, while the
+ *   module uses only 32 bit integer operations (no cycle counts here)
+ *
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+
+#define TRACE_LEN		200000U		// readings per trace
+#define BENCH_LEN		2000000U	// readings in the cost measurement
+
+#define CHECK(cond)		check((cond), #cond, __LINE__)
+
+typedef struct {
+	uint16_t	All[VL53L1__STATS_MED_WIN];		// last readings, for the median
+	uint32_t	AllCnt;
+	uint16_t	Acc[VL53L1__STATS_WIN];			// last accepted readings
+	uint32_t	AccCnt;
+} RefStats_t;
+
+static int failures;
+static uint32_t randState=2463534242U;
+static uint32_t ambiguous;			// outlier decisions within the limit rounding
+
+
+
+
+static void check(int ok, const char *expr, int line){
+	if (!ok) {
+		failures++;
+		if (failures<20)
+			printf("test_z_vl53l1_stats.c:%d: check failed: %s\n", line, expr);
+	}
+}
+
+
+
+
+static uint32_t testRand(void){
+	randState ^= randState << 13;
+	randState ^= randState >> 17;
+	randState ^= randState << 5;
+	return randState;
+}
+
+
+
+
+// roughly normal noise, standard deviation about sigma
+static int32_t testNoise(int32_t sigma){
+	int32_t sum=0;
+	int k;
+
+	for (k=0; k<4; k++)
+		sum += (int32_t)(testRand() & 0xFFFF) - 0x8000;
+	return (int32_t)(((int64_t)sum*sigma) / 37837);	// 4 uniform: sd = 0x10000/sqrt(3)
+}
+
+
+
+
+static uint16_t clampDistance(int32_t d){
+	return (d<0) ? 0 : ((d>65535) ? 65535 : (uint16_t)d);
+}
+
+
+
+
+static int cmpU16(const void *a, const void *b){
+	return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+
+
+
+static double refMedian(const RefStats_t *pRef){
+	uint16_t sorted[VL53L1__STATS_MED_WIN];
+	uint32_t n=(pRef->AllCnt<VL53L1__STATS_MED_WIN) ? pRef->AllCnt : VL53L1__STATS_MED_WIN;
+
+	memcpy(sorted, pRef->All, n*sizeof(uint16_t));
+	qsort(sorted, n, sizeof(uint16_t), cmpU16);
+	return sorted[n/2];
+}
+
+
+
+
+static void refMeanStd(const RefStats_t *pRef, double *pMean, double *pStd){
+	uint32_t n=(pRef->AccCnt<VL53L1__STATS_WIN) ? pRef->AccCnt : VL53L1__STATS_WIN;
+	double sum=0, sq=0;
+	uint32_t k;
+
+	*pMean=0;
+	*pStd=0;
+	if (!n)
+		return;
+	for (k=0; k<n; k++)
+		sum += pRef->Acc[k];
+	*pMean=sum/n;
+	if (n<2)
+		return;
+	for (k=0; k<n; k++)
+		sq += (pRef->Acc[k]-*pMean)*(pRef->Acc[k]-*pMean);
+	*pStd=sqrt(sq/n);
+}
+
+
+
+
+/*****************************************
+ * @brief	feeds one reading to both implementations and compares
+ *****************************************/
+static void compareAdd(VL53L1__Stats_t *pStats, RefStats_t *pRef, uint16_t Distance){
+	double mean, std, median, limit, dev;
+	int refReject=-1;		// -1: within the rounding of the limit, either is right
+	uint8_t rejected;
+	uint16_t clamped=(Distance>VL53L1__STATS_MAX_DIST) ? VL53L1__STATS_MAX_DIST : Distance;
+
+	if ((VL53L1__STATS_OUTLIER_MIN>0) && (pRef->AllCnt>=VL53L1__STATS_MED_WIN)) {
+		refMeanStd(pRef, &mean, &std);
+		median=refMedian(pRef);
+		limit=VL53L1__STATS_OUTLIER_K*std;
+		dev=fabs(clamped-median);
+		if (limit<=VL53L1__STATS_OUTLIER_MIN)
+			refReject=(dev>VL53L1__STATS_OUTLIER_MIN);
+		else if (dev>limit+1e-9)
+			refReject=1;
+		else if (dev<=limit-1.0-VL53L1__STATS_OUTLIER_K/16.0)
+			refReject=0;
+	} else
+		refReject=0;
+
+	rejected=VL53L1__StatsAdd(pStats, Distance);
+	if (refReject<0)
+		ambiguous++;
+	else
+		CHECK(rejected==refReject);
+
+	pRef->All[pRef->AllCnt % VL53L1__STATS_MED_WIN]=clamped;
+	pRef->AllCnt++;
+	if (!rejected) {
+		pRef->Acc[pRef->AccCnt % VL53L1__STATS_WIN]=clamped;
+		pRef->AccCnt++;
+	}
+
+	refMeanStd(pRef, &mean, &std);
+	CHECK(fabs(VL53L1__StatsMeanQ4(pStats)/16.0 - mean) <= 1.0/32 + 1e-9);
+	CHECK(VL53L1__StatsStdDevQ4(pStats)/16.0 <= std + 1e-9);
+	CHECK(VL53L1__StatsStdDevQ4(pStats)/16.0 > std - 1.0/16);
+	CHECK(VL53L1__StatsMedian(pStats) == refMedian(pRef));
+}
+
+
+
+
+/*****************************************
+ * @brief	trace generators, t = reading index
+ *****************************************/
+// steady target with sensor noise and 1% spikes
+static uint16_t traceSpikes(uint32_t t){
+	(void)t;
+	if ((testRand() % 100) == 0)
+		return clampDistance(1000 + (int32_t)(testRand() % 3000) - 800);
+	return clampDistance(1000 + testNoise(8));
+}
+
+// target moving between levels every 500 readings, noise growing with range
+static uint16_t traceSteps(uint32_t t){
+	static int32_t level=1000;
+
+	if ((t % 500) == 0)
+		level=100 + (int32_t)(testRand() % 3400);
+	return clampDistance(level + testNoise(2 + level/200));
+}
+
+// slow ramp with no echo readings (0) in bursts
+static uint16_t traceRamp(uint32_t t){
+	if ((t % 1000) < 20)
+		return 0;
+	return clampDistance(200 + (int32_t)((t/10) % 3800) + testNoise(5));
+}
+
+// both ends of the clamped range: largest variance, the sums must not overflow
+static uint16_t traceExtremes(uint32_t t){
+	(void)t;
+	return (testRand() & 1) ? (uint16_t)(VL53L1__STATS_MAX_DIST - (testRand() & 0xFF)) : (uint16_t)(testRand() & 0xFF);
+}
+
+// anything in the 16 bit range, clamped by the module
+static uint16_t traceFullRange(uint32_t t){
+	(void)t;
+	return (testRand() & 1) ? (uint16_t)(65535 - (testRand() & 0xFF)) : (uint16_t)testRand();
+}
+
+
+
+
+static void testTrace(const char *name, uint16_t (*trace)(uint32_t)){
+	static VL53L1__Stats_t stats;
+	static RefStats_t ref;
+	uint32_t t, rejects=0;
+	int before=failures;
+
+	VL53L1__StatsReset(&stats);
+	memset(&ref, 0, sizeof(ref));
+	ambiguous=0;
+	for (t=0; (t<TRACE_LEN) && (failures-before<20); t++)
+		compareAdd(&stats, &ref, trace(t));
+	rejects=(uint32_t)(ref.AllCnt-ref.AccCnt);
+	CHECK(stats.Rejected == rejects);
+	printf("%-11s %lu readings, %lu outliers, %lu decisions within the limit rounding\n",
+			name, (unsigned long)t, (unsigned long)rejects, (unsigned long)ambiguous);
+}
+
+
+
+
+// the first readings: empty window, one sample, median of fewer than MED_WIN
+static void testStart(void){
+	VL53L1__Stats_t stats;
+
+	VL53L1__StatsReset(&stats);
+	CHECK(VL53L1__StatsMeanQ4(&stats) == 0);
+	CHECK(VL53L1__StatsStdDevQ4(&stats) == 0);
+	CHECK(VL53L1__StatsMedian(&stats) == 0);
+	CHECK(VL53L1__StatsAdd(&stats, 1000) == 0);
+	CHECK(VL53L1__StatsMeanQ4(&stats) == 16000);
+	CHECK(VL53L1__StatsStdDevQ4(&stats) == 0);
+	CHECK(VL53L1__StatsAdd(&stats, 1002) == 0);
+	CHECK(VL53L1__StatsMeanQ4(&stats) == 16016);
+	CHECK(VL53L1__StatsStdDevQ4(&stats) == 16);
+	CHECK(VL53L1__StatsMedian(&stats) == 1002);
+	// no outlier test before the median window is full
+	CHECK(VL53L1__StatsAdd(&stats, 4000) == 0);
+	CHECK(VL53L1__StatsMedian(&stats) == 1002);
+}
+
+
+
+
+/*****************************************
+ * @brief	cost per reading: this module against the float code it replaced
+ *****************************************/
+static double nowNs(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+static void testCost(void){
+	static VL53L1__Stats_t stats;
+	static float DistArray[VL53L1__STATS_WIN];
+	volatile float avgDist, StdDev;
+	volatile uint32_t sink=0;
+	uint16_t posArr=0, sampleNum=0;
+	double start, fixedNs, floatNs;
+	uint32_t t;
+
+	VL53L1__StatsReset(&stats);
+	start=nowNs();
+	for (t=0; t<BENCH_LEN; t++) {
+		VL53L1__StatsAdd(&stats, traceSpikes(t));
+		sink += VL53L1__StatsMeanQ4(&stats) + VL53L1__StatsStdDevQ4(&stats) + VL53L1__StatsMedian(&stats);
+	}
+	fixedNs=(nowNs()-start)/BENCH_LEN;
+
+	start=nowNs();
+	for (t=0; t<BENCH_LEN; t++) {
+		float sumArr=0, sumSqArr=0;
+		uint16_t k;
+
+		DistArray[posArr]=traceSpikes(t);
+		if ((posArr+1) > sampleNum)
+			sampleNum=(posArr+1);
+		posArr=(posArr+1) % VL53L1__STATS_WIN;
+		for (k=0; k<sampleNum; k++) {
+			sumArr+=DistArray[k];
+			sumSqArr+=(DistArray[k]*DistArray[k]);
+		}
+		avgDist=sumArr/((float)sampleNum);
+		StdDev=sqrtf(sampleNum*sumSqArr - sumArr*sumArr)/((float)sampleNum);
+	}
+	floatNs=(nowNs()-start)/BENCH_LEN;
+	(void)avgDist;
+	(void)StdDev;
+	(void)sink;
+
+	printf("cost        %.1f ns/reading fixed point (median, outliers included), "
+			"%.1f ns/reading float re-sum of %u samples (host)\n",
+			fixedNs, floatNs, (unsigned)VL53L1__STATS_WIN);
+}
+
+
+
+
+int main(void){
+	testStart();
+	testTrace("spikes", traceSpikes);
+	testTrace("steps", traceSteps);
+	testTrace("ramp", traceRamp);
+	testTrace("extremes", traceExtremes);
+	testTrace("full range", traceFullRange);
+	testCost();
+
+	printf("test_z_vl53l1_stats: %s\n", (failures == 0) ? "OK" : "FAILED");
+	return (failures == 0) ? 0 : 1;
+}
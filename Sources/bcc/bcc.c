@@ -41,6 +41,7 @@
  * Includes
  ******************************************************************************/
 
+#include <string.h>
 #include "bcc_spi.h"
 #include "bcc_tpl.h"
 
@@ -48,10 +49,6 @@
  * Definitions
  ******************************************************************************/
 
-/*! @brief Cell map for 7 cells connected to MC33771. */
-#define BCC_CM_MC33771_7CELLS     0x380FU
-/*! @brief Cell map for 3 cells connected to MC33772. */
-#define BCC_CM_MC33772_3CELLS     0x0023U
 
 /*! @brief Time after VPWR connection for the IC to be ready for initialization
  *  (t_VPWR(READY)) in [ms]. */
@@ -73,6 +70,20 @@
 /*! @brief RESET de-glitch filter (t_RESETFLT, typ.) in [us]. */
 #define BCC_T_RESETFLT_US         100U
 
+/*! @brief Composes GUID from the traceability fuse mirror registers.
+ *
+ * @param tr0 Content of FUSE_TR_0 register.
+ * @param tr1 Content of FUSE_TR_1 register.
+ * @param tr2 Content of FUSE_TR_2 register.
+ */
+#define BCC_GET_GUID(tr0, tr1, tr2) \
+    ((((uint64_t)((tr0) & BCC_FUSE_TR_0_MASK)) << 21) | \
+     (((uint64_t)((tr1) & BCC_FUSE_TR_1_MASK)) << 5) | \
+     ((uint64_t)((tr2) & BCC_FUSE_TR_2_MASK)))
+
+/*! @brief Number of bytes of bcc_inventory_t protected by CRC. */
+#define BCC_INV_CRC_LEN   ((uint16_t)offsetof(bcc_inventory_t, crc))
+
 /*******************************************************************************
  * Global variables (constants)
  ******************************************************************************/
@@ -222,6 +233,45 @@ static bcc_status_t BCC_AssignCid(bcc_drv_config_t* const drvConfig,
 static bcc_status_t BCC_InitDevices(bcc_drv_config_t* const drvConfig,
     const uint16_t devConf[][BCC_INIT_CONF_REG_CNT]);
 
+/*!
+ * @brief This function evaluates result of a register read/write and does
+ * a recovery step if the operation failed due to a communication error.
+ *
+ * Depending on the error, it waits (exponential backoff), resynchronizes
+ * the Rolling Counter or wakes up the devices. It also updates the recovery
+ * statistics and the degraded state of the device.
+ *
+ * @param drvConfig Pointer to driver instance configuration.
+ * @param cid Cluster Identification Address.
+ * @param error Result of the operation.
+ * @param attempt Number of already done retries of the operation.
+ *
+ * @return True if the operation should be retried.
+ */
+static bool BCC_Recover(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
+    bcc_status_t error, uint8_t attempt);
+
+/*!
+ * @brief This function writes a value to addressed register of selected BCC
+ * device once, without the error recovery.
+ *
+ * It is used for writes which get no response by design (software reset,
+ * go to sleep) and for writes which are not safe to repeat: the first
+ * transfer can reach the device even though its response is lost, so a
+ * retry would start a second conversion (SOC) or clear a fault latched in
+ * the meantime (fault status clear).
+ *
+ * @param drvConfig Pointer to driver instance configuration.
+ * @param cid Cluster Identification Address.
+ * @param regAddr Register address.
+ * @param regVal New value of selected register.
+ * @param retReg Automatic response of BCC or NULL.
+ *
+ * @return bcc_status_t Error code.
+ */
+static bcc_status_t BCC_Reg_WriteOnce(bcc_drv_config_t* const drvConfig,
+    bcc_cid_t cid, uint8_t regAddr, uint16_t regVal, uint16_t* retReg);
+
 /*******************************************************************************
  * Internal function
  ******************************************************************************/
@@ -290,11 +340,11 @@ static bcc_status_t BCC_InitRegisters(bcc_drv_config_t* const drvConfig,
     bcc_status_t error;
 
     /* Initialize all registers according to according to the user values. */
-    for (cid = 1; cid <= drvConfig->devicesCnt; cid++)
+    for (cid = 1; cid <= BCC_DEVICES_CNT(drvConfig); cid++)
     {
         for (i = 0; i < BCC_INIT_CONF_REG_CNT; i++)
         {
-            if (drvConfig->device[cid - 1U] == BCC_DEVICE_MC33772)
+            if (BCC_DEVICE_TYPE(drvConfig, cid) == BCC_DEVICE_MC33772)
             {
                 if (BCC_IS_IN_RANGE(BCC_INIT_CONF_REG_ADDR[i], BCC_REG_CB7_CFG_ADDR, BCC_REG_CB14_CFG_ADDR) ||
                     BCC_IS_IN_RANGE(BCC_INIT_CONF_REG_ADDR[i], BCC_REG_TH_CT14_ADDR, BCC_REG_TH_CT7_ADDR))
@@ -344,7 +394,7 @@ static bcc_status_t BCC_AssignCid(bcc_drv_config_t* const drvConfig,
      * just CID needs to be written.
      * Note: It is forbidden to use global write command to assign CID (writing
      * into INIT register). */
-    if ((uint8_t)cid < drvConfig->devicesCnt)
+    if ((uint8_t)cid < BCC_DEVICES_CNT(drvConfig))
     {
         writeVal = BCC_SET_CID(readVal, (uint8_t)cid) | BCC_BUS_SWITCH_ENABLED | BCC_RTERM_COMM_SW;
     }
@@ -395,7 +445,7 @@ static bcc_status_t BCC_InitDevices(bcc_drv_config_t* const drvConfig,
     BCC_WakeUp(drvConfig);
 
     /* Reset (soft reset) all configured devices (in case CID was already assigned). */
-    (void)BCC_SoftwareReset(drvConfig, (drvConfig->commMode == BCC_MODE_TPL) ? BCC_CID_UNASSIG : BCC_CID_DEV1);
+    (void)BCC_SoftwareReset(drvConfig, (BCC_COMM_MODE(drvConfig) == BCC_MODE_TPL) ? BCC_CID_UNASSIG : BCC_CID_DEV1);
 
     /* Wait for 5 ms - for the IC to be ready for initialization. */
     BCC_MCU_WaitMs(BCC_T_VPWR_READY_MS);
@@ -407,7 +457,7 @@ static bcc_status_t BCC_InitDevices(bcc_drv_config_t* const drvConfig,
         return error;
     }
 
-    for (cid = 2U; cid <= drvConfig->devicesCnt; cid++)
+    for (cid = 2U; cid <= BCC_DEVICES_CNT(drvConfig); cid++)
     {
         BCC_MCU_WaitMs(2U);
 
@@ -430,6 +480,116 @@ static bcc_status_t BCC_InitDevices(bcc_drv_config_t* const drvConfig,
     return error;
 }
 
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : BCC_Recover
+ * Description   : This function evaluates result of a register read/write and
+ *                 does a recovery step if the operation failed due to
+ *                 a communication error.
+ *
+ *END**************************************************************************/
+static bool BCC_Recover(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
+    bcc_status_t error, uint8_t attempt)
+{
+    bcc_recovery_stats_t *stats = &(drvConfig->drvData.recStats);
+    uint16_t devMask;
+    uint8_t dev;
+
+    /* Recovery is not used during CID assignment and for global messages. */
+    if ((!drvConfig->drvData.recoveryEn) || (cid == BCC_CID_UNASSIG) ||
+            (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
+    {
+        return false;
+    }
+
+    dev = (uint8_t)cid - 1U;
+    devMask = (uint16_t)(1U << dev);
+
+    switch (error)
+    {
+        case BCC_STATUS_SUCCESS:
+            drvConfig->drvData.failCnt[dev] = 0U;
+            drvConfig->drvData.degradedMap &= (uint16_t)~devMask;
+            return false;
+
+        case BCC_STATUS_CRC:
+            stats->crcErrors++;
+            break;
+
+        case BCC_STATUS_COM_RC:
+        case BCC_STATUS_COM_TAG_ID:
+            stats->rcTagErrors++;
+            break;
+
+        case BCC_STATUS_NULL_RESP:
+            stats->nullResps++;
+            break;
+
+        case BCC_STATUS_COM_TIMEOUT:
+            stats->timeouts++;
+            break;
+
+        default:
+            /* Not a communication error, retry would not help. */
+            return false;
+    }
+
+    if ((attempt >= BCC_RETRY_CNT_MAX) || ((drvConfig->drvData.degradedMap & devMask) != 0U))
+    {
+        stats->failures++;
+        if (drvConfig->drvData.failCnt[dev] < BCC_DEGRADED_FAIL_CNT)
+        {
+            drvConfig->drvData.failCnt[dev]++;
+            if (drvConfig->drvData.failCnt[dev] == BCC_DEGRADED_FAIL_CNT)
+            {
+                drvConfig->drvData.degradedMap |= devMask;
+                stats->degraded++;
+            }
+        }
+
+        return false;
+    }
+
+    stats->retries++;
+    BCC_MCU_WaitUs((uint32_t)BCC_RETRY_BACKOFF_US << attempt);
+
+    if ((error == BCC_STATUS_NULL_RESP) || (error == BCC_STATUS_COM_TIMEOUT))
+    {
+        /* The device does not respond, it may have entered sleep mode. */
+        stats->wakeUps++;
+        BCC_WakeUp(drvConfig);
+    }
+    else if (error == BCC_STATUS_COM_RC)
+    {
+        /* A response to an older request was received. Flush it by NOP
+         * command, the next request uses the following RC value. */
+        stats->resyncs++;
+        (void)BCC_VerifyCom(drvConfig, cid);
+    }
+
+    return true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : BCC_Reg_WriteOnce
+ * Description   : This function writes a value to addressed register of
+ *                 selected Battery Cell Controller device without retries.
+ *
+ *END**************************************************************************/
+static bcc_status_t BCC_Reg_WriteOnce(bcc_drv_config_t* const drvConfig,
+    bcc_cid_t cid, uint8_t regAddr, uint16_t regVal, uint16_t* retReg)
+{
+    if (BCC_COMM_MODE(drvConfig) == BCC_MODE_SPI)
+    {
+        return BCC_Reg_WriteSpi(drvConfig, cid, regAddr, regVal, retReg);
+    }
+    else
+    {
+        return BCC_Reg_WriteTpl(drvConfig, cid, regAddr, regVal, retReg);
+    }
+}
+
 /******************************************************************************
  * API
  ******************************************************************************/
@@ -446,7 +606,6 @@ bcc_status_t BCC_Init(bcc_drv_config_t* const drvConfig,
     const uint16_t devConf[][BCC_INIT_CONF_REG_CNT])
 {
     uint8_t dev;
-    uint8_t cell;
     uint8_t cid;
     bcc_status_t error;
 
@@ -459,6 +618,24 @@ bcc_status_t BCC_Init(bcc_drv_config_t* const drvConfig,
         return BCC_STATUS_PARAM_RANGE;
     }
 
+#ifdef BCC_FIXED_TOPOLOGY
+    /* The driver is built for a fixed topology, the configuration must match. */
+    if ((drvConfig->commMode != BCC_FIXED_COMM_MODE) ||
+            (drvConfig->devicesCnt != BCC_FIXED_DEVICES_CNT))
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    for (dev = 0; dev < drvConfig->devicesCnt; dev++)
+    {
+        if ((drvConfig->device[dev] != BCC_FIXED_DEVICE) ||
+                (drvConfig->cellCnt[dev] != BCC_FIXED_CELL_CNT))
+        {
+            return BCC_STATUS_PARAM_RANGE;
+        }
+    }
+#endif
+
     for (dev = 0; dev < drvConfig->devicesCnt; dev++)
     {
         if (drvConfig->device[dev] == BCC_DEVICE_MC33771)
@@ -480,35 +657,28 @@ bcc_status_t BCC_Init(bcc_drv_config_t* const drvConfig,
     /* Initialize driver variables. */
     for (dev = 0; dev < drvConfig->devicesCnt; dev++)
     {
-        if (drvConfig->device[dev] == BCC_DEVICE_MC33771)
-        {
-            drvConfig->drvData.cellMap[dev] = BCC_CM_MC33771_7CELLS;
-            for (cell = BCC_MIN_CELLS_MC33771; cell < drvConfig->cellCnt[dev]; cell++)
-            {
-                drvConfig->drvData.cellMap[dev] |= (0x0400U >> (cell - BCC_MIN_CELLS_MC33771));
-            }
-        }
-        else
-        {
-            drvConfig->drvData.cellMap[dev] = BCC_CM_MC33772_3CELLS;
-            for (cell = BCC_MIN_CELLS_MC33772; cell < drvConfig->cellCnt[dev]; cell++)
-            {
-                drvConfig->drvData.cellMap[dev] |= (0x0010U >> (cell - BCC_MIN_CELLS_MC33772));
-            }
-        }
+        drvConfig->drvData.cellMap[dev] = BCC_CELL_MAP_CALC(drvConfig->device[dev],
+                drvConfig->cellCnt[dev]);
     }
 
-    /* Initialize TAG ID. */
+    /* Initialize TAG ID, device inventory and error recovery. */
     for (cid = 0; cid < drvConfig->devicesCnt; cid++)
     {
         drvConfig->drvData.rcTbl[cid] = 0U;
         drvConfig->drvData.tagId[cid] = 0U;
+        drvConfig->drvData.inventory[cid].fuseCnt = 0U;
+        drvConfig->drvData.failCnt[cid] = 0U;
     }
 
+    /* Error recovery is enabled when CIDs are assigned. */
+    drvConfig->drvData.recoveryEn = false;
+    drvConfig->drvData.degradedMap = 0U;
+    (void)memset(&(drvConfig->drvData.recStats), 0, sizeof(bcc_recovery_stats_t));
+
     /* RESET -> 0. */
     BCC_MCU_WriteRstPin(drvConfig->drvInstance, 0);
 
-    if (drvConfig->commMode == BCC_MODE_TPL)
+    if (BCC_COMM_MODE(drvConfig) == BCC_MODE_TPL)
     {
         /* Enable MC33664 device. */
         if ((error = BCC_TPL_Enable(drvConfig)) != BCC_STATUS_SUCCESS)
@@ -519,7 +689,22 @@ bcc_status_t BCC_Init(bcc_drv_config_t* const drvConfig,
 
     /* Wake-up BCC (if case of idle/sleep mode), resets them, assigns CID,
      * initialize registers and check communication with configured devices. */
-    return BCC_InitDevices(drvConfig, devConf);
+    if ((error = BCC_InitDevices(drvConfig, devConf)) != BCC_STATUS_SUCCESS)
+    {
+        return error;
+    }
+
+    drvConfig->drvData.recoveryEn = true;
+
+    /* Read identification data, they do not change at runtime. The devices
+     * are usable without them: a failed read leaves the inventory invalid
+     * (see BCC_Inventory_IsValid) and it can be read again later. */
+    for (cid = 1U; cid <= BCC_DEVICES_CNT(drvConfig); cid++)
+    {
+        (void)BCC_Inventory_Read(drvConfig, (bcc_cid_t)cid);
+    }
+
+    return BCC_STATUS_SUCCESS;
 }
 
 /*FUNCTION**********************************************************************
@@ -534,7 +719,7 @@ bcc_status_t BCC_VerifyCom(bcc_drv_config_t* const drvConfig, bcc_cid_t cid)
 {
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if (drvConfig->commMode == BCC_MODE_SPI)
+    if (BCC_COMM_MODE(drvConfig) == BCC_MODE_SPI)
     {
         return BCC_VerifyComSpi(drvConfig, cid);
     }
@@ -555,10 +740,12 @@ bcc_status_t BCC_Sleep(bcc_drv_config_t* const drvConfig)
 {
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if (drvConfig->commMode == BCC_MODE_SPI)
+    if (BCC_COMM_MODE(drvConfig) == BCC_MODE_SPI)
     {
-        return BCC_Reg_Write(drvConfig, BCC_CID_DEV1, BCC_REG_SYS_CFG_GLOBAL_ADDR,
-                             BCC_GO2SLEEP_ENABLED, NULL);
+        /* The device goes to sleep without a response, a retry would wake
+         * it up again. */
+        return BCC_Reg_WriteOnce(drvConfig, BCC_CID_DEV1, BCC_REG_SYS_CFG_GLOBAL_ADDR,
+                                 BCC_GO2SLEEP_ENABLED, NULL);
     }
     else
     {
@@ -578,7 +765,7 @@ void BCC_WakeUp(const bcc_drv_config_t* const drvConfig)
 {
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if (drvConfig->commMode == BCC_MODE_SPI)
+    if (BCC_COMM_MODE(drvConfig) == BCC_MODE_SPI)
     {
         BCC_WakeUpPatternSpi(drvConfig);
     }
@@ -603,8 +790,8 @@ bcc_status_t BCC_SoftwareReset(bcc_drv_config_t* const drvConfig, bcc_cid_t cid)
 
     /* Note: it is not necessary to read content of SYS_CFG1 register
     * to change only RST bit, because registers are set to default values. */
-    if ((((uint8_t)cid) > drvConfig->devicesCnt) ||
-            ((cid == BCC_CID_UNASSIG) && (drvConfig->commMode == BCC_MODE_SPI)))
+    if ((((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)) ||
+            ((cid == BCC_CID_UNASSIG) && (BCC_COMM_MODE(drvConfig) == BCC_MODE_SPI)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -615,7 +802,8 @@ bcc_status_t BCC_SoftwareReset(bcc_drv_config_t* const drvConfig, bcc_cid_t cid)
     }
     else
     {
-        error = BCC_Reg_Write(drvConfig, cid, BCC_REG_SYS_CFG1_ADDR, BCC_W_SOFT_RST_MASK, NULL);
+        /* Not retried, the device resets without a response. */
+        error = BCC_Reg_WriteOnce(drvConfig, cid, BCC_REG_SYS_CFG1_ADDR, BCC_W_SOFT_RST_MASK, NULL);
         if (error == BCC_STATUS_COM_TIMEOUT)
         {
             /* Device does not respond after reset - normal condition. */
@@ -654,7 +842,7 @@ bcc_status_t BCC_TPL_Enable(const bcc_drv_config_t* const drvConfig)
     int32_t timeout;
 
     BCC_MCU_Assert(drvConfig != NULL);
-    BCC_MCU_Assert(drvConfig->commMode == BCC_MODE_TPL);
+    BCC_MCU_Assert(BCC_COMM_MODE(drvConfig) == BCC_MODE_TPL);
 
     /* Set normal state (transition from low to high). */
     BCC_MCU_WriteEnPin(drvConfig->drvInstance, 0);
@@ -704,7 +892,7 @@ bcc_status_t BCC_TPL_Enable(const bcc_drv_config_t* const drvConfig)
 void BCC_TPL_Disable(const bcc_drv_config_t* const drvConfig)
 {
     BCC_MCU_Assert(drvConfig != NULL);
-    BCC_MCU_Assert(drvConfig->commMode == BCC_MODE_TPL);
+    BCC_MCU_Assert(BCC_COMM_MODE(drvConfig) == BCC_MODE_TPL);
 
     BCC_MCU_WriteEnPin(drvConfig->drvInstance, 0);
 }
@@ -720,16 +908,24 @@ void BCC_TPL_Disable(const bcc_drv_config_t* const drvConfig)
 bcc_status_t BCC_Reg_Read(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
     uint8_t regAddr, uint8_t regCnt, uint16_t* regVal)
 {
+    uint8_t attempt = 0U;
+    bcc_status_t error;
+
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if (drvConfig->commMode == BCC_MODE_SPI)
+    do
     {
-        return BCC_Reg_ReadSpi(drvConfig, cid, regAddr, regCnt, regVal);
-    }
-    else
-    {
-        return BCC_Reg_ReadTpl(drvConfig, cid, regAddr, regCnt, regVal);
-    }
+        if (BCC_COMM_MODE(drvConfig) == BCC_MODE_SPI)
+        {
+            error = BCC_Reg_ReadSpi(drvConfig, cid, regAddr, regCnt, regVal);
+        }
+        else
+        {
+            error = BCC_Reg_ReadTpl(drvConfig, cid, regAddr, regCnt, regVal);
+        }
+    } while (BCC_Recover(drvConfig, cid, error, attempt++));
+
+    return error;
 }
 
 /*FUNCTION**********************************************************************
@@ -742,16 +938,17 @@ bcc_status_t BCC_Reg_Read(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
 bcc_status_t BCC_Reg_Write(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
     uint8_t regAddr, uint16_t regVal, uint16_t* retReg)
 {
+    uint8_t attempt = 0U;
+    bcc_status_t error;
+
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if (drvConfig->commMode == BCC_MODE_SPI)
+    do
     {
-        return BCC_Reg_WriteSpi(drvConfig, cid, regAddr, regVal, retReg);
-    }
-    else
-    {
-        return BCC_Reg_WriteTpl(drvConfig, cid, regAddr, regVal, retReg);
-    }
+        error = BCC_Reg_WriteOnce(drvConfig, cid, regAddr, regVal, retReg);
+    } while (BCC_Recover(drvConfig, cid, error, attempt++));
+
+    return error;
 }
 
 /*FUNCTION**********************************************************************
@@ -765,7 +962,7 @@ bcc_status_t BCC_Reg_WriteGlobal(bcc_drv_config_t* const drvConfig,
      uint8_t regAddr, uint16_t regVal)
 {
     BCC_MCU_Assert(drvConfig != NULL);
-    BCC_MCU_Assert(drvConfig->commMode == BCC_MODE_TPL);
+    BCC_MCU_Assert(BCC_COMM_MODE(drvConfig) == BCC_MODE_TPL);
 
     return BCC_Reg_WriteGlobalTpl(drvConfig, regAddr, regVal);
 }
@@ -785,7 +982,7 @@ bcc_status_t BCC_Reg_Update(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
 
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if (((uint8_t)cid) > drvConfig->devicesCnt)
+    if (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -818,7 +1015,7 @@ bcc_status_t BCC_Meas_StartConversion(bcc_drv_config_t* const drvConfig,
 
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -836,7 +1033,9 @@ bcc_status_t BCC_Meas_StartConversion(bcc_drv_config_t* const drvConfig,
     regVal = BCC_SET_TAG_ID(regVal, drvConfig->drvData.tagId[(uint8_t)cid - 1]);
     regVal = BCC_REG_SET_BIT_VALUE(regVal, BCC_W_SOC_MASK);
 
-    return BCC_Reg_Write(drvConfig, cid, BCC_REG_ADC_CFG_ADDR, regVal, NULL);
+    /* Not retried, a lost response does not mean the conversion did not
+     * start. */
+    return BCC_Reg_WriteOnce(drvConfig, cid, BCC_REG_ADC_CFG_ADDR, regVal, NULL);
 }
 
 /*FUNCTION**********************************************************************
@@ -853,13 +1052,13 @@ bcc_status_t BCC_Meas_StartConversionGlobal(bcc_drv_config_t* const drvConfig,
     uint8_t dev;
 
     BCC_MCU_Assert(drvConfig != NULL);
-    BCC_MCU_Assert(drvConfig->commMode == BCC_MODE_TPL);
+    BCC_MCU_Assert(BCC_COMM_MODE(drvConfig) == BCC_MODE_TPL);
 
     /* Increment & Use TAG ID (4 bit value) of the first node. */
     drvConfig->drvData.tagId[0] = (drvConfig->drvData.tagId[0] + 1U) & 0x0FU;
 
     /* Set Tag ID to all BCCs in the driver configuration structure. */
-    for (dev = 1; dev < drvConfig->devicesCnt; dev++)
+    for (dev = 1; dev < BCC_DEVICES_CNT(drvConfig); dev++)
     {
         drvConfig->drvData.tagId[dev] = drvConfig->drvData.tagId[0];
     }
@@ -887,7 +1086,7 @@ bcc_status_t BCC_Meas_IsConverting(bcc_drv_config_t* const drvConfig,
     BCC_MCU_Assert(drvConfig != NULL);
     BCC_MCU_Assert(completed != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -917,7 +1116,7 @@ bcc_status_t BCC_Meas_GetRawValues(bcc_drv_config_t* const drvConfig,
     BCC_MCU_Assert(drvConfig != NULL);
     BCC_MCU_Assert(measurements != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -925,7 +1124,7 @@ bcc_status_t BCC_Meas_GetRawValues(bcc_drv_config_t* const drvConfig,
     /* Read all the measurement registers.
     * Note: the order and number of registers conforms to the order of measured
     * values in Measurements array, see enumeration bcc_measurements_t. */
-    if (drvConfig->device[(uint8_t)cid - 1] == BCC_DEVICE_MC33771)
+    if (BCC_DEVICE_TYPE(drvConfig, cid) == BCC_DEVICE_MC33771)
     {
         error = BCC_Reg_Read(drvConfig, cid, BCC_REG_CC_NB_SAMPLES_ADDR,
                              BCC_MEAS_CNT, measurements);
@@ -983,7 +1182,7 @@ bcc_status_t BCC_Fault_GetStatus(bcc_drv_config_t* const drvConfig,
     BCC_MCU_Assert(drvConfig != NULL);
     BCC_MCU_Assert(status != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -1041,7 +1240,7 @@ bcc_status_t BCC_Fault_ClearStatus(bcc_drv_config_t* const drvConfig,
 
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -1051,7 +1250,9 @@ bcc_status_t BCC_Fault_ClearStatus(bcc_drv_config_t* const drvConfig,
         return BCC_STATUS_PARAM_RANGE;
     }
 
-    return BCC_Reg_Write(drvConfig, cid, REG_ADDR_MAP[statSel], 0x00U, NULL);
+    /* Not retried, a second write would clear a fault latched after the
+     * first one. */
+    return BCC_Reg_WriteOnce(drvConfig, cid, REG_ADDR_MAP[statSel], 0x00U, NULL);
 }
 
 /*FUNCTION**********************************************************************
@@ -1068,7 +1269,7 @@ bcc_status_t BCC_GPIO_SetOutput(bcc_drv_config_t* const drvConfig,
 
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt) || (gpioSel >= BCC_GPIO_INPUT_CNT))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)) || (gpioSel >= BCC_GPIO_INPUT_CNT))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -1099,7 +1300,7 @@ bcc_status_t BCC_CB_Enable(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
 {
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -1122,12 +1323,12 @@ bcc_status_t BCC_CB_SetIndividual(bcc_drv_config_t* const drvConfig,
 
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
 
-    if (cellIndex > (BCC_MAX_CELLS_DEV(drvConfig->device[(uint8_t)cid - 1]) - 1))
+    if (cellIndex > (BCC_MAX_CELLS_DEV(BCC_DEVICE_TYPE(drvConfig, cid)) - 1))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -1157,7 +1358,7 @@ bcc_status_t BCC_CB_Pause(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
 
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -1182,7 +1383,7 @@ bcc_status_t BCC_FuseMirror_Read(bcc_drv_config_t* const drvConfig,
     BCC_MCU_Assert(drvConfig != NULL);
     BCC_MCU_Assert(value != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -1217,7 +1418,7 @@ bcc_status_t BCC_FuseMirror_Write(bcc_drv_config_t* const drvConfig,
 
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -1275,12 +1476,12 @@ bcc_status_t BCC_GUID_Read(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
     BCC_MCU_Assert(drvConfig != NULL);
     BCC_MCU_Assert(guid != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
 
-    readAddr = (drvConfig->device[(uint8_t)cid - 1] == BCC_DEVICE_MC33771) ? addrMc33771 : addrMc33772;
+    readAddr = (BCC_DEVICE_TYPE(drvConfig, cid) == BCC_DEVICE_MC33771) ? addrMc33771 : addrMc33772;
 
     for (i = 0; i < 3; i++)
     {
@@ -1291,9 +1492,7 @@ bcc_status_t BCC_GUID_Read(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
         }
     }
 
-    *guid = (((uint64_t)(readData[0] & BCC_FUSE_TR_0_MASK)) << 21) |
-            (((uint64_t)(readData[1] & BCC_FUSE_TR_1_MASK)) << 5) |
-            ((uint64_t)(readData[2] & BCC_FUSE_TR_2_MASK));
+    *guid = BCC_GET_GUID(readData[0], readData[1], readData[2]);
 
     return BCC_STATUS_SUCCESS;
 }
@@ -1314,7 +1513,7 @@ bcc_status_t BCC_EEPROM_Read(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
     BCC_MCU_Assert(drvConfig != NULL);
     BCC_MCU_Assert(data != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -1374,7 +1573,7 @@ bcc_status_t BCC_EEPROM_Write(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
 
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -1417,3 +1616,201 @@ bcc_status_t BCC_EEPROM_Write(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
 
     return BCC_STATUS_SUCCESS;
 }
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : BCC_Inventory_Read
+ * Description   : This function reads identification data of a BCC device
+ *                 and stores them to the device inventory together with CRC.
+ *
+ *END**************************************************************************/
+bcc_status_t BCC_Inventory_Read(bcc_drv_config_t* const drvConfig, bcc_cid_t cid)
+{
+    bcc_inventory_t *inv;
+    uint8_t fuseCnt;
+    uint8_t trAddr;
+    uint8_t i;
+    bcc_status_t error;
+
+    BCC_MCU_Assert(drvConfig != NULL);
+
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    inv = &(drvConfig->drvData.inventory[(uint8_t)cid - 1U]);
+    inv->fuseCnt = 0U;
+
+    error = BCC_Reg_Read(drvConfig, cid, BCC_REG_SILICON_REV_ADDR, 1U, &(inv->siliconRev));
+    if (error != BCC_STATUS_SUCCESS)
+    {
+        return error;
+    }
+
+    if (BCC_DEVICE_TYPE(drvConfig, cid) == BCC_DEVICE_MC33771)
+    {
+        fuseCnt = BCC_LAST_FUSE_ADDR_MC33771B + 1U;
+        trAddr = BCC_FUSE_TR_0_ADDR_MC33771;
+    }
+    else
+    {
+        fuseCnt = BCC_LAST_FUSE_ADDR_MC33772B + 1U;
+        trAddr = BCC_FUSE_TR_0_ADDR_MC33772;
+    }
+
+    /* Fuse mirror is accessed indirectly: FUSE_MIRROR_DATA shows only the
+     * register selected by FUSE_MIRROR_CTRL[FMR_ADDR], and the address is not
+     * incremented. A burst (BCC_Reg_Read with regCnt > 1) from
+     * FUSE_MIRROR_DATA would return FUSE_MIRROR_CTRL and the following
+     * registers instead of the next fuses, so each register needs its own
+     * select and read. */
+    for (i = 0U; i < fuseCnt; i++)
+    {
+        error = BCC_FuseMirror_Read(drvConfig, cid, i, &(inv->fuse[i]));
+        if (error != BCC_STATUS_SUCCESS)
+        {
+            return error;
+        }
+    }
+
+    /* Traceability registers are part of the fuse mirror. */
+    inv->guid = BCC_GET_GUID(inv->fuse[trAddr], inv->fuse[trAddr + 1U],
+            inv->fuse[trAddr + 2U]);
+    inv->fuseCnt = fuseCnt;
+    inv->crc = BCC_CalcDataCRC((const uint8_t *)inv, BCC_INV_CRC_LEN);
+
+    return BCC_STATUS_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : BCC_Inventory_IsValid
+ * Description   : This function checks CRC of the device inventory.
+ *
+ *END**************************************************************************/
+bool BCC_Inventory_IsValid(const bcc_drv_config_t* const drvConfig, bcc_cid_t cid)
+{
+    const bcc_inventory_t *inv;
+
+    BCC_MCU_Assert(drvConfig != NULL);
+
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
+    {
+        return false;
+    }
+
+    inv = &(drvConfig->drvData.inventory[(uint8_t)cid - 1U]);
+
+    return (inv->fuseCnt != 0U) &&
+            (inv->crc == BCC_CalcDataCRC((const uint8_t *)inv, BCC_INV_CRC_LEN));
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : BCC_Inventory_GetGuid
+ * Description   : This function returns GUID stored in the device inventory.
+ *
+ *END**************************************************************************/
+bcc_status_t BCC_Inventory_GetGuid(const bcc_drv_config_t* const drvConfig,
+    bcc_cid_t cid, uint64_t* const guid)
+{
+    BCC_MCU_Assert(drvConfig != NULL);
+    BCC_MCU_Assert(guid != NULL);
+
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    *guid = drvConfig->drvData.inventory[(uint8_t)cid - 1U].guid;
+
+    return BCC_STATUS_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : BCC_Inventory_GetFuse
+ * Description   : This function returns content of a fuse mirror register
+ *                 stored in the device inventory.
+ *
+ *END**************************************************************************/
+bcc_status_t BCC_Inventory_GetFuse(const bcc_drv_config_t* const drvConfig,
+    bcc_cid_t cid, uint8_t fuseAddr, uint16_t* const value)
+{
+    const bcc_inventory_t *inv;
+
+    BCC_MCU_Assert(drvConfig != NULL);
+    BCC_MCU_Assert(value != NULL);
+
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    inv = &(drvConfig->drvData.inventory[(uint8_t)cid - 1U]);
+    if (fuseAddr >= inv->fuseCnt)
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    *value = inv->fuse[fuseAddr];
+
+    return BCC_STATUS_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : BCC_Inventory_GetSiliconRev
+ * Description   : This function returns content of SILICON_REV register stored
+ *                 in the device inventory.
+ *
+ *END**************************************************************************/
+bcc_status_t BCC_Inventory_GetSiliconRev(const bcc_drv_config_t* const drvConfig,
+    bcc_cid_t cid, uint16_t* const siliconRev)
+{
+    BCC_MCU_Assert(drvConfig != NULL);
+    BCC_MCU_Assert(siliconRev != NULL);
+
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    *siliconRev = drvConfig->drvData.inventory[(uint8_t)cid - 1U].siliconRev;
+
+    return BCC_STATUS_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : BCC_IsDegraded
+ * Description   : This function returns true if a BCC device is marked as
+ *                 degraded.
+ *
+ *END**************************************************************************/
+bool BCC_IsDegraded(const bcc_drv_config_t* const drvConfig, bcc_cid_t cid)
+{
+    BCC_MCU_Assert(drvConfig != NULL);
+
+    if ((cid == BCC_CID_UNASSIG) || (((uint8_t)cid) > BCC_DEVICES_CNT(drvConfig)))
+    {
+        return false;
+    }
+
+    return (drvConfig->drvData.degradedMap & (1U << ((uint8_t)cid - 1U))) != 0U;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : BCC_GetRecoveryStats
+ * Description   : This function returns statistics of the communication error
+ *                 recovery.
+ *
+ *END**************************************************************************/
+const bcc_recovery_stats_t* BCC_GetRecoveryStats(const bcc_drv_config_t* const drvConfig)
+{
+    BCC_MCU_Assert(drvConfig != NULL);
+
+    return &(drvConfig->drvData.recStats);
+}
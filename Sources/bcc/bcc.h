@@ -59,6 +59,61 @@
  *  defined, little-endian is used ([0] CRC, ..., [3] DATA_L, [4] DATA_H) */
 #define BCC_MSG_BIGEND
 
+/*! @brief Use \#define BCC_FIXED_TOPOLOGY if the driver is used with one known
+ *  topology only (e.g. 12 x MC33771 in TPL mode). Communication mode, BCC
+ *  device type, number of devices and number of cells are then taken from
+ *  BCC_FIXED_* macros below instead of bcc_drv_config_t, so the compiler
+ *  removes the branches which are not used by the topology. It is a code size
+ *  option (about 3 % of the driver, see tests/Makefile), not a speed option:
+ *  a measurement read is dominated by the transfers and is not faster. All
+ *  devices have the same type and cell count in this case. BCC_Init checks
+ *  that the content of bcc_drv_config_t matches the fixed topology.
+ *  The BCC_FIXED_* defaults below describe the demo board (1 x MC33771,
+ *  14 cells, SPI), common.h fails to compile if they differ from its device
+ *  and communication selection. Other topologies override them by compiler
+ *  options, which then apply to the driver and the application alike.
+ *  If BCC_FIXED_TOPOLOGY is not defined, the topology is read from
+ *  bcc_drv_config_t at runtime. */
+//#define BCC_FIXED_TOPOLOGY
+
+/*! @brief Number of retries of a register read/write which failed due to
+ *  a communication error (CRC, RC, TAG ID, null response or timeout).
+ *  Zero disables the recovery.
+ *  Writes which get no response by design (BCC_SoftwareReset, BCC_Sleep) and
+ *  writes which are not safe to repeat (SOC in BCC_Meas_StartConversion,
+ *  BCC_Fault_ClearStatus) are sent once, without retries, and do not count
+ *  as failures of the device. */
+#define BCC_RETRY_CNT_MAX         3U
+
+/*! @brief Wait time before the first retry in [us]. It is doubled with each
+ *  following retry (exponential backoff). */
+#define BCC_RETRY_BACKOFF_US      50U
+
+/*! @brief Number of consecutive failed operations (after all retries) after
+ *  which a device is marked as degraded. Operations with a degraded device are
+ *  not retried, so a broken device does not slow down the whole scan. The
+ *  flag is cleared by the first successful operation. */
+#define BCC_DEGRADED_FAIL_CNT     3U
+
+#ifdef BCC_FIXED_TOPOLOGY
+/*! @brief Communication mode of the fixed topology (bcc_mode_t). */
+#ifndef BCC_FIXED_COMM_MODE
+#define BCC_FIXED_COMM_MODE       BCC_MODE_SPI
+#endif
+/*! @brief Type of all BCC devices of the fixed topology (bcc_device_t). */
+#ifndef BCC_FIXED_DEVICE
+#define BCC_FIXED_DEVICE          BCC_DEVICE_MC33771
+#endif
+/*! @brief Number of BCC devices of the fixed topology. */
+#ifndef BCC_FIXED_DEVICES_CNT
+#define BCC_FIXED_DEVICES_CNT     1U
+#endif
+/*! @brief Number of cells connected to each BCC device of the fixed topology. */
+#ifndef BCC_FIXED_CELL_CNT
+#define BCC_FIXED_CELL_CNT        14U
+#endif
+#endif
+
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
@@ -88,6 +143,46 @@
 #define BCC_MAX_CELLS_DEV(dev)                             \
     ((dev == BCC_DEVICE_MC33771) ? BCC_MAX_CELLS_MC33771 : BCC_MAX_CELLS_MC33772)
 
+/*! @brief Cell map for 7 cells connected to MC33771. */
+#define BCC_CM_MC33771_7CELLS     0x380FU
+/*! @brief Cell map for 3 cells connected to MC33772. */
+#define BCC_CM_MC33772_3CELLS     0x0023U
+
+/*!
+ * @brief Returns bit map of used cells. Cells above the minimal count are
+ * connected from the top of the middle part of the map (see BCC datasheet).
+ *
+ * @param dev BCC device type.
+ * @param cellCnt Number of connected cells (in range of the device).
+ * @return Cell map.
+ */
+#define BCC_CELL_MAP_CALC(dev, cellCnt)                                      \
+    (((dev) == BCC_DEVICE_MC33771) ?                                         \
+     (BCC_CM_MC33771_7CELLS | (uint16_t)(((1U << ((cellCnt) - BCC_MIN_CELLS_MC33771)) - 1U) \
+            << (11U - ((cellCnt) - BCC_MIN_CELLS_MC33771)))) :              \
+     (BCC_CM_MC33772_3CELLS | (uint16_t)(((1U << ((cellCnt) - BCC_MIN_CELLS_MC33772)) - 1U) \
+            << (5U - ((cellCnt) - BCC_MIN_CELLS_MC33772)))))
+
+/*!
+ * @brief Topology accessors. They return constants if BCC_FIXED_TOPOLOGY is
+ * defined, values from the driver configuration otherwise.
+ *
+ * @param drvConfig Pointer to driver instance configuration.
+ * @param cid Cluster Identification Address.
+ */
+#ifdef BCC_FIXED_TOPOLOGY
+#define BCC_COMM_MODE(drvConfig)          (BCC_FIXED_COMM_MODE)
+#define BCC_DEVICES_CNT(drvConfig)        ((uint8_t)BCC_FIXED_DEVICES_CNT)
+#define BCC_DEVICE_TYPE(drvConfig, cid)   (BCC_FIXED_DEVICE)
+#define BCC_CELL_MAP(drvConfig, cid)      \
+    ((uint16_t)BCC_CELL_MAP_CALC(BCC_FIXED_DEVICE, BCC_FIXED_CELL_CNT))
+#else
+#define BCC_COMM_MODE(drvConfig)          ((drvConfig)->commMode)
+#define BCC_DEVICES_CNT(drvConfig)        ((drvConfig)->devicesCnt)
+#define BCC_DEVICE_TYPE(drvConfig, cid)   ((drvConfig)->device[(uint8_t)(cid) - 1U])
+#define BCC_CELL_MAP(drvConfig, cid)      ((drvConfig)->drvData.cellMap[(uint8_t)(cid) - 1U])
+#endif
+
 /*!
  * @brief Returns a non-zero value when desired cell (cellNo) is connected
  * to the BCC specified by CID. Otherwise returns zero.
@@ -99,7 +194,7 @@
  * @return Non-zero value if cell is connected, zero otherwise.
  */
 #define BCC_IS_CELL_CONN(drvConfig, cid, cellNo) \
-    ((drvConfig)->drvData.cellMap[(cid) - 1U] & (1U << ((cellNo) - 1U)))
+    (BCC_CELL_MAP(drvConfig, cid) & (1U << ((cellNo) - 1U)))
 
 /*! @brief Maximal frequency of SPI clock in SPI mode. */
 #define BCC_SPI_FREQ_MC3377x_MAX  4200000U
@@ -138,6 +233,13 @@
 /*! @brief Number of GPIO/temperature sensor inputs. */
 #define BCC_GPIO_INPUT_CNT        7U
 
+/*! @brief Address of the last fuse mirror register of MC33771B. */
+#define BCC_LAST_FUSE_ADDR_MC33771B   0x1AU
+/*! @brief Address of the last fuse mirror register of MC33772B. */
+#define BCC_LAST_FUSE_ADDR_MC33772B   0x12U
+/*! @brief Number of fuse mirror registers stored in the device inventory. */
+#define BCC_INV_FUSE_CNT              (BCC_LAST_FUSE_ADDR_MC33771B + 1U)
+
 /*!
  * @brief Calculates ISENSE value in [uV]. Resolution is
  * 0.6 uV/LSB. Result is int32_t type.
@@ -337,6 +439,39 @@ typedef enum
  * @addtogroup struct_group
  * @{
  */
+/*!
+ * @brief Device inventory (identification data of a BCC device).
+ *
+ * It is read once in BCC_Init, because the content does not change at
+ * runtime. The structure is protected by CRC, see BCC_Inventory_IsValid.
+ */
+typedef struct
+{
+    uint64_t guid;                   /*!< Unique ID (37 bits), see BCC_GUID_Read. */
+    uint16_t fuse[BCC_INV_FUSE_CNT]; /*!< Content of fuse mirror registers (traceability data
+                                          included). */
+    uint16_t siliconRev;             /*!< Content of SILICON_REV register. */
+    uint8_t fuseCnt;                 /*!< Number of valid items in fuse array. Zero if
+                                          the inventory was not read yet. */
+    uint8_t crc;                     /*!< CRC of the previous members. */
+} bcc_inventory_t;
+
+/*!
+ * @brief Statistics of the communication error recovery.
+ */
+typedef struct
+{
+    uint32_t retries;      /*!< Number of retried operations. */
+    uint32_t crcErrors;    /*!< Number of CRC errors. */
+    uint32_t rcTagErrors;  /*!< Number of Rolling Counter and TAG ID mismatches. */
+    uint32_t nullResps;    /*!< Number of null responses. */
+    uint32_t timeouts;     /*!< Number of communication timeouts. */
+    uint32_t resyncs;      /*!< Number of Rolling Counter resynchronizations. */
+    uint32_t wakeUps;      /*!< Number of wake-ups of not responding devices. */
+    uint32_t failures;     /*!< Number of operations failed after all retries. */
+    uint32_t degraded;     /*!< Number of transitions of a device to degraded state. */
+} bcc_recovery_stats_t;
+
 /*!
  * @brief Driver internal data.
  *
@@ -349,6 +484,11 @@ typedef struct
     uint8_t rcTbl[BCC_DEVICE_CNT_MAX];    /*!< Rolling counter index (0-4). */
     uint8_t tagId[BCC_DEVICE_CNT_MAX];    /*!< TAG IDs of BCC devices. */
     uint8_t rxBuf[BCC_RX_BUF_SIZE_TPL];   /*!< Buffer for receiving data in TPL mode. */
+    bcc_inventory_t inventory[BCC_DEVICE_CNT_MAX]; /*!< Device inventory of BCC devices. */
+    bcc_recovery_stats_t recStats;        /*!< Statistics of the error recovery. */
+    uint8_t failCnt[BCC_DEVICE_CNT_MAX];  /*!< Consecutive failed operations of each BCC device. */
+    uint16_t degradedMap;                 /*!< Bit map of degraded BCC devices (bit 0 for CID 1). */
+    bool recoveryEn;                      /*!< Error recovery enabled (after CID assignment). */
 } bcc_drv_data_t;
 
 /*!
@@ -790,6 +930,94 @@ bcc_status_t BCC_EEPROM_Read(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
 bcc_status_t BCC_EEPROM_Write(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
     uint8_t addr, uint8_t data);
 
+/*!
+ * @brief This function returns true if a BCC device is marked as degraded, i.e.
+ * BCC_DEGRADED_FAIL_CNT consecutive operations with the device failed even
+ * after retries.
+ *
+ * @param drvConfig Pointer to driver instance configuration.
+ * @param cid Cluster Identification Address.
+ *
+ * @return True if the device is degraded.
+ */
+bool BCC_IsDegraded(const bcc_drv_config_t* const drvConfig, bcc_cid_t cid);
+
+/*!
+ * @brief This function returns statistics of the communication error recovery.
+ *
+ * @param drvConfig Pointer to driver instance configuration.
+ *
+ * @return Pointer to the statistics.
+ */
+const bcc_recovery_stats_t* BCC_GetRecoveryStats(const bcc_drv_config_t* const drvConfig);
+
+/*!
+ * @brief This function reads identification data of a BCC device (content of
+ * fuse mirror including GUID and SILICON_REV register) and stores them to the
+ * device inventory together with CRC.
+ *
+ * It is called for all devices by BCC_Init, which does not fail when the
+ * read fails. Call it again when BCC_Inventory_IsValid reports missing or
+ * corrupted data.
+ *
+ * @param drvConfig Pointer to driver instance configuration.
+ * @param cid Cluster Identification Address.
+ *
+ * @return bcc_status_t Error code.
+ */
+bcc_status_t BCC_Inventory_Read(bcc_drv_config_t* const drvConfig, bcc_cid_t cid);
+
+/*!
+ * @brief This function checks CRC of the device inventory.
+ *
+ * @param drvConfig Pointer to driver instance configuration.
+ * @param cid Cluster Identification Address.
+ *
+ * @return True if the inventory was read and it is not corrupted.
+ */
+bool BCC_Inventory_IsValid(const bcc_drv_config_t* const drvConfig, bcc_cid_t cid);
+
+/*!
+ * @brief This function returns GUID stored in the device inventory. No
+ * communication with the device is performed.
+ *
+ * @param drvConfig Pointer to driver instance configuration.
+ * @param cid Cluster Identification Address.
+ * @param guid Pointer to memory where 37b unique ID will be stored.
+ *
+ * @return bcc_status_t Error code.
+ */
+bcc_status_t BCC_Inventory_GetGuid(const bcc_drv_config_t* const drvConfig,
+    bcc_cid_t cid, uint64_t* const guid);
+
+/*!
+ * @brief This function returns content of a fuse mirror register stored in
+ * the device inventory. No communication with the device is performed.
+ *
+ * @param drvConfig Pointer to driver instance configuration.
+ * @param cid Cluster Identification Address.
+ * @param fuseAddr Address of a fuse mirror register.
+ * @param value Pointer to memory where the content of register will be stored.
+ *
+ * @return bcc_status_t Error code.
+ */
+bcc_status_t BCC_Inventory_GetFuse(const bcc_drv_config_t* const drvConfig,
+    bcc_cid_t cid, uint8_t fuseAddr, uint16_t* const value);
+
+/*!
+ * @brief This function returns content of SILICON_REV register stored in
+ * the device inventory. No communication with the device is performed.
+ *
+ * @param drvConfig Pointer to driver instance configuration.
+ * @param cid Cluster Identification Address.
+ * @param siliconRev Pointer to memory where the content of register will be
+ *                   stored.
+ *
+ * @return bcc_status_t Error code.
+ */
+bcc_status_t BCC_Inventory_GetSiliconRev(const bcc_drv_config_t* const drvConfig,
+    bcc_cid_t cid, uint16_t* const siliconRev);
+
 /*******************************************************************************
  * Platform specific functions
  ******************************************************************************/
@@ -271,3 +271,27 @@ bcc_status_t BCC_CheckRcTagId(bcc_device_t devType, const uint8_t *resp,
 
     return BCC_STATUS_SUCCESS;
 }
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : BCC_CalcDataCRC
+ * Description   : This function calculates CRC of a memory block.
+ *
+ *END**************************************************************************/
+uint8_t BCC_CalcDataCRC(const uint8_t *data, uint16_t dataLen)
+{
+    uint8_t crc;
+    uint16_t dataIdx;
+
+    BCC_MCU_Assert(data != NULL);
+
+    /* Expanding value. */
+    crc = 0x42U;
+
+    for (dataIdx = 0U; dataIdx < dataLen; dataIdx++)
+    {
+        crc = BCC_CRC_TABLE[crc ^ data[dataIdx]];
+    }
+
+    return crc;
+}
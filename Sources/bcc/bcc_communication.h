@@ -175,6 +175,17 @@ bcc_status_t BCC_CheckCRC(const uint8_t *resp);
 bcc_status_t BCC_CheckRcTagId(bcc_device_t devType, const uint8_t *resp,
         uint8_t rc, uint8_t tagId);
 
+/*!
+ * @brief This function calculates CRC (the same polynomial as the frame CRC)
+ * of a memory block. It is intended for integrity check of data stored in RAM.
+ *
+ * @param data Pointer to the memory block.
+ * @param dataLen Length of the memory block in bytes.
+ *
+ * @return Computed CRC value.
+ */
+uint8_t BCC_CalcDataCRC(const uint8_t *data, uint16_t dataLen);
+
 /*! @} */
 
 #endif /* __BCC_COMM_H__ */
@@ -65,7 +65,7 @@ bcc_status_t BCC_Reg_ReadTpl(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
     BCC_MCU_Assert(drvConfig != NULL);
     BCC_MCU_Assert(regVal != NULL);
 
-    if (((uint8_t)cid > drvConfig->devicesCnt) || (regAddr > BCC_MAX_REG_ADDR) ||
+    if (((uint8_t)cid > BCC_DEVICES_CNT(drvConfig)) || (regAddr > BCC_MAX_REG_ADDR) ||
         (regCnt == 0U) || ((regAddr + regCnt - 1U) > BCC_MAX_REG_ADDR))
     {
         return BCC_STATUS_PARAM_RANGE;
@@ -107,7 +107,7 @@ bcc_status_t BCC_Reg_ReadTpl(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
         if (cid != BCC_CID_UNASSIG)
         {
             /* RC and TAG ID are not intended for global messages. */
-            error = BCC_CheckRcTagId(drvConfig->device[(uint8_t)cid - 1U], rxBuf, rc,
+            error = BCC_CheckRcTagId(BCC_DEVICE_TYPE(drvConfig, cid), rxBuf, rc,
                                      drvConfig->drvData.tagId[(uint8_t)cid - 1U]);
             if (error != BCC_STATUS_SUCCESS)
             {
@@ -140,7 +140,7 @@ bcc_status_t BCC_Reg_WriteTpl(bcc_drv_config_t* const drvConfig, bcc_cid_t cid,
 
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if (((uint8_t)cid > drvConfig->devicesCnt) || (regAddr > BCC_MAX_REG_ADDR))
+    if (((uint8_t)cid > BCC_DEVICES_CNT(drvConfig)) || (regAddr > BCC_MAX_REG_ADDR))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
@@ -233,7 +233,7 @@ bcc_status_t BCC_VerifyComTpl(bcc_drv_config_t* const drvConfig, bcc_cid_t cid)
 
     BCC_MCU_Assert(drvConfig != NULL);
 
-    if ((cid == BCC_CID_UNASSIG) || ((uint8_t)cid > drvConfig->devicesCnt))
+    if ((cid == BCC_CID_UNASSIG) || ((uint8_t)cid > BCC_DEVICES_CNT(drvConfig)))
     {
         return BCC_STATUS_PARAM_RANGE;
     }
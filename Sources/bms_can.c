@@ -0,0 +1,125 @@
+/*!
+ * @file bms_can.c
+ *
+ * Bit packing of the CAN message set of the battery pack monitor, see
+ * bms_can.h.
+ */
+
+#include <string.h>
+#include "bms_can.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief True for signed integer types. */
+#define BMS_CAN_IS_SIGNED(type)   (((type)-1) < ((type)0))
+
+/* Encoding and decoding of one signal (or signal array) of msg. */
+#define BMS_CAN_ENCODE(type, name, start, length) \
+    bmsCanPutBits(data, (start), (length), (uint32_t)msg->name);
+#define BMS_CAN_ENCODE_ARRAY(type, name, count, start, length) \
+    for (i = 0U; i < (count); i++) \
+    { \
+        bmsCanPutBits(data, (uint8_t)((start) + (i * (length))), (length), \
+            (uint32_t)msg->name[i]); \
+    }
+#define BMS_CAN_DECODE(type, name, start, length) \
+    msg->name = (type)bmsCanGetBits(data, (start), (length), \
+        BMS_CAN_IS_SIGNED(type));
+#define BMS_CAN_DECODE_ARRAY(type, name, count, start, length) \
+    for (i = 0U; i < (count); i++) \
+    { \
+        msg->name[i] = (type)bmsCanGetBits(data, \
+            (uint8_t)((start) + (i * (length))), (length), \
+            BMS_CAN_IS_SIGNED(type)); \
+    }
+
+/*! @brief Encode and decode functions of a message. */
+#define BMS_CAN_CODEC(Name, name, SIGNALS) \
+    void bmsCanEncode##Name(const bms_can_##name##_t* msg, uint8_t data[]) \
+    { \
+        uint8_t i; \
+        (void)i; \
+        memset(data, 0, BMS_CAN_DLC); \
+        SIGNALS(BMS_CAN_ENCODE, BMS_CAN_ENCODE_ARRAY) \
+    } \
+    void bmsCanDecode##Name(const uint8_t data[], bms_can_##name##_t* msg) \
+    { \
+        uint8_t i; \
+        (void)i; \
+        SIGNALS(BMS_CAN_DECODE, BMS_CAN_DECODE_ARRAY) \
+    }
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : bmsCanPutBits
+ * Description   : This function writes a signal to frame data.
+ *
+ *END**************************************************************************/
+void bmsCanPutBits(uint8_t data[], uint8_t start, uint8_t length,
+    uint32_t value)
+{
+    uint8_t idx, shift, cnt;
+    uint8_t mask;
+
+    while (length > 0U)
+    {
+        idx = start >> 3U;
+        shift = start & 7U;
+        cnt = 8U - shift;
+        if (cnt > length)
+        {
+            cnt = length;
+        }
+        mask = (uint8_t)(((1U << cnt) - 1U) << shift);
+
+        data[idx] = (uint8_t)((data[idx] & ~mask) | (((uint8_t)value << shift) & mask));
+
+        value >>= cnt;
+        start += cnt;
+        length -= cnt;
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : bmsCanGetBits
+ * Description   : This function reads a signal from frame data.
+ *
+ *END**************************************************************************/
+uint32_t bmsCanGetBits(const uint8_t data[], uint8_t start, uint8_t length,
+    bool isSigned)
+{
+    uint32_t value = 0U;
+    uint8_t pos = 0U;
+    uint8_t idx, shift, cnt;
+
+    while (pos < length)
+    {
+        idx = (uint8_t)(start + pos) >> 3U;
+        shift = (uint8_t)(start + pos) & 7U;
+        cnt = 8U - shift;
+        if (cnt > (length - pos))
+        {
+            cnt = length - pos;
+        }
+
+        value |= (uint32_t)((data[idx] >> shift) & ((1U << cnt) - 1U)) << pos;
+        pos += cnt;
+    }
+
+    if (isSigned && (length < 32U) && ((value >> (length - 1U)) & 1U))
+    {
+        value |= ~(uint32_t)0U << length;
+    }
+
+    return value;
+}
+
+/* bmsCanEncode<Name> and bmsCanDecode<Name> of all messages. */
+BMS_CAN_MESSAGES(BMS_CAN_CODEC)
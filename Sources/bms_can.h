@@ -0,0 +1,214 @@
+/*!
+ * @file bms_can.h
+ *
+ * CAN message set of the battery pack monitor (S32K144 + MC3377x devices),
+ * shared by the S32K144 firmware and the Arduino MCP2515 nodes. The file
+ * pair bms_can.h/bms_can.c is plain C99 without dependencies, copies in the
+ * sketch folders must be kept identical to Sources/.
+ *
+ * Each message is defined once below as a list of signals; the C structure
+ * and the bit-packing encode/decode functions are generated from the list
+ * (bmsCanEncode<Message>, bmsCanDecode<Message>). Signals are unsigned or
+ * two's complement integers, little endian (Intel) bit order: start bit 0 is
+ * the least significant bit of data byte 0. Units are given per signal.
+ *
+ * All messages use standard identifiers BMS_CAN_ID_BASE + offset and 8 data
+ * bytes. Cells, temperatures and faults are multiplexed, the first signal
+ * selects the content:
+ *  - CELLS:  mux g carries cells 4g..4g+3 of the pack, cell numbering
+ *            (cid - 1) * BMS_CAN_CELLS_PER_DEV + (cell - 1), i.e.
+ *            BMS_CAN_CELL_FRAMES frames for 15 x 14 cells.
+ *  - TEMPS:  one frame per device (AN0..AN6).
+ *  - FAULTS: one frame per device.
+ *
+ * Bus load of the full pack state (15 devices) sent every
+ * BMS_CAN_PERIOD_MS: 1 + 1 + 53 + 15 + 15 = 85 frames, i.e. 850 frames/s.
+ * A standard frame with 8 data bytes takes 111 bits including the
+ * interframe space, at most 135 bits with stuff bits, so the pack state
+ * takes 94 to 115 kbit/s, 19 to 23 % of a 500 kbit/s bus.
+ */
+
+#ifndef BMS_CAN_H_
+#define BMS_CAN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Identifier of the first message. The whole set fits in
+ * BMS_CAN_ID_BASE..BMS_CAN_ID_BASE + 0x1F (acceptance mask BMS_CAN_ID_MASK). */
+#define BMS_CAN_ID_BASE           0x300U
+/*! @brief Acceptance mask of the message set. */
+#define BMS_CAN_ID_MASK           0x7E0U
+
+/* Identifiers. Lower identifiers win the arbitration. */
+#define BMS_CAN_ID_PACK_STATUS    (BMS_CAN_ID_BASE + 0x00U)
+#define BMS_CAN_ID_CELL_STATS     (BMS_CAN_ID_BASE + 0x01U)
+#define BMS_CAN_ID_FAULTS         (BMS_CAN_ID_BASE + 0x10U)
+#define BMS_CAN_ID_TEMPS          (BMS_CAN_ID_BASE + 0x11U)
+#define BMS_CAN_ID_CELLS          (BMS_CAN_ID_BASE + 0x12U)
+
+/*! @brief Data length of all messages. */
+#define BMS_CAN_DLC               8U
+
+/*! @brief Period of the message set in [ms]. */
+#define BMS_CAN_PERIOD_MS         100U
+
+/* Pack topology covered by the message set. */
+#define BMS_CAN_DEVICES_MAX       15U
+#define BMS_CAN_CELLS_PER_DEV     14U
+#define BMS_CAN_TEMPS_PER_DEV     7U
+#define BMS_CAN_CELLS_PER_FRAME   4U
+#define BMS_CAN_CELL_FRAMES \
+    (((BMS_CAN_DEVICES_MAX * BMS_CAN_CELLS_PER_DEV) + BMS_CAN_CELLS_PER_FRAME - 1U) / \
+     BMS_CAN_CELLS_PER_FRAME)
+/*! @brief Maximal number of frames of the message set. */
+#define BMS_CAN_FRAMES_MAX \
+    (2U + BMS_CAN_CELL_FRAMES + (2U * BMS_CAN_DEVICES_MAX))
+
+/*! @brief Cell voltage of a cell which is not connected. */
+#define BMS_CAN_CELL_NA           0U
+/*! @brief Temperature of an input which is not measured (or out of range). */
+#define BMS_CAN_TEMP_NA           (-128)
+
+/* Bits of the PACK_STATUS faults signal. */
+#define BMS_CAN_FLT_CELL_OV       0x01U   /*!< A cell overvoltage. */
+#define BMS_CAN_FLT_CELL_UV       0x02U   /*!< A cell undervoltage. */
+#define BMS_CAN_FLT_OT_UT         0x04U   /*!< An over/undertemperature. */
+#define BMS_CAN_FLT_DEVICE        0x08U   /*!< Other fault of a device
+                                               (FAULT1..3 status). */
+#define BMS_CAN_FLT_COMM          0x10U   /*!< A device did not respond, its
+                                               data are the last known. */
+
+/*
+ * Signal lists. X(type, name, start, length) declares a scalar signal,
+ * XA(type, name, count, start, length) an array of count consecutive
+ * signals. Signed types are sign extended by decoding.
+ */
+
+/*! @brief PACK_STATUS: pack summary. */
+#define BMS_CAN_PACK_STATUS_SIGNALS(X, XA) \
+    X(uint16_t, voltage,   0, 16)   /* Stack voltage sum [0.1 V]. */ \
+    X(int16_t,  current,  16, 16)   /* Current [10 mA], ISENSE of CID 1. */ \
+    X(uint8_t,  soc,      32,  8)   /* State of charge [0.5 %]. */ \
+    X(uint8_t,  faults,   40,  8)   /* BMS_CAN_FLT_* bits. */ \
+    X(int8_t,   tempMax,  48,  8)   /* Highest temperature [degC]. */ \
+    X(uint8_t,  counter,  56,  4)   /* Incremented with each message set. */ \
+    X(uint8_t,  devices,  60,  4)   /* Number of devices. */
+
+/*! @brief CELL_STATS: cell voltage statistics of the pack. */
+#define BMS_CAN_CELL_STATS_SIGNALS(X, XA) \
+    X(uint16_t, minMv,     0, 16)   /* Minimal cell voltage [mV]. */ \
+    X(uint16_t, maxMv,    16, 16)   /* Maximal cell voltage [mV]. */ \
+    X(uint16_t, meanMv,   32, 16)   /* Mean cell voltage [mV]. */ \
+    X(uint8_t,  stdDevMv, 48,  8)   /* Standard deviation [mV], 255 max. */ \
+    X(uint8_t,  cellCnt,  56,  8)   /* Number of connected cells. */
+
+/*! @brief FAULTS: fault registers of a device. */
+#define BMS_CAN_FAULTS_SIGNALS(X, XA) \
+    X(uint8_t,  device,    0,  4)   /* CID - 1. */ \
+    X(uint16_t, cellOv,    4, 14)   /* CELL_OV_FLT, bit 0: cell 1. */ \
+    X(uint16_t, cellUv,   18, 14)   /* CELL_UV_FLT, bit 0: cell 1. */ \
+    X(uint16_t, fault1,   32, 16)   /* FAULT1_STATUS. */ \
+    X(uint16_t, fault2,   48, 16)   /* FAULT2_STATUS. */
+
+/*! @brief TEMPS: temperatures of a device. */
+#define BMS_CAN_TEMPS_SIGNALS(X, XA) \
+    X(uint8_t,  device,    0,  8)   /* CID - 1. */ \
+    XA(int8_t,  temp, BMS_CAN_TEMPS_PER_DEV, 8, 8) /* AN0..AN6 [degC]. */
+
+/*! @brief CELLS: four cell voltages. */
+#define BMS_CAN_CELLS_SIGNALS(X, XA) \
+    X(uint8_t,  mux,       0,  8)   /* Frame index g (cells 4g..4g+3). */ \
+    XA(uint16_t, cellMv, BMS_CAN_CELLS_PER_FRAME, 8, 14) /* Cell voltages [mV]. */
+
+/*! @brief The message set: M(Name, name, SIGNALS). */
+#define BMS_CAN_MESSAGES(M) \
+    M(PackStatus, pack_status, BMS_CAN_PACK_STATUS_SIGNALS) \
+    M(CellStats,  cell_stats,  BMS_CAN_CELL_STATS_SIGNALS) \
+    M(Faults,     faults,      BMS_CAN_FAULTS_SIGNALS) \
+    M(Temps,      temps,       BMS_CAN_TEMPS_SIGNALS) \
+    M(Cells,      cells,       BMS_CAN_CELLS_SIGNALS)
+
+/*******************************************************************************
+ * Structure definition
+ ******************************************************************************/
+
+/*! @cond Generated structure members. */
+#define BMS_CAN_MEMBER(type, name, start, length)              type name;
+#define BMS_CAN_MEMBER_ARRAY(type, name, count, start, length) type name[count];
+#define BMS_CAN_STRUCT(Name, name, SIGNALS) \
+    typedef struct \
+    { \
+        SIGNALS(BMS_CAN_MEMBER, BMS_CAN_MEMBER_ARRAY) \
+    } bms_can_##name##_t;
+/*! @endcond */
+
+/* bms_can_pack_status_t, bms_can_cell_stats_t, bms_can_faults_t,
+ * bms_can_temps_t and bms_can_cells_t. */
+BMS_CAN_MESSAGES(BMS_CAN_STRUCT)
+
+/*!
+ * @brief CAN frame of the message set.
+ */
+typedef struct
+{
+    uint16_t id;                  /*!< Standard identifier. */
+    uint8_t data[BMS_CAN_DLC];    /*!< Data, BMS_CAN_DLC bytes. */
+} bms_can_frame_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief Encode and decode functions of each message:
+ *
+ * void bmsCanEncode<Name>(const bms_can_<name>_t* msg, uint8_t data[]);
+ * void bmsCanDecode<Name>(const uint8_t data[], bms_can_<name>_t* msg);
+ *
+ * Encoding writes all BMS_CAN_DLC bytes (unused bits are zero) and keeps
+ * only the lowest length bits of each value.
+ */
+#define BMS_CAN_PROTOTYPES(Name, name, SIGNALS) \
+    void bmsCanEncode##Name(const bms_can_##name##_t* msg, uint8_t data[]); \
+    void bmsCanDecode##Name(const uint8_t data[], bms_can_##name##_t* msg);
+
+BMS_CAN_MESSAGES(BMS_CAN_PROTOTYPES)
+
+/*!
+ * @brief This function writes a signal to frame data.
+ *
+ * @param data Frame data.
+ * @param start Position of the least significant bit.
+ * @param length Number of bits (1 to 32).
+ * @param value Value, only the lowest length bits are written.
+ */
+void bmsCanPutBits(uint8_t data[], uint8_t start, uint8_t length,
+    uint32_t value);
+
+/*!
+ * @brief This function reads a signal from frame data.
+ *
+ * @param data Frame data.
+ * @param start Position of the least significant bit.
+ * @param length Number of bits (1 to 32).
+ * @param isSigned Sign extend the value.
+ *
+ * @return Value of the signal.
+ */
+uint32_t bmsCanGetBits(const uint8_t data[], uint8_t start, uint8_t length,
+    bool isSigned);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMS_CAN_H_ */
@@ -0,0 +1,248 @@
+/*!
+ * @file cell_stats.c
+ *
+ * Cell voltage statistics of the whole pack.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "cell_stats.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Number of 32-bit words holding cell voltage registers of a device
+ * (two cells per word). */
+#define CELL_WORD_CNT         (BCC_MAX_CELLS / 2U)
+
+/*! @brief Mask of measured value in two cell voltage registers. */
+#define CELL_MEAS_MASK2       ((BCC_R_MEAS_MASK << 16) | BCC_R_MEAS_MASK)
+
+/*! @brief Resolution of cell voltage registers in [uV] * 100,
+ * see BCC_GET_VOLT. */
+#define CELL_RES_UV_X100      15259U
+
+/*! @brief Converts raw value (or a sum of raw values) to [uV]. */
+#define CELL_RAW_TO_UV(raw)   ((uint32_t)(((uint64_t)(raw) * CELL_RES_UV_X100) / 100U))
+
+#if defined(__GNUC__) && defined(__ARM_FEATURE_SIMD32)
+
+/* Cortex-M4 DSP extension. Each macro processes two unsigned 16-bit values
+ * packed in a 32-bit word. USUB16 sets GE flags of halfwords where a >= b,
+ * SEL then picks the halfwords according to the flags. */
+
+/*! @brief Maximum of packed halfwords. */
+#define CELL_MAX16(a, b) ({ uint32_t r_; \
+    __asm ("usub16 %0, %1, %2\n\tsel %0, %1, %2" : "=&r"(r_) : "r"(a), "r"(b)); r_; })
+
+/*! @brief Minimum of packed halfwords. */
+#define CELL_MIN16(a, b) ({ uint32_t r_; \
+    __asm ("usub16 %0, %1, %2\n\tsel %0, %2, %1" : "=&r"(r_) : "r"(a), "r"(b)); r_; })
+
+/*! @brief Adds both halfwords (up to 0x7FFF) of x to acc. */
+#define CELL_SUM16(acc, x) \
+    __asm ("smlad %0, %1, %2, %0" : "+r"(acc) : "r"(x), "r"(0x00010001U))
+
+/*! @brief Adds squares of both halfwords (up to 0x7FFF) of x to 64-bit acc. */
+#define CELL_SUMSQ16(acc, x) \
+    __asm ("smlald %Q0, %R0, %1, %1" : "+r"(acc) : "r"(x))
+
+#else
+
+/* Portable variant. The expressions are branch-free, so the compiler can
+ * vectorize them (SSE/NEON) on a host. */
+
+/*! @brief Maximum of packed halfwords. */
+#define CELL_MAX16(a, b) \
+    ((((a) & 0xFFFFU) > ((b) & 0xFFFFU) ? ((a) & 0xFFFFU) : ((b) & 0xFFFFU)) | \
+     (((a) >> 16) > ((b) >> 16) ? ((a) & 0xFFFF0000U) : ((b) & 0xFFFF0000U)))
+
+/*! @brief Minimum of packed halfwords. */
+#define CELL_MIN16(a, b) \
+    ((((a) & 0xFFFFU) < ((b) & 0xFFFFU) ? ((a) & 0xFFFFU) : ((b) & 0xFFFFU)) | \
+     (((a) >> 16) < ((b) >> 16) ? ((a) & 0xFFFF0000U) : ((b) & 0xFFFF0000U)))
+
+/*! @brief Adds both halfwords of x to acc. */
+#define CELL_SUM16(acc, x) \
+    ((acc) += ((x) & 0xFFFFU) + ((x) >> 16))
+
+/*! @brief Adds squares of both halfwords of x to 64-bit acc. */
+#define CELL_SUMSQ16(acc, x) \
+    ((acc) += (uint64_t)(((x) & 0xFFFFU) * ((x) & 0xFFFFU)) + \
+              (uint64_t)(((x) >> 16) * ((x) >> 16)))
+
+#endif
+
+/*******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+
+/*!
+ * @brief This function returns mask of two cells (0xFFFF for connected cell)
+ * stored in word wordIdx of cell voltage registers.
+ *
+ * Word 0 contains MEAS_CELL14 (lower halfword) and MEAS_CELL13 (upper
+ * halfword), word 1 MEAS_CELL12 and MEAS_CELL11, etc.
+ *
+ * @param cellMap Bit map of connected cells (bit 0 for cell 1).
+ * @param wordIdx Index of the word.
+ *
+ * @return Mask of the word.
+ */
+static inline uint32_t getCellMask2(uint16_t cellMap, uint8_t wordIdx);
+
+/*!
+ * @brief This function returns number of connected cells in a cell map
+ * (population count, portable replacement of a compiler built-in).
+ *
+ * @param cellMap Bit map of connected cells.
+ *
+ * @return Number of bits set in cellMap.
+ */
+static inline uint32_t getCellCnt(uint16_t cellMap);
+
+/*******************************************************************************
+ * Private functions
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : getCellMask2
+ * Description   : This function returns mask of two cells stored in a word of
+ *                 cell voltage registers.
+ *
+ *END**************************************************************************/
+static inline uint32_t getCellMask2(uint16_t cellMap, uint8_t wordIdx)
+{
+    uint32_t lo = ((uint32_t)cellMap >> (13U - (2U * wordIdx))) & 1U;
+    uint32_t hi = ((uint32_t)cellMap >> (12U - (2U * wordIdx))) & 1U;
+
+    return (lo * 0x0000FFFFU) | (hi * 0xFFFF0000U);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : getCellCnt
+ * Description   : This function returns number of connected cells in a cell
+ *                 map.
+ *
+ *END**************************************************************************/
+static inline uint32_t getCellCnt(uint16_t cellMap)
+{
+    uint32_t cnt = cellMap;
+
+    cnt = cnt - ((cnt >> 1) & 0x5555U);
+    cnt = (cnt & 0x3333U) + ((cnt >> 2) & 0x3333U);
+    cnt = (cnt + (cnt >> 4)) & 0x0F0FU;
+
+    return (cnt + (cnt >> 8)) & 0x1FU;
+}
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : calcCellStats
+ * Description   : This function computes cell voltage statistics of the pack.
+ *
+ *END**************************************************************************/
+void calcCellStats(const bcc_drv_config_t* const drvConfig,
+    const uint16_t meas[][BCC_MEAS_CNT], cell_stats_t* const stats)
+{
+    uint32_t minW = 0xFFFFFFFFU;  /* Packed minimums. */
+    uint32_t maxW = 0U;           /* Packed maximums. */
+    uint32_t sum = 0U;            /* Sum of raw values (max. 210 * 0x7FFF). */
+    uint64_t sumSq = 0U;          /* Sum of squares of raw values. */
+    uint32_t cellCnt = 0U;
+    uint32_t cells, mask;
+    uint32_t minRaw, maxRaw;
+    uint16_t cellMap;
+    uint64_t varN2;               /* Variance of raw values * cellCnt^2. */
+    uint8_t dev, i;
+
+    BCC_MCU_Assert(drvConfig != NULL);
+    BCC_MCU_Assert(meas != NULL);
+    BCC_MCU_Assert(stats != NULL);
+
+    for (dev = 0U; dev < BCC_DEVICES_CNT(drvConfig); dev++)
+    {
+        cellMap = BCC_CELL_MAP(drvConfig, dev + 1U);
+        cellCnt += getCellCnt(cellMap);
+
+        for (i = 0U; i < CELL_WORD_CNT; i++)
+        {
+            /* Two consecutive cell voltage registers. */
+            (void)memcpy(&cells, &meas[dev][BCC_MSR_CELL_VOLT14 + (2U * i)], sizeof(cells));
+            cells &= CELL_MEAS_MASK2;
+            mask = getCellMask2(cellMap, i);
+
+            /* Not connected cells: zero for maximum and sums, 0xFFFF for minimum. */
+            maxW = CELL_MAX16(maxW, cells & mask);
+            minW = CELL_MIN16(minW, cells | ~mask);
+            cells &= mask;
+            CELL_SUM16(sum, cells);
+            CELL_SUMSQ16(sumSq, cells);
+        }
+    }
+
+    if (cellCnt == 0U)
+    {
+        (void)memset(stats, 0, sizeof(cell_stats_t));
+        return;
+    }
+
+    minRaw = ((minW & 0xFFFFU) < (minW >> 16)) ? (minW & 0xFFFFU) : (minW >> 16);
+    maxRaw = ((maxW & 0xFFFFU) > (maxW >> 16)) ? (maxW & 0xFFFFU) : (maxW >> 16);
+
+    /* Variance in raw units: n^2 * (E[x^2] - E[x]^2), exact in integers
+     * (max. 210 * 210 * 0x7FFF^2). Only the square root is in single
+     * precision float, which the Cortex-M4F computes in hardware. */
+    varN2 = ((uint64_t)cellCnt * sumSq) - ((uint64_t)sum * sum);
+
+    stats->minUV = CELL_RAW_TO_UV(minRaw);
+    stats->maxUV = CELL_RAW_TO_UV(maxRaw);
+    stats->spreadUV = stats->maxUV - stats->minUV;
+    stats->sumUV = CELL_RAW_TO_UV(sum);
+    stats->meanUV = stats->sumUV / cellCnt;
+    stats->stdDevUV = (uint32_t)(((sqrtf((float)varN2) / (float)cellCnt) *
+            (float)CELL_RES_UV_X100) / 100.0f);
+    stats->cellCnt = (uint16_t)cellCnt;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : calcCellDeviation
+ * Description   : This function computes deviation of each cell voltage from
+ *                 the mean cell voltage of the pack.
+ *
+ *END**************************************************************************/
+void calcCellDeviation(const bcc_drv_config_t* const drvConfig,
+    const uint16_t meas[][BCC_MEAS_CNT], const cell_stats_t* const stats,
+    int32_t deviation[][BCC_MAX_CELLS])
+{
+    uint16_t cellMap;
+    uint8_t dev, cell;
+    int32_t volt;
+
+    BCC_MCU_Assert(drvConfig != NULL);
+    BCC_MCU_Assert(meas != NULL);
+    BCC_MCU_Assert(stats != NULL);
+    BCC_MCU_Assert(deviation != NULL);
+
+    for (dev = 0U; dev < BCC_DEVICES_CNT(drvConfig); dev++)
+    {
+        cellMap = BCC_CELL_MAP(drvConfig, dev + 1U);
+
+        for (cell = 0U; cell < BCC_MAX_CELLS; cell++)
+        {
+            volt = (int32_t)BCC_GET_VOLT(meas[dev][BCC_MSR_CELL_VOLT1 - cell]);
+
+            /* Zero for not connected cells. */
+            deviation[dev][cell] = (volt - (int32_t)stats->meanUV) *
+                    (int32_t)((cellMap >> cell) & 1U);
+        }
+    }
+}
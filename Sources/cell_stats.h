@@ -0,0 +1,72 @@
+/*!
+ * @file cell_stats.h
+ *
+ * Cell voltage statistics of the whole pack (minimum, maximum, mean, spread
+ * and standard deviation of cell voltages) and deviation of each cell from
+ * the mean.
+ *
+ * The statistics are computed in a single pass over the content of
+ * measurement registers (see BCC_Meas_GetRawValues) of all BCC devices. Cells
+ * which are not connected (see BCC_CELL_MAP) are masked out without branches.
+ * On Cortex-M4 the DSP SIMD instructions process two cells at once.
+ */
+
+#ifndef CELL_STATS_H_
+#define CELL_STATS_H_
+
+#include "bcc/bcc.h"
+
+/*******************************************************************************
+ * Structure definition
+ ******************************************************************************/
+
+/*!
+ * @brief Cell voltage statistics of the pack.
+ */
+typedef struct
+{
+    uint32_t minUV;      /*!< Minimal cell voltage in [uV]. */
+    uint32_t maxUV;      /*!< Maximal cell voltage in [uV]. */
+    uint32_t meanUV;     /*!< Mean cell voltage in [uV]. */
+    uint32_t spreadUV;   /*!< Difference of maximal and minimal cell voltage
+                              (imbalance) in [uV]. */
+    uint32_t stdDevUV;   /*!< Standard deviation of cell voltages in [uV]. */
+    uint32_t sumUV;      /*!< Sum of cell voltages in [uV]. */
+    uint16_t cellCnt;    /*!< Number of connected cells in the pack. */
+} cell_stats_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief This function computes cell voltage statistics of the pack.
+ *
+ * @param drvConfig Pointer to driver instance configuration (number of devices
+ *                  and cell maps).
+ * @param meas Content of measurement registers of all devices, meas[0] belongs
+ *             to the device with CID 1, etc. No alignment is required, pairs
+ *             of cell voltage registers are loaded by memcpy.
+ * @param stats Computed statistics. All items are zero if no cell is connected.
+ */
+void calcCellStats(const bcc_drv_config_t* const drvConfig,
+    const uint16_t meas[][BCC_MEAS_CNT], cell_stats_t* const stats);
+
+/*!
+ * @brief This function computes deviation of each cell voltage from the mean
+ * cell voltage of the pack.
+ *
+ * @param drvConfig Pointer to driver instance configuration (number of devices
+ *                  and cell maps).
+ * @param meas Content of measurement registers of all devices (the same as
+ *             passed to calcCellStats).
+ * @param stats Statistics computed by calcCellStats.
+ * @param deviation Deviation from the mean in [uV]. deviation[0][0] belongs to
+ *                  cell 1 of the device with CID 1. Items of not connected
+ *                  cells are zero.
+ */
+void calcCellDeviation(const bcc_drv_config_t* const drvConfig,
+    const uint16_t meas[][BCC_MEAS_CNT], const cell_stats_t* const stats,
+    int32_t deviation[][BCC_MAX_CELLS]);
+
+#endif /* CELL_STATS_H_ */
@@ -62,10 +62,6 @@
 /* Value of FAULT3_STATUS register when no event occurred. */
 #define BCC_FAULT3_STATUS_NOEVENT 0x0000U
 
-/* Address of last printed fuse mirror register. */
-#define BCC_LAST_FUSE_ADDR_MC33771B   0x1A
-#define BCC_LAST_FUSE_ADDR_MC33772B   0x12
-
 /**
  * Prints formated string with register name, value and whether an event
  * occurred. It is intended for the status registers.
@@ -246,7 +242,7 @@ bcc_status_t printInitialSettings(uint8_t cid)
 
     PRINTF("###############################################\r\n");
     PRINTF("# CID %d (MC3377%s): Initial value of registers\r\n", cid,
-            (g_bccData.drvConfig.device[cid - 1] == BCC_DEVICE_MC33771) ?
+            (BCC_DEVICE_TYPE(&g_bccData.drvConfig, cid) == BCC_DEVICE_MC33771) ?
                     "1" : "2");
     PRINTF("###############################################\r\n\r\n");
 
@@ -262,7 +258,7 @@ bcc_status_t printInitialSettings(uint8_t cid)
 
     PRINTF(printPattern, "INIT", regVal >> 8, regVal & 0xFFU);
 
-    if (g_bccData.drvConfig.device[cid - 1] == BCC_DEVICE_MC33771)
+    if (BCC_DEVICE_TYPE(&g_bccData.drvConfig, cid) == BCC_DEVICE_MC33771)
     {
         for (i = 0U; i < REG_CONF_CNT_MC33771; i++)
         {
@@ -293,30 +289,35 @@ bcc_status_t printInitialSettings(uint8_t cid)
     PRINTF("  ----------------------------------\r\n");
     PRINTF("\r\n");
 
-    PRINTF("  ------------------------\r\n");
-    PRINTF("  | Fuse Mirror | Value  |\r\n");
-    PRINTF("  |  Register   |        |\r\n");
-    PRINTF("  ------------------------\r\n");
-    for (i = 0U; i <= ((g_bccData.drvConfig.device[cid - 1] == BCC_DEVICE_MC33771) ?
-            BCC_LAST_FUSE_ADDR_MC33771B : BCC_LAST_FUSE_ADDR_MC33772B); i++)
+    /* Fuse mirror and GUID are read once in BCC_Init, print the stored copy.
+     * Read them again only if the stored copy is corrupted. */
+    if (!BCC_Inventory_IsValid(&g_bccData.drvConfig, cid))
     {
-        error = BCC_FuseMirror_Read(&g_bccData.drvConfig, cid, i, &regVal);
+        error = BCC_Inventory_Read(&g_bccData.drvConfig, cid);
         if (error != BCC_STATUS_SUCCESS)
         {
             return error;
         }
+    }
 
+    PRINTF("  ------------------------\r\n");
+    PRINTF("  | Fuse Mirror | Value  |\r\n");
+    PRINTF("  |  Register   |        |\r\n");
+    PRINTF("  ------------------------\r\n");
+    i = 0U;
+    while (BCC_Inventory_GetFuse(&g_bccData.drvConfig, cid, i, &regVal) == BCC_STATUS_SUCCESS)
+    {
         PRINTF("  | $%02X\t| 0x%02X%02X |\r\n", i, regVal >> 8, regVal & 0xFFU);
+        i++;
     }
     PRINTF("  ------------------------\r\n");
     PRINTF("\r\n");
 
-    error = BCC_GUID_Read(&g_bccData.drvConfig, cid, &guid);
-    if (error != BCC_STATUS_SUCCESS)
-    {
-        return error;
-    }
+    (void)BCC_Inventory_GetSiliconRev(&g_bccData.drvConfig, cid, &regVal);
+    PRINTF("  Silicon revision: %d.%d\r\n",
+            (regVal & BCC_R_FREV_MASK) >> 3U, regVal & BCC_R_MREV_MASK);
 
+    (void)BCC_Inventory_GetGuid(&g_bccData.drvConfig, cid, &guid);
     PRINTF("  Device GUID: %02X%04X%04X\r\n",
             (uint16_t)((guid >> 32) & 0x001FU),
             (uint16_t)((guid >> 16) & 0xFFFFU),
@@ -340,7 +341,7 @@ bcc_status_t printFaultRegisters(uint8_t cid)
 
     PRINTF("###############################################\r\n");
     PRINTF("# CID %d (MC3377%s): Device status\r\n", cid,
-            (g_bccData.drvConfig.device[cid - 1] == BCC_DEVICE_MC33771) ?
+            (BCC_DEVICE_TYPE(&g_bccData.drvConfig, cid) == BCC_DEVICE_MC33771) ?
                     "1" : "2");
     PRINTF("###############################################\r\n\r\n");
 
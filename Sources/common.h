@@ -33,6 +33,7 @@
 
 #include "Cpu.h"
 #include "bcc/bcc.h"
+#include "cell_stats.h"
 
 /*******************************************************************************
  * Definitions (depends on the utilized device/board/battery)
@@ -72,6 +73,34 @@
     #error "Select only one type of communication."
 #endif
 
+/* Topology of the demo (bcc_drv_config_t filled in main.c). */
+#define DEMO_DEVICES_CNT        1U
+#ifdef MC33771
+#define DEMO_BCC_DEVICE         BCC_DEVICE_MC33771
+#define DEMO_CELL_CNT           14U
+#else
+#define DEMO_BCC_DEVICE         BCC_DEVICE_MC33772
+#define DEMO_CELL_CNT           6U
+#endif
+#ifdef SPI
+#define DEMO_COMM_MODE          BCC_MODE_SPI
+#else
+#define DEMO_COMM_MODE          BCC_MODE_TPL
+#endif
+
+/* BCC_FIXED_TOPOLOGY (bcc/bcc.h) compiles the driver for the BCC_FIXED_*
+ * topology, whatever is selected above. The driver sources do not include
+ * this file, so a mismatch is caught here at compile time (negative array
+ * size) instead of by BCC_Init at runtime. Override the BCC_FIXED_* values by
+ * compiler options for the other boards. */
+#ifdef BCC_FIXED_TOPOLOGY
+typedef char demoFixedTopologyCheck[
+    ((BCC_FIXED_COMM_MODE == DEMO_COMM_MODE) &&
+     (BCC_FIXED_DEVICE == DEMO_BCC_DEVICE) &&
+     (BCC_FIXED_DEVICES_CNT == DEMO_DEVICES_CNT) &&
+     (BCC_FIXED_CELL_CNT == DEMO_CELL_CNT)) ? 1 : -1];
+#endif
+
 /*******************************************************************************
  * Initial register configuration
  ******************************************************************************/
@@ -426,6 +455,11 @@ typedef struct
 
 extern bcc_data_t g_bccData;
 
+/* Pack snapshot (measurement registers of all devices) and its cell voltage
+ * statistics, updated by the main loop (see scanPack in main.c). */
+extern uint16_t g_packMeas[BCC_DEVICE_CNT_MAX][BCC_MEAS_CNT];
+extern cell_stats_t g_cellStats;
+
 /*******************************************************************************
  * API
  ******************************************************************************/
@@ -52,6 +52,10 @@ volatile int exit_code = 0;
 #include "bcc_s32k144/bcc_peripheries.h"
 #include "common.h"
 #include "monitoring.h"
+#include "shell.h"
+#include "cell_stats.h"
+#include "pack_can.h"
+#include "led_fx.h"
 
 /**********************************************************/
 /****Added by Arjun G****/
@@ -79,7 +83,7 @@ volatile int exit_code = 0;
 #define NUM_OF_BUTTON_PINS   			1
 
 #define MAX_MEASUREMENTS 				10U
-#define DELAY							4U
+#define DELAY							4U  // Battery status display time (in seconds)
 
 #define PCC_CLOCKPCC_PORTA_CLOCK
 #define PCC_CLOCKPCC_PORTC_CLOCK
@@ -88,12 +92,43 @@ volatile int exit_code = 0;
 
 #define SHORT_PRESS_TIME				1000U  //1 second for short press detection (in milliseconds)
 #define LONG_PRESS_TIME        			2000U  // 2 seconds for long press detection (in milliseconds)
-#define MAX_ON_DELAY					300000U//5 minutes
+#define MAX_ON_DELAY					300000U//5 minutes (in milliseconds)
+#define GAUGE_BLINK_TIME				100U  // On and off time of the blinking gauge LEDs (in milliseconds)
+
+/* Mean cell voltage levels [V] of the LED battery gauge (25/50/75/100 %). */
+#define CELL_VOLT_LEVEL_1				1.05f
+#define CELL_VOLT_LEVEL_2				2.1f
+#define CELL_VOLT_LEVEL_3				3.15f
+#define CELL_VOLT_LEVEL_4				4.2f
+
+#define PACK_SCAN_PERIOD				1000U  // Period of the pack measurement scan (in milliseconds)
 
 static uint32_t buttonPressStartTime = 0;
-static bool buttonPressed = false;
-static uint32_t max_delay = 0;
+static bool buttonPressed = false;   // Debounced button state
+/* Battery gauge display, LED_PIN_1..LED_PIN_4 driven by the LED effect
+ * engine from the main loop. */
+typedef enum {
+	GAUGE_OFF,
+	GAUGE_STATUS,   // Short press: DELAY seconds
+	GAUGE_ON        // Long press: until the next long press, at most MAX_ON_DELAY
+} gauge_mode_t;
+static gauge_mode_t gaugeMode = GAUGE_OFF;
+static uint32_t gaugeStartTime = 0;
+static const uint32_t gaugePins[NUM_OF_LED_PINS] = { LED_PIN_1, LED_PIN_2,
+		LED_PIN_3, LED_PIN_4 };
+static led_fx_channel_t gaugeChannels[NUM_OF_LED_PINS];
+static led_fx_engine_t gaugeLeds;
+/* LEDs of the reached levels are on, the ones above blink. */
+static const led_fx_t gaugeSolid = LED_FX_SOLID(LED_FX_LEVEL_MAX, 0U);
+static const led_fx_t gaugeBlink = LED_FX_BLINK(LED_FX_LEVEL_MAX, 0U,
+		GAUGE_BLINK_TIME, GAUGE_BLINK_TIME);
 bcc_data_t g_bccData;
+/* Pack snapshot (measurement registers of all devices) and its statistics.
+ * Updated from the main loop, LED handling and the shell only read them. */
+uint16_t g_packMeas[BCC_DEVICE_CNT_MAX][BCC_MEAS_CNT];
+cell_stats_t g_cellStats;
+/* Status registers of all devices, published with the snapshot on CAN. */
+static uint16_t g_packFaults[BCC_DEVICE_CNT_MAX][BCC_STAT_CNT];
 /*******************************************************************************
  * Pin-muxing configuration
  ******************************************************************************/
@@ -433,6 +468,12 @@ void init_gpio(void);
 void PORTC_IRQHandler(void);
 
 void led_handling_func(void);
+
+static void setGaugeLed(uint8_t channel, uint8_t level);
+
+static void showGauge(void);
+
+static void scanPack(void);
 /*******************************************************************************
  * Functions
  ******************************************************************************/
@@ -525,10 +566,14 @@ void init_gpio(void) {
 	//4. Configure interrupt for the button
 	INT_SYS_InstallHandler(PORTC_IRQn, PORTC_IRQHandler, (isr_t*) 0);
 	INT_SYS_EnableIRQ(PORTC_IRQn);
+
+	//5. Battery gauge LEDs off, effects run by led_handling_func()
+	ledFxInit(&gaugeLeds, gaugeChannels, NUM_OF_LED_PINS, setGaugeLed);
 }
 
 static void initDemo(status_t *error, bcc_status_t *bccError) {
 	ntc_config_t ntcConfig;
+	uint8_t cid;
 
 	CLOCK_SYS_Init(g_clockManConfigsArr, CLOCK_MANAGER_CONFIG_CNT,
 			g_clockManCallbacksArr, CLOCK_MANAGER_CALLBACK_CNT);
@@ -552,21 +597,10 @@ static void initDemo(status_t *error, bcc_status_t *bccError) {
 
 	/* Initialize BCC driver configuration structure (g_bccData.drvConfig). */
 	g_bccData.drvConfig.drvInstance = 0U;
-	g_bccData.drvConfig.devicesCnt = 1U;
-#ifdef MC33771
-	g_bccData.drvConfig.device[0] = BCC_DEVICE_MC33771;
-	g_bccData.drvConfig.cellCnt[0] = 14U;
-	g_bccData.drvConfig.device[1] = BCC_DEVICE_MC33771;
-	g_bccData.drvConfig.cellCnt[1] = 14U;
-#else
-    g_bccData.drvConfig.device[0] = BCC_DEVICE_MC33772;
-    g_bccData.drvConfig.cellCnt[0] = 6U;
-#endif
-#if defined(SPI)
-	g_bccData.drvConfig.commMode = BCC_MODE_SPI;
-#else
-    g_bccData.drvConfig.commMode = BCC_MODE_TPL;
-#endif
+	g_bccData.drvConfig.devicesCnt = DEMO_DEVICES_CNT;
+	g_bccData.drvConfig.device[0] = DEMO_BCC_DEVICE;
+	g_bccData.drvConfig.cellCnt[0] = DEMO_CELL_CNT;
+	g_bccData.drvConfig.commMode = DEMO_COMM_MODE;
 
 	/* Precalculate NTC look up table for fast temperature measurement. */
 	ntcConfig.rntc = 6800U; /* NTC pull-up 6.8kOhm */
@@ -587,191 +621,174 @@ static void initDemo(status_t *error, bcc_status_t *bccError) {
 
 	/* Initialize BCC device */
 	*bccError = BCC_Init(&g_bccData.drvConfig, BCC_INIT_CONF);
+
+	/* Missing identification data is not fatal, it is read again when
+	 * printed (printInitialSettings). */
+	if (*bccError == BCC_STATUS_SUCCESS) {
+		for (cid = BCC_CID_DEV1; cid <= BCC_DEVICES_CNT(&g_bccData.drvConfig); cid++) {
+			if (!BCC_Inventory_IsValid(&g_bccData.drvConfig, cid)) {
+				PRINTF("CID %d: inventory not read\r\n", cid);
+			}
+		}
+	}
 }
 /*************************************************************/
 /****Added by Arjun G****/
+/*!
+ * @brief Output function of the gauge LED effects.
+ */
+static void setGaugeLed(uint8_t channel, uint8_t level) {
+	if (level >= LED_FX_LEVEL_ON) {
+		PINS_DRV_SetPins(LED_PORT, 1U << gaugePins[channel]);
+	} else {
+		PINS_DRV_ClearPins(LED_PORT, 1U << gaugePins[channel]);
+	}
+}
+
+/*!
+ * @brief This function sets the gauge LED effects from the mean cell voltage
+ * of the last pack scan. Running effects keep their phase.
+ */
+static void showGauge(void) {
+	// Mean cell voltage of the pack [V] from the last pack scan
+	float cellVolt = g_cellStats.meanUV / 1000000.0f;
+	uint32_t now = OSIF_GetMilliseconds();
+	uint8_t solid;  // LEDs on, counted from LED_PIN_4
+	uint8_t i;
+
+	if (cellVolt >= CELL_VOLT_LEVEL_3) {
+		solid = 4U;
+	} else if (cellVolt >= CELL_VOLT_LEVEL_2) {
+		solid = 3U;
+	} else if (cellVolt >= CELL_VOLT_LEVEL_1) {
+		solid = 2U;
+	} else {
+		solid = 1U;
+	}
+
+	for (i = 0U; i < NUM_OF_LED_PINS; i++) {
+		ledFxStart(&gaugeLeds, i,
+				(i >= (NUM_OF_LED_PINS - solid)) ? &gaugeSolid : &gaugeBlink, now);
+	}
+}
+
+/*!
+ * @brief This function handles the button and the battery gauge LEDs, called
+ * from the main loop. It never waits: the button is debounced and the press
+ * times measured against OSIF_GetMilliseconds(), the LED effects advance by
+ * one tick per call.
+ *
+ * - Short press (released within SHORT_PRESS_TIME): gauge for DELAY seconds.
+ * - Long press (held for LONG_PRESS_TIME): gauge on, or off if it is on.
+ *   It goes off by itself after MAX_ON_DELAY.
+ */
 void led_handling_func(void) {
-	static bool ledState = false;
-
-	// Check if the button is pressed (assuming active low)
-	if (PINS_DRV_ReadPins(BUTTON_PORT) == 0) {
-		if (!buttonPressed) {
-			// Button was just pressed, start the timer
-			buttonPressStartTime = OSIF_GetMilliseconds(); // Function to get current time in ms
-			buttonPressed = true;
-		}
-		/*******************1. For handling 'ON' state of battery*****************************/
-		if (buttonPressed) {
-			// Check if the button has been pressed for a long time
-			if ((OSIF_GetMilliseconds() - buttonPressStartTime
-					>= LONG_PRESS_TIME)
-					&& (OSIF_GetMilliseconds() - buttonPressStartTime
-							<= SHORT_PRESS_TIME)) {
-				// Long press detected
-				PRINTF("Long press detected\r\n");
-				// Perform any action you want for long press, e.g., reset the system or change a mode
-				uint16_t sum = (BCC_GET_VOLT(BCC_MSR_CELL_VOLT1)
-						+ BCC_GET_VOLT(BCC_MSR_CELL_VOLT2)
-						+ BCC_GET_VOLT(BCC_MSR_CELL_VOLT3)
-						+ BCC_GET_VOLT(BCC_MSR_CELL_VOLT4)
-						+ BCC_GET_VOLT(BCC_MSR_CELL_VOLT5)
-						+ BCC_GET_VOLT(BCC_MSR_CELL_VOLT6)) / (double) 1000000;
-
-				// Perform actions based on voltage levels
-				while (max_delay <= MAX_ON_DELAY) {
-
-					if (sum >= 18.9 && sum <= 25.2) {
-						PINS_DRV_SetPins(LED_PORT,
-								LED_PIN_1 | LED_PIN_2 | LED_PIN_3 | LED_PIN_4);
-						ledState = true;
-					} else if (sum >= 12.6 && sum <= 18.9) {
-						for (;;) {
-							PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_1);
-							BCC_MCU_WaitMs(100);
-							PINS_DRV_SetPins(LED_PORT, LED_PIN_1);
-							BCC_MCU_WaitMs(100);
-						}
-						PINS_DRV_SetPins(LED_PORT,
-								LED_PIN_2 | LED_PIN_3 | LED_PIN_4);
-						ledState = true;
-					} else if (sum >= 6.3 && sum <= 12.6) {
-						for (;;) {
-							PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_1);
-							PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_2);
-							BCC_MCU_WaitMs(100);
-							PINS_DRV_SetPins(LED_PORT, LED_PIN_1 | LED_PIN_2);
-							BCC_MCU_WaitMs(100);
-						}
-						ledState = true;
-						PINS_DRV_SetPins(LED_PORT, LED_PIN_3 | LED_PIN_4);
-					} else {
-						for (;;) {
-							PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_1);
-							PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_2);
-							PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_3);
-							BCC_MCU_WaitMs(100);
-							PINS_DRV_SetPins(LED_PORT,
-									LED_PIN_1 | LED_PIN_2 | LED_PIN_3);
-							BCC_MCU_WaitMs(100);
-						}
-						PINS_DRV_SetPins(LED_PORT, LED_PIN_4);
-						ledState = true; //Set Led flag
-					}
-					max_delay++;
-				}
-				ledState = false;
-				buttonPressed = false;  // Reset buttonPressed flag
+	static bool bouncing = false;
+	static uint32_t bounceStartTime = 0;
+	static bool longPressHandled = false;
+	uint32_t now = OSIF_GetMilliseconds();
+	// Button is active low
+	bool pressed = (PINS_DRV_ReadPins(BUTTON_PORT) & (1U << BUTTON_PIN)) == 0U;
+	uint8_t i;
+
+	// De-bounce: a new level counts once stable for BUTTON_DEBOUNCE_DELAY
+	if (pressed == buttonPressed) {
+		bouncing = false;
+	} else if (!bouncing) {
+		bouncing = true;
+		bounceStartTime = now;
+	} else if ((now - bounceStartTime) >= BUTTON_DEBOUNCE_DELAY) {
+		bouncing = false;
+		buttonPressed = pressed;
+		if (pressed) {
+			buttonPressStartTime = now;
+			longPressHandled = false;
+		} else if (!longPressHandled
+				&& ((now - buttonPressStartTime) <= SHORT_PRESS_TIME)) {
+			/*******************1. 'STATUS' state of battery*****************************/
+			PRINTF("Short press detected\r\n");
+			if (gaugeMode != GAUGE_ON) {
+				gaugeMode = GAUGE_STATUS;
+				gaugeStartTime = now;
 			}
 		}
-		/***********************2. For handling 'STATUS' state of battery****************************/
-		else if (buttonPressed) {
-			uint16_t sum = (BCC_GET_VOLT(BCC_MSR_CELL_VOLT1)
-					+ BCC_GET_VOLT(BCC_MSR_CELL_VOLT2)
-					+ BCC_GET_VOLT(BCC_MSR_CELL_VOLT3)
-					+ BCC_GET_VOLT(BCC_MSR_CELL_VOLT4)
-					+ BCC_GET_VOLT(BCC_MSR_CELL_VOLT5)
-					+ BCC_GET_VOLT(BCC_MSR_CELL_VOLT6)) / (double) 1000000;
-			if (OSIF_GetMilliseconds()
-					- buttonPressStartTime<= SHORT_PRESS_TIME) {
-				// Short press detected
-				PRINTF("Short press detected\r\n");
-				if (sum >= 18.9 && sum <= 25.2) {
-					PINS_DRV_SetPins(LED_PORT,
-							LED_PIN_1 | LED_PIN_2 | LED_PIN_3 | LED_PIN_4);
-					//Delay of 4s
-					BCC_MCU_WaitSec(DELAY);
-
-					//Then switch off the LED
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_1);
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_2);
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_3);
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_4);
-				} else if (sum >= 12.6 && sum <= 18.9) {
-
-					for (int i = 0; i < DELAY; i++) {
-						PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_1);
-						BCC_MCU_WaitMs(100);
-						PINS_DRV_SetPins(LED_PORT, LED_PIN_1);
-						BCC_MCU_WaitMs(100);
-					}
-
-					PINS_DRV_SetPins(LED_PORT,
-							LED_PIN_2 | LED_PIN_3 | LED_PIN_4);
-					//Delay of 4s
-					BCC_MCU_WaitSec(DELAY);
-
-					//Then switch off the LED
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_1);
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_2);
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_3);
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_4);
-
-				} else if (sum >= 6.3 && sum <= 12.6) {
-					for (int i = 0; i < DELAY; i++) {
-						PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_1);
-						PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_2);
-						BCC_MCU_WaitMs(100);
-						PINS_DRV_SetPins(LED_PORT, LED_PIN_1 | LED_PIN_2);
-						BCC_MCU_WaitMs(100);
-					}
-					PINS_DRV_SetPins(LED_PORT, LED_PIN_3);
-					PINS_DRV_SetPins(LED_PORT, LED_PIN_4);
-
-					//Delay of 4s
-					BCC_MCU_WaitSec(DELAY);
-					//Then switch off the LED
-
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_1);
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_2);
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_3);
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_4);
-				} else {
-					for (int i = 0; i < DELAY; i++) {
-						PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_1);
-						PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_2);
-						PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_3);
-						BCC_MCU_WaitMs(100);
-						PINS_DRV_SetPins(LED_PORT,
-								LED_PIN_1 | LED_PIN_2 | LED_PIN_3);
-						BCC_MCU_WaitMs(100);
-					}
-					PINS_DRV_SetPins(LED_PORT, LED_PIN_4);
-					//Delay of 4s
-					BCC_MCU_WaitSec(DELAY);
-
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_1);
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_2);
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_3);
-					PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_4);
-				}
-			}
-			ledState = false;
-			buttonPressed = false;  // Reset buttonPressed flag
+	}
+
+	if (buttonPressed && !longPressHandled
+			&& ((now - buttonPressStartTime) >= LONG_PRESS_TIME)) {
+		longPressHandled = true;
+		PRINTF("Long press detected\r\n");
+		if (gaugeMode == GAUGE_OFF) {
+			/*******************2. 'ON' state of battery*****************************/
+			gaugeMode = GAUGE_ON;
+			gaugeStartTime = now;
+		} else {
+			/*******************3. 'OFF' state of battery*****************************/
+			gaugeMode = GAUGE_OFF;
 		}
-		/************************3. For handling 'OFF' state of battery***********************/
-		else {
-			if ((OSIF_GetMilliseconds() - buttonPressStartTime
-					>= LONG_PRESS_TIME)
-					&& (OSIF_GetMilliseconds() - buttonPressStartTime
-							<= SHORT_PRESS_TIME) && (ledState == true)) {
-				PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_1);
-				PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_2);
-				PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_3);
-				PINS_DRV_ClearPins(LED_PORT, 1U << LED_PIN_4);
-			}
-			ledState = false;
-			buttonPressed = false;
+	}
+
+	if (((gaugeMode == GAUGE_STATUS) && ((now - gaugeStartTime) >= (DELAY * 1000U)))
+			|| ((gaugeMode == GAUGE_ON) && ((now - gaugeStartTime) >= MAX_ON_DELAY))) {
+		gaugeMode = GAUGE_OFF;
+	}
+
+	if (gaugeMode == GAUGE_OFF) {
+		for (i = 0U; i < NUM_OF_LED_PINS; i++) {
+			ledFxStart(&gaugeLeds, i, NULL, now);
 		}
-		// Optionally de-bounce the button (i.e., ignore further presses for a short period)
-		BCC_MCU_WaitMs(BUTTON_DEBOUNCE_DELAY);
-		max_delay = 0;
-	}  //End of Main 'if' statement
+	} else {
+		showGauge();
+	}
+	ledFxTick(&gaugeLeds, now);
+}
+
+/*!
+ * @brief This function measures all devices (at most once per PACK_SCAN_PERIOD)
+ * and updates the pack cell voltage statistics and the CAN frames of the pack
+ * state.
+ */
+static void scanPack(void) {
+	static uint32_t lastScanTime = 0;
+	static bool scanned = false;
+	static uint8_t soc = 0U;   /* [0.5 %] */
+	uint32_t now = OSIF_GetMilliseconds();
+	uint8_t cid;
+	float level;
+
+	if (scanned && ((now - lastScanTime) < PACK_SCAN_PERIOD)) {
+		return;
+	}
+	lastScanTime = now;
+	scanned = true;
+
+	for (cid = BCC_CID_DEV1; cid <= BCC_DEVICES_CNT(&g_bccData.drvConfig); cid++) {
+		if ((getMeasurements(cid, g_packMeas[cid - 1]) != BCC_STATUS_SUCCESS)
+				|| (BCC_Fault_GetStatus(&g_bccData.drvConfig, cid,
+						g_packFaults[cid - 1]) != BCC_STATUS_SUCCESS)) {
+			/* Keep the last statistics, the scan is repeated next period.
+			 * The last known state is published flagged as stale. */
+			updatePackCan(&g_bccData.drvConfig, g_packMeas, g_packFaults,
+					&g_cellStats, soc, true);
+			return;
+		}
+	}
+
+	calcCellStats(&g_bccData.drvConfig, g_packMeas, &g_cellStats);
+
+	/* State of charge estimated from the mean cell voltage, as the LED gauge. */
+	level = (g_cellStats.meanUV / 1000000.0f) / CELL_VOLT_LEVEL_4;
+	soc = (uint8_t)(((level > 1.0f) ? 1.0f : level) * 200.0f);
+	updatePackCan(&g_bccData.drvConfig, g_packMeas, g_packFaults, &g_cellStats,
+			soc, false);
 }
 
 /****Added by Arjun G****/
 /************Soft start method***************/
+/* Button edge. The button is debounced and handled by led_handling_func()
+ * from the main loop, the handler only acknowledges the interrupt. */
 void PORTC_IRQHandler(void) {
-	led_handling_func();
+	PINS_DRV_ClearPinIntFlagCmd(PORTC, BUTTON_PIN);
 }
 
 /* Dummy functions for time and GPIO handling for illustration */
@@ -784,22 +801,22 @@ void PORTC_IRQHandler(void) {
 static bcc_status_t startApp(void) {
 	uint8_t cid;
 	bcc_status_t error;
-
-	for (cid = BCC_CID_DEV1; cid <= g_bccData.drvConfig.devicesCnt; cid++) {
-		if ((error = printInitialSettings(cid)) != BCC_STATUS_SUCCESS) {
-			return error;
-		}
-
-		if ((error = doMeasurements(cid)) != BCC_STATUS_SUCCESS) {
-			return error;
-		}
-
-		if ((error = printFaultRegisters(cid)) != BCC_STATUS_SUCCESS) {
-			return error;
+	bcc_status_t firstError = BCC_STATUS_SUCCESS;
+
+	/* A failing device does not stop the scan of the following devices,
+	 * the first error is returned. */
+	for (cid = BCC_CID_DEV1; cid <= BCC_DEVICES_CNT(&g_bccData.drvConfig); cid++) {
+		if (((error = printInitialSettings(cid)) != BCC_STATUS_SUCCESS)
+				|| ((error = doMeasurements(cid)) != BCC_STATUS_SUCCESS)
+				|| ((error = printFaultRegisters(cid)) != BCC_STATUS_SUCCESS)) {
+			PRINTF("CID %d: an error occurred (0x%04x)\r\n", cid, error);
+			if (firstError == BCC_STATUS_SUCCESS) {
+				firstError = error;
+			}
 		}
 	}
 
-	return BCC_STATUS_SUCCESS;
+	return firstError;
 }
 
 /*!
@@ -853,6 +870,19 @@ int main(void) {
 	bccError = BCC_CB_Enable(&myConfig, BCC_CID_DEV2, true);
 	DEV_ASSERT(bccError == BCC_STATUS_SUCCESS);
 
+	//3. Serve the debug shell, refresh the pack statistics and handle the
+	//   button and gauge LEDs from the main loop (bounded time per call).
+	//   The shell is a debug aid: if its reception can't be started,
+	//   runShell() retries it and the monitoring runs anyway.
+	if (initShell() != STATUS_SUCCESS) {
+		PRINTF("Shell reception not started, retrying\r\n");
+	}
+	for (;;) {
+		runShell();
+		scanPack();
+		led_handling_func();
+	}
+
 	/*** Don't write any code pass this line, or it will be deleted during code generation. ***/
 	/*** RTOS startup code. Macro PEX_RTOS_START is defined by the RTOS component. DON'T MODIFY THIS CODE!!! ***/
 #ifdef PEX_RTOS_START
@@ -73,29 +73,6 @@ static uint16_t g_ntcTable[NTC_TABLE_SIZE];
  * Function prototypes
  ******************************************************************************/
 
-/*!
- * @brief This function calculates temperature from raw value of MEAS_ANx
- * register. It uses precalculated values stored in g_ntcTable table.
- * You can use function BCC_Meas_GetRawValues to get values of measurement
- * registers.
- *
- * @param regVal Value of MEAS_ANx register.
- * @param temp Temperature value in deg. of Celsius * 10.
- *
- * @return bcc_status_t Error code.
- */
-static bcc_status_t getNtcCelsius(uint16_t regVal, int16_t* temp);
-
-/////*!
-//// * @brief This function starts on-demand conversion and reads measured values.
-//// *
-//// * @param cid Cluster Identification Address.
-//// * @param measurement Content of the measurement registers (result).
-//// *
-//// * @return bcc_status_t Error code.
-//// */
-//static bcc_status_t getMeasurements(uint8_t cid, uint16_t measurements[]);
-
 /*!
  * @brief This function prints value of a register to serial console output.
  *
@@ -129,69 +106,6 @@ static void printMeasResults(uint16_t measurements[], uint8_t cid);
  * Private functions
  ******************************************************************************/
 
-/*FUNCTION**********************************************************************
- *
- * Function Name : getNtcCelsius
- * Description   : This function calculates temperature from raw value of
- *                 MEAS_ANx register.
- *
- *END**************************************************************************/
-static bcc_status_t getNtcCelsius(uint16_t regVal, int16_t* temp)
-{
-    int16_t left = 0;    /* Pointer (index) to the left border of interval
-                            (NTC table). */
-    int16_t right = NTC_TABLE_SIZE - 1; /* Pointer (index) to the right border
-                                           of interval (NTC table). */
-    int16_t middle;      /* Pointer (index) to the middle of interval
-                            (NTC table). */
-    int8_t degTenths;    /* Fractional part of temperature value. */
-
-    BCC_MCU_Assert(temp != NULL);
-
-    /* Check range of NTC table. */
-    if (g_ntcTable[NTC_TABLE_SIZE - 1] > regVal)
-    {
-        *temp = NTC_COMP_TEMP(NTC_TABLE_SIZE - 1, 0);
-        return BCC_STATUS_PARAM_RANGE;
-    }
-    if (g_ntcTable[0] < regVal)
-    {
-        *temp = NTC_COMP_TEMP(0, 0);
-        return BCC_STATUS_PARAM_RANGE;
-    }
-
-    regVal &= BCC_GET_MEAS_RAW(regVal);
-
-    /* Search for an array item which is close to the register value provided
-    * by user (regVal). Used method is binary search in sorted array. */
-    while ((left + 1) != right)
-    {
-        /* Split interval into halves. */
-        middle = (left + right) >> 1U;
-        if (g_ntcTable[middle] <= regVal)
-        {
-            /* Select right half (array items are in descending order). */
-            right = middle;
-        }
-        else
-        {
-            /* Select left half. */
-            left = middle;
-        }
-    }
-
-    /* Notes: found table item (left) is less than the following item in the
-    * table (left + 1).
-    * The last item cannot be found (algorithm property). */
-
-    /* Calculate fractional part of temperature. */
-    degTenths = (g_ntcTable[left] - regVal) /
-            ((g_ntcTable[left] - g_ntcTable[left + 1]) / 10);
-    (*temp) = NTC_COMP_TEMP(left, degTenths);
-
-    return BCC_STATUS_SUCCESS;
-}
-
 /*FUNCTION**********************************************************************
  *
  * Function Name : getMeasurements
@@ -199,7 +113,7 @@ static bcc_status_t getNtcCelsius(uint16_t regVal, int16_t* temp)
  *                 values.
  *
  *END**************************************************************************/
-static bcc_status_t getMeasurements(uint8_t cid, uint16_t measurements[])
+bcc_status_t getMeasurements(uint8_t cid, uint16_t measurements[])
 {
     bool convCompl;
     bcc_status_t error;
@@ -283,7 +197,7 @@ static void printMeasResults(uint16_t measurements[], uint8_t cid)
 
     PRINTF("###############################################\r\n");
     PRINTF("# CID %d (MC3377%s): Measurements\r\n", cid,
-            (g_bccData.drvConfig.device[cid - 1] == BCC_DEVICE_MC33771) ?
+            (BCC_DEVICE_TYPE(&g_bccData.drvConfig, cid) == BCC_DEVICE_MC33771) ?
                     "1" : "2");
     PRINTF("###############################################\r\n\r\n");
 
@@ -330,7 +244,7 @@ static void printMeasResults(uint16_t measurements[], uint8_t cid)
     printMeas("CELL 6", measurements[BCC_MSR_CELL_VOLT6],
             BCC_GET_VOLT(measurements[BCC_MSR_CELL_VOLT6]) / 1000U, "mV");
 
-    if (g_bccData.drvConfig.device[cid - 1] == BCC_DEVICE_MC33771)
+    if (BCC_DEVICE_TYPE(&g_bccData.drvConfig, cid) == BCC_DEVICE_MC33771)
     {
         printMeas("CELL 7", measurements[BCC_MSR_CELL_VOLT7],
                 BCC_GET_VOLT(measurements[BCC_MSR_CELL_VOLT7]) / 1000U, "mV");
@@ -381,6 +295,69 @@ static void printMeasResults(uint16_t measurements[], uint8_t cid)
  * API
  ******************************************************************************/
 
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : getNtcCelsius
+ * Description   : This function calculates temperature from raw value of
+ *                 MEAS_ANx register.
+ *
+ *END**************************************************************************/
+bcc_status_t getNtcCelsius(uint16_t regVal, int16_t* temp)
+{
+    int16_t left = 0;    /* Pointer (index) to the left border of interval
+                            (NTC table). */
+    int16_t right = NTC_TABLE_SIZE - 1; /* Pointer (index) to the right border
+                                           of interval (NTC table). */
+    int16_t middle;      /* Pointer (index) to the middle of interval
+                            (NTC table). */
+    int8_t degTenths;    /* Fractional part of temperature value. */
+
+    BCC_MCU_Assert(temp != NULL);
+
+    /* Check range of NTC table. */
+    if (g_ntcTable[NTC_TABLE_SIZE - 1] > regVal)
+    {
+        *temp = NTC_COMP_TEMP(NTC_TABLE_SIZE - 1, 0);
+        return BCC_STATUS_PARAM_RANGE;
+    }
+    if (g_ntcTable[0] < regVal)
+    {
+        *temp = NTC_COMP_TEMP(0, 0);
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    regVal &= BCC_GET_MEAS_RAW(regVal);
+
+    /* Search for an array item which is close to the register value provided
+    * by user (regVal). Used method is binary search in sorted array. */
+    while ((left + 1) != right)
+    {
+        /* Split interval into halves. */
+        middle = (left + right) >> 1U;
+        if (g_ntcTable[middle] <= regVal)
+        {
+            /* Select right half (array items are in descending order). */
+            right = middle;
+        }
+        else
+        {
+            /* Select left half. */
+            left = middle;
+        }
+    }
+
+    /* Notes: found table item (left) is less than the following item in the
+    * table (left + 1).
+    * The last item cannot be found (algorithm property). */
+
+    /* Calculate fractional part of temperature. */
+    degTenths = (g_ntcTable[left] - regVal) /
+            ((g_ntcTable[left] - g_ntcTable[left + 1]) / 10);
+    (*temp) = NTC_COMP_TEMP(left, degTenths);
+
+    return BCC_STATUS_SUCCESS;
+}
+
 /*FUNCTION**********************************************************************
  *
  * Function Name : BCC_FillNtcTable
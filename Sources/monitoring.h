@@ -115,6 +115,31 @@ typedef struct
  */
 void fillNtcTable(const ntc_config_t* const ntcConfig);
 
+/*!
+ * @brief This function calculates temperature from raw value of MEAS_ANx
+ * register. It uses precalculated values stored in the NTC table (see
+ * fillNtcTable). You can use function BCC_Meas_GetRawValues to get values of
+ * measurement registers.
+ *
+ * @param regVal Value of MEAS_ANx register.
+ * @param temp Temperature value in deg. of Celsius * 10.
+ *
+ * @return bcc_status_t Error code (BCC_STATUS_PARAM_RANGE - temperature out
+ *         of <NTC_MINTEMP, NTC_MAXTEMP>).
+ */
+bcc_status_t getNtcCelsius(uint16_t regVal, int16_t* temp);
+
+/*!
+ * @brief This function starts on-demand conversion and reads measured values.
+ *
+ * @param cid Cluster Identification Address.
+ * @param measurements Content of the measurement registers (result). The array
+ *                     must have at least BCC_MEAS_CNT items.
+ *
+ * @return Error code (BCC_STATUS_SUCCESS - no error).
+ */
+bcc_status_t getMeasurements(uint8_t cid, uint16_t measurements[]);
+
 /*!
  * @brief This function reads the measurement registers and print them to serial
  * console output.
@@ -0,0 +1,201 @@
+/*!
+ * @file pack_can.c
+ *
+ * Pack state encoded as the CAN message set of bms_can.h.
+ */
+
+#include <string.h>
+#include "common.h"            /* DEMO_RSHUNT */
+#include "monitoring.h"        /* getNtcCelsius */
+#include "pack_can.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Mask of the cell bits of CELL_OV_FLT and CELL_UV_FLT registers. */
+#define PACK_CAN_CELL_MASK    0x3FFFU
+
+/*! @brief Limits value to the range of the type. */
+#define PACK_CAN_CLAMP(val, min, max) \
+    (((val) < (min)) ? (min) : (((val) > (max)) ? (max) : (val)))
+
+/*******************************************************************************
+ * Global variables
+ ******************************************************************************/
+
+/*! @brief Frames of the last update. */
+static bms_can_frame_t g_packCanFrames[BMS_CAN_FRAMES_MAX];
+
+/*! @brief Number of valid items of g_packCanFrames. */
+static uint8_t g_packCanFrameCnt;
+
+/*! @brief PACK_STATUS counter. */
+static uint8_t g_packCanCounter;
+
+/*******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+
+/*!
+ * @brief This function returns temperature of an analog input in [degC], or
+ * BMS_CAN_TEMP_NA if it is out of range of the NTC table.
+ *
+ * @param regVal Value of MEAS_ANx register.
+ *
+ * @return Temperature.
+ */
+static int8_t getAnTemp(uint16_t regVal);
+
+/*******************************************************************************
+ * Private functions
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : getAnTemp
+ * Description   : This function returns temperature of an analog input.
+ *
+ *END**************************************************************************/
+static int8_t getAnTemp(uint16_t regVal)
+{
+    int16_t temp;
+
+    if (getNtcCelsius(regVal, &temp) != BCC_STATUS_SUCCESS)
+    {
+        return BMS_CAN_TEMP_NA;
+    }
+
+    return (int8_t)PACK_CAN_CLAMP(temp / 10, BMS_CAN_TEMP_NA + 1, 127);
+}
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : updatePackCan
+ * Description   : This function encodes the pack state to the frames of the
+ *                 message set.
+ *
+ *END**************************************************************************/
+void updatePackCan(const bcc_drv_config_t* const drvConfig,
+    const uint16_t meas[][BCC_MEAS_CNT], const uint16_t faults[][BCC_STAT_CNT],
+    const cell_stats_t* const stats, uint8_t soc, bool stale)
+{
+    bms_can_pack_status_t status;
+    bms_can_cell_stats_t cellStats;
+    bms_can_faults_t devFaults;
+    bms_can_temps_t temps;
+    bms_can_cells_t cells;
+    bms_can_frame_t *frame = g_packCanFrames;
+    uint8_t devCnt = BCC_DEVICES_CNT(drvConfig);
+    uint32_t stackUV = 0U;
+    uint16_t cellCnt, cellIdx;
+    uint8_t dev, i, cell;
+    int32_t current;
+
+    BCC_MCU_Assert(devCnt <= BMS_CAN_DEVICES_MAX);
+
+    memset(&status, 0, sizeof(status));
+    status.tempMax = BMS_CAN_TEMP_NA;
+    status.faults = stale ? BMS_CAN_FLT_COMM : 0U;
+
+    /* FAULTS and TEMPS of each device, PACK_STATUS summary. */
+    frame += 2U;
+    for (dev = 0U; dev < devCnt; dev++)
+    {
+        devFaults.device = dev;
+        devFaults.cellOv = faults[dev][BCC_FS_CELL_OV] & PACK_CAN_CELL_MASK;
+        devFaults.cellUv = faults[dev][BCC_FS_CELL_UV] & PACK_CAN_CELL_MASK;
+        devFaults.fault1 = faults[dev][BCC_FS_FAULT1];
+        devFaults.fault2 = faults[dev][BCC_FS_FAULT2];
+        frame->id = BMS_CAN_ID_FAULTS;
+        bmsCanEncodeFaults(&devFaults, frame->data);
+        frame++;
+
+        status.faults |= (devFaults.cellOv != 0U) ? BMS_CAN_FLT_CELL_OV : 0U;
+        status.faults |= (devFaults.cellUv != 0U) ? BMS_CAN_FLT_CELL_UV : 0U;
+        status.faults |= (faults[dev][BCC_FS_AN_OT_UT] != 0U) ? BMS_CAN_FLT_OT_UT : 0U;
+        /* Note: FAULT1_STATUS summarizes the cell and AN faults above. */
+        status.faults |= ((faults[dev][BCC_FS_FAULT2] | faults[dev][BCC_FS_FAULT3]) != 0U) ?
+                BMS_CAN_FLT_DEVICE : 0U;
+
+        stackUV += BCC_GET_STACK_VOLT(meas[dev][BCC_MSR_STACK_VOLT]);
+    }
+
+    for (dev = 0U; dev < devCnt; dev++)
+    {
+        temps.device = dev;
+        for (i = 0U; i < BMS_CAN_TEMPS_PER_DEV; i++)
+        {
+            temps.temp[i] = getAnTemp(meas[dev][BCC_MSR_AN0 - i]);
+            if (temps.temp[i] > status.tempMax)
+            {
+                status.tempMax = temps.temp[i];
+            }
+        }
+        frame->id = BMS_CAN_ID_TEMPS;
+        bmsCanEncodeTemps(&temps, frame->data);
+        frame++;
+    }
+
+    /* CELLS, fixed numbering of BMS_CAN_CELLS_PER_DEV cells per device. */
+    cellCnt = (uint16_t)devCnt * BMS_CAN_CELLS_PER_DEV;
+    for (cellIdx = 0U; cellIdx < cellCnt; cellIdx += BMS_CAN_CELLS_PER_FRAME)
+    {
+        cells.mux = (uint8_t)(cellIdx / BMS_CAN_CELLS_PER_FRAME);
+        for (i = 0U; i < BMS_CAN_CELLS_PER_FRAME; i++)
+        {
+            dev = (uint8_t)((cellIdx + i) / BMS_CAN_CELLS_PER_DEV);
+            cell = (uint8_t)((cellIdx + i) % BMS_CAN_CELLS_PER_DEV) + 1U;
+            if ((cellIdx + i < cellCnt) && BCC_IS_CELL_CONN(drvConfig, dev + 1U, cell))
+            {
+                cells.cellMv[i] = (uint16_t)(BCC_GET_VOLT(
+                        meas[dev][BCC_MSR_CELL_VOLT1 - (cell - 1U)]) / 1000U);
+            }
+            else
+            {
+                cells.cellMv[i] = BMS_CAN_CELL_NA;
+            }
+        }
+        frame->id = BMS_CAN_ID_CELLS;
+        bmsCanEncodeCells(&cells, frame->data);
+        frame++;
+    }
+
+    /* PACK_STATUS and CELL_STATS first (lowest identifiers). Current is
+     * measured by the device with CID 1. */
+    current = BCC_GET_ISENSE_AMP(DEMO_RSHUNT, meas[0][BCC_MSR_ISENSE1],
+            meas[0][BCC_MSR_ISENSE2]) / 10;
+    status.voltage = (uint16_t)(stackUV / 100000U);
+    status.current = (int16_t)PACK_CAN_CLAMP(current, -32768, 32767);
+    status.soc = soc;
+    status.counter = g_packCanCounter++;
+    status.devices = devCnt;
+    g_packCanFrames[0].id = BMS_CAN_ID_PACK_STATUS;
+    bmsCanEncodePackStatus(&status, g_packCanFrames[0].data);
+
+    cellStats.minMv = (uint16_t)(stats->minUV / 1000U);
+    cellStats.maxMv = (uint16_t)(stats->maxUV / 1000U);
+    cellStats.meanMv = (uint16_t)(stats->meanUV / 1000U);
+    cellStats.stdDevMv = (uint8_t)((stats->stdDevUV < 255000U) ? (stats->stdDevUV / 1000U) : 255U);
+    cellStats.cellCnt = (uint8_t)stats->cellCnt;
+    g_packCanFrames[1].id = BMS_CAN_ID_CELL_STATS;
+    bmsCanEncodeCellStats(&cellStats, g_packCanFrames[1].data);
+
+    g_packCanFrameCnt = (uint8_t)(frame - g_packCanFrames);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : getPackCanFrames
+ * Description   : This function returns the frames of the last update.
+ *
+ *END**************************************************************************/
+const bms_can_frame_t* getPackCanFrames(uint8_t* frameCnt)
+{
+    *frameCnt = g_packCanFrameCnt;
+    return g_packCanFrames;
+}
@@ -0,0 +1,54 @@
+/*!
+ * @file pack_can.h
+ *
+ * Pack state encoded as the CAN message set of bms_can.h.
+ *
+ * updatePackCan converts a pack snapshot (measurement and fault registers of
+ * all devices, cell statistics) to the frames of the message set, which are
+ * kept until the next update. The frames can be sent by a CAN driver or
+ * printed by the "can" shell command in candump log format, so the pack state
+ * can be replayed to the CAN nodes (canplayer) or decoded on a host.
+ */
+
+#ifndef PACK_CAN_H_
+#define PACK_CAN_H_
+
+#include "bcc/bcc.h"
+#include "bms_can.h"
+#include "cell_stats.h"
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief This function encodes the pack state to the frames of the message
+ * set.
+ *
+ * The PACK_STATUS counter is incremented with each call.
+ *
+ * @param drvConfig Pointer to driver instance configuration (number of devices
+ *                  and cell maps).
+ * @param meas Content of measurement registers of all devices, meas[0] belongs
+ *             to the device with CID 1, etc.
+ * @param faults Content of status registers (see BCC_Fault_GetStatus) of all
+ *               devices.
+ * @param stats Statistics computed by calcCellStats from meas.
+ * @param soc State of charge in [0.5 %].
+ * @param stale True if the snapshot is not complete (a device did not
+ *              respond), sets BMS_CAN_FLT_COMM.
+ */
+void updatePackCan(const bcc_drv_config_t* const drvConfig,
+    const uint16_t meas[][BCC_MEAS_CNT], const uint16_t faults[][BCC_STAT_CNT],
+    const cell_stats_t* const stats, uint8_t soc, bool stale);
+
+/*!
+ * @brief This function returns the frames of the last update.
+ *
+ * @param frameCnt Number of frames (zero before the first update).
+ *
+ * @return Pointer to the frames, in the order of their identifiers.
+ */
+const bms_can_frame_t* getPackCanFrames(uint8_t* frameCnt);
+
+#endif /* PACK_CAN_H_ */
@@ -0,0 +1,1212 @@
+/*!
+ * @file shell.c
+ *
+ * Non-blocking command shell running on the debug console (LPUART1).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "utils/nxp_console.h" /* PRINTF, LPUART_GetInstance */
+#include "osif.h"
+#include "common.h"
+#include "monitoring.h"
+#include "pack_can.h"
+#include "shell.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Number of items of the command hash table. */
+#define SHELL_CMD_TBL_SIZE    16U
+
+/*! @brief Perfect hash of a command name. It is collision free for the set of
+ * supported commands (see g_shellCmdTbl), the name still has to be compared
+ * to reject unknown commands. */
+#define SHELL_CMD_HASH(name, len) \
+    ((uint8_t)(((uint8_t)(name)[0] + ((uint8_t)(name)[(len) - 1U] << 1U)) & \
+    (SHELL_CMD_TBL_SIZE - 1U)))
+
+/*! @brief Maximal number of registers read by the "reg r" command. */
+#define SHELL_REG_CNT_MAX     8U
+
+/*! @brief Number of values printed by the stats command. */
+#define SHELL_STATS_CNT       17U
+
+/*! @brief Number of rows of the faults command per device (title and status
+ * registers). */
+#define SHELL_FAULT_ROWS      (1U + BCC_STAT_CNT)
+
+/*! @brief Prompt printed after each command. */
+#define SHELL_PROMPT          "bcc> "
+
+/* Control characters used by the line editing. */
+#define SHELL_CHAR_CTRL_C     0x03U
+#define SHELL_CHAR_BS         0x08U
+#define SHELL_CHAR_DEL        0x7FU
+
+/*******************************************************************************
+ * Structure definition
+ ******************************************************************************/
+
+/*!
+ * @brief Command handler.
+ *
+ * @param argc Number of arguments (including command name).
+ * @param argv Arguments. argv[0] is the command name.
+ *
+ * @return bcc_status_t Error code.
+ */
+typedef bcc_status_t (*shell_cmd_handler_t)(uint8_t argc, char *argv[]);
+
+/*!
+ * @brief Item of the command table.
+ */
+typedef struct
+{
+    const char *name;              /*!< Command name. */
+    shell_cmd_handler_t handler;   /*!< Command handler. */
+    const char *help;              /*!< Usage printed by the help command. */
+} shell_cmd_t;
+
+/*!
+ * @brief Printer of a command output. It prints one row of the output, so
+ * that a long table is spread over several calls of runShell.
+ *
+ * @param row Index of the row (from zero).
+ *
+ * @return False if there is no such row (end of the output).
+ */
+typedef bool (*shell_out_printer_t)(uint16_t row);
+
+/*!
+ * @brief Output of a command printed row by row.
+ */
+typedef struct
+{
+    shell_out_printer_t print;    /*!< Row printer (NULL - no output). */
+    uint16_t row;                 /*!< Next row. */
+    uint8_t cid;                  /*!< Device (first device of faults). */
+    uint8_t lastCid;              /*!< Last device of faults. */
+    uint8_t addr;                 /*!< First register address of reg r. */
+    uint8_t cnt;                  /*!< Number of registers of reg r. */
+    uint32_t time;                /*!< Time of the command in [ms]. */
+    union
+    {
+        uint16_t regs[BCC_MEAS_CNT];        /*!< Measurement, status or
+                                                 read registers. */
+        uint32_t values[SHELL_STATS_CNT];   /*!< Values of stats. */
+        struct
+        {
+            cell_stats_t stats;             /*!< Pack statistics. */
+            int32_t deviation[BCC_DEVICE_CNT_MAX][BCC_MAX_CELLS];
+                                            /*!< Deviation of cells from
+                                                 the mean in [uV]. */
+        } pack;                             /*!< Captured by pack. */
+    } data;                       /*!< Data captured by the command. */
+} shell_out_t;
+
+/*!
+ * @brief Item of the status register table of the faults command.
+ */
+typedef struct
+{
+    const char *name;   /*!< Register name. */
+    uint8_t index;      /*!< Index in the status registers (bcc_fault_status_t). */
+    bool fault;         /*!< True for a fault register (zero - no event). */
+} shell_status_reg_t;
+
+/*******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+
+/*!
+ * @brief LPUART receive callback. It stores the received character to the ring
+ * buffer and provides the driver with the buffer for the next character.
+ *
+ * @param driverState LPUART driver state.
+ * @param event Event type.
+ * @param userData Not used.
+ */
+static void shellRxCallback(void *driverState, uart_event_t event,
+    void *userData);
+
+/*!
+ * @brief This function handles one received character (line editing).
+ *
+ * @param ch Received character.
+ *
+ * @return True if the command line is complete.
+ */
+static bool editLine(uint8_t ch);
+
+/*!
+ * @brief This function splits the command line to arguments and executes the
+ * command.
+ */
+static void executeLine(void);
+
+/*!
+ * @brief This function prints cell voltages of one device (stream output).
+ */
+static void streamMeas(void);
+
+/*!
+ * @brief This function converts an argument to a number (decimal or
+ * hexadecimal with 0x prefix).
+ *
+ * @param arg Argument.
+ * @param max Maximal admissible value.
+ * @param value Converted value.
+ *
+ * @return bcc_status_t Error code.
+ */
+static bcc_status_t parseNum(const char *arg, uint32_t max, uint32_t *value);
+
+/*!
+ * @brief This function converts an argument to CID and checks it is in range
+ * of configured devices.
+ *
+ * @param arg Argument.
+ * @param cid Converted CID.
+ *
+ * @return bcc_status_t Error code.
+ */
+static bcc_status_t parseCid(const char *arg, uint8_t *cid);
+
+/*!
+ * @brief This function starts the row by row output of a command.
+ *
+ * @param print Row printer.
+ */
+static void startOutput(shell_out_printer_t print);
+
+/*!
+ * @brief This function prints a temperature in [0.1 degC].
+ *
+ * @param name Name of the measurement.
+ * @param temp Temperature in [0.1 degC].
+ */
+static void printTemp(const char *name, int32_t temp);
+
+static bool outHelpRow(uint16_t row);
+static bool outMeasRow(uint16_t row);
+static bool outFaultsRow(uint16_t row);
+static bool outRegRow(uint16_t row);
+static bool outStatsRow(uint16_t row);
+static bool outCanRow(uint16_t row);
+static bool outPackRow(uint16_t row);
+
+static bcc_status_t cmdHelp(uint8_t argc, char *argv[]);
+static bcc_status_t cmdMeas(uint8_t argc, char *argv[]);
+static bcc_status_t cmdFaults(uint8_t argc, char *argv[]);
+static bcc_status_t cmdCb(uint8_t argc, char *argv[]);
+static bcc_status_t cmdReg(uint8_t argc, char *argv[]);
+static bcc_status_t cmdStats(uint8_t argc, char *argv[]);
+static bcc_status_t cmdStream(uint8_t argc, char *argv[]);
+static bcc_status_t cmdCan(uint8_t argc, char *argv[]);
+static bcc_status_t cmdPack(uint8_t argc, char *argv[]);
+
+/*******************************************************************************
+ * Global variables
+ ******************************************************************************/
+
+/*! @brief Command table indexed by SHELL_CMD_HASH of the command name. */
+static const shell_cmd_t g_shellCmdTbl[SHELL_CMD_TBL_SIZE] =
+{
+    [0]  = { "reg",    cmdReg,    "reg r <cid> <addr> [cnt] | reg w <cid> <addr> <val>" },
+    [3]  = { "meas",   cmdMeas,   "meas <cid>" },
+    [6]  = { "pack",   cmdPack,   "pack" },
+    [7]  = { "cb",     cmdCb,     "cb <cid> <cell> <on|off>" },
+    [8]  = { "help",   cmdHelp,   "help" },
+    [9]  = { "stats",  cmdStats,  "stats" },
+    [12] = { "faults", cmdFaults, "faults [cid]" },
+    [13] = { "stream", cmdStream, "stream <on|off>" },
+    [15] = { "can",    cmdCan,    "can" },
+};
+
+/*! @brief Status registers printed by the faults command. */
+static const shell_status_reg_t g_shellStatusRegs[BCC_STAT_CNT] =
+{
+    { "CELL_OV",    BCC_FS_CELL_OV,      true },
+    { "CELL_UV",    BCC_FS_CELL_UV,      true },
+    { "CB_OPEN",    BCC_FS_CB_OPEN,      true },
+    { "CB_SHORT",   BCC_FS_CB_SHORT,     true },
+    { "AN_OT_UT",   BCC_FS_AN_OT_UT,     true },
+    { "GPIO_SHORT", BCC_FS_GPIO_SHORT,   true },
+    { "FAULT1",     BCC_FS_FAULT1,       true },
+    { "FAULT2",     BCC_FS_FAULT2,       true },
+    { "FAULT3",     BCC_FS_FAULT3,       true },
+    { "GPIO_STS",   BCC_FS_GPIO_STATUS,  false },
+    { "COM_STATUS", BCC_FS_COMM,         false },
+};
+
+/*! @brief Labels of the values printed by the stats command. */
+static const char *const g_shellStatsLabels[SHELL_STATS_CNT] =
+{
+    "RX chars      ", "RX overruns   ", "RX errors     ", "RX start err. ",
+    "Line overruns ", "Commands      ", "Unknown       ", "Failed        ",
+    "BCC retries   ", "BCC CRC err.  ", "BCC RC/TAG    ", "BCC null resp.",
+    "BCC timeouts  ", "BCC resyncs   ", "BCC wake-ups  ", "BCC failures  ",
+    "BCC degraded  ",
+};
+
+/*! @brief Receive ring buffer. Written by the LPUART interrupt only. */
+static volatile uint8_t g_shellRxBuf[SHELL_RX_BUF_SIZE];
+/*! @brief Write index of the ring buffer (LPUART interrupt). */
+static volatile uint32_t g_shellRxHead;
+/*! @brief Read index of the ring buffer (shell task). */
+static volatile uint32_t g_shellRxTail;
+/*! @brief Character being received by the LPUART driver. */
+static uint8_t g_shellRxChar;
+
+/*! @brief LPUART instance of the debug console. */
+static uint32_t g_shellLpuart;
+
+/*! @brief Command line being edited. */
+static char g_shellLine[SHELL_LINE_SIZE + 1U];
+/*! @brief Length of the command line. */
+static uint8_t g_shellLineLen;
+/*! @brief True if the command line did not fit into g_shellLine. */
+static bool g_shellLineOverrun;
+
+/*! @brief Stream output enabled. */
+static bool g_shellStream;
+/*! @brief Time of the last stream output in [ms]. */
+static uint32_t g_shellStreamTime;
+/*! @brief CID of the device printed by the next stream output. */
+static uint8_t g_shellStreamCid;
+
+/*! @brief Output of the last command, printed one row per runShell. */
+static shell_out_t g_shellOut;
+
+/*! @brief Shell statistics. */
+static shell_stats_t g_shellStats;
+
+/*******************************************************************************
+ * Private functions
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : shellRxCallback
+ * Description   : LPUART receive callback. It stores the received character
+ *                 to the ring buffer and provides the driver with the buffer
+ *                 for the next character.
+ *
+ *END**************************************************************************/
+static void shellRxCallback(void *driverState, uart_event_t event,
+    void *userData)
+{
+    uint32_t head;
+
+    (void)driverState;
+    (void)userData;
+
+    if (event == UART_EVENT_RX_FULL)
+    {
+        head = g_shellRxHead;
+        if ((head - g_shellRxTail) < SHELL_RX_BUF_SIZE)
+        {
+            g_shellRxBuf[head & (SHELL_RX_BUF_SIZE - 1U)] = g_shellRxChar;
+            g_shellRxHead = head + 1U;
+        }
+        else
+        {
+            g_shellStats.rxOverruns++;
+        }
+
+        /* Continuous reception. */
+        (void)LPUART_DRV_SetRxBuffer(g_shellLpuart, &g_shellRxChar, 1U);
+    }
+    else if (event == UART_EVENT_ERROR)
+    {
+        g_shellStats.rxErrors++;
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : editLine
+ * Description   : This function handles one received character (line
+ *                 editing).
+ *
+ *END**************************************************************************/
+static bool editLine(uint8_t ch)
+{
+    if ((ch == '\r') || (ch == '\n'))
+    {
+        PRINTF("\r\n");
+        if ((g_shellLineLen == 0U) && !g_shellLineOverrun)
+        {
+            /* Empty line (or LF of CR-LF pair). */
+            PRINTF(SHELL_PROMPT);
+            return false;
+        }
+
+        g_shellLine[g_shellLineLen] = '\0';
+        return true;
+    }
+
+    if ((ch == SHELL_CHAR_BS) || (ch == SHELL_CHAR_DEL))
+    {
+        if (g_shellLineLen > 0U)
+        {
+            g_shellLineLen--;
+            PRINTF("\b \b");
+        }
+    }
+    else if (ch == SHELL_CHAR_CTRL_C)
+    {
+        g_shellLineLen = 0U;
+        g_shellLineOverrun = false;
+        PRINTF("^C\r\n" SHELL_PROMPT);
+    }
+    else if ((ch >= ' ') && (ch < SHELL_CHAR_DEL))
+    {
+        if (g_shellLineLen < SHELL_LINE_SIZE)
+        {
+            g_shellLine[g_shellLineLen++] = (char)ch;
+            PUTCHAR(ch);
+        }
+        else
+        {
+            g_shellLineOverrun = true;
+        }
+    }
+
+    return false;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : executeLine
+ * Description   : This function splits the command line to arguments and
+ *                 executes the command.
+ *
+ *END**************************************************************************/
+static void executeLine(void)
+{
+    char *argv[SHELL_ARGS_MAX];
+    uint8_t argc = 0U;
+    char *token;
+    size_t len;
+    const shell_cmd_t *cmd;
+    bcc_status_t error;
+
+    if (g_shellLineOverrun)
+    {
+        g_shellStats.lineOverruns++;
+        PRINTF("Line too long\r\n");
+    }
+    else
+    {
+        token = strtok(g_shellLine, " ");
+        while ((token != NULL) && (argc < SHELL_ARGS_MAX))
+        {
+            argv[argc++] = token;
+            token = strtok(NULL, " ");
+        }
+
+        if (argc > 0U)
+        {
+            len = strlen(argv[0]);
+            cmd = &g_shellCmdTbl[SHELL_CMD_HASH(argv[0], len)];
+
+            if ((cmd->name == NULL) || (strcmp(cmd->name, argv[0]) != 0))
+            {
+                g_shellStats.cmdUnknown++;
+                PRINTF("Unknown command \"%s\", type help\r\n", argv[0]);
+            }
+            else
+            {
+                g_shellStats.cmdExecuted++;
+                if ((error = cmd->handler(argc, argv)) != BCC_STATUS_SUCCESS)
+                {
+                    g_shellStats.cmdFailed++;
+                    if (error == BCC_STATUS_PARAM_RANGE)
+                    {
+                        PRINTF("Usage: %s\r\n", cmd->help);
+                    }
+                    else
+                    {
+                        PRINTF("Error (0x%04x)\r\n", error);
+                    }
+                }
+            }
+        }
+    }
+
+    g_shellLineLen = 0U;
+    g_shellLineOverrun = false;
+    if (g_shellOut.print == NULL)
+    {
+        PRINTF(SHELL_PROMPT);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : streamMeas
+ * Description   : This function prints cell voltages of one device (stream
+ *                 output). Devices are printed in round-robin manner.
+ *
+ *END**************************************************************************/
+static void streamMeas(void)
+{
+    uint16_t measurements[BCC_MEAS_CNT];
+    uint8_t cid = g_shellStreamCid;
+    uint8_t cell;
+    bcc_status_t error;
+
+    g_shellStreamCid = (cid >= BCC_DEVICES_CNT(&g_bccData.drvConfig)) ? 1U : cid + 1U;
+
+    if ((error = getMeasurements(cid, measurements)) != BCC_STATUS_SUCCESS)
+    {
+        PRINTF("%u CID %d: error (0x%04x)\r\n", g_shellStreamTime, cid, error);
+        return;
+    }
+
+    PRINTF("%u CID %d: %u mV |", g_shellStreamTime, cid,
+            BCC_GET_STACK_VOLT(measurements[BCC_MSR_STACK_VOLT]) / 1000U);
+    for (cell = 1U; cell <= BCC_MAX_CELLS; cell++)
+    {
+        if (BCC_IS_CELL_CONN(&g_bccData.drvConfig, cid, cell))
+        {
+            PRINTF(" %u", BCC_GET_VOLT(measurements[BCC_MSR_CELL_VOLT1 -
+                    (cell - 1U)]) / 1000U);
+        }
+    }
+    PRINTF("\r\n");
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : parseNum
+ * Description   : This function converts an argument to a number (decimal or
+ *                 hexadecimal with 0x prefix).
+ *
+ *END**************************************************************************/
+static bcc_status_t parseNum(const char *arg, uint32_t max, uint32_t *value)
+{
+    char *end;
+
+    *value = (uint32_t)strtoul(arg, &end, 0);
+
+    return ((end == arg) || (*end != '\0') || (*value > max)) ?
+            BCC_STATUS_PARAM_RANGE : BCC_STATUS_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : parseCid
+ * Description   : This function converts an argument to CID and checks it is
+ *                 in range of configured devices.
+ *
+ *END**************************************************************************/
+static bcc_status_t parseCid(const char *arg, uint8_t *cid)
+{
+    uint32_t value;
+
+    if ((parseNum(arg, BCC_DEVICES_CNT(&g_bccData.drvConfig), &value)
+            != BCC_STATUS_SUCCESS) || (value == 0U))
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    *cid = (uint8_t)value;
+    return BCC_STATUS_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : startOutput
+ * Description   : This function starts the row by row output of a command.
+ *
+ *END**************************************************************************/
+static void startOutput(shell_out_printer_t print)
+{
+    g_shellOut.print = print;
+    g_shellOut.row = 0U;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : printTemp
+ * Description   : This function prints a temperature in [0.1 degC].
+ *
+ *END**************************************************************************/
+static void printTemp(const char *name, int32_t temp)
+{
+    PRINTF("  %s: %s%d.%d degC\r\n", name, (temp < 0) ? "-" : "",
+            abs(temp) / 10, abs(temp) % 10);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : outHelpRow
+ * Description   : Prints usage of one command.
+ *
+ *END**************************************************************************/
+static bool outHelpRow(uint16_t row)
+{
+    uint8_t i;
+
+    for (i = 0U; i < SHELL_CMD_TBL_SIZE; i++)
+    {
+        if ((g_shellCmdTbl[i].name != NULL) && (row-- == 0U))
+        {
+            PRINTF("  %s\r\n", g_shellCmdTbl[i].help);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : outMeasRow
+ * Description   : Prints one row of the measurements captured by cmdMeas:
+ *                 title, coulomb counter, current, stack voltage, cell
+ *                 voltages, AN0 - AN6 temperatures, IC temperature and band
+ *                 gap references.
+ *
+ *END**************************************************************************/
+static bool outMeasRow(uint16_t row)
+{
+    const uint16_t *meas = g_shellOut.data.regs;
+    uint8_t cells = BCC_MAX_CELLS_DEV(BCC_DEVICE_TYPE(&g_bccData.drvConfig,
+            g_shellOut.cid));
+    int16_t temp;
+
+    switch (row)
+    {
+        case 0U:
+            PRINTF("# CID %d (MC3377%s): Measurements\r\n", g_shellOut.cid,
+                    (cells == BCC_MAX_CELLS_MC33771) ? "1" : "2");
+            return true;
+
+        case 1U:
+            PRINTF("  C CNT     : %d (%u samples)\r\n",
+                    (int32_t)BCC_GET_COULOMB_CNT(meas[BCC_MSR_COULOMB_CNT1],
+                    meas[BCC_MSR_COULOMB_CNT2]), meas[BCC_MSR_CC_NB_SAMPLES]);
+            return true;
+
+        case 2U:
+            PRINTF("  ISENSE    : %d uV, %d mA\r\n",
+                    BCC_GET_ISENSE_VOLT(meas[BCC_MSR_ISENSE1],
+                    meas[BCC_MSR_ISENSE2]),
+                    BCC_GET_ISENSE_AMP(DEMO_RSHUNT, meas[BCC_MSR_ISENSE1],
+                    meas[BCC_MSR_ISENSE2]));
+            return true;
+
+        case 3U:
+            PRINTF("  STACK     : %u mV\r\n",
+                    BCC_GET_STACK_VOLT(meas[BCC_MSR_STACK_VOLT]) / 1000U);
+            return true;
+
+        default:
+            break;
+    }
+
+    /* Cell voltages. */
+    row -= 4U;
+    if (row < cells)
+    {
+        PRINTF("  CELL %-2u   : %u mV\r\n", row + 1U,
+                BCC_GET_VOLT(meas[BCC_MSR_CELL_VOLT1 - row]) / 1000U);
+        return true;
+    }
+
+    /* Temperature measured on AN0 - AN6. */
+    row -= cells;
+    if (row <= 6U)
+    {
+        if (getNtcCelsius(meas[BCC_MSR_AN0 - row], &temp) != BCC_STATUS_SUCCESS)
+        {
+            PRINTF("  AN %u      : out of range\r\n", row);
+        }
+        else
+        {
+            PRINTF("  AN %u    ", row);
+            printTemp("", temp);
+        }
+        return true;
+    }
+
+    row -= 7U;
+    if (row == 0U)
+    {
+        printTemp("IC TEMP   ", BCC_GET_IC_TEMP(meas[BCC_MSR_ICTEMP]));
+        return true;
+    }
+    if (row == 1U)
+    {
+        PRINTF("  VBG ADC1  : %u mV, %u mV\r\n",
+                BCC_GET_VOLT(meas[BCC_MSR_VBGADC1A]) / 1000U,
+                BCC_GET_VOLT(meas[BCC_MSR_VBGADC1B]) / 1000U);
+        return true;
+    }
+
+    return false;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : outFaultsRow
+ * Description   : Prints one row of the faults output. The status registers
+ *                 of a device are read by its title row.
+ *
+ *END**************************************************************************/
+static bool outFaultsRow(uint16_t row)
+{
+    uint8_t cid = g_shellOut.cid + (uint8_t)(row / SHELL_FAULT_ROWS);
+    const shell_status_reg_t *reg;
+    uint16_t value;
+    bcc_status_t error;
+
+    if (cid > g_shellOut.lastCid)
+    {
+        return false;
+    }
+
+    row %= SHELL_FAULT_ROWS;
+    if (row == 0U)
+    {
+        error = BCC_Fault_GetStatus(&g_bccData.drvConfig, (bcc_cid_t)cid,
+                g_shellOut.data.regs);
+        if (error != BCC_STATUS_SUCCESS)
+        {
+            g_shellStats.cmdFailed++;
+            PRINTF("Error (0x%04x)\r\n", error);
+            return false;
+        }
+
+        PRINTF("# CID %d (MC3377%s): Device status\r\n", cid,
+                (BCC_DEVICE_TYPE(&g_bccData.drvConfig, cid) ==
+                BCC_DEVICE_MC33771) ? "1" : "2");
+        return true;
+    }
+
+    /* Value of all fault registers without an event is zero. GPIO_STS and
+     * COM_STATUS are not fault registers. */
+    reg = &g_shellStatusRegs[row - 1U];
+    value = g_shellOut.data.regs[reg->index];
+    PRINTF("  %-10s: 0x%04x %s\r\n", reg->name, value,
+            !reg->fault ? "" : ((value != 0U) ? "fault" : "-"));
+
+    return true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : outRegRow
+ * Description   : Prints one register read by cmdReg.
+ *
+ *END**************************************************************************/
+static bool outRegRow(uint16_t row)
+{
+    if (row >= g_shellOut.cnt)
+    {
+        return false;
+    }
+
+    PRINTF("  0x%02x: 0x%04x\r\n", g_shellOut.addr + row,
+            g_shellOut.data.regs[row]);
+
+    return true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : outStatsRow
+ * Description   : Prints one value captured by cmdStats, followed by the list
+ *                 of degraded devices.
+ *
+ *END**************************************************************************/
+static bool outStatsRow(uint16_t row)
+{
+    uint8_t cid;
+
+    if (row < SHELL_STATS_CNT)
+    {
+        PRINTF("  %s: %u\r\n", g_shellStatsLabels[row],
+                g_shellOut.data.values[row]);
+        return true;
+    }
+
+    cid = (uint8_t)(row - SHELL_STATS_CNT + 1U);
+    if (cid > BCC_DEVICES_CNT(&g_bccData.drvConfig))
+    {
+        return false;
+    }
+
+    if (BCC_IsDegraded(&g_bccData.drvConfig, (bcc_cid_t)cid))
+    {
+        PRINTF("  CID %d is degraded\r\n", cid);
+    }
+
+    return true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : outCanRow
+ * Description   : Prints one CAN frame of the pack state in candump log
+ *                 format (replayable by canplayer).
+ *
+ *END**************************************************************************/
+static bool outCanRow(uint16_t row)
+{
+    const bms_can_frame_t *frame;
+    uint32_t now = g_shellOut.time;
+    uint8_t cnt;
+
+    frame = getPackCanFrames(&cnt);
+    if (row >= cnt)
+    {
+        return false;
+    }
+
+    frame += row;
+    PRINTF("(%u.%03u000) can0 %03X#%02X%02X%02X%02X%02X%02X%02X%02X\r\n",
+            now / 1000U, now % 1000U, frame->id,
+            frame->data[0], frame->data[1], frame->data[2], frame->data[3],
+            frame->data[4], frame->data[5], frame->data[6], frame->data[7]);
+
+    return true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : outPackRow
+ * Description   : Prints one row of the pack snapshot captured by cmdPack:
+ *                 statistics, then deviation of the cells of one device.
+ *
+ *END**************************************************************************/
+static bool outPackRow(uint16_t row)
+{
+    const cell_stats_t *stats = &g_shellOut.data.pack.stats;
+    uint8_t cell;
+
+    if (row == 0U)
+    {
+        PRINTF("# Pack: %u cells, %u / %u / %u mV (min / mean / max), "
+                "std. dev. %u uV\r\n", stats->cellCnt, stats->minUV / 1000U,
+                stats->meanUV / 1000U, stats->maxUV / 1000U, stats->stdDevUV);
+        return true;
+    }
+
+    if (row > BCC_DEVICES_CNT(&g_bccData.drvConfig))
+    {
+        return false;
+    }
+
+    /* Deviation from the mean in [mV], cells from 1. */
+    PRINTF("  CID %d:", row);
+    for (cell = 1U; cell <= BCC_MAX_CELLS; cell++)
+    {
+        if (BCC_IS_CELL_CONN(&g_bccData.drvConfig, row, cell))
+        {
+            PRINTF(" %d", g_shellOut.data.pack.deviation[row - 1U][cell - 1U] / 1000);
+        }
+    }
+    PRINTF(" mV\r\n");
+
+    return true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : cmdHelp
+ * Description   : Prints usage of all commands.
+ *
+ *END**************************************************************************/
+static bcc_status_t cmdHelp(uint8_t argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    startOutput(outHelpRow);
+
+    return BCC_STATUS_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : cmdMeas
+ * Description   : Measures a device, the values are printed by outMeasRow.
+ *
+ *END**************************************************************************/
+static bcc_status_t cmdMeas(uint8_t argc, char *argv[])
+{
+    bcc_status_t error;
+
+    if ((argc != 2U) || (parseCid(argv[1], &g_shellOut.cid) != BCC_STATUS_SUCCESS))
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    if ((error = getMeasurements(g_shellOut.cid, g_shellOut.data.regs))
+            != BCC_STATUS_SUCCESS)
+    {
+        return error;
+    }
+
+    startOutput(outMeasRow);
+
+    return BCC_STATUS_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : cmdFaults
+ * Description   : Prints fault registers of one or all devices (by
+ *                 outFaultsRow).
+ *
+ *END**************************************************************************/
+static bcc_status_t cmdFaults(uint8_t argc, char *argv[])
+{
+    if (argc == 2U)
+    {
+        if (parseCid(argv[1], &g_shellOut.cid) != BCC_STATUS_SUCCESS)
+        {
+            return BCC_STATUS_PARAM_RANGE;
+        }
+
+        g_shellOut.lastCid = g_shellOut.cid;
+    }
+    else if (argc == 1U)
+    {
+        g_shellOut.cid = 1U;
+        g_shellOut.lastCid = BCC_DEVICES_CNT(&g_bccData.drvConfig);
+    }
+    else
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    startOutput(outFaultsRow);
+
+    return BCC_STATUS_SUCCESS;
+}
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : cmdCb
+ * Description   : Enables or disables cell balancing of a cell.
+ *
+ *END**************************************************************************/
+static bcc_status_t cmdCb(uint8_t argc, char *argv[])
+{
+    uint8_t cid;
+    uint32_t cell;
+    bool enable;
+
+    if ((argc != 4U) || (parseCid(argv[1], &cid) != BCC_STATUS_SUCCESS) ||
+            (parseNum(argv[2], BCC_MAX_CELLS, &cell) != BCC_STATUS_SUCCESS) ||
+            (cell == 0U))
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    if (strcmp(argv[3], "on") == 0)
+    {
+        enable = true;
+    }
+    else if (strcmp(argv[3], "off") == 0)
+    {
+        enable = false;
+    }
+    else
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    return BCC_CB_SetIndividual(&g_bccData.drvConfig, (bcc_cid_t)cid,
+            (uint8_t)(cell - 1U), enable, BCC_RW_CB_TIMER_MASK);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : cmdReg
+ * Description   : Reads or writes BCC registers.
+ *
+ *END**************************************************************************/
+static bcc_status_t cmdReg(uint8_t argc, char *argv[])
+{
+    uint8_t cid;
+    uint32_t addr;
+    uint32_t value = 1U;
+    bcc_status_t error;
+
+    if ((argc < 4U) || (argc > 5U) ||
+            (parseCid(argv[2], &cid) != BCC_STATUS_SUCCESS) ||
+            (parseNum(argv[3], BCC_MAX_REG_ADDR, &addr) != BCC_STATUS_SUCCESS))
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    if (strcmp(argv[1], "r") == 0)
+    {
+        if ((argc == 5U) && ((parseNum(argv[4], SHELL_REG_CNT_MAX, &value)
+                != BCC_STATUS_SUCCESS) || (value == 0U)))
+        {
+            return BCC_STATUS_PARAM_RANGE;
+        }
+
+        error = BCC_Reg_Read(&g_bccData.drvConfig, (bcc_cid_t)cid,
+                (uint8_t)addr, (uint8_t)value, g_shellOut.data.regs);
+        if (error != BCC_STATUS_SUCCESS)
+        {
+            return error;
+        }
+
+        g_shellOut.addr = (uint8_t)addr;
+        g_shellOut.cnt = (uint8_t)value;
+        startOutput(outRegRow);
+    }
+    else if ((strcmp(argv[1], "w") == 0) && (argc == 5U))
+    {
+        if (parseNum(argv[4], 0xFFFFU, &value) != BCC_STATUS_SUCCESS)
+        {
+            return BCC_STATUS_PARAM_RANGE;
+        }
+
+        error = BCC_Reg_Write(&g_bccData.drvConfig, (bcc_cid_t)cid,
+                (uint8_t)addr, (uint16_t)value, NULL);
+        if (error != BCC_STATUS_SUCCESS)
+        {
+            return error;
+        }
+    }
+    else
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    return BCC_STATUS_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : cmdStats
+ * Description   : Prints shell statistics.
+ *
+ *END**************************************************************************/
+static bcc_status_t cmdStats(uint8_t argc, char *argv[])
+{
+    const bcc_recovery_stats_t *stats;
+    uint32_t *value = g_shellOut.data.values;
+
+    (void)argc;
+    (void)argv;
+
+    /* Same order as g_shellStatsLabels. */
+    stats = BCC_GetRecoveryStats(&g_bccData.drvConfig);
+    value[0] = g_shellStats.rxChars;
+    value[1] = g_shellStats.rxOverruns;
+    value[2] = g_shellStats.rxErrors;
+    value[3] = g_shellStats.rxStartErrors;
+    value[4] = g_shellStats.lineOverruns;
+    value[5] = g_shellStats.cmdExecuted;
+    value[6] = g_shellStats.cmdUnknown;
+    value[7] = g_shellStats.cmdFailed;
+    value[8] = stats->retries;
+    value[9] = stats->crcErrors;
+    value[10] = stats->rcTagErrors;
+    value[11] = stats->nullResps;
+    value[12] = stats->timeouts;
+    value[13] = stats->resyncs;
+    value[14] = stats->wakeUps;
+    value[15] = stats->failures;
+    value[16] = stats->degraded;
+
+    startOutput(outStatsRow);
+
+    return BCC_STATUS_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : cmdStream
+ * Description   : Enables or disables periodic print of cell voltages.
+ *
+ *END**************************************************************************/
+static bcc_status_t cmdStream(uint8_t argc, char *argv[])
+{
+    if (argc != 2U)
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    if (strcmp(argv[1], "on") == 0)
+    {
+        g_shellStream = true;
+        g_shellStreamCid = 1U;
+        g_shellStreamTime = OSIF_GetMilliseconds() - SHELL_STREAM_PERIOD;
+    }
+    else if (strcmp(argv[1], "off") == 0)
+    {
+        g_shellStream = false;
+    }
+    else
+    {
+        return BCC_STATUS_PARAM_RANGE;
+    }
+
+    return BCC_STATUS_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : cmdCan
+ * Description   : Prints the CAN frames of the pack state in candump log
+ *                 format (replayable by canplayer).
+ *
+ *END**************************************************************************/
+static bcc_status_t cmdCan(uint8_t argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    g_shellOut.time = OSIF_GetMilliseconds();
+    startOutput(outCanRow);
+
+    return BCC_STATUS_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : cmdPack
+ * Description   : Prints statistics of the last pack scan and deviation of
+ *                 each cell from the mean cell voltage (by outPackRow).
+ *
+ *END**************************************************************************/
+static bcc_status_t cmdPack(uint8_t argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    g_shellOut.data.pack.stats = g_cellStats;
+    calcCellDeviation(&g_bccData.drvConfig,
+            (const uint16_t (*)[BCC_MEAS_CNT])g_packMeas,
+            &g_shellOut.data.pack.stats, g_shellOut.data.pack.deviation);
+    startOutput(outPackRow);
+
+    return BCC_STATUS_SUCCESS;
+}
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : initShell
+ * Description   : This function initializes the shell and starts interrupt
+ *                 driven reception on the debug console LPUART.
+ *
+ *END**************************************************************************/
+status_t initShell(void)
+{
+    status_t error;
+
+    g_shellLpuart = LPUART_GetInstance((void *)BOARD_DEBUG_UART_BASEADDR);
+    g_shellRxHead = 0U;
+    g_shellRxTail = 0U;
+    g_shellLineLen = 0U;
+    g_shellLineOverrun = false;
+    g_shellStream = false;
+    g_shellOut.print = NULL;
+    (void)memset(&g_shellStats, 0, sizeof(g_shellStats));
+
+    /* Start the OSIF timer used by the stream output. */
+    OSIF_TimeDelay(0U);
+
+    (void)LPUART_DRV_InstallRxCallback(g_shellLpuart, shellRxCallback, NULL);
+
+    PRINTF("\r\nType help for list of commands.\r\n" SHELL_PROMPT);
+
+    error = LPUART_DRV_ReceiveData(g_shellLpuart, &g_shellRxChar, 1U);
+    if (error != STATUS_SUCCESS)
+    {
+        /* Retried by runShell. */
+        g_shellStats.rxStartErrors++;
+    }
+
+    return error;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : runShell
+ * Description   : This function runs one slot of the shell. It processes at
+ *                 most SHELL_RX_BUDGET received characters and executes at
+ *                 most one command (or one stream output). Output of the
+ *                 command is printed one row per call.
+ *
+ *END**************************************************************************/
+void runShell(void)
+{
+    uint32_t budget = SHELL_RX_BUDGET;
+    uint32_t bytesRemaining;
+    uint32_t now;
+    uint8_t ch;
+
+    /* Restart the reception if it was stopped by a receive error or could
+     * not be started by initShell. */
+    if ((LPUART_DRV_GetReceiveStatus(g_shellLpuart, &bytesRemaining) != STATUS_BUSY)
+            && (LPUART_DRV_ReceiveData(g_shellLpuart, &g_shellRxChar, 1U)
+            != STATUS_SUCCESS))
+    {
+        g_shellStats.rxStartErrors++;
+    }
+
+    /* Print the next row of the command output, the input waits for it. */
+    if (g_shellOut.print != NULL)
+    {
+        if (!g_shellOut.print(g_shellOut.row++))
+        {
+            g_shellOut.print = NULL;
+            PRINTF(SHELL_PROMPT);
+        }
+        return;
+    }
+
+    while ((budget > 0U) && (g_shellRxTail != g_shellRxHead))
+    {
+        ch = g_shellRxBuf[g_shellRxTail & (SHELL_RX_BUF_SIZE - 1U)];
+        g_shellRxTail++;
+        g_shellStats.rxChars++;
+        budget--;
+
+        if (editLine(ch))
+        {
+            /* The rest of the input is processed in the next slot. */
+            executeLine();
+            return;
+        }
+    }
+
+    if (g_shellStream)
+    {
+        now = OSIF_GetMilliseconds();
+        if ((now - g_shellStreamTime) >= SHELL_STREAM_PERIOD)
+        {
+            g_shellStreamTime = now;
+            streamMeas();
+        }
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : getShellStats
+ * Description   : This function returns the shell statistics.
+ *
+ *END**************************************************************************/
+const shell_stats_t* getShellStats(void)
+{
+    return &g_shellStats;
+}
@@ -0,0 +1,109 @@
+/*!
+ * @file shell.h
+ *
+ * Non-blocking command shell running on the debug console (LPUART1).
+ *
+ * Received characters are stored to a ring buffer by the LPUART receive
+ * interrupt. The shell task consumes a bounded number of characters per call,
+ * echoes them back (line editing) and executes at most one command per call.
+ * Output of a command is printed one row per call (the input waits until the
+ * output ends), so it can be run from the main loop without disturbing
+ * measurement timing.
+ *
+ * Supported commands:
+ *  - help                          List of the commands.
+ *  - meas <cid>                    Print measurements of a device.
+ *  - faults [cid]                  Print fault registers (all devices if cid
+ *                                  is omitted).
+ *  - cb <cid> <cell> <on|off>      Control cell balancing of a cell (cells
+ *                                  indexed from 1).
+ *  - reg r <cid> <addr> [cnt]      Read register(s).
+ *  - reg w <cid> <addr> <val>      Write a register.
+ *  - stats                         Print shell statistics and statistics
+ *                                  of the BCC error recovery.
+ *  - stream <on|off>               Periodic print of cell voltages.
+ *  - can                           Print the CAN frames of the pack state
+ *                                  (see pack_can.h) in candump log format.
+ *  - pack                          Print statistics of the last pack scan and
+ *                                  deviation of each cell from the mean.
+ *
+ * Note that DbgConsole_Getchar and DbgConsole_Scanf (GETCHAR, SCANF) must not
+ * be used after initShell is called, because the shell owns the receiver.
+ */
+
+#ifndef SHELL_H_
+#define SHELL_H_
+
+#include "Cpu.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Size of the receive ring buffer. Must be a power of two. */
+#define SHELL_RX_BUF_SIZE     64U
+
+/*! @brief Maximal length of a command line (without terminating character). */
+#define SHELL_LINE_SIZE       48U
+
+/*! @brief Maximal number of received characters processed by one call of
+ * runShell. It bounds the time spent in the shell slot. */
+#define SHELL_RX_BUDGET       8U
+
+/*! @brief Maximal number of command arguments (including command name). */
+#define SHELL_ARGS_MAX        6U
+
+/*! @brief Period of the stream output in [ms]. */
+#define SHELL_STREAM_PERIOD   1000U
+
+/*******************************************************************************
+ * Structure definition
+ ******************************************************************************/
+
+/*!
+ * @brief Shell statistics.
+ */
+typedef struct
+{
+    uint32_t rxChars;      /*!< Number of received characters. */
+    uint32_t rxOverruns;   /*!< Number of characters lost due to full ring. */
+    uint32_t rxErrors;     /*!< Number of LPUART receive errors. */
+    uint32_t rxStartErrors;/*!< Number of failed starts of the reception. */
+    uint32_t lineOverruns; /*!< Number of lines longer than SHELL_LINE_SIZE. */
+    uint32_t cmdExecuted;  /*!< Number of executed commands. */
+    uint32_t cmdUnknown;   /*!< Number of unknown commands. */
+    uint32_t cmdFailed;    /*!< Number of commands finished with an error. */
+} shell_stats_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief This function initializes the shell and starts interrupt driven
+ * reception on the debug console LPUART.
+ *
+ * DbgConsole_Init must be called before this function. A failing start of
+ * the reception is not fatal: it is recorded (rxStartErrors) and runShell
+ * retries it, the shell may be run anyway.
+ *
+ * @return Error code of the reception start (STATUS_SUCCESS - no error).
+ */
+status_t initShell(void);
+
+/*!
+ * @brief This function runs one slot of the shell. It processes at most
+ * SHELL_RX_BUDGET received characters and executes at most one command (or
+ * one stream output), or prints one row of the output of the last command.
+ * It never waits for input.
+ */
+void runShell(void);
+
+/*!
+ * @brief This function returns the shell statistics.
+ *
+ * @return Pointer to the shell statistics.
+ */
+const shell_stats_t* getShellStats(void);
+
+#endif /* SHELL_H_ */
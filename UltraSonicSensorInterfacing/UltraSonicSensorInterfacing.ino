@@ -4,11 +4,49 @@
 #define _PIN_ULTRASONIC_TRIGGER 8
 #define _PIN_ULTRASONIC_ECHO 8
 #define _MAX_DISTANCE 300
+#define _PING_PERIOD 33     // ms between pings, echoes of the previous ping have died out
+#define _MEDIAN_SIZE 5      // pings in the median filter
+#define _PRINT_PERIOD 300   // ms between distance prints
+
+// I2C register map, 16-bit values big endian. A write of one byte sets the
+// register of the next read only, reads continue up to the end of the map.
+// A read without a write starts at 0: the distance, as before
+#define _REG_DISTANCE 0     // median distance [cm], 0: no echo in the window
+#define _REG_RAW 2          // last ping [cm], 0: no echo
+#define _REG_COUNT 4        // pings, wraps at 255
+#define _REG_STATUS 5
+#define _REG_NO_ECHO 6      // consecutive pings without echo, stops at 255
+#define _REG_SIZE 7
+
+// _REG_STATUS bits
+#define _STATUS_VALID 0x01    // distance from at least one echo
+#define _STATUS_NO_ECHO 0x02  // last ping without echo (out of range)
+#define _STATUS_FULL 0x04     // window filled: _MEDIAN_SIZE pings since start
 
 NewPing oultrasonicSensor(_PIN_ULTRASONIC_TRIGGER, _PIN_ULTRASONIC_ECHO, _MAX_DISTANCE);
 uint16_t un16distance;
 byte breceived;
 
+// Echo time of the running ping, set by the timer interrupt
+volatile unsigned long ulechoTime;
+volatile bool bechoDone;
+unsigned long ullastPing;
+bool bpinging = false;
+
+// Last pings [cm] for the median filter, 0: no echo
+uint16_t an16window[_MEDIAN_SIZE];
+byte bwindowNext = 0;
+bool bwindowFull = false;
+byte bpingCount = 0;
+byte bnoEcho = 0;
+
+// Register maps: the main loop fills the one not served, then switches, so
+// a read never sees a half updated distance
+byte abregs[2][_REG_SIZE];
+volatile byte bactiveRegs = 0;
+volatile byte bregPointer = _REG_DISTANCE;
+
+unsigned long ullastPrint;
 
 void setup() {
   Serial.begin(9600);
@@ -17,18 +55,97 @@ void setup() {
   Wire.onReceive(receiveEvent);
 }
 void loop() {
-  un16distance = oultrasonicSensor.ping_cm();
-  Serial.print("Distance: ");
-  Serial.print(un16distance);
-  Serial.println(" cm");
-  delay(300);
+  unsigned long ulnow = millis();
+
+  // Next ping once the previous one has ended, in the background: the
+  // timer interrupt checks the echo every 24 us
+  if (ulnow - ullastPing >= _PING_PERIOD) {
+    if (bpinging) {
+      noInterrupts();
+      bool bdone = bechoDone;
+      unsigned long ultime = ulechoTime;
+      interrupts();
+      addPing(bdone ? ultime / US_ROUNDTRIP_CM : 0);
+    }
+    ullastPing = ulnow;
+    bechoDone = false;
+    bpinging = true;
+    oultrasonicSensor.ping_timer(echoCheck);
+  }
+
+  if (ulnow - ullastPrint >= _PRINT_PERIOD && Serial.availableForWrite() >= 20) {
+    ullastPrint = ulnow;
+    Serial.print("Distance: ");
+    Serial.print(un16distance);
+    Serial.println(" cm");
+  }
+}
+// Timer interrupt during a ping
+void echoCheck() {
+  if (oultrasonicSensor.check_timer()) {
+    ulechoTime = oultrasonicSensor.ping_result;
+    bechoDone = true;
+  }
+}
+// Main loop: median of the last pings with an echo, published to I2C
+void addPing(uint16_t un16cm) {
+  uint16_t an16sorted[_MEDIAN_SIZE];
+  byte bcount = 0;
+  byte bstatus = 0;
+
+  an16window[bwindowNext] = un16cm;
+  bwindowNext = (bwindowNext + 1) % _MEDIAN_SIZE;
+  if (bwindowNext == 0)
+    bwindowFull = true;
+  bpingCount++;
+  if (un16cm) {
+    bnoEcho = 0;
+  } else {
+    if (bnoEcho < 255)
+      bnoEcho++;
+    bstatus |= _STATUS_NO_ECHO;
+  }
+
+  // insertion sort of the echoes
+  for (byte i = 0; i < _MEDIAN_SIZE; i++) {
+    uint16_t un16value = an16window[i];
+    byte j = bcount;
+    if (!un16value)
+      continue;
+    while (j > 0 && an16sorted[j - 1] > un16value) {
+      an16sorted[j] = an16sorted[j - 1];
+      j--;
+    }
+    an16sorted[j] = un16value;
+    bcount++;
+  }
+  un16distance = bcount ? an16sorted[bcount / 2] : 0;
+  if (bcount)
+    bstatus |= _STATUS_VALID;
+  if (bwindowFull)
+    bstatus |= _STATUS_FULL;
+
+  byte *pbregs = abregs[bactiveRegs ^ 1];
+  pbregs[_REG_DISTANCE] = highByte(un16distance);
+  pbregs[_REG_DISTANCE + 1] = lowByte(un16distance);
+  pbregs[_REG_RAW] = highByte(un16cm);
+  pbregs[_REG_RAW + 1] = lowByte(un16cm);
+  pbregs[_REG_COUNT] = bpingCount;
+  pbregs[_REG_STATUS] = bstatus;
+  pbregs[_REG_NO_ECHO] = bnoEcho;
+  bactiveRegs ^= 1;
 }
 void receiveEvent(int howMany) {
   while (Wire.available() > 0) {
     breceived = Wire.read();
   }
+  // a single byte selects the register
+  if (howMany == 1 && breceived < _REG_SIZE)
+    bregPointer = breceived;
 }
+// I2C interrupt: the whole answer comes from one register map. The pointer
+// goes back to the distance, for the masters which only read
 void requestEvent() {
-  Wire.write(highByte(un16distance));
-  Wire.write(lowByte(un16distance));
+  Wire.write(&abregs[bactiveRegs][bregPointer], _REG_SIZE - bregPointer);
+  bregPointer = _REG_DISTANCE;
 }
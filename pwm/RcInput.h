@@ -0,0 +1,110 @@
+// RcInput.h
+// RC receiver input decoded in the background: PWM channels or a PPM stream.
+//
+// PWM: one receiver channel per pin, the pin interrupt (CHANGE) timestamps
+// both edges with micros() and stores the width of each high pulse. PPM: all
+// channels on one pin, the width of channel n is the time between rising
+// edges n and n + 1 after a sync gap (> RC_PPM_SYNC). Nothing waits for a
+// pulse: the main loop reads the latest width of a channel in constant time
+// and sees a change one RC frame (about 20 ms) after the transmitter.
+//
+// Glitch filter: pulses outside RC_MIN_PULSE..RC_MAX_PULSE are discarded, a
+// jump of more than RC_GLITCH_STEP from the last accepted width is taken only
+// when the next pulse confirms it (a real stick move costs one frame, a
+// single corrupted pulse is dropped).
+//
+// Failsafe: a channel without an accepted pulse for RC_FAILSAFE_MS (receiver
+// off, wire loose) reads width 0. Receivers which send their own failsafe
+// values instead of stopping can't be told apart from valid input.
+//
+// Usage:
+//     RcInput rc;
+//
+//     setup():  rc.addPwm(3);             channel 0 on D3
+//               rc.begin();
+//     loop():   unsigned int w = rc.width(0);   0: failsafe
+//
+// PWM pins need an external interrupt (D2 and D3 on an Uno: two channels),
+// PPM takes a single pin for up to RC_MAX_CHANNELS channels. micros() has a
+// resolution of 4 us on 16 MHz AVRs. SBUS (inverted 100000 baud UART) is not
+// decoded.
+
+#ifndef RC_INPUT_H
+#define RC_INPUT_H
+
+#include <Arduino.h>
+
+#define RC_MAX_CHANNELS     8
+// PWM channels, one interrupt pin each
+#define RC_MAX_PWM          4
+
+#define RC_MIN_PULSE        800     // us, shorter pulses are glitches
+#define RC_MAX_PULSE        2200    // us, longer pulses are glitches
+#define RC_GLITCH_STEP      300     // us, bigger jumps need a second pulse
+#define RC_PPM_SYNC         3000    // us, PPM gap before channel 0
+#define RC_FAILSAFE_MS      100     // ms without an accepted pulse
+
+struct RcPulse {
+    unsigned int width;         // us, 0: failsafe
+    unsigned long stamp;        // micros() at the end of the pulse
+    unsigned long frames;       // pulses accepted
+};
+
+class RcInput {
+public:
+    RcInput();
+
+    // next channel as PWM on pin. False if the pin has no external interrupt
+    // or RC_MAX_PWM channels are used
+    bool addPwm(byte pin);
+
+    // channels 0..count-1 as a PPM stream on pin, instead of PWM channels
+    bool setPpm(byte pin, byte count);
+
+    // enables the pin interrupts
+    void begin();
+
+    byte channels() const { return channelCnt; }
+
+    // main loop side, constant time: latest accepted width in us, 0 in
+    // failsafe
+    unsigned int width(byte ch) const;
+
+    // copy of the channel (taken with interrupts disabled), width 0 in
+    // failsafe
+    RcPulse read(byte ch) const;
+
+    // no accepted pulse for RC_FAILSAFE_MS
+    bool failsafe(byte ch) const;
+
+    // pulses discarded by the glitch filter, all channels
+    unsigned long glitches() const;
+
+private:
+    struct Channel {
+        byte pin;
+        unsigned long rise;         // micros() of the rising edge
+        bool high;                  // rising edge seen, pulse running
+        unsigned int width;         // last accepted
+        unsigned int pending;       // jump waiting for confirmation, 0: none
+        unsigned long stamp;
+        unsigned long frames;
+    };
+
+    template <byte N> static void pwmIsr();
+    static void ppmIsr();
+    void edge(byte ch, bool high, unsigned long now);
+    void pulse(byte ch, unsigned int width, unsigned long now);
+
+    static RcInput *instance;
+
+    Channel chans[RC_MAX_CHANNELS];     // written by the interrupts
+    byte channelCnt;
+    bool ppm;
+    byte ppmPin;
+    byte ppmNext;                       // PPM channel of the next edge
+    unsigned long ppmLast;              // micros() of the last PPM edge
+    unsigned long glitchCnt;
+};
+
+#endif
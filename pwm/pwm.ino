@@ -1,16 +1,26 @@
 #include <Adafruit_NeoPixel.h>
+#include "NeoCompositor.h"
+#include "RcInput.h"
 
 //User-defined MACROS
 #define PWM_PIN             3
 #define NEO_LED_PIN         2
 #define NUM_PIXELS          2
+#define PRINT_PERIOD        500   //ms between PWM value prints
 
 //User defined global variables
 double pulse_var;
+unsigned long last_print = 0;
 
-//LED objects
-Adafruit_NeoPixel white=  Adafruit_NeoPixel(NUM_PIXELS, NEO_LED_PIN, NEO_GRB + NEO_KHZ800);
-Adafruit_NeoPixel blue=   Adafruit_NeoPixel(NUM_PIXELS,  NEO_LED_PIN, NEO_GRB + NEO_KHZ800);
+//RC receiver channel on PWM_PIN, decoded by the pin interrupt
+RcInput rc;
+
+//LED object: white and blue are colours of the same strip on NEO_LED_PIN
+Adafruit_NeoPixel strip=  Adafruit_NeoPixel(NUM_PIXELS, NEO_LED_PIN, NEO_GRB + NEO_KHZ800);
+
+//Strip colour, show() only when it changed
+NeoCompositor leds(50);
+int8_t ledStrip;
 
 //Private function prototypes
 void white_led_strip(void);
@@ -20,15 +30,20 @@ void off_led_strip(void);
 void setup() {
   // put your setup code here, to run once:
   Serial.begin(9600);
-  pinMode(PWM_PIN, INPUT);
-  white.begin();
-  blue.begin();
+  rc.addPwm(PWM_PIN);
+  rc.begin();
+  ledStrip = leds.add(strip);
+  leds.begin();
 }
 void loop() {
   // put your main code here, to run repeatedly:
-  pulse_var= pulseIn(PWM_PIN, HIGH);
-  Serial.println("PWM values: ");
-  Serial.println(pulse_var);
+  //Latest pulse width, 0 if the receiver signal is lost
+  pulse_var= rc.width(0);
+  if(millis() - last_print >= PRINT_PERIOD && Serial.availableForWrite() >= 24){
+    last_print = millis();
+    Serial.println("PWM values: ");
+    Serial.println(pulse_var);
+  }
 
   if(pulse_var>=1470.00 && pulse_var<=1500.00){
     blue_led_strip();
@@ -38,20 +53,14 @@ void loop() {
   }else{
     off_led_strip();
   }
-  delay(500);
+  leds.update();
 }
 void blue_led_strip(void){
-  blue.setPixelColor(0, blue.Color(0,0,255));
-  blue.setPixelColor(1, blue.Color(0,0,255));
-  blue.show();
+  leds.set(ledStrip, strip.Color(0,0,255));
 }
 void white_led_strip(void){
-  white.setPixelColor(0, white.Color(255,255,255)); 
-  white.setPixelColor(1, white.Color(255,255,255));
-  white.show();
+  leds.set(ledStrip, strip.Color(255,255,255));
 }
 void off_led_strip(void){
-  white.setPixelColor(0, white.Color(0, 0, 0));   
-  white.setPixelColor(1, white.Color(0, 0, 0));
-  white.show();
-}
\ No newline at end of file
+  leds.set(ledStrip, strip.Color(0, 0, 0));
+}
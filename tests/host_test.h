@@ -0,0 +1,72 @@
+/*!
+ * @file host_test.h
+ *
+ * Minimal helpers of the host tests: checks which count failures instead of
+ * stopping, a deterministic random generator and a monotonic clock for the
+ * throughput measurements.
+ */
+
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+static int testFailures;
+
+/*! @brief Counts a failure and prints its location if cond is false. */
+#define CHECK(cond) \
+    do \
+    { \
+        if (!(cond)) \
+        { \
+            testFailures++; \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+/*! @brief Like CHECK, prints both values of a failed comparison. */
+#define CHECK_EQ(a, b) \
+    do \
+    { \
+        long long va_ = (long long)(a), vb_ = (long long)(b); \
+        if (va_ != vb_) \
+        { \
+            testFailures++; \
+            printf("%s:%d: check failed: %s == %s (%lld != %lld)\n", \
+                __FILE__, __LINE__, #a, #b, va_, vb_); \
+        } \
+    } while (0)
+
+/*! @brief Result of the test program: prints a summary, exit code 1 on
+ * failure. */
+static inline int testResult(const char* name)
+{
+    printf("%s: %s\n", name, (testFailures == 0) ? "OK" : "FAILED");
+    return (testFailures == 0) ? 0 : 1;
+}
+
+/*! @brief xorshift32, the same sequence on every host. */
+static inline uint32_t testRand(void)
+{
+    static uint32_t state = 2463534242U;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/*! @brief Monotonic time in [ns]. */
+static inline uint64_t testNowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+}
+
+#endif /* HOST_TEST_H_ */
@@ -0,0 +1,387 @@
+/*!
+ * @file test_bcc_topology.c
+ *
+ * Host test of the BCC driver (Sources/bcc) against a simulated MC33771 on
+ * the SPI link, built twice by the Makefile: with the topology read from
+ * bcc_drv_config_t and with -DBCC_FIXED_TOPOLOGY (1 x MC33771, 14 cells,
+ * SPI, the defaults of bcc.h). Both builds must behave the same:
+ *  - BCC_Init assigns the CID and reads the inventory, a failed inventory
+ *    read does not fail the initialization,
+ *  - measurement reads return the masked register values,
+ *  - a corrupted response is recovered by a retry,
+ *  - the fixed build rejects a configuration of another topology,
+ *  - cost of a measurement read (BCC_Meas_GetRawValues) of both builds, for
+ *    information: the fixed build is a code size option (printed by make)
+ *    and is not expected to be faster.
+ */
+
+#include "host_test.h"
+
+#include <string.h>
+#include "bcc/bcc.h"
+#include "bcc/bcc_communication.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#ifdef BCC_FIXED_TOPOLOGY
+#define VARIANT                   "fixed"
+#else
+#define VARIANT                   "flexible"
+#endif
+
+/*! @brief Measurement reads of the cost measurement. */
+#define COST_READS                200000U
+
+/*! @brief Registers answered with TAG ID instead of the rolling counter. */
+#define MOCK_HAS_TAG_ID(regAddr) \
+    (((regAddr) == BCC_REG_SYS_DIAG_ADDR) || \
+     (((regAddr) >= BCC_REG_FAULT1_STATUS_ADDR) && ((regAddr) <= BCC_REG_FAULT3_STATUS_ADDR)) || \
+     (((regAddr) >= BCC_REG_CC_NB_SAMPLES_ADDR) && ((regAddr) <= BCC_REG_MEAS_VBG_DIAG_ADC1B_ADDR)))
+
+/*! @brief Simulated MC33771 on the SPI link. The response to a frame is
+ * shifted out with the following transfer. */
+typedef struct
+{
+    uint16_t regs[BCC_MAX_REG_ADDR + 1U];
+    uint16_t fuse[BCC_MAX_FUSE_ADDR + 1U];
+    uint8_t cid;
+    uint8_t resp[BCC_MSG_SIZE];
+    uint32_t transfers;
+    uint32_t corrupt;       /*!< Responses to corrupt (CRC), from the next. */
+    uint8_t corruptAddr;    /*!< Responses to reads of this register are
+                                 corrupted (0 - none). */
+} mock_bcc_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static mock_bcc_t mock;
+static bcc_drv_config_t drvConfig;
+
+/*******************************************************************************
+ * MCU abstraction of the driver
+ ******************************************************************************/
+
+void BCC_MCU_WaitMs(uint16_t delay)
+{
+    (void)delay;
+}
+
+void BCC_MCU_WaitUs(uint32_t delay)
+{
+    (void)delay;
+}
+
+void BCC_MCU_Assert(bool x)
+{
+    CHECK(x);
+}
+
+bcc_status_t BCC_MCU_TransferSpi(uint8_t drvInstance, uint8_t transBuf[],
+    uint8_t recvBuf[])
+{
+    uint16_t data = BCC_GET_MSG_DATA(transBuf);
+    uint8_t addr = transBuf[BCC_MSG_IDX_ADDR] & BCC_MSG_ADDR_MASK;
+    uint8_t cid = transBuf[BCC_MSG_IDX_CID_CMD] >> 4U;
+    uint8_t cmd = transBuf[BCC_MSG_IDX_CID_CMD] & 0x0FU;
+
+    CHECK_EQ(drvInstance, 0U);
+    CHECK_EQ(BCC_CheckCRC(transBuf), BCC_STATUS_SUCCESS);
+    mock.transfers++;
+
+    memcpy(recvBuf, mock.resp, BCC_MSG_SIZE);
+    if (mock.corrupt > 0U)
+    {
+        mock.corrupt--;
+        recvBuf[BCC_MSG_IDX_CRC] ^= 0x01U;
+    }
+
+    /* Not addressed to the device: null response. */
+    BCC_PackFrame(0U, 0U, BCC_CID_UNASSIG, BCC_CMD_NOOP, mock.resp);
+    if (cid != mock.cid)
+    {
+        return BCC_STATUS_SUCCESS;
+    }
+
+    if ((cmd & 0x03U) == BCC_CMD_READ)
+    {
+        if ((mock.corruptAddr != 0U) && (addr == mock.corruptAddr))
+        {
+            mock.corrupt++;
+        }
+        BCC_PackFrame(mock.regs[addr], addr, (bcc_cid_t)mock.cid,
+            MOCK_HAS_TAG_ID(addr) ? 0U : (cmd & BCC_MSG_RC_MASK), mock.resp);
+    }
+    else if (cmd == BCC_CMD_WRITE)
+    {
+        BCC_PackFrame(data, addr, (bcc_cid_t)mock.cid, cmd, mock.resp);
+        if ((addr == BCC_REG_SYS_CFG1_ADDR) && ((data & BCC_W_SOFT_RST_MASK) != 0U))
+        {
+            /* Reset: CID unassigned, the first response is null. */
+            mock.cid = 0U;
+            BCC_PackFrame(0U, 0U, BCC_CID_UNASSIG, BCC_CMD_NOOP, mock.resp);
+        }
+        else if (addr == BCC_REG_INIT_ADDR)
+        {
+            mock.cid = (uint8_t)(data & BCC_RW_CID_MASK);
+            mock.regs[addr] = data;
+        }
+        else if (addr == BCC_REG_FUSE_MIRROR_CTRL_ADDR)
+        {
+            mock.regs[BCC_REG_FUSE_MIRROR_DATA_ADDR] =
+                mock.fuse[(data & BCC_RW_FMR_ADDR_MASK) >> BCC_RW_FMR_ADDR_SHIFT];
+        }
+        else
+        {
+            mock.regs[addr] = data;
+        }
+    }
+
+    return BCC_STATUS_SUCCESS;
+}
+
+bcc_status_t BCC_MCU_TransferTpl(uint8_t drvInstance, uint8_t transBuf[],
+    uint8_t recvBuf[], uint16_t recvTrCnt)
+{
+    (void)drvInstance;
+    (void)transBuf;
+    (void)recvBuf;
+    (void)recvTrCnt;
+
+    /* Only the SPI link is simulated. */
+    CHECK(false);
+    return BCC_STATUS_COM_TIMEOUT;
+}
+
+void BCC_MCU_WriteCsbPin(uint8_t drvInstance, uint8_t value)
+{
+    (void)drvInstance;
+    (void)value;
+}
+
+void BCC_MCU_WriteRstPin(uint8_t drvInstance, uint8_t value)
+{
+    (void)drvInstance;
+    (void)value;
+}
+
+void BCC_MCU_WriteEnPin(uint8_t drvInstance, uint8_t value)
+{
+    (void)drvInstance;
+    (void)value;
+}
+
+uint32_t BCC_MCU_ReadIntbPin(uint8_t drvInstance)
+{
+    (void)drvInstance;
+    return 1U;
+}
+
+/*******************************************************************************
+ * Functions
+ ******************************************************************************/
+
+/*!
+ * @brief Powers up the simulated device and prepares the configuration of
+ * the demo board.
+ */
+static void reset(void)
+{
+    uint16_t i;
+
+    memset(&mock, 0, sizeof(mock));
+    BCC_PackFrame(0U, 0U, BCC_CID_UNASSIG, BCC_CMD_NOOP, mock.resp);
+    for (i = 0U; i <= BCC_MAX_FUSE_ADDR; i++)
+    {
+        mock.fuse[i] = (uint16_t)(0x0100U + (i * 37U));
+    }
+    mock.regs[BCC_REG_SILICON_REV_ADDR] = 0x0012U;
+
+    memset(&drvConfig, 0, sizeof(drvConfig));
+    drvConfig.drvInstance = 0U;
+    drvConfig.commMode = BCC_MODE_SPI;
+    drvConfig.devicesCnt = 1U;
+    drvConfig.device[0] = BCC_DEVICE_MC33771;
+    drvConfig.cellCnt[0] = 14U;
+}
+
+/*!
+ * @brief BCC_Init assigns CID 1 and reads the inventory of the device.
+ */
+static void testInit(void)
+{
+    reset();
+    CHECK_EQ(BCC_Init(&drvConfig, NULL), BCC_STATUS_SUCCESS);
+    CHECK_EQ(mock.cid, BCC_CID_DEV1);
+    CHECK(BCC_Inventory_IsValid(&drvConfig, BCC_CID_DEV1));
+    CHECK_EQ(drvConfig.drvData.inventory[0].siliconRev, 0x0012U);
+    CHECK_EQ(drvConfig.drvData.inventory[0].fuse[5], mock.fuse[5]);
+    CHECK_EQ(BCC_CELL_MAP(&drvConfig, BCC_CID_DEV1),
+        BCC_CELL_MAP_CALC(BCC_DEVICE_MC33771, 14U));
+    CHECK_EQ(BCC_GetRecoveryStats(&drvConfig)->retries, 0U);
+
+    /* SILICON_REV can't be read: the device is initialized anyway, without
+     * inventory, which is read later. */
+    reset();
+    mock.corruptAddr = BCC_REG_SILICON_REV_ADDR;
+    CHECK_EQ(BCC_Init(&drvConfig, NULL), BCC_STATUS_SUCCESS);
+    CHECK_EQ(mock.cid, BCC_CID_DEV1);
+    CHECK(!BCC_Inventory_IsValid(&drvConfig, BCC_CID_DEV1));
+    CHECK(BCC_GetRecoveryStats(&drvConfig)->failures > 0U);
+
+    mock.corruptAddr = 0U;
+    CHECK_EQ(BCC_Inventory_Read(&drvConfig, BCC_CID_DEV1), BCC_STATUS_SUCCESS);
+    CHECK(BCC_Inventory_IsValid(&drvConfig, BCC_CID_DEV1));
+    CHECK_EQ(drvConfig.drvData.inventory[0].fuse[5], mock.fuse[5]);
+}
+
+/*!
+ * @brief Measurement registers are read in one burst and masked.
+ */
+static void testMeasurements(void)
+{
+    uint16_t meas[BCC_MEAS_CNT];
+    uint16_t mask;
+    uint8_t i;
+
+    reset();
+    CHECK_EQ(BCC_Init(&drvConfig, NULL), BCC_STATUS_SUCCESS);
+    for (i = 0U; i < BCC_MEAS_CNT; i++)
+    {
+        mock.regs[BCC_REG_CC_NB_SAMPLES_ADDR + i] = (uint16_t)testRand();
+    }
+
+    mock.transfers = 0U;
+    CHECK_EQ(BCC_Meas_GetRawValues(&drvConfig, BCC_CID_DEV1, meas), BCC_STATUS_SUCCESS);
+    CHECK_EQ(mock.transfers, BCC_MEAS_CNT + 1U);
+    for (i = 0U; i < BCC_MEAS_CNT; i++)
+    {
+        if (i == (uint8_t)BCC_MSR_ISENSE2)
+        {
+            mask = BCC_R_MEAS2_I_MASK;
+        }
+        else
+        {
+            mask = (i < (uint8_t)BCC_MSR_ISENSE1) ? 0xFFFFU : BCC_R_MEAS_MASK;
+        }
+        CHECK_EQ(meas[i], mock.regs[BCC_REG_CC_NB_SAMPLES_ADDR + i] & mask);
+    }
+
+    /* Only one device is configured. */
+    CHECK_EQ(BCC_Meas_GetRawValues(&drvConfig, BCC_CID_DEV2, meas), BCC_STATUS_PARAM_RANGE);
+}
+
+/*!
+ * @brief A response with a wrong CRC is read again.
+ */
+static void testRecovery(void)
+{
+    uint16_t meas[BCC_MEAS_CNT];
+
+    reset();
+    CHECK_EQ(BCC_Init(&drvConfig, NULL), BCC_STATUS_SUCCESS);
+    mock.regs[BCC_REG_CC_NB_SAMPLES_ADDR] = 0x1234U;
+    mock.corrupt = 1U;
+    CHECK_EQ(BCC_Meas_GetRawValues(&drvConfig, BCC_CID_DEV1, meas), BCC_STATUS_SUCCESS);
+    CHECK_EQ(meas[BCC_MSR_CC_NB_SAMPLES], 0x1234U);
+    CHECK_EQ(BCC_GetRecoveryStats(&drvConfig)->crcErrors, 1U);
+    CHECK_EQ(BCC_GetRecoveryStats(&drvConfig)->retries, 1U);
+    CHECK_EQ(BCC_GetRecoveryStats(&drvConfig)->failures, 0U);
+}
+
+/*!
+ * @brief Other topologies: the flexible build takes them from the
+ * configuration, the fixed build rejects them.
+ */
+static void testOtherTopology(void)
+{
+    reset();
+    drvConfig.cellCnt[0] = 12U;
+#ifdef BCC_FIXED_TOPOLOGY
+    CHECK_EQ(BCC_Init(&drvConfig, NULL), BCC_STATUS_PARAM_RANGE);
+    CHECK_EQ(mock.transfers, 0U);
+#else
+    CHECK_EQ(BCC_Init(&drvConfig, NULL), BCC_STATUS_SUCCESS);
+    CHECK_EQ(BCC_CELL_MAP(&drvConfig, BCC_CID_DEV1),
+        BCC_CELL_MAP_CALC(BCC_DEVICE_MC33771, 12U));
+#endif
+
+    reset();
+    drvConfig.devicesCnt = 2U;
+    drvConfig.device[1] = BCC_DEVICE_MC33771;
+    drvConfig.cellCnt[1] = 14U;
+#ifdef BCC_FIXED_TOPOLOGY
+    CHECK_EQ(BCC_Init(&drvConfig, NULL), BCC_STATUS_PARAM_RANGE);
+#else
+    /* The second device does not answer on the simulated link. */
+    CHECK(BCC_Init(&drvConfig, NULL) != BCC_STATUS_SUCCESS);
+#endif
+
+#ifdef BCC_FIXED_TOPOLOGY
+    reset();
+    drvConfig.device[0] = BCC_DEVICE_MC33772;
+    drvConfig.cellCnt[0] = 6U;
+    CHECK_EQ(BCC_Init(&drvConfig, NULL), BCC_STATUS_PARAM_RANGE);
+
+    reset();
+    drvConfig.commMode = BCC_MODE_TPL;
+    CHECK_EQ(BCC_Init(&drvConfig, NULL), BCC_STATUS_PARAM_RANGE);
+#endif
+}
+
+/*!
+ * @brief Cost of a measurement read: driver and simulated link. The link
+ * costs the same in both builds, the difference is the driver.
+ */
+static void testCost(void)
+{
+    uint16_t meas[BCC_MEAS_CNT];
+    uint64_t start, ns, linkNs;
+    uint32_t n, sum = 0U;
+    uint8_t txBuf[BCC_MSG_SIZE], rxBuf[BCC_MSG_SIZE];
+
+    reset();
+    CHECK_EQ(BCC_Init(&drvConfig, NULL), BCC_STATUS_SUCCESS);
+    for (n = 0U; n < BCC_MEAS_CNT; n++)
+    {
+        mock.regs[BCC_REG_CC_NB_SAMPLES_ADDR + n] = (uint16_t)(3300U + n);
+    }
+
+    start = testNowNs();
+    for (n = 0U; n < COST_READS; n++)
+    {
+        (void)BCC_Meas_GetRawValues(&drvConfig, BCC_CID_DEV1, meas);
+        sum += meas[BCC_MSR_CELL_VOLT1];
+    }
+    ns = testNowNs() - start;
+
+    /* The simulated link alone: the same transfers without the driver. */
+    BCC_PackFrame(1U, BCC_REG_CC_NB_SAMPLES_ADDR, BCC_CID_DEV1, BCC_CMD_READ, txBuf);
+    start = testNowNs();
+    for (n = 0U; n < COST_READS * (BCC_MEAS_CNT + 1U); n++)
+    {
+        (void)BCC_MCU_TransferSpi(0U, txBuf, rxBuf);
+        sum += rxBuf[BCC_MSG_IDX_DATA_L];
+    }
+    linkNs = testNowNs() - start;
+
+    CHECK(sum != 0U);
+    CHECK_EQ(BCC_GetRecoveryStats(&drvConfig)->failures, 0U);
+    printf("%-9s    measurement read %.0f ns, of it %.0f ns simulated link "
+        "(%u transfers) (host)\n", VARIANT, (double)ns / COST_READS,
+        (double)linkNs / COST_READS, (unsigned)(BCC_MEAS_CNT + 1U));
+}
+
+int main(void)
+{
+    testInit();
+    testMeasurements();
+    testRecovery();
+    testOtherTopology();
+    testCost();
+
+    return testResult("test_bcc_topology (" VARIANT ")");
+}
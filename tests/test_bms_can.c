@@ -0,0 +1,297 @@
+/*!
+ * @file test_bms_can.c
+ *
+ * Host test of the BMS CAN message set (Sources/bms_can.c):
+ *  - the signals of each message do not overlap and fit in BMS_CAN_DLC bytes,
+ *  - random values of every signal survive encode + decode, unused bits are
+ *    zero,
+ *  - known frames (bit order, sign extension),
+ *  - bus load of the full message set,
+ *  - encode/decode throughput compared to the rate of the message set.
+ */
+
+#include "host_test.h"
+
+#include <string.h>
+#include "bms_can.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Random round trips per message. */
+#define ROUND_TRIPS               100000U
+
+/*! @brief Passes of the full message set in the throughput measurement. */
+#define THROUGHPUT_SETS           20000U
+
+/*! @brief Bits of a standard 8-byte frame including the interframe space and
+ * the worst-case stuff bits. */
+#define FRAME_BITS_MAX            135U
+
+/*! @brief Bus bitrate and the bus load the message set may take [%]. */
+#define BUS_BITRATE               500000U
+#define BUS_LOAD_MAX_PCT          30U
+
+#define IS_SIGNED(type)           (((type)-1) < ((type)0))
+
+/* Coverage of the signals: every bit of a signal set once. */
+#define COVER(type, name, start, length) \
+    cover(bits, &bitCnt, (start), (length));
+#define COVER_ARRAY(type, name, count, start, length) \
+    for (i = 0U; i < (count); i++) \
+    { \
+        cover(bits, &bitCnt, (uint8_t)((start) + (i * (length))), (length)); \
+    }
+
+/* Random value within the length of the signal. */
+#define RANDOMIZE(type, name, start, length) \
+    in.name = (type)randSignal((length), IS_SIGNED(type));
+#define RANDOMIZE_ARRAY(type, name, count, start, length) \
+    for (i = 0U; i < (count); i++) \
+    { \
+        in.name[i] = (type)randSignal((length), IS_SIGNED(type)); \
+    }
+
+#define COMPARE(type, name, start, length) \
+    CHECK_EQ(out.name, in.name);
+#define COMPARE_ARRAY(type, name, count, start, length) \
+    for (i = 0U; i < (count); i++) \
+    { \
+        CHECK_EQ(out.name[i], in.name[i]); \
+    }
+
+/*! @brief Layout and round trip test of a message. */
+#define TEST_MESSAGE(Name, name, SIGNALS) \
+    static void test##Name(void) \
+    { \
+        uint8_t bits[BMS_CAN_DLC] = {0U}; \
+        uint8_t data[BMS_CAN_DLC]; \
+        uint32_t bitCnt = 0U; \
+        uint32_t n; \
+        uint8_t i, j; \
+        bms_can_##name##_t in, out; \
+        (void)i; \
+        SIGNALS(COVER, COVER_ARRAY) \
+        for (n = 0U; n < ROUND_TRIPS; n++) \
+        { \
+            memset(&in, 0, sizeof(in)); \
+            memset(&out, 0xA5, sizeof(out)); \
+            memset(data, 0xA5, sizeof(data)); \
+            SIGNALS(RANDOMIZE, RANDOMIZE_ARRAY) \
+            bmsCanEncode##Name(&in, data); \
+            bmsCanDecode##Name(data, &out); \
+            SIGNALS(COMPARE, COMPARE_ARRAY) \
+            for (j = 0U; j < BMS_CAN_DLC; j++) \
+            { \
+                CHECK_EQ(data[j] & (uint8_t)~bits[j], 0); \
+            } \
+            if (testFailures > 0) \
+            { \
+                return; \
+            } \
+        } \
+        printf("%-12s %2u signal bits, %u round trips\n", #Name, \
+            (unsigned)bitCnt, (unsigned)ROUND_TRIPS); \
+    }
+
+/*******************************************************************************
+ * Functions
+ ******************************************************************************/
+
+/*!
+ * @brief Marks the bits of a signal, a bit used twice or outside of the frame
+ * is a failure.
+ */
+static void cover(uint8_t bits[], uint32_t* bitCnt, uint8_t start, uint8_t length)
+{
+    uint8_t pos;
+
+    CHECK((length > 0U) && (length <= 32U));
+    CHECK((uint32_t)start + length <= (BMS_CAN_DLC * 8U));
+    if ((uint32_t)start + length > (BMS_CAN_DLC * 8U))
+    {
+        return;
+    }
+
+    for (pos = start; pos < (uint8_t)(start + length); pos++)
+    {
+        CHECK((bits[pos >> 3U] & (1U << (pos & 7U))) == 0U);
+        bits[pos >> 3U] |= (uint8_t)(1U << (pos & 7U));
+        (*bitCnt)++;
+    }
+}
+
+/*!
+ * @brief Random value which fits in length bits (sign extended if signed).
+ */
+static int64_t randSignal(uint8_t length, int isSigned)
+{
+    uint32_t value = testRand();
+
+    if (length < 32U)
+    {
+        value &= (1U << length) - 1U;
+    }
+    if (isSigned && (length < 32U) && ((value >> (length - 1U)) & 1U))
+    {
+        return (int64_t)value - ((int64_t)1 << length);
+    }
+    return isSigned ? (int64_t)(int32_t)value : (int64_t)value;
+}
+
+/* testPackStatus, testCellStats, testFaults, testTemps, testCells. */
+BMS_CAN_MESSAGES(TEST_MESSAGE)
+
+/*!
+ * @brief Frames with known content: little endian bit order, sign extension,
+ * truncation to the signal length.
+ */
+static void testKnownFrames(void)
+{
+    bms_can_pack_status_t status = {0};
+    bms_can_cells_t cells = {0};
+    bms_can_faults_t faults = {0};
+    uint8_t data[BMS_CAN_DLC];
+    const uint8_t statusData[BMS_CAN_DLC] = {
+        0x34U, 0x12U, 0xFEU, 0xFFU, 0xC8U, 0x11U, 0xF6U, 0xF5U
+    };
+    const uint8_t cellsData[BMS_CAN_DLC] = {
+        0x02U, 0xFFU, 0x3FU, 0x00U, 0x00U, 0x00U, 0x00U, 0xC0U
+    };
+
+    status.voltage = 0x1234U;
+    status.current = -2;
+    status.soc = 200U;
+    status.faults = BMS_CAN_FLT_CELL_OV | BMS_CAN_FLT_COMM;
+    status.tempMax = -10;
+    status.counter = 0x15U;         /* 4 bits: 0x5 */
+    status.devices = 15U;
+    bmsCanEncodePackStatus(&status, data);
+    CHECK(memcmp(data, statusData, BMS_CAN_DLC) == 0);
+    bmsCanDecodePackStatus(data, &status);
+    CHECK_EQ(status.current, -2);
+    CHECK_EQ(status.tempMax, -10);
+    CHECK_EQ(status.counter, 5);
+
+    cells.mux = 2U;
+    cells.cellMv[0] = 0x3FFFU;
+    cells.cellMv[3] = 0x3000U;
+    bmsCanEncodeCells(&cells, data);
+    CHECK(memcmp(data, cellsData, BMS_CAN_DLC) == 0);
+
+    /* 14-bit fault bitmaps across the byte boundaries. */
+    faults.device = 14U;
+    faults.cellOv = 0x2001U;
+    faults.cellUv = 0x0003U;
+    bmsCanEncodeFaults(&faults, data);
+    CHECK_EQ(data[0], 0x1EU);
+    CHECK_EQ(data[1], 0x00U);
+    CHECK_EQ(data[2], 0x0EU);
+    CHECK_EQ(data[3], 0x00U);
+}
+
+/*!
+ * @brief The full message set fits in the bus load budget.
+ */
+static void testBusLoad(void)
+{
+    uint32_t framesPerS = (BMS_CAN_FRAMES_MAX * 1000U) / BMS_CAN_PERIOD_MS;
+    uint32_t bitsPerS = framesPerS * FRAME_BITS_MAX;
+
+    CHECK_EQ(BMS_CAN_CELL_FRAMES, 53);
+    CHECK_EQ(BMS_CAN_FRAMES_MAX, 85);
+    CHECK(bitsPerS * 100U <= BUS_BITRATE * BUS_LOAD_MAX_PCT);
+    printf("bus load     %u frames/s, %u bit/s worst case, %u.%u %% of %u bit/s\n",
+        (unsigned)framesPerS, (unsigned)bitsPerS,
+        (unsigned)(bitsPerS * 100U / BUS_BITRATE),
+        (unsigned)((bitsPerS * 1000U / BUS_BITRATE) % 10U), (unsigned)BUS_BITRATE);
+}
+
+/*!
+ * @brief Encodes and decodes the full message set, as the firmware and
+ * a receiver do every BMS_CAN_PERIOD_MS.
+ */
+static void testThroughput(void)
+{
+    static bms_can_frame_t frames[BMS_CAN_FRAMES_MAX];
+    bms_can_pack_status_t status = {0};
+    bms_can_cell_stats_t stats = {0};
+    bms_can_faults_t faults = {0};
+    bms_can_temps_t temps = {0};
+    bms_can_cells_t cells = {0};
+    uint64_t start, encodeNs, decodeNs;
+    uint32_t set, n, f, sum = 0U;
+    uint8_t i;
+
+    start = testNowNs();
+    for (set = 0U; set < THROUGHPUT_SETS; set++)
+    {
+        f = 0U;
+        status.counter = (uint8_t)set;
+        bmsCanEncodePackStatus(&status, frames[f++].data);
+        stats.minMv = (uint16_t)set;
+        bmsCanEncodeCellStats(&stats, frames[f++].data);
+        for (n = 0U; n < BMS_CAN_CELL_FRAMES; n++)
+        {
+            cells.mux = (uint8_t)n;
+            for (i = 0U; i < BMS_CAN_CELLS_PER_FRAME; i++)
+            {
+                cells.cellMv[i] = (uint16_t)(3300U + n + i + set);
+            }
+            bmsCanEncodeCells(&cells, frames[f++].data);
+        }
+        for (n = 0U; n < BMS_CAN_DEVICES_MAX; n++)
+        {
+            faults.device = (uint8_t)n;
+            bmsCanEncodeFaults(&faults, frames[f++].data);
+            temps.device = (uint8_t)n;
+            temps.temp[0] = (int8_t)set;
+            bmsCanEncodeTemps(&temps, frames[f++].data);
+        }
+    }
+    encodeNs = testNowNs() - start;
+
+    start = testNowNs();
+    for (set = 0U; set < THROUGHPUT_SETS; set++)
+    {
+        f = 0U;
+        bmsCanDecodePackStatus(frames[f++].data, &status);
+        bmsCanDecodeCellStats(frames[f++].data, &stats);
+        for (n = 0U; n < BMS_CAN_CELL_FRAMES; n++)
+        {
+            bmsCanDecodeCells(frames[f++].data, &cells);
+            sum += cells.cellMv[0];
+        }
+        for (n = 0U; n < BMS_CAN_DEVICES_MAX; n++)
+        {
+            bmsCanDecodeFaults(frames[f++].data, &faults);
+            bmsCanDecodeTemps(frames[f++].data, &temps);
+            sum += (uint32_t)temps.temp[0];
+        }
+        sum += status.counter;
+    }
+    decodeNs = testNowNs() - start;
+
+    CHECK(sum != 0U);
+    printf("throughput   encode %.1f ns/frame, decode %.1f ns/frame "
+        "(%.0f full sets/s, %u needed)\n",
+        (double)encodeNs / ((double)THROUGHPUT_SETS * BMS_CAN_FRAMES_MAX),
+        (double)decodeNs / ((double)THROUGHPUT_SETS * BMS_CAN_FRAMES_MAX),
+        (double)THROUGHPUT_SETS * 1e9 / (double)(encodeNs + decodeNs),
+        (unsigned)(1000U / BMS_CAN_PERIOD_MS));
+}
+
+int main(void)
+{
+    testPackStatus();
+    testCellStats();
+    testFaults();
+    testTemps();
+    testCells();
+    testKnownFrames();
+    testBusLoad();
+    testThroughput();
+
+    return testResult("test_bms_can");
+}
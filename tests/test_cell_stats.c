@@ -0,0 +1,287 @@
+/*!
+ * @file test_cell_stats.c
+ *
+ * Host test of the pack cell voltage statistics (Sources/cell_stats.c):
+ *  - equal to a per-cell double precision reference on random packs of
+ *    1..15 MC33771/MC33772 devices with any cell count (minimum, maximum,
+ *    sum and mean exact, standard deviation within 1 uV + 1 ppm),
+ *  - deviation of each cell from the mean (zero for not connected cells),
+ *  - not connected cells and the reserved bits of the registers are ignored,
+ *  - cost of a 15 x 14 cell pack compared with the per-cell reference.
+ */
+
+#include "host_test.h"
+
+#include <math.h>
+#include <string.h>
+#include "cell_stats.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Random packs of the equivalence test. */
+#define RANDOM_PACKS              200000U
+
+/*! @brief Passes of the cost measurement. */
+#define COST_PASSES               200000U
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static bcc_drv_config_t drvConfig;
+static uint16_t meas[BCC_DEVICE_CNT_MAX][BCC_MEAS_CNT];
+static int32_t deviation[BCC_DEVICE_CNT_MAX][BCC_MAX_CELLS];
+
+/*******************************************************************************
+ * Functions
+ ******************************************************************************/
+
+void BCC_MCU_Assert(bool x)
+{
+    CHECK(x);
+}
+
+/*!
+ * @brief Configures a pack of devCnt devices.
+ */
+static void setPack(uint8_t devCnt, bcc_device_t device, uint8_t cellCnt)
+{
+    uint8_t dev;
+
+    memset(&drvConfig, 0, sizeof(drvConfig));
+    drvConfig.commMode = BCC_MODE_TPL;
+    drvConfig.devicesCnt = devCnt;
+    for (dev = 0U; dev < devCnt; dev++)
+    {
+        drvConfig.device[dev] = device;
+        drvConfig.cellCnt[dev] = cellCnt;
+        drvConfig.drvData.cellMap[dev] = BCC_CELL_MAP_CALC(device, cellCnt);
+    }
+}
+
+/*!
+ * @brief Random cell voltages around 3.3 V, random reserved bit 15 and
+ * garbage in the not connected cells.
+ */
+static void randomMeas(uint16_t spread)
+{
+    uint8_t dev, i;
+
+    for (dev = 0U; dev < BCC_DEVICE_CNT_MAX; dev++)
+    {
+        for (i = 0U; i < BCC_MEAS_CNT; i++)
+        {
+            meas[dev][i] = (uint16_t)(21600U - (spread / 2U) + (testRand() % (spread + 1U)));
+            meas[dev][i] |= (uint16_t)(testRand() & 0x8000U);
+        }
+    }
+}
+
+/*!
+ * @brief Reference: one cell at a time, two-pass double precision variance.
+ */
+static void refStats(cell_stats_t* const stats, double* stdDevUV)
+{
+    uint32_t raw, minRaw = 0xFFFFU, maxRaw = 0U, sum = 0U, cnt = 0U;
+    double mean, sq = 0.0;
+    uint8_t dev, cell;
+
+    memset(stats, 0, sizeof(cell_stats_t));
+    *stdDevUV = 0.0;
+    for (dev = 0U; dev < drvConfig.devicesCnt; dev++)
+    {
+        for (cell = 1U; cell <= BCC_MAX_CELLS; cell++)
+        {
+            if (BCC_IS_CELL_CONN(&drvConfig, dev + 1U, cell))
+            {
+                raw = meas[dev][BCC_MSR_CELL_VOLT1 - (cell - 1U)] & BCC_R_MEAS_MASK;
+                minRaw = (raw < minRaw) ? raw : minRaw;
+                maxRaw = (raw > maxRaw) ? raw : maxRaw;
+                sum += raw;
+                cnt++;
+            }
+        }
+    }
+    if (cnt == 0U)
+    {
+        return;
+    }
+
+    mean = (double)sum / cnt;
+    for (dev = 0U; dev < drvConfig.devicesCnt; dev++)
+    {
+        for (cell = 1U; cell <= BCC_MAX_CELLS; cell++)
+        {
+            if (BCC_IS_CELL_CONN(&drvConfig, dev + 1U, cell))
+            {
+                raw = meas[dev][BCC_MSR_CELL_VOLT1 - (cell - 1U)] & BCC_R_MEAS_MASK;
+                sq += (raw - mean) * (raw - mean);
+            }
+        }
+    }
+
+    stats->minUV = BCC_GET_VOLT(minRaw);
+    stats->maxUV = BCC_GET_VOLT(maxRaw);
+    stats->spreadUV = stats->maxUV - stats->minUV;
+    stats->sumUV = (uint32_t)(((uint64_t)sum * 15259U) / 100U);
+    stats->meanUV = stats->sumUV / cnt;
+    stats->cellCnt = (uint16_t)cnt;
+    *stdDevUV = sqrt(sq / cnt) * 152.59;
+}
+
+/*!
+ * @brief Compares the kernel with the reference on the current pack.
+ */
+static void compare(void)
+{
+    cell_stats_t stats, ref;
+    double refStdDev;
+    int32_t refDev;
+    uint8_t dev, cell;
+
+    memset(&stats, 0xA5, sizeof(stats));
+    calcCellStats(&drvConfig, (const uint16_t (*)[BCC_MEAS_CNT])meas, &stats);
+    refStats(&ref, &refStdDev);
+
+    CHECK_EQ(stats.cellCnt, ref.cellCnt);
+    CHECK_EQ(stats.minUV, ref.minUV);
+    CHECK_EQ(stats.maxUV, ref.maxUV);
+    CHECK_EQ(stats.spreadUV, ref.spreadUV);
+    CHECK_EQ(stats.sumUV, ref.sumUV);
+    CHECK_EQ(stats.meanUV, ref.meanUV);
+    /* Truncation to 1 uV and the single precision square root. */
+    CHECK(fabs((double)stats.stdDevUV - refStdDev) <= 1.0 + (refStdDev * 1e-6));
+
+    memset(deviation, 0xA5, sizeof(deviation));
+    calcCellDeviation(&drvConfig, (const uint16_t (*)[BCC_MEAS_CNT])meas, &stats,
+        deviation);
+    for (dev = 0U; dev < drvConfig.devicesCnt; dev++)
+    {
+        for (cell = 1U; cell <= BCC_MAX_CELLS; cell++)
+        {
+            refDev = !BCC_IS_CELL_CONN(&drvConfig, dev + 1U, cell) ? 0 :
+                (int32_t)BCC_GET_VOLT(meas[dev][BCC_MSR_CELL_VOLT1 - (cell - 1U)] &
+                BCC_R_MEAS_MASK) - (int32_t)ref.meanUV;
+            CHECK_EQ(deviation[dev][cell - 1U], refDev);
+        }
+    }
+}
+
+/*!
+ * @brief Known pack: cells of one MC33771 at 1..14 mV steps of 100 raw.
+ */
+static void testKnown(void)
+{
+    cell_stats_t stats;
+    uint8_t cell;
+
+    setPack(1U, BCC_DEVICE_MC33771, 14U);
+    memset(meas, 0, sizeof(meas));
+    for (cell = 1U; cell <= 14U; cell++)
+    {
+        meas[0][BCC_MSR_CELL_VOLT1 - (cell - 1U)] = (uint16_t)(0x8000U | (20000U + (100U * cell)));
+    }
+    calcCellStats(&drvConfig, (const uint16_t (*)[BCC_MEAS_CNT])meas, &stats);
+
+    CHECK_EQ(stats.cellCnt, 14);
+    CHECK_EQ(stats.minUV, BCC_GET_VOLT(20100U));
+    CHECK_EQ(stats.maxUV, BCC_GET_VOLT(21400U));
+    /* 100 raw * sqrt((14^2 - 1) / 12) = 403.1 raw = 61510 uV. */
+    CHECK_EQ(stats.stdDevUV / 10U, 6151U);
+
+    /* Mean is at cell 7.5: cells 1 and 14 deviate by -/+ 6.5 * 100 raw
+     * = 99183.5 uV (mean truncated to 3166242 uV). */
+    calcCellDeviation(&drvConfig, (const uint16_t (*)[BCC_MEAS_CNT])meas, &stats,
+        deviation);
+    CHECK_EQ(deviation[0][0], -99183);
+    CHECK_EQ(deviation[0][13], 99184);
+
+    /* All cells equal: no deviation. */
+    for (cell = 1U; cell <= 14U; cell++)
+    {
+        meas[0][BCC_MSR_CELL_VOLT1 - (cell - 1U)] = 21000U;
+    }
+    calcCellStats(&drvConfig, (const uint16_t (*)[BCC_MEAS_CNT])meas, &stats);
+    CHECK_EQ(stats.stdDevUV, 0);
+    CHECK_EQ(stats.spreadUV, 0);
+
+    /* No device: everything zero. */
+    setPack(0U, BCC_DEVICE_MC33771, 14U);
+    memset(&stats, 0xA5, sizeof(stats));
+    calcCellStats(&drvConfig, (const uint16_t (*)[BCC_MEAS_CNT])meas, &stats);
+    CHECK_EQ(stats.cellCnt, 0);
+    CHECK_EQ(stats.maxUV, 0);
+    CHECK_EQ(stats.stdDevUV, 0);
+}
+
+/*!
+ * @brief Random packs: device type, count, cells and the spread of voltages
+ * (from equal cells up to the full register range).
+ */
+static void testRandom(void)
+{
+    static const uint16_t spreads[] = { 0U, 3U, 100U, 2000U, 0x7FFFU };
+    uint32_t n;
+    uint8_t cellCnt;
+    bcc_device_t device;
+
+    for (n = 0U; (n < RANDOM_PACKS) && (testFailures == 0); n++)
+    {
+        device = ((testRand() & 1U) != 0U) ? BCC_DEVICE_MC33771 : BCC_DEVICE_MC33772;
+        cellCnt = (device == BCC_DEVICE_MC33771) ?
+            (uint8_t)(BCC_MIN_CELLS_MC33771 + (testRand() % 8U)) :
+            (uint8_t)(BCC_MIN_CELLS_MC33772 + (testRand() % 4U));
+        setPack((uint8_t)(1U + (testRand() % BCC_DEVICE_CNT_MAX)), device, cellCnt);
+        randomMeas(spreads[testRand() % (sizeof(spreads) / sizeof(spreads[0]))]);
+        compare();
+    }
+    printf("random       %u packs compared\n", (unsigned)n);
+}
+
+/*!
+ * @brief Cost of the statistics of the largest pack.
+ */
+static void testCost(void)
+{
+    cell_stats_t stats;
+    double refStdDev;
+    uint64_t start, kernelNs, refNs;
+    uint32_t n, sum = 0U;
+
+    setPack(BCC_DEVICE_CNT_MAX, BCC_DEVICE_MC33771, 14U);
+    randomMeas(2000U);
+
+    start = testNowNs();
+    for (n = 0U; n < COST_PASSES; n++)
+    {
+        meas[0][BCC_MSR_CELL_VOLT1] = (uint16_t)(20000U + (n & 0xFFU));
+        calcCellStats(&drvConfig, (const uint16_t (*)[BCC_MEAS_CNT])meas, &stats);
+        sum += stats.stdDevUV;
+    }
+    kernelNs = testNowNs() - start;
+
+    start = testNowNs();
+    for (n = 0U; n < COST_PASSES; n++)
+    {
+        meas[0][BCC_MSR_CELL_VOLT1] = (uint16_t)(20000U + (n & 0xFFU));
+        refStats(&stats, &refStdDev);
+        sum += (uint32_t)refStdDev;
+    }
+    refNs = testNowNs() - start;
+
+    CHECK(sum != 0U);
+    printf("cost         %.0f ns kernel, %.0f ns per-cell reference for %u cells (host)\n",
+        (double)kernelNs / COST_PASSES, (double)refNs / COST_PASSES,
+        (unsigned)(BCC_DEVICE_CNT_MAX * 14U));
+}
+
+int main(void)
+{
+    testKnown();
+    testRandom();
+    testCost();
+
+    return testResult("test_cell_stats");
+}
@@ -0,0 +1,325 @@
+/*!
+ * @file test_led_fx.c
+ *
+ * Host test of the LED effect engine (Sources/led_fx.c) on a virtual clock:
+ *  - the waveform of each effect type, ticked every millisecond,
+ *  - the same edges within one tick period when the main loop ticks at
+ *    random intervals (the timing depends on the clock only),
+ *  - the output function is called on level changes only,
+ *  - start, restart, stop and end of effects, the millisecond clock wrap,
+ *  - cost of a tick.
+ */
+
+#include "host_test.h"
+
+#include <string.h>
+#include "led_fx.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define CHANNELS                  4U
+
+/*! @brief Transitions recorded per channel. */
+#define EDGES_MAX                 64U
+
+/*! @brief Ticks of the cost measurement. */
+#define COST_TICKS                2000000U
+
+/*! @brief Output log of a channel: time and level of each output call. */
+typedef struct
+{
+    uint32_t time[EDGES_MAX];
+    uint8_t level[EDGES_MAX];
+    uint32_t cnt;
+    uint32_t calls;
+} output_log_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static led_fx_engine_t engine;
+static led_fx_channel_t channels[CHANNELS];
+static output_log_t logs[CHANNELS];
+static uint8_t outLevel[CHANNELS];
+static uint32_t clockMs;
+
+static const led_fx_t solid = LED_FX_SOLID(200U, 500U);
+static const led_fx_t solidForever = LED_FX_SOLID(255U, 0U);
+static const led_fx_t blink3 = LED_FX_BLINK(255U, 3U, 100U, 50U);
+static const led_fx_t strobe = LED_FX_STROBE(255U, 2U, 100U, 75U, 1000U);
+static const led_fx_t breathe = LED_FX_BREATHE(255U, 400U, 600U, 200U);
+
+/*******************************************************************************
+ * Functions
+ ******************************************************************************/
+
+/*!
+ * @brief Output function: records the calls on the virtual clock.
+ */
+static void output(uint8_t channel, uint8_t level)
+{
+    output_log_t* log = &logs[channel];
+
+    CHECK(channel < CHANNELS);
+    log->calls++;
+    if (log->cnt < EDGES_MAX)
+    {
+        log->time[log->cnt] = clockMs;
+        log->level[log->cnt] = level;
+        log->cnt++;
+    }
+    outLevel[channel] = level;
+}
+
+static void reset(uint32_t now)
+{
+    clockMs = now;
+    ledFxInit(&engine, channels, CHANNELS, output);
+    memset(logs, 0, sizeof(logs));
+}
+
+/*!
+ * @brief Advances the virtual clock to end, ticking every step [ms].
+ */
+static void run(uint32_t end, uint32_t step)
+{
+    while ((int32_t)(end - clockMs) > 0)
+    {
+        clockMs += step;
+        ledFxTick(&engine, clockMs);
+        /* the output always shows the level of the effect */
+        CHECK_EQ(outLevel[0], channels[0].level);
+    }
+}
+
+/*!
+ * @brief Solid: on for onMs, then done; onMs 0 stays on.
+ */
+static void testSolid(void)
+{
+    reset(1000U);
+    ledFxStart(&engine, 0U, &solid, clockMs);
+    ledFxStart(&engine, 1U, &solidForever, clockMs);
+    run(3000U, 1U);
+
+    CHECK_EQ(logs[0].cnt, 2);
+    CHECK_EQ(logs[0].time[0], 1001);
+    CHECK_EQ(logs[0].level[0], 200);
+    CHECK_EQ(logs[0].time[1], 1500);
+    CHECK_EQ(logs[0].level[1], 0);
+    CHECK(ledFxDone(&engine, 0U));
+    CHECK(!ledFxDone(&engine, 1U));
+    CHECK_EQ(logs[1].cnt, 1);
+    CHECK_EQ(outLevel[1], 255);
+    /* channels without an effect: only the initial off */
+    CHECK_EQ(logs[2].calls, 0);
+}
+
+/*!
+ * @brief Blink N: N pulses of onMs every onMs + offMs, then done.
+ */
+static void testBlink(void)
+{
+    uint32_t i;
+
+    reset(0U);
+    ledFxStart(&engine, 0U, &blink3, clockMs);
+    run(1000U, 1U);
+
+    CHECK_EQ(logs[0].cnt, 6);
+    for (i = 0U; (i < 3U) && (logs[0].cnt == 6U); i++)
+    {
+        CHECK_EQ(logs[0].time[2U * i], (i == 0U) ? 1U : (i * 150U));
+        CHECK_EQ(logs[0].level[2U * i], 255);
+        CHECK_EQ(logs[0].time[(2U * i) + 1U], (i * 150U) + 100U);
+        CHECK_EQ(logs[0].level[(2U * i) + 1U], 0);
+    }
+    CHECK(ledFxDone(&engine, 0U));
+
+    /* an effect which has ended starts again */
+    ledFxStart(&engine, 0U, &blink3, clockMs);
+    CHECK(!ledFxDone(&engine, 0U));
+    run(2000U, 1U);
+    CHECK_EQ(logs[0].cnt, 12);
+    CHECK_EQ(logs[0].time[6], 1001);
+}
+
+/*!
+ * @brief Strobe: bursts of 2 x 100 ms, 75 ms apart, 1 s dark, repeated.
+ */
+static void testStrobe(void)
+{
+    static const uint32_t rise[] = { 1U, 175U, 1350U, 1525U, 2700U, 2875U };
+    uint32_t i;
+
+    reset(0U);
+    ledFxStart(&engine, 0U, &strobe, clockMs);
+    run(3000U, 1U);
+
+    CHECK_EQ(logs[0].cnt, 12);
+    for (i = 0U; (i < 6U) && (logs[0].cnt == 12U); i++)
+    {
+        CHECK_EQ(logs[0].time[2U * i], rise[i]);
+        CHECK_EQ(logs[0].time[(2U * i) + 1U], ((rise[i] == 1U) ? 0U : rise[i]) + 100U);
+    }
+    CHECK(!ledFxDone(&engine, 0U));
+}
+
+/*!
+ * @brief Breathe: rises to the level in onMs, falls to 0 in offMs, dark for
+ * pauseMs.
+ */
+static void testBreathe(void)
+{
+    uint8_t prev = 0U, level, peak = 0U;
+    uint32_t t;
+    bool done;
+
+    for (t = 0U; t < 1200U; t++)
+    {
+        level = ledFxLevel(&breathe, t, &done);
+        CHECK(!done);
+        if (t <= 400U)
+        {
+            CHECK(level >= prev);
+        }
+        else if (t <= 1000U)
+        {
+            CHECK(level <= prev);
+        }
+        else
+        {
+            CHECK_EQ(level, 0);
+        }
+        if (level > peak)
+        {
+            peak = level;
+        }
+        prev = level;
+    }
+    CHECK(peak >= 250U);
+    CHECK_EQ(ledFxLevel(&breathe, 0U, NULL), 0);
+    CHECK_EQ(ledFxLevel(&breathe, 1200U, NULL), 0);
+    /* half way up: squared ramp, about a quarter */
+    CHECK(ledFxLevel(&breathe, 200U, NULL) >= 60U);
+    CHECK(ledFxLevel(&breathe, 200U, NULL) <= 68U);
+}
+
+/*!
+ * @brief A main loop which ticks at random intervals (1..40 ms) sees the
+ * same edges, each one at the first tick at or after its time.
+ */
+static void testJitter(void)
+{
+    output_log_t ref;
+    uint32_t i, end = 5000U;
+
+    reset(0U);
+    ledFxStart(&engine, 0U, &strobe, clockMs);
+    run(end, 1U);
+    ref = logs[0];
+
+    reset(0U);
+    ledFxStart(&engine, 0U, &strobe, clockMs);
+    while (clockMs < end)
+    {
+        clockMs += 1U + (testRand() % 40U);
+        ledFxTick(&engine, clockMs);
+    }
+
+    CHECK_EQ(logs[0].cnt, ref.cnt);
+    for (i = 0U; (i < ref.cnt) && (i < logs[0].cnt); i++)
+    {
+        CHECK_EQ(logs[0].level[i], ref.level[i]);
+        CHECK(logs[0].time[i] >= ref.time[i]);
+        CHECK(logs[0].time[i] < ref.time[i] + 40U);
+    }
+}
+
+/*!
+ * @brief Restarting the running effect keeps its phase, another effect or
+ * NULL replaces it on the next tick.
+ */
+static void testStartStop(void)
+{
+    reset(0U);
+    ledFxStart(&engine, 0U, &strobe, clockMs);
+    run(50U, 1U);
+    ledFxStart(&engine, 0U, &strobe, clockMs);
+    run(150U, 1U);
+    /* the first pulse ended at 100 ms, not 150 ms */
+    CHECK_EQ(logs[0].cnt, 2);
+    CHECK_EQ(logs[0].time[1], 100);
+
+    ledFxStart(&engine, 0U, &solidForever, clockMs);
+    run(151U, 1U);
+    CHECK_EQ(outLevel[0], 255);
+    ledFxStart(&engine, 0U, NULL, clockMs);
+    CHECK(ledFxDone(&engine, 0U));
+    run(152U, 1U);
+    CHECK_EQ(outLevel[0], 0);
+
+    /* out of range channels are ignored */
+    ledFxStart(&engine, CHANNELS, &solid, clockMs);
+    CHECK(ledFxDone(&engine, CHANNELS));
+}
+
+/*!
+ * @brief The millis() clock wraps after 49.7 days, the effects don't see it.
+ */
+static void testClockWrap(void)
+{
+    uint32_t start = 0xFFFFFFFFU - 500U;
+
+    reset(start);
+    ledFxStart(&engine, 0U, &blink3, clockMs);
+    run(start + 1000U, 1U);
+
+    CHECK_EQ(logs[0].cnt, 6);
+    CHECK_EQ(logs[0].time[4], start + 300U);
+    CHECK_EQ(logs[0].time[5], start + 400U);
+    CHECK(ledFxDone(&engine, 0U));
+}
+
+/*!
+ * @brief Cost of a tick with all channels running.
+ */
+static void testCost(void)
+{
+    uint64_t start, ns;
+    uint32_t n;
+
+    reset(0U);
+    ledFxStart(&engine, 0U, &strobe, clockMs);
+    ledFxStart(&engine, 1U, &breathe, clockMs);
+    ledFxStart(&engine, 2U, &blink3, clockMs);
+    ledFxStart(&engine, 3U, &solidForever, clockMs);
+
+    start = testNowNs();
+    for (n = 0U; n < COST_TICKS; n++)
+    {
+        ledFxTick(&engine, n);
+    }
+    ns = testNowNs() - start;
+
+    CHECK(logs[0].calls > 0U);
+    printf("tick         %.1f ns for %u channels (host)\n",
+        (double)ns / COST_TICKS, (unsigned)CHANNELS);
+}
+
+int main(void)
+{
+    testSolid();
+    testBlink();
+    testStrobe();
+    testBreathe();
+    testJitter();
+    testStartStop();
+    testClockWrap();
+    testCost();
+
+    return testResult("test_led_fx");
+}